@@ -3,49 +3,112 @@ QT += core gui openglwidgets network
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
+
+# Файл и строка в сообщениях лога сохраняются и в release-сборке
+DEFINES += QT_MESSAGELOGCONTEXT
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
     SettingsManager.cpp \
+    auto_exposure.cpp \
+    controlbindings.cpp \
     controlwindow.cpp \
     iplineedit.cpp \
     lineeditutils.cpp \
     customlineedit.cpp \
     gamepadworker.cpp \
+    latencyhistogram.cpp \
+    latencystatswindow.cpp \
+    latest_frame_stage.cpp \
+    linkmonitor.cpp \
     mainwindow.cpp \
     profilemanager.cpp \
     camera.cpp \
+    camera_backend.cpp \
+    camera_benchmark.cpp \
     camera_worker.cpp \
+    control_benchmark.cpp \
+    eventlog.cpp \
+    frame_enhancer.cpp \
+    frame_quality.cpp \
     logger.cpp \
     main.cpp \
+    mosaic_builder.cpp \
+    mosaic_canvas.cpp \
+    mosaicwindow.cpp \
+    mvs_camera_backend.cpp \
+    persistenceservice.cpp \
+    replay_camera_backend.cpp \
+    rovsimulator.cpp \
     settingsdialog.cpp \
+    stereo_auto_capture.cpp \
+    stereo_calibration.cpp \
+    stereo_calibrator.cpp \
+    stereo_measurement.cpp \
+    stereo_processor.cpp \
+    stereo_proximity.cpp \
+    stereoprocessingwindow.cpp \
+    synthetic_camera_backend.cpp \
+    typedsettings.cpp \
     udphandler.cpp \
     udptelemetryparser.cpp \
     video_recorder.cpp \
+    video_stabilizer.cpp \
     video_streamer.cpp \
+    visual_odometry.cpp \
     settingsdialog.cpp \
     overlaywidget.cpp
 
 HEADERS += \
     SettingsManager.h \
+    auto_exposure.h \
+    controlbindings.h \
     controlwindow.h \
     customlineedit.h \
     gamepadworker.h \
     iplineedit.h \
+    latencyhistogram.h \
+    latencystatswindow.h \
+    latest_frame_stage.h \
     lineeditutils.h \
+    linkmonitor.h \
     mainwindow.h \
     profilemanager.h \
     camera.h \
+    camera_backend.h \
+    camera_benchmark.h \
     camera_structs.h \
     camera_worker.h \
+    control_benchmark.h \
+    eventlog.h \
+    frame_enhancer.h \
+    frame_quality.h \
     logger.h \
+    mosaic_builder.h \
+    mosaic_canvas.h \
+    mosaicwindow.h \
+    mvs_camera_backend.h \
+    persistenceservice.h \
+    replay_camera_backend.h \
+    rovsimulator.h \
     settingsdialog.h \
+    stereo_auto_capture.h \
+    stereo_calibration.h \
+    stereo_calibrator.h \
+    stereo_measurement.h \
+    stereo_processor.h \
+    stereo_proximity.h \
+    stereoprocessingwindow.h \
+    synthetic_camera_backend.h \
+    typedsettings.h \
     udphandler.h \
     udptelemetryparser.h \
     video_recorder.h \
+    video_stabilizer.h \
     video_streamer.h \
+    visual_odometry.h \
     settingsdialog.h \
     overlaywidget.h
 
@@ -63,7 +126,7 @@ INCLUDEPATH += c:\opencv-4.10.0-build\install\include
 LIBS += -lwsock32
 LIBS += -lws2_32
 LIBS += -LC:\opencv-4.10.0-build\install\x64\vc17\lib
-LIBS += -lopencv_core4100 -lopencv_imgcodecs4100 -lopencv_highgui4100 -lopencv_features2d4100 -lopencv_calib3d4100 -lopencv_videoio4100 -lopencv_imgproc4100 -lopencv_ximgproc4100
+LIBS += -lopencv_core4100 -lopencv_imgcodecs4100 -lopencv_highgui4100 -lopencv_features2d4100 -lopencv_calib3d4100 -lopencv_video4100 -lopencv_videoio4100 -lopencv_imgproc4100 -lopencv_ximgproc4100
 
 LIBS += -LC:\MVS\Development\Libraries\win64 -lMvCameraControl
 INCLUDEPATH += c:\MVS\Development\Includes
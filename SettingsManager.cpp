@@ -1,4 +1,6 @@
 #include "SettingsManager.h"
+#include "typedsettings.h"
+#include "persistenceservice.h"
 #include <QFile>
 #include <QJsonDocument>
 #include <QDebug>
@@ -33,15 +35,9 @@ bool SettingsManager::initialize(const QString& profileName)
 
     QString targetFile = targetDirPath + QDir::separator() + profileName;
 
-    QFile file(targetFile);
-    if (!file.exists()) {
+    // Если запись прервалась до замены файла, остаётся резервная копия - это не новый файл
+    if (!QFile::exists(targetFile) && !QFile::exists(PersistenceService::backupPath(targetFile))) {
         newFile=true;
-        if (!file.open(QIODevice::WriteOnly)) {
-            qWarning() << "Cannot create file:" << targetFile;
-            // Дополнительная обработка ошибки создания файла
-        } else {
-            file.close(); // Закрываем файл после создания
-        }
     }
     if (newFile) {
     SettingsManager::instance().setString("ip", "192.168.0.1");
@@ -66,26 +62,151 @@ bool SettingsManager::initialize(const QString& profileName)
     SettingsManager::instance().setDouble("DepthkP", 200);
     SettingsManager::instance().setDouble("DepthkI", 0);
     SettingsManager::instance().setDouble("DepthkD", 0);
+
+    SettingsManager::instance().setInt("Link_heartbeat_ms", 50);
+    SettingsManager::instance().setInt("Link_timeout_ms", 1000);
+    SettingsManager::instance().setDouble("Link_max_loss_percent", 20);
+    SettingsManager::instance().setDouble("Link_max_rtt_ms", 250);
+    SettingsManager::instance().setBool("Link_failsafe_zero_thrust", true);
+    SettingsManager::instance().setInt("Control_resend_ms", 20);
+    SettingsManager::instance().setString("Camera_backend", "mvs");
+    SettingsManager::instance().setInt("Camera_synthetic_width", 2448);
+    SettingsManager::instance().setInt("Camera_synthetic_height", 2048);
+    SettingsManager::instance().setDouble("Camera_synthetic_fps", 20);
+    SettingsManager::instance().setString("Camera_replay_path", "replay/{camera}.avi");
+    SettingsManager::instance().setInt("Camera_replay_width", 2448);
+    SettingsManager::instance().setInt("Camera_replay_height", 2048);
+    SettingsManager::instance().setDouble("Camera_replay_fps", 20);
+    SettingsManager::instance().setBool("Camera_replay_loop", true);
+    SettingsManager::instance().setInt("Camera_packet_size", 0);
+    SettingsManager::instance().setInt("Camera_packet_delay", 0);
+    SettingsManager::instance().setInt("Camera_image_nodes", 8);
+    SettingsManager::instance().setBool("Camera_resend", true);
+    SettingsManager::instance().setInt("Camera_resend_max_percent", 10);
+    SettingsManager::instance().setInt("Camera_resend_timeout_ms", 50);
+    SettingsManager::instance().setInt("Camera_grab_thread_priority", 5);
+    SettingsManager::instance().setBool("Camera_ae_enabled", false);
+    SettingsManager::instance().setInt("Camera_ae_target", 100);
+    SettingsManager::instance().setDouble("Camera_ae_damping", 0.3);
+    SettingsManager::instance().setDouble("Camera_ae_region_x", 0.1);
+    SettingsManager::instance().setDouble("Camera_ae_region_y", 0.1);
+    SettingsManager::instance().setDouble("Camera_ae_region_width", 0.8);
+    SettingsManager::instance().setDouble("Camera_ae_region_height", 0.8);
+    SettingsManager::instance().setInt("Camera_ae_sample_step", 8);
+    SettingsManager::instance().setDouble("Camera_ae_highlight_percent", 2);
+    SettingsManager::instance().setDouble("Camera_ae_min_exposure_us", 50);
+    SettingsManager::instance().setDouble("Camera_ae_max_exposure_us", 20000);
+    SettingsManager::instance().setDouble("Camera_ae_max_gain_db", 15);
+    SettingsManager::instance().setBool("Camera_enhance_display", false);
+    SettingsManager::instance().setBool("Camera_enhance_stream", false);
+    SettingsManager::instance().setBool("Camera_enhance_record", false);
+    SettingsManager::instance().setString("Camera_enhance_white_balance", "grayworld");
+    SettingsManager::instance().setDouble("Camera_enhance_wb_gain_b", 1);
+    SettingsManager::instance().setDouble("Camera_enhance_wb_gain_g", 1);
+    SettingsManager::instance().setDouble("Camera_enhance_wb_gain_r", 1);
+    SettingsManager::instance().setDouble("Camera_enhance_wb_adaptation", 0.1);
+    SettingsManager::instance().setBool("Camera_enhance_dehaze", true);
+    SettingsManager::instance().setDouble("Camera_enhance_dehaze_strength", 0.8);
+    SettingsManager::instance().setDouble("Camera_enhance_min_transmission", 0.3);
+    SettingsManager::instance().setBool("Camera_enhance_clahe", true);
+    SettingsManager::instance().setDouble("Camera_enhance_clahe_clip", 2);
+    SettingsManager::instance().setInt("Camera_enhance_clahe_tiles", 8);
+    SettingsManager::instance().setBool("Camera_stabilize_stream", false);
+    SettingsManager::instance().setBool("Camera_stabilize_record", false);
+    SettingsManager::instance().setInt("Camera_stabilize_lookahead", 3);
+    SettingsManager::instance().setDouble("Camera_stabilize_smoothing_frames", 10);
+    SettingsManager::instance().setDouble("Camera_stabilize_crop", 0.06);
+    SettingsManager::instance().setDouble("Camera_stabilize_max_angle_deg", 5);
+    SettingsManager::instance().setInt("Camera_stabilize_work_width", 320);
+    SettingsManager::instance().setInt("Camera_stabilize_features", 200);
+    SettingsManager::instance().setDouble("Camera_stabilize_hfov_deg", 80);
+    SettingsManager::instance().setInt("Camera_stabilize_roll_sign", 1);
+    SettingsManager::instance().setInt("Camera_stabilize_pitch_sign", 1);
+    SettingsManager::instance().setBool("Camera_quality_enabled", true);
+    SettingsManager::instance().setInt("Camera_quality_grid_columns", 8);
+    SettingsManager::instance().setInt("Camera_quality_grid_rows", 6);
+    SettingsManager::instance().setInt("Camera_quality_patch", 32);
+    SettingsManager::instance().setInt("Camera_quality_log_interval_ms", 1000);
+    SettingsManager::instance().setInt("Camera_stereo_burst_frames", 5);
+    SettingsManager::instance().setInt("Camera_stereo_burst_timeout_ms", 2000);
+    SettingsManager::instance().setString("Stereo_auto_camera", "LCamera");
+    SettingsManager::instance().setDouble("Stereo_auto_rate_hz", 10);
+    SettingsManager::instance().setInt("Stereo_auto_work_width", 256);
+    SettingsManager::instance().setDouble("Stereo_auto_target_overlap", 0.7);
+    SettingsManager::instance().setDouble("Stereo_auto_min_overlap", 0.5);
+    SettingsManager::instance().setDouble("Stereo_auto_max_rate_hz", 1);
+    SettingsManager::instance().setInt("Stereo_auto_sharpness_window", 10);
+    SettingsManager::instance().setDouble("Stereo_auto_sharpness_ratio", 0.7);
+    SettingsManager::instance().setDouble("Stereo_auto_min_response", 0.05);
+    SettingsManager::instance().setString("Stereo_calibration_file", "stereo/calibration.yml");
+    SettingsManager::instance().setInt("Stereo_num_disparities", 256);
+    SettingsManager::instance().setInt("Stereo_block_size", 5);
+    SettingsManager::instance().setDouble("Stereo_wls_lambda", 8000);
+    SettingsManager::instance().setDouble("Stereo_wls_sigma", 1.5);
+    SettingsManager::instance().setInt("Stereo_downscale", 2);
+    SettingsManager::instance().setDouble("Stereo_max_depth_m", 10);
+    SettingsManager::instance().setBool("Stereo_point_cloud", true);
+    SettingsManager::instance().setInt("Stereo_parallel_pairs", 0);
+    SettingsManager::instance().setInt("Stereo_board_columns", 9);
+    SettingsManager::instance().setInt("Stereo_board_rows", 6);
+    SettingsManager::instance().setDouble("Stereo_board_square_mm", 25);
+    SettingsManager::instance().setInt("Stereo_measure_window", 21);
+    SettingsManager::instance().setInt("Stereo_measure_max_disparity", 640);
+    SettingsManager::instance().setDouble("Stereo_measure_min_score", 0.7);
+    SettingsManager::instance().setInt("Stereo_measure_max_skew_ms", 30);
+    SettingsManager::instance().setBool("Stereo_proximity_enabled", true);
+    SettingsManager::instance().setDouble("Stereo_proximity_rate_hz", 5);
+    SettingsManager::instance().setInt("Stereo_proximity_width", 320);
+    SettingsManager::instance().setInt("Stereo_proximity_num_disparities", 64);
+    SettingsManager::instance().setInt("Stereo_proximity_block_size", 5);
+    SettingsManager::instance().setInt("Stereo_proximity_columns", 3);
+    SettingsManager::instance().setInt("Stereo_proximity_rows", 3);
+    SettingsManager::instance().setDouble("Stereo_proximity_warn_m", 1.0);
+    SettingsManager::instance().setDouble("Stereo_proximity_caution_m", 2.0);
+    SettingsManager::instance().setString("Mosaic_camera", "DCamera");
+    SettingsManager::instance().setString("Mosaic_directory", "mosaic");
+    SettingsManager::instance().setDouble("Mosaic_rate_hz", 6);
+    SettingsManager::instance().setInt("Mosaic_work_width", 640);
+    SettingsManager::instance().setInt("Mosaic_features", 1000);
+    SettingsManager::instance().setInt("Mosaic_min_inliers", 25);
+    SettingsManager::instance().setInt("Mosaic_yaw_sign", 1);
+    SettingsManager::instance().setDouble("Mosaic_max_yaw_error_deg", 10);
+    SettingsManager::instance().setDouble("Mosaic_steady_depth_m", 0.05);
+    SettingsManager::instance().setInt("Mosaic_memory_mb", 256);
+    SettingsManager::instance().setString("Odometry_camera", "DCamera");
+    SettingsManager::instance().setDouble("Odometry_rate_hz", 25);
+    SettingsManager::instance().setInt("Odometry_work_width", 320);
+    SettingsManager::instance().setInt("Odometry_features", 150);
+    SettingsManager::instance().setInt("Odometry_min_features", 40);
+    SettingsManager::instance().setInt("Odometry_min_inliers", 15);
+    SettingsManager::instance().setDouble("Odometry_hfov_deg", 90);
+    SettingsManager::instance().setDouble("Odometry_altitude_m", 1.5);
+    SettingsManager::instance().setInt("Odometry_yaw_sign", 1);
+    SettingsManager::instance().setInt("Odometry_tilt_sign", 1);
+    SettingsManager::instance().setDouble("Odometry_budget_ms", 15);
+    SettingsManager::instance().setDouble("Odometry_hold_kp", 0.5);
+    SettingsManager::instance().setDouble("Odometry_hold_ki", 0.05);
+    SettingsManager::instance().setDouble("Odometry_hold_max_thrust", 0.3);
+    SettingsManager::instance().setDouble("Odometry_hold_deadband_m", 0.03);
     setLastActiveProfile("default");  // Устанавливаем значение по умолчанию
     SettingsManager::instance().saveToFile("settings.json");
     newFile=false;
-    }
-    // Теперь открываем файл для чтения
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Cannot open settings file:" << targetFile;
-        // Дополнительная обработка ошибки открытия файла
+    // Файл пишется в фоне, настройки по умолчанию уже в памяти
+    m_initialized = true;
+    resolveTypedSettings();
+    return true;
     }
 
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
-    file.close();  // Явное закрытие после чтения!
-    if(error.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << error.errorString();
+    // Повреждённый файл (например, после сбоя питания) заменяется последней исправной копией
+    QJsonObject loaded;
+    if (!PersistenceService::readJsonWithBackup(targetFile, loaded)) {
+        qWarning() << "Cannot read settings file:" << targetFile;
         return false;
     }
 
-    m_settings = doc.object();
+    m_settings = loaded;
     m_initialized = true;
+    resolveTypedSettings();
     return true;
 }
 
@@ -135,6 +256,7 @@ bool SettingsManager::loadFromFile(const QString& filePath)
     }
 
     m_settings = doc.object();
+    resolveTypedSettings();
 
     return true;
 }
@@ -144,29 +266,10 @@ bool SettingsManager::saveToFile(const QString& profileName) const
 
     QString baseDir = QCoreApplication::applicationDirPath();
     QString targetDirPath = baseDir + QDir::separator() + "Configs";
-
-    QDir dir;
-    if (!dir.exists(targetDirPath)) {
-        if (!dir.mkpath(targetDirPath)) {
-            qWarning() << "Не удалось создать папку Configs";
-            return false;
-        }
-    }
-
     QString targetFile = targetDirPath + QDir::separator() + profileName;
 
-    QFile file(targetFile);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "Failed to open settings file for writing:" << targetFile;
-        return false;
-    }
-
-    QJsonDocument doc(m_settings);
-    if (file.write(doc.toJson()) == -1) {
-        qWarning() << "Failed to write settings to file";
-        return false;
-    }
-
+    // Папку при необходимости создаёт PersistenceService. Запись в фоновом потоке: частые сохранения объединяются, файл заменяется атомарно
+    PersistenceService::instance().scheduleWrite(targetFile, m_settings);
     return true;
 }
 
@@ -208,8 +311,14 @@ bool SettingsManager::getBool(const QString& key, bool defaultValue) const
 
 double SettingsManager::getDouble(const QString& key, double defaultValue) const
 {
-    if (m_settings.contains(key) && m_settings[key].isDouble()) {
-        return m_settings[key].toDouble();
+    if (m_settings.contains(key)) {
+        if (m_settings[key].isDouble()) {
+            return m_settings[key].toDouble();
+        } else if (m_settings[key].isString()) {
+            bool ok;
+            double value = m_settings[key].toString().toDouble(&ok);
+            if (ok) return value;
+        }
     }
     return defaultValue;
 }
@@ -227,7 +336,27 @@ void SettingsManager::setValue(const QString& key, const QJsonValue& value)
 {
     if (m_settings[key] != value) {
         m_settings[key] = value;
-      //  emit settingsChanged();
+        if (TypedSetting* setting = TypedSetting::find(key)) {
+            QJsonValue normalized;
+            setting->load(value, normalized);
+            m_settings[key] = normalized;
+        }
+        emit settingChanged(key);
+    }
+}
+
+void SettingsManager::resolveTypedSettings()
+{
+    for (TypedSetting* setting : TypedSetting::all()) {
+        auto it = m_settings.find(setting->key());
+        QJsonValue raw = it != m_settings.end() ? *it : QJsonValue(QJsonValue::Undefined);
+        QJsonValue normalized;
+        bool changed = setting->load(raw, normalized);
+        // Числа, сохранённые строками, и значения вне диапазона исправляем и в самом объекте
+        if (it != m_settings.end() && raw != normalized)
+            m_settings[setting->key()] = normalized;
+        if (changed)
+            emit settingChanged(setting->key());
     }
 }
 
@@ -47,11 +47,18 @@ public:
 public slots:
     void updateLastActiveProfile(const QString &profileName);
 
+signals:
+    // Значение настройки изменилось (setValue или загрузка файла)
+    void settingChanged(const QString& key);
+
 private:
     // Приватный конструктор
     explicit SettingsManager(QObject* parent = nullptr);
     //Q_DISABLE_COPY(SettingsManager);
 
+    // Разбор и проверка типизированных настроек (typedsettings.h) после загрузки файла
+    void resolveTypedSettings();
+
     bool m_initialized = false;
     QJsonObject m_settings; // Основной объект для хранения настроек
 
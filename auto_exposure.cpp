@@ -0,0 +1,86 @@
+#include "auto_exposure.h"
+#include <algorithm>
+#include <cmath>
+
+AutoExposure::AutoExposure(const AutoExposureSettings& settings)
+    : m_settings(settings) {
+    m_settings.sampleStep = std::max(2, settings.sampleStep & ~1);
+    m_settings.damping = std::clamp(settings.damping, 0.01, 1.0);
+    m_settings.target = std::clamp(settings.target, 1, 254);
+    m_histogram.fill(0);
+    reset(settings.startExposureUs, settings.startGainDb);
+}
+
+void AutoExposure::reset(double exposureUs, double gainDb) {
+    m_exposureUs = std::clamp(exposureUs, m_settings.minExposureUs, m_settings.maxExposureUs);
+    m_gainDb = std::clamp(gainDb, 0.0, m_settings.maxGainDb);
+    m_settleFrames = 0;
+}
+
+void AutoExposure::meter(const unsigned char* data, unsigned int width, unsigned int height) {
+    const unsigned int step = static_cast<unsigned int>(m_settings.sampleStep);
+    // Границы зоны чётные: в строке RGGB с чётным номером зелёные пиксели стоят на нечётных x
+    const unsigned int x0 = static_cast<unsigned int>(width * std::clamp(m_settings.regionX, 0.0, 1.0)) & ~1u;
+    const unsigned int y0 = static_cast<unsigned int>(height * std::clamp(m_settings.regionY, 0.0, 1.0)) & ~1u;
+    const unsigned int x1 = std::min(width, x0 + static_cast<unsigned int>(width * std::clamp(m_settings.regionWidth, 0.0, 1.0)));
+    const unsigned int y1 = std::min(height, y0 + static_cast<unsigned int>(height * std::clamp(m_settings.regionHeight, 0.0, 1.0)));
+
+    // Четыре частичные гистограммы: соседние отсчёты с одинаковой яркостью попадают
+    // в разные массивы и не ждут друг друга на инкременте одной ячейки
+    quint32 parts[4][256] = {};
+    for (unsigned int y = y0; y < y1; y += step) {
+        const unsigned char* row = data + static_cast<size_t>(y) * width;
+        unsigned int x = x0 + 1;
+        for (; x + 3 * step < x1; x += 4 * step) {
+            ++parts[0][row[x]];
+            ++parts[1][row[x + step]];
+            ++parts[2][row[x + 2 * step]];
+            ++parts[3][row[x + 3 * step]];
+        }
+        for (; x < x1; x += step) {
+            ++parts[0][row[x]];
+        }
+    }
+
+    quint64 sum = 0;
+    quint32 highlights = 0;
+    m_samples = 0;
+    for (int level = 0; level < 256; ++level) {
+        const quint32 count = parts[0][level] + parts[1][level] + parts[2][level] + parts[3][level];
+        m_histogram[level] = count;
+        m_samples += count;
+        sum += static_cast<quint64>(count) * level;
+        if (level >= HIGHLIGHT_LEVEL) highlights += count;
+    }
+    m_mean = m_samples ? double(sum) / m_samples : 0;
+    m_highlightFraction = m_samples ? double(highlights) / m_samples : 0;
+}
+
+bool AutoExposure::update(double& exposureUs, double& gainDb) {
+    if (m_settleFrames > 0) {
+        --m_settleFrames;
+        return false;
+    }
+    if (m_samples == 0) return false;
+
+    double ratio = m_settings.target / std::max(1.0, m_mean);
+    // Блики от фар и взвеси: пока пересвеченных отсчётов много, яркость только снижается
+    if (m_highlightFraction * 100 > m_settings.highlightPercent) {
+        ratio = std::min(ratio, HIGHLIGHT_STEP);
+    }
+    const double logStep = std::clamp(m_settings.damping * std::log(ratio), -MAX_STEP, MAX_STEP);
+    if (std::abs(logStep) < DEADBAND) return false;
+
+    const double total = m_exposureUs * std::pow(10.0, m_gainDb / 20) * std::exp(logStep);
+    const double newExposureUs = std::clamp(total, m_settings.minExposureUs, m_settings.maxExposureUs);
+    const double newGainDb = std::clamp(20 * std::log10(total / newExposureUs), 0.0, m_settings.maxGainDb);
+    // Упёрлись в пределы - менять нечего
+    if (std::abs(newExposureUs - m_exposureUs) < 1 && std::abs(newGainDb - m_gainDb) < 0.05) return false;
+
+    m_exposureUs = newExposureUs;
+    m_gainDb = newGainDb;
+    m_settleFrames = SETTLE_FRAMES;
+    exposureUs = m_exposureUs;
+    gainDb = m_gainDb;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <QtGlobal>
+#include <array>
+
+// Настройки программной автоэкспозиции. Зона замера задаётся долями кадра,
+// поэтому не зависит от ROI и биннинга.
+struct AutoExposureSettings {
+    bool enabled = false;
+    int target = 100;                // Целевая средняя яркость зелёных пикселей, 0..255
+    double damping = 0.3;            // Доля ошибки яркости, исправляемая за один шаг, 0..1
+    double regionX = 0.1;            // Зона замера, доли ширины/высоты кадра
+    double regionY = 0.1;
+    double regionWidth = 0.8;
+    double regionHeight = 0.8;
+    int sampleStep = 8;              // Шаг сетки выборки, пикселей (чётный - сохраняет фазу Байера)
+    double highlightPercent = 2;     // Допустимая доля пересвеченных отсчётов, %
+    double minExposureUs = 50;
+    double maxExposureUs = 20000;    // Длиннее - смаз при движении аппарата, дальше растёт усиление
+    double maxGainDb = 15;
+    double startExposureUs = 10000;  // Начальные значения, если источник не сообщает текущие
+    double startGainDb = 0;
+};
+
+// Автоэкспозиция и автоусиление по гистограмме кадра BayerRG8.
+// Гистограмма строится по зелёным пикселям на разреженной сетке внутри зоны замера:
+// для кадра 5 Мп это около 80 тыс. отсчётов вместо 5 млн.
+// Регулятор работает в логарифме суммарной экспозиции (выдержка x усиление): сначала
+// растёт выдержка, усиление - только когда выдержка упёрлась в maxExposureUs.
+class AutoExposure {
+public:
+    explicit AutoExposure(const AutoExposureSettings& settings);
+
+    // Текущие выдержка и усиление камеры, от которых считаются следующие шаги
+    void reset(double exposureUs, double gainDb);
+
+    // Замер кадра BayerRG8 (строки без выравнивания)
+    void meter(const unsigned char* data, unsigned int width, unsigned int height);
+    // Шаг регулятора по последнему замеру. true - выдержку или усиление нужно изменить.
+    bool update(double& exposureUs, double& gainDb);
+
+    double meanLevel() const { return m_mean; }
+    double highlightFraction() const { return m_highlightFraction; }
+    const std::array<quint32, 256>& histogram() const { return m_histogram; }
+
+private:
+    static constexpr int HIGHLIGHT_LEVEL = 250;     // Отсчёт считается пересвеченным
+    static constexpr double HIGHLIGHT_STEP = 0.8;   // Уменьшение экспозиции при пересвете за шаг
+    static constexpr double DEADBAND = 0.03;        // Отклонение в логарифме, на которое не реагируем (~3%)
+    static constexpr double MAX_STEP = 0.69;        // Не больше чем вдвое за шаг (ln 2)
+    static constexpr int SETTLE_FRAMES = 2;         // Новая выдержка видна в кадре не сразу
+
+    AutoExposureSettings m_settings;
+    std::array<quint32, 256> m_histogram;
+    quint32 m_samples = 0;
+    double m_mean = 0;
+    double m_highlightFraction = 0;
+    double m_exposureUs;
+    double m_gainDb;
+    int m_settleFrames = 0;
+};
+
+#endif // AUTO_EXPOSURE_H
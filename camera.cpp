@@ -1,34 +1,52 @@
 #include "camera.h"
-
-Camera::Camera(QStringList& names, QObject* parent) : QObject(parent), m_cameraNames(names), m_reconnectAttempts(0), m_maxReconnectAttempts(5) {
-    qDebug() << "Создание объекта Camera";
+#include "SettingsManager.h"
+#include "mvs_camera_backend.h"
+#include "synthetic_camera_backend.h"
+#include "replay_camera_backend.h"
+#include "eventlog.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+Camera::Camera(QStringList& names, const QString& backendType, QObject* parent)
+    : QObject(parent), m_cameraNames(names) {
+    m_backendType = backendType.isEmpty() ? SettingsManager::instance().getString("Camera_backend", "mvs") : backendType;
+    if (m_backendType != "mvs" && m_backendType != "synthetic" && m_backendType != "replay") {
+        qDebug() << "Неизвестный источник кадров" << m_backendType << ", используется mvs";
+        m_backendType = "mvs";
+    }
+    qDebug() << "Создание объекта Camera, источник кадров:" << m_backendType;
     memset(&m_deviceList, 0, sizeof(MV_CC_DEVICE_INFO_LIST));
 
-    m_checkCameraTimer = new QTimer(this);
-    connect(m_checkCameraTimer, &QTimer::timeout, this, &Camera::checkCameras);
-
-    cleanupAllCameras();
+    m_discoveryTimer = new QTimer(this);
+    connect(m_discoveryTimer, &QTimer::timeout, this, &Camera::discoverCameras);
+    m_stereoBurstTimer = new QTimer(this);
+    connect(m_stereoBurstTimer, &QTimer::timeout, this, &Camera::collectStereoBurst);
 
-    if (checkCameras() != MV_OK) {
-        QString errorMsg = "Не удалось инициализировать камеры";
+    // Камеры открываются в start(), уже в потоке объекта Camera
+    for (const QString& name : m_cameraNames) {
+        createCameraSlot(name);
+    }
+    if (m_cameras.isEmpty()) {
+        QString errorMsg = "Список имен камер пуст";
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
-        return;
     }
 }
 
 Camera::~Camera() {
     qDebug() << "Уничтожение объекта Camera...";
     stopAll();
-    cleanupAllCameras();
-
-    if (m_checkCameraTimer) {
-        m_checkCameraTimer->stop();
-        delete m_checkCameraTimer;
-        m_checkCameraTimer = nullptr;
-    }
 
     for (size_t i = 0; i < m_cameras.size(); ++i) {
+        // Цикл захвата выходит после текущего grabFrame, тайм-аут которого 500 мс
+        if (m_cameras[i]->thread) {
+            m_cameras[i]->thread->wait();
+        }
+        if (m_cameras[i]->backend) {
+            m_cameras[i]->backend->close();
+        }
         delete m_cameras[i]->worker;
         delete m_cameras[i]->thread;
         delete m_streamInfos[i]->streamer;
@@ -74,173 +92,627 @@ void Camera::stereoShotSlot() {
     stereoShot();
 }
 
-void Camera::initializeCameras() {
-    if (checkCameras() != MV_OK) {
-        QString errorMsg = "Не удалось обновить список камер";
+void Camera::stereoShotRequestSlot(quint64 requestId) {
+    stereoShot(requestId);
+}
+
+int Camera::createCameraSlot(const QString& name) {
+    const int index = m_cameras.size();
+    // Для MVS номер устройства становится известен только после перечисления
+    const unsigned int id = (m_backendType == "mvs") ? (unsigned int)-1 : (unsigned int)index;
+
+    CameraFrameInfo* frameInfo = new CameraFrameInfo();
+    StreamFrameInfo* streamInfo = new StreamFrameInfo();
+    RecordFrameInfo* recordInfo = new RecordFrameInfo();
+    frameInfo->name = name;
+    frameInfo->id = id;
+    streamInfo->name = name;
+    streamInfo->id = id;
+    recordInfo->name = name;
+    recordInfo->id = id;
+    m_cameras.append(frameInfo);
+    m_streamInfos.append(streamInfo);
+    m_recordInfos.append(recordInfo);
+
+    // Запись и стриминг живут независимо от подключения камеры: пока камера
+    // переподключается, клиенты стрима и файл записи остаются открытыми
+    recordInfo->recorder = new VideoRecorder(recordInfo);
+    recordInfo->recorderThread = new QThread(this);
+    recordInfo->recorder->moveToThread(recordInfo->recorderThread);
+    recordInfo->recorderThread->start();
+    recordInfo->recorderThread->setPriority(QThread::LowPriority);
+    qDebug() << "Создан и запущен поток записи для камеры" << name;
+
+    streamInfo->streamer = new VideoStreamer(streamInfo, 0);
+    streamInfo->streamerThread = new QThread(this);
+    streamInfo->streamer->moveToThread(streamInfo->streamerThread);
+    streamInfo->streamerThread->start();
+    qDebug() << "Создан и запущен поток стриминга для камеры" << name;
+
+    frameInfo->thread = new QThread(this);
+    m_parameters.append(CameraParameters::fromJson(SettingsManager::instance().getObject("Camera_params_" + name)));
+
+    connect(recordInfo->recorder, &VideoRecorder::errorOccurred, this, &Camera::errorOccurred);
+    connect(streamInfo->streamer, &VideoStreamer::errorOccurred, this, &Camera::errorOccurred);
+
+    ReconnectState reconnect;
+    reconnect.timer = new QTimer(this);
+    reconnect.timer->setSingleShot(true);
+    connect(reconnect.timer, &QTimer::timeout, this, [this, index]() {
+        connectCamera(index);
+    });
+    m_reconnect.append(reconnect);
+    qDebug() << "Добавлена камера" << name << "(источник" << m_backendType << ")";
+    return index;
+}
+
+int Camera::indexOf(const QString& cameraName) const {
+    for (int i = 0; i < m_cameras.size(); ++i) {
+        if (m_cameras[i]->name == cameraName) return i;
+    }
+    return -1;
+}
+
+QString Camera::deviceName(const MV_CC_DEVICE_INFO* device) {
+    const unsigned char* name = (device->nTLayerType == MV_USB_DEVICE)
+        ? device->SpecialInfo.stUsb3VInfo.chUserDefinedName
+        : device->SpecialInfo.stGigEInfo.chUserDefinedName;
+    return QString::fromUtf8(reinterpret_cast<const char*>(name));
+}
+
+QString Camera::deviceSerial(const MV_CC_DEVICE_INFO* device) {
+    const unsigned char* serial = (device->nTLayerType == MV_USB_DEVICE)
+        ? device->SpecialInfo.stUsb3VInfo.chSerialNumber
+        : device->SpecialInfo.stGigEInfo.chSerialNumber;
+    return QString::fromLatin1(reinterpret_cast<const char*>(serial));
+}
+
+bool Camera::enumerateMvsDevices() {
+    memset(&m_deviceList, 0, sizeof(MV_CC_DEVICE_INFO_LIST));
+    int nRet = MV_CC_EnumDevices(MV_GIGE_DEVICE | MV_USB_DEVICE, &m_deviceList);
+    if (nRet != MV_OK || m_deviceList.nDeviceNum == 0) {
+        qDebug() << "Устройства не найдены или не удалось выполнить перечисление. Ошибка:" << nRet;
+        return false;
+    }
+    return true;
+}
+
+int Camera::findMvsDevice(const CameraFrameInfo* frameInfo) const {
+    // Камера, уже подключавшаяся раньше, ищется по серийному номеру: имя устройства
+    // задаётся пользователем и может совпасть у двух камер
+    if (!frameInfo->serialNumber.isEmpty()) {
+        for (unsigned int i = 0; i < m_deviceList.nDeviceNum; i++) {
+            if (m_deviceList.pDeviceInfo[i] && deviceSerial(m_deviceList.pDeviceInfo[i]) == frameInfo->serialNumber) {
+                return int(i);
+            }
+        }
+    }
+    // Первое подключение или замена камеры - по имени, если устройство не занято другой камерой
+    for (unsigned int i = 0; i < m_deviceList.nDeviceNum; i++) {
+        const MV_CC_DEVICE_INFO* device = m_deviceList.pDeviceInfo[i];
+        if (!device || deviceName(device) != frameInfo->name) continue;
+        const QString serial = deviceSerial(device);
+        bool claimed = false;
+        for (const CameraFrameInfo* other : m_cameras) {
+            if (other != frameInfo && other->serialNumber == serial) claimed = true;
+        }
+        if (!claimed) return int(i);
+    }
+    return -1;
+}
+
+void Camera::discoverCameras() {
+    bool waiting = false;
+    for (const ReconnectState& reconnect : m_reconnect) {
+        if (reconnect.state == LinkState::Backoff) waiting = true;
+    }
+    if (!waiting) {
+        m_discoveryTimer->stop();
+        return;
+    }
+    if (!enumerateMvsDevices()) return;
+
+    // Появившуюся камеру подключаем сразу, не дожидаясь конца паузы переподключения
+    for (int i = 0; i < m_cameras.size(); ++i) {
+        if (m_reconnect[i].state == LinkState::Backoff && findMvsDevice(m_cameras[i]) >= 0) {
+            qDebug() << "Обнаружено устройство камеры" << m_cameras[i]->name << ", подключение без ожидания";
+            m_reconnect[i].timer->start(0);
+        }
+    }
+}
+
+void Camera::addCameraSlot(const QString& cameraName) {
+    int index = indexOf(cameraName);
+    if (index < 0) {
+        m_cameraNames.append(cameraName);
+        index = createCameraSlot(cameraName);
+    } else if (m_reconnect[index].state != LinkState::Idle) {
+        qDebug() << "Камера" << cameraName << "уже подключена или переподключается";
+        return;
+    }
+    m_reconnect[index].attempt = 0;
+    connectCamera(index);
+}
+
+void Camera::removeCameraSlot(const QString& cameraName) {
+    const int index = indexOf(cameraName);
+    if (index < 0) {
+        QString errorMsg = QString("Камера с именем %1 не найдена").arg(cameraName);
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
         return;
     }
+    // Структуры камеры остаются на месте: на них держат указатели окно и замеры
+    ReconnectState& reconnect = m_reconnect[index];
+    reconnect.timer->stop();
+    reconnect.state = LinkState::Idle;
+    reconnect.attempt = 0;
+    stopRecording(cameraName);
+    stopStreaming(cameraName);
+    disconnectCamera(index);
+    qDebug() << "Камера" << cameraName << "отключена";
+}
 
-    for (size_t i = 0; i < m_cameras.size(); ++i) {
-        CameraFrameInfo* frameInfo = m_cameras[i];
-        StreamFrameInfo* streamInfo = m_streamInfos[i];
-        RecordFrameInfo* recordInfo = m_recordInfos[i];
-        qDebug() << "Инициализация камеры" << frameInfo->name << "с ID" << frameInfo->id;
-        getHandle(frameInfo->id, &frameInfo->handle, frameInfo->name.toStdString());
-        streamInfo->id = frameInfo->id;
-        recordInfo->id = frameInfo->id;
+void Camera::restartCameraSlot(const QString& cameraName) {
+    const int index = indexOf(cameraName);
+    if (index < 0) {
+        QString errorMsg = QString("Камера с именем %1 не найдена").arg(cameraName);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+        return;
+    }
+    qDebug() << "Перезапуск камеры" << cameraName;
+    m_reconnect[index].timer->stop();
+    disconnectCamera(index);
+    m_reconnect[index].attempt = 0;
+    connectCamera(index);
+}
+
+CameraParameters Camera::cameraParameters(const QString& cameraName) const {
+    const int index = indexOf(cameraName);
+    return index < 0 ? CameraParameters() : m_parameters[index];
+}
+
+void Camera::setCameraParametersSlot(const QString& cameraName, const CameraParameters& parameters) {
+    const int index = indexOf(cameraName);
+    if (index < 0) {
+        QString errorMsg = QString("Камера с именем %1 не найдена").arg(cameraName);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+        return;
+    }
+
+    const bool geometryChanged = !m_parameters[index].sameGeometry(parameters);
+    m_parameters[index] = parameters;
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    if (m_reconnect[index].state != LinkState::Running || !frameInfo->backend) {
+        qDebug() << "Параметры камеры" << cameraName << "будут применены при подключении";
+        return;
+    }
+
+    // Размеры кадра нельзя менять во время захвата; буферы конвейера подстроятся под новый кадр сами
+    if (geometryChanged) {
+        qDebug() << "Геометрия кадра камеры" << cameraName << "изменилась, перезапуск захвата";
+        restartCameraSlot(cameraName);
+        return;
+    }
+
+    int nRet = frameInfo->backend->applyParameters(parameters, false);
+    if (nRet != MV_OK && nRet != MV_E_SUPPORT) {
+        QString errorMsg = QString("Не удалось применить параметры камеры %1. Ошибка: %2").arg(cameraName).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+        return;
+    }
+    qDebug() << "Параметры камеры" << cameraName << "применены:" << parameters.toJson();
+}
+
+void Camera::connectCamera(int index) {
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    ReconnectState& reconnect = m_reconnect[index];
+    reconnect.state = LinkState::Connecting;
+    // Новый worker пишет в те же буферы камеры, поэтому стартует только после остановки старого
+    if (reconnect.stopping) {
+        qDebug() << "Подключение камеры" << frameInfo->name << "отложено до остановки потока захвата";
+        reconnect.connectPending = true;
+        return;
+    }
+    qDebug() << "Подключение камеры" << frameInfo->name << ", попытка" << (reconnect.attempt + 1);
+
+    delete frameInfo->backend;
+    frameInfo->backend = nullptr;
+    frameInfo->handle = nullptr;
 
-        if (!frameInfo->handle || frameInfo->id < 0 || frameInfo->id >= (int)m_deviceList.nDeviceNum || !m_deviceList.pDeviceInfo[frameInfo->id]) {
-            QString errorMsg = QString("Камера %1 не инициализирована").arg(frameInfo->name);
+    if (m_backendType == "mvs") {
+        const int device = enumerateMvsDevices() ? findMvsDevice(frameInfo) : -1;
+        if (device < 0) {
+            QString errorMsg = QString("Камера %1 не найдена среди устройств").arg(frameInfo->name);
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
-            frameInfo->handle = nullptr;
-            continue;
+            EventLog::record(EventId::CameraOpenFailed, {frameInfo->name, m_backendType});
+            scheduleReconnect(index);
+            return;
+        }
+        frameInfo->id = device;
+        const QString serial = deviceSerial(m_deviceList.pDeviceInfo[device]);
+        if (frameInfo->serialNumber != serial) {
+            if (!frameInfo->serialNumber.isEmpty()) {
+                qDebug() << "Камера" << frameInfo->name << "заменена: серийный номер" << frameInfo->serialNumber << "->" << serial;
+            }
+            frameInfo->serialNumber = serial;
         }
+    }
 
-        if (m_deviceList.pDeviceInfo[frameInfo->id]->nTLayerType == MV_GIGE_DEVICE) {
-            int nPacketSize = MV_CC_GetOptimalPacketSize(frameInfo->handle);
-            if (nPacketSize <= 0) {
-                QString errorMsg = QString("Не удалось определить оптимальный размер пакета для %1. Код ошибки: %2")
-                                       .arg(frameInfo->name).arg(nPacketSize);
-                qDebug() << errorMsg;
-                emit errorOccurred("Camera", errorMsg);
-            } else {
-                int nRet = MV_CC_SetIntValue(frameInfo->handle, "GevSCPSPacketSize", nPacketSize);
-                if (nRet != MV_OK) {
-                    QString errorMsg = QString("Не удалось установить размер пакета для %1. Ошибка: %2")
-                                           .arg(frameInfo->name).arg(nRet);
-                    qDebug() << errorMsg;
-                    emit errorOccurred("Camera", errorMsg);
-                    destroyCameras(frameInfo->handle);
-                    frameInfo->handle = nullptr;
-                    continue;
-                }
-                qDebug() << "Установлен размер пакета для" << frameInfo->name << ":" << nPacketSize;
+    if (!openBackend(frameInfo)) {
+        EventLog::record(EventId::CameraOpenFailed, {frameInfo->name, m_backendType});
+        scheduleReconnect(index);
+        return;
+    }
+    EventLog::record(EventId::CameraOpened, {frameInfo->name, frameInfo->backend->typeName()});
+
+    int nRet = frameInfo->backend->applyParameters(m_parameters[index], true);
+    if (nRet != MV_OK && nRet != MV_E_SUPPORT) {
+        QString errorMsg = QString("Параметры изображения камеры %1 применены не полностью. Ошибка: %2")
+                               .arg(frameInfo->name).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+    }
+    m_streamInfos[index]->id = frameInfo->id;
+    m_recordInfos[index]->id = frameInfo->id;
+
+    memset(&frameInfo->frame, 0, sizeof(MV_DISPLAY_FRAME_INFO));
+    startCapture(index);
+    reconnect.state = LinkState::Running;
+}
+
+void Camera::startCapture(int index) {
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    RecordFrameInfo* recordInfo = m_recordInfos[index];
+
+    // Сигналы предыдущего worker'а, ещё стоящие в очереди, относятся к старому подключению
+    const quint64 generation = ++m_reconnect[index].generation;
+
+    frameInfo->worker = new CameraWorker(frameInfo, m_streamInfos[index], recordInfo);
+    AutoExposureSettings autoExposure = loadAutoExposureSettings(frameInfo->name);
+    if (m_parameters[index].exposureUs > 0) autoExposure.startExposureUs = m_parameters[index].exposureUs;
+    if (m_parameters[index].gainDb >= 0) autoExposure.startGainDb = m_parameters[index].gainDb;
+    frameInfo->worker->setAutoExposure(autoExposure);
+    frameInfo->worker->setEnhancement(loadEnhancementSettings(frameInfo->name));
+    frameInfo->worker->setStabilization(loadStabilizationSettings(frameInfo->name));
+    frameInfo->worker->setQuality(loadQualitySettings());
+    frameInfo->worker->moveToThread(frameInfo->thread);
+    connect(frameInfo->thread, &QThread::started, frameInfo->worker, &CameraWorker::capture);
+    connect(frameInfo->worker, &CameraWorker::errorOccurred, this, &Camera::errorOccurred);
+    connect(frameInfo->worker, &CameraWorker::frameReady, this, [this, index, generation, frameInfo]() {
+        ReconnectState& reconnect = m_reconnect[index];
+        if (reconnect.generation != generation) return;
+        if (!reconnect.online) {
+            reconnect.online = true;
+            if (reconnect.attempt > 0) {
+                emit greatSuccess("Camera", QString("Камера %1 переподключена").arg(frameInfo->name));
             }
+            reconnect.attempt = 0;
+            emit cameraConnectionChanged(frameInfo->name, true);
         }
+        emit frameReady(frameInfo);
+    }, Qt::QueuedConnection);
+    connect(frameInfo->worker, &CameraWorker::captureFailed, this, [this, index, generation](const QString& reason) {
+        if (m_reconnect[index].generation != generation) return;
+        handleCaptureFailure(index, reason);
+    }, Qt::QueuedConnection);
+    if (m_reconnect[index].recording && recordInfo->recorder) {
+        connect(frameInfo->worker, &CameraWorker::frameReady, recordInfo->recorder, &VideoRecorder::recordFrame, Qt::QueuedConnection);
+    }
 
-        memset(&frameInfo->frame, 0, sizeof(MV_DISPLAY_FRAME_INFO));
+    frameInfo->thread->start(QThread::Priority(loadTransportProfile(frameInfo->name).grabThreadPriority));
+    qDebug() << "Поток захвата для камеры" << frameInfo->name << "запущен.";
+}
 
-        frameInfo->worker = new CameraWorker(frameInfo, streamInfo, recordInfo);
-        frameInfo->thread = new QThread(this);
-        frameInfo->worker->moveToThread(frameInfo->thread);
-        qDebug() << "Создан поток захвата для камеры" << frameInfo->name;
+// Поток захвата не ждём: цикл захвата выходит после текущего grabFrame, а worker и
+// устройство освобождаются в finishDisconnect() по сигналу finished потока
+void Camera::disconnectCamera(int index) {
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    ReconnectState& reconnect = m_reconnect[index];
+    // Сигналы останавливаемого worker'а больше не относятся к камере
+    reconnect.generation++;
+    reconnect.connectPending = false;
+    if (reconnect.online) {
+        reconnect.online = false;
+        emit cameraConnectionChanged(frameInfo->name, false);
+    }
+    if (reconnect.stopping) {
+        return;
+    }
 
-        recordInfo->recorder = new VideoRecorder(recordInfo);
-        recordInfo->recorderThread = new QThread(this);
-        recordInfo->recorder->moveToThread(recordInfo->recorderThread);
-        recordInfo->recorderThread->start();
-        recordInfo->recorderThread->setPriority(QThread::LowPriority);
-        qDebug() << "Создан и запущен поток записи для камеры" << frameInfo->name;
+    if (frameInfo->worker) {
+        frameInfo->worker->stop();
+    }
+    if (frameInfo->thread && frameInfo->thread->isRunning()) {
+        reconnect.stopping = true;
+        connect(frameInfo->thread, &QThread::finished, this, [this, index]() {
+            finishDisconnect(index);
+        }, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
+        frameInfo->thread->quit();
+        return;
+    }
+    finishDisconnect(index);
+}
 
-        streamInfo->streamer = new VideoStreamer(streamInfo, 0);
-        streamInfo->streamerThread = new QThread(this);
-        streamInfo->streamer->moveToThread(streamInfo->streamerThread);
-        streamInfo->streamerThread->start();
-        qDebug() << "Создан и запущен поток стриминга для камеры" << frameInfo->name;
+void Camera::finishDisconnect(int index) {
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    ReconnectState& reconnect = m_reconnect[index];
+    reconnect.stopping = false;
 
-        connect(frameInfo->worker, &CameraWorker::errorOccurred, this, &Camera::errorOccurred);
-        connect(recordInfo->recorder, &VideoRecorder::errorOccurred, this, &Camera::errorOccurred);
-        connect(streamInfo->streamer, &VideoStreamer::errorOccurred, this, &Camera::errorOccurred);
+    delete frameInfo->worker;
+    frameInfo->worker = nullptr;
+    if (frameInfo->backend) {
+        frameInfo->backend->close();
     }
+    frameInfo->handle = nullptr;
+    qDebug() << "Поток захвата для камеры" << frameInfo->name << "остановлен";
 
-    bool anyCameraInitialized = false;
-    for (const CameraFrameInfo* frameInfo : m_cameras) {
-        if (frameInfo->handle) {
-            anyCameraInitialized = true;
-            qDebug() << "Камера" << frameInfo->name << "успешно инициализирована.";
-            break;
+    if (reconnect.connectPending) {
+        reconnect.connectPending = false;
+        if (reconnect.state == LinkState::Connecting) {
+            connectCamera(index);
         }
     }
-    if (!anyCameraInitialized) {
-        QString errorMsg = "Не удалось открыть ни одну камеру";
-        qDebug() << errorMsg;
-        emit errorOccurred("Camera", errorMsg);
-        return;
+}
+
+void Camera::scheduleReconnect(int index) {
+    ReconnectState& reconnect = m_reconnect[index];
+    // 1, 2, 4, ... с, не больше RECONNECT_MAX_DELAY_MS
+    const int delayMs = std::min(RECONNECT_MAX_DELAY_MS, RECONNECT_INITIAL_DELAY_MS << std::min(reconnect.attempt, 5));
+    ++reconnect.attempt;
+    reconnect.state = LinkState::Backoff;
+    EventLog::record(EventId::CameraReconnectScheduled, {m_cameras[index]->name, reconnect.attempt, delayMs});
+    qDebug() << "Повторное подключение камеры" << m_cameras[index]->name << "через" << delayMs << "мс, попытка" << reconnect.attempt;
+    reconnect.timer->start(delayMs);
+
+    if (m_backendType == "mvs" && !m_discoveryTimer->isActive()) {
+        m_discoveryTimer->start(DISCOVERY_INTERVAL_MS);
     }
 }
 
-void Camera::reinitializeCameras() {
-    for (size_t i = 0; i < m_cameras.size(); ++i) {
-        CameraFrameInfo* frameInfo = m_cameras[i];
-        StreamFrameInfo* streamInfo = m_streamInfos[i];
-        RecordFrameInfo* recordInfo = m_recordInfos[i];
-        qDebug() << "Инициализация камеры" << frameInfo->name << "с ID" << frameInfo->id;
-        getHandle(frameInfo->id, &frameInfo->handle, frameInfo->name.toStdString());
-        streamInfo->id = frameInfo->id;
-        recordInfo->id = frameInfo->id;
+bool Camera::openBackend(CameraFrameInfo* frameInfo) {
+    if (m_backendType == "synthetic") {
+        SettingsManager& settings = SettingsManager::instance();
+        frameInfo->backend = new SyntheticCameraBackend(frameInfo->name,
+                                                        settings.getInt("Camera_synthetic_width", 2448),
+                                                        settings.getInt("Camera_synthetic_height", 2048),
+                                                        settings.getDouble("Camera_synthetic_fps", 20.0));
+        if (!frameInfo->backend->isOpen()) {
+            delete frameInfo->backend;
+            frameInfo->backend = nullptr;
+            return false;
+        }
+        return true;
+    }
 
-        if (!frameInfo->handle || frameInfo->id < 0 || frameInfo->id >= (int)m_deviceList.nDeviceNum || !m_deviceList.pDeviceInfo[frameInfo->id]) {
-            QString errorMsg = QString("Камера %1 не инициализирована").arg(frameInfo->name);
+    if (m_backendType == "replay") {
+        SettingsManager& settings = SettingsManager::instance();
+        QString path = settings.getString("Camera_replay_path", "replay/{camera}.avi");
+        path.replace("{camera}", frameInfo->name);
+        frameInfo->backend = new ReplayCameraBackend(frameInfo->name, path,
+                                                     settings.getInt("Camera_replay_width", 2448),
+                                                     settings.getInt("Camera_replay_height", 2048),
+                                                     settings.getDouble("Camera_replay_fps", 20.0),
+                                                     settings.getBool("Camera_replay_loop", true));
+        if (!frameInfo->backend->isOpen()) {
+            QString errorMsg = QString("Камера %1 не инициализирована: нет данных для воспроизведения в %2").arg(frameInfo->name, path);
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
-            frameInfo->handle = nullptr;
-            continue;
+            delete frameInfo->backend;
+            frameInfo->backend = nullptr;
+            return false;
         }
+        return true;
+    }
 
-        if (m_deviceList.pDeviceInfo[frameInfo->id]->nTLayerType == MV_GIGE_DEVICE) {
-            int nPacketSize = MV_CC_GetOptimalPacketSize(frameInfo->handle);
-            if (nPacketSize <= 0) {
-                QString errorMsg = QString("Не удалось определить оптимальный размер пакета для %1. Код ошибки: %2")
-                                       .arg(frameInfo->name).arg(nPacketSize);
-                qDebug() << errorMsg;
-                emit errorOccurred("Camera", errorMsg);
-            } else {
-                int nRet = MV_CC_SetIntValue(frameInfo->handle, "GevSCPSPacketSize", nPacketSize);
-                if (nRet != MV_OK) {
-                    QString errorMsg = QString("Не удалось установить размер пакета для %1. Ошибка: %2")
-                                           .arg(frameInfo->name).arg(nRet);
-                    qDebug() << errorMsg;
-                    emit errorOccurred("Camera", errorMsg);
-                    destroyCameras(frameInfo->handle);
-                    frameInfo->handle = nullptr;
-                    continue;
-                }
-                qDebug() << "Установлен размер пакета для" << frameInfo->name << ":" << nPacketSize;
-            }
-        }
+    getHandle(frameInfo->id, &frameInfo->handle, frameInfo->name.toStdString());
 
-        memset(&frameInfo->frame, 0, sizeof(MV_DISPLAY_FRAME_INFO));
+    if (!frameInfo->handle || frameInfo->id < 0 || frameInfo->id >= (int)m_deviceList.nDeviceNum || !m_deviceList.pDeviceInfo[frameInfo->id]) {
+        QString errorMsg = QString("Камера %1 не инициализирована").arg(frameInfo->name);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+        frameInfo->handle = nullptr;
+        return false;
+    }
 
-        frameInfo->worker = new CameraWorker(frameInfo, streamInfo, recordInfo);
-        frameInfo->thread = new QThread(this);
-        frameInfo->worker->moveToThread(frameInfo->thread);
-        qDebug() << "Создан поток захвата для камеры" << frameInfo->name;
+    if (!applyTransportProfile(frameInfo, loadTransportProfile(frameInfo->name))) {
+        destroyCameras(frameInfo->handle);
+        frameInfo->handle = nullptr;
+        return false;
+    }
 
-        recordInfo->recorder = new VideoRecorder(recordInfo);
-        recordInfo->recorderThread = new QThread(this);
-        recordInfo->recorder->moveToThread(recordInfo->recorderThread);
-        recordInfo->recorderThread->start();
-        recordInfo->recorderThread->setPriority(QThread::LowPriority);
-        qDebug() << "Создан и запущен поток записи для камеры" << frameInfo->name;
+    frameInfo->backend = new MvsCameraBackend(frameInfo->handle, frameInfo->name);
+    return true;
+}
 
-        streamInfo->streamer = new VideoStreamer(streamInfo, 0);
-        streamInfo->streamerThread = new QThread(this);
-        streamInfo->streamer->moveToThread(streamInfo->streamerThread);
-        streamInfo->streamerThread->start();
-        qDebug() << "Создан и запущен поток стриминга для камеры" << frameInfo->name;
+TransportProfile Camera::loadTransportProfile(const QString& cameraName) {
+    // Общие значения Camera_*, поверх них - объект Camera_transport_<имя камеры>, если он есть
+    SettingsManager& settings = SettingsManager::instance();
+    const QJsonObject overrides = settings.getObject("Camera_transport_" + cameraName);
+    auto intValue = [&](const char* key, int defaultValue) {
+        const int value = settings.getInt(QString("Camera_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toInt(value) : value;
+    };
+    auto boolValue = [&](const char* key, bool defaultValue) {
+        const bool value = settings.getBool(QString("Camera_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toBool(value) : value;
+    };
+
+    TransportProfile profile;
+    profile.packetSize = qMax(0, intValue("packet_size", profile.packetSize));
+    profile.packetDelay = qMax(0, intValue("packet_delay", profile.packetDelay));
+    profile.imageNodes = qBound(1, intValue("image_nodes", profile.imageNodes), 64);
+    profile.resend = boolValue("resend", profile.resend);
+    profile.resendMaxPercent = qBound(0, intValue("resend_max_percent", profile.resendMaxPercent), 100);
+    profile.resendTimeoutMs = qMax(0, intValue("resend_timeout_ms", profile.resendTimeoutMs));
+    profile.grabThreadPriority = qBound(int(QThread::IdlePriority), intValue("grab_thread_priority", profile.grabThreadPriority),
+                                        int(QThread::TimeCriticalPriority));
+    return profile;
+}
 
-        connect(frameInfo->worker, &CameraWorker::errorOccurred, this, &Camera::errorOccurred);
-        connect(recordInfo->recorder, &VideoRecorder::errorOccurred, this, &Camera::errorOccurred);
-        connect(streamInfo->streamer, &VideoStreamer::errorOccurred, this, &Camera::errorOccurred);
+AutoExposureSettings Camera::loadAutoExposureSettings(const QString& cameraName) {
+    // Общие значения Camera_ae_*, поверх них - объект Camera_exposure_<имя камеры>, если он есть
+    SettingsManager& settings = SettingsManager::instance();
+    const QJsonObject overrides = settings.getObject("Camera_exposure_" + cameraName);
+    auto doubleValue = [&](const char* key, double defaultValue) {
+        const double value = settings.getDouble(QString("Camera_ae_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toDouble(value) : value;
+    };
+
+    AutoExposureSettings ae;
+    ae.enabled = settings.getBool("Camera_ae_enabled", ae.enabled);
+    if (overrides.contains("enabled")) ae.enabled = overrides["enabled"].toBool(ae.enabled);
+    ae.target = qBound(1, qRound(doubleValue("target", ae.target)), 254);
+    ae.damping = qBound(0.01, doubleValue("damping", ae.damping), 1.0);
+    ae.regionX = qBound(0.0, doubleValue("region_x", ae.regionX), 0.9);
+    ae.regionY = qBound(0.0, doubleValue("region_y", ae.regionY), 0.9);
+    ae.regionWidth = qBound(0.1, doubleValue("region_width", ae.regionWidth), 1.0 - ae.regionX);
+    ae.regionHeight = qBound(0.1, doubleValue("region_height", ae.regionHeight), 1.0 - ae.regionY);
+    ae.sampleStep = qBound(2, qRound(doubleValue("sample_step", ae.sampleStep)), 64);
+    ae.highlightPercent = qBound(0.0, doubleValue("highlight_percent", ae.highlightPercent), 100.0);
+    ae.minExposureUs = qMax(1.0, doubleValue("min_exposure_us", ae.minExposureUs));
+    ae.maxExposureUs = qMax(ae.minExposureUs, doubleValue("max_exposure_us", ae.maxExposureUs));
+    ae.maxGainDb = qMax(0.0, doubleValue("max_gain_db", ae.maxGainDb));
+    return ae;
+}
+
+EnhancementSettings Camera::loadEnhancementSettings(const QString& cameraName) {
+    // Общие значения Camera_enhance_*, поверх них - объект Camera_enhancement_<имя камеры>, если он есть
+    SettingsManager& settings = SettingsManager::instance();
+    const QJsonObject overrides = settings.getObject("Camera_enhancement_" + cameraName);
+    auto doubleValue = [&](const char* key, double defaultValue) {
+        const double value = settings.getDouble(QString("Camera_enhance_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toDouble(value) : value;
+    };
+    auto boolValue = [&](const char* key, bool defaultValue) {
+        const bool value = settings.getBool(QString("Camera_enhance_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toBool(value) : value;
+    };
+
+    EnhancementSettings enhancement;
+    enhancement.display = boolValue("display", enhancement.display);
+    enhancement.stream = boolValue("stream", enhancement.stream);
+    enhancement.record = boolValue("record", enhancement.record);
+
+    QString whiteBalance = settings.getString("Camera_enhance_white_balance");
+    if (overrides.contains("white_balance")) whiteBalance = overrides["white_balance"].toString(whiteBalance);
+    if (whiteBalance == "off") {
+        enhancement.whiteBalance = EnhancementSettings::WhiteBalance::Off;
+    } else if (whiteBalance == "learned") {
+        enhancement.whiteBalance = EnhancementSettings::WhiteBalance::Learned;
+    } else {
+        enhancement.whiteBalance = EnhancementSettings::WhiteBalance::GrayWorld;
     }
+    enhancement.learnedGains[0] = qBound(0.1, doubleValue("wb_gain_b", 1), 8.0);
+    enhancement.learnedGains[1] = qBound(0.1, doubleValue("wb_gain_g", 1), 8.0);
+    enhancement.learnedGains[2] = qBound(0.1, doubleValue("wb_gain_r", 1), 8.0);
+    enhancement.wbAdaptation = qBound(0.01, doubleValue("wb_adaptation", enhancement.wbAdaptation), 1.0);
+    enhancement.dehaze = boolValue("dehaze", enhancement.dehaze);
+    enhancement.dehazeStrength = qBound(0.0, doubleValue("dehaze_strength", enhancement.dehazeStrength), 1.0);
+    enhancement.minTransmission = qBound(0.05, doubleValue("min_transmission", enhancement.minTransmission), 1.0);
+    enhancement.clahe = boolValue("clahe", enhancement.clahe);
+    enhancement.claheClipLimit = qBound(0.1, doubleValue("clahe_clip", enhancement.claheClipLimit), 40.0);
+    enhancement.claheTiles = qBound(1, qRound(doubleValue("clahe_tiles", enhancement.claheTiles)), 32);
+    return enhancement;
+}
 
-    bool anyCameraInitialized = false;
-    for (const CameraFrameInfo* frameInfo : m_cameras) {
-        if (frameInfo->handle) {
-            anyCameraInitialized = true;
-            qDebug() << "Камера" << frameInfo->name << "успешно инициализирована.";
-            break;
+StabilizationSettings Camera::loadStabilizationSettings(const QString& cameraName) {
+    // Общие значения Camera_stabilize_*, поверх них - объект Camera_stabilization_<имя камеры>, если он есть
+    SettingsManager& settings = SettingsManager::instance();
+    const QJsonObject overrides = settings.getObject("Camera_stabilization_" + cameraName);
+    auto doubleValue = [&](const char* key, double defaultValue) {
+        const double value = settings.getDouble(QString("Camera_stabilize_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toDouble(value) : value;
+    };
+    auto boolValue = [&](const char* key, bool defaultValue) {
+        const bool value = settings.getBool(QString("Camera_stabilize_") + key, defaultValue);
+        return overrides.contains(key) ? overrides[key].toBool(value) : value;
+    };
+
+    StabilizationSettings stabilization;
+    stabilization.stream = boolValue("stream", stabilization.stream);
+    stabilization.record = boolValue("record", stabilization.record);
+    stabilization.lookahead = qBound(0, qRound(doubleValue("lookahead", stabilization.lookahead)), 30);
+    stabilization.smoothingFrames = qBound(1.0, doubleValue("smoothing_frames", stabilization.smoothingFrames), 30.0);
+    stabilization.crop = qBound(0.0, doubleValue("crop", stabilization.crop), 0.25);
+    stabilization.maxAngleDeg = qBound(0.0, doubleValue("max_angle_deg", stabilization.maxAngleDeg), 30.0);
+    stabilization.workWidth = qBound(80, qRound(doubleValue("work_width", stabilization.workWidth)), 1280);
+    stabilization.features = qBound(20, qRound(doubleValue("features", stabilization.features)), 1000);
+    stabilization.hfovDeg = qBound(10.0, doubleValue("hfov_deg", stabilization.hfovDeg), 170.0);
+    stabilization.rollSign = qBound(-1, qRound(doubleValue("roll_sign", stabilization.rollSign)), 1);
+    stabilization.pitchSign = qBound(-1, qRound(doubleValue("pitch_sign", stabilization.pitchSign)), 1);
+    return stabilization;
+}
+
+FrameQualitySettings Camera::loadQualitySettings() {
+    SettingsManager& settings = SettingsManager::instance();
+    FrameQualitySettings quality;
+    quality.enabled = settings.getBool("Camera_quality_enabled", quality.enabled);
+    quality.gridColumns = qBound(1, settings.getInt("Camera_quality_grid_columns", quality.gridColumns), 32);
+    quality.gridRows = qBound(1, settings.getInt("Camera_quality_grid_rows", quality.gridRows), 32);
+    quality.patchSize = qBound(8, settings.getInt("Camera_quality_patch", quality.patchSize), 64);
+    quality.logIntervalMs = qMax(100, settings.getInt("Camera_quality_log_interval_ms", quality.logIntervalMs));
+    return quality;
+}
+
+bool Camera::applyTransportProfile(CameraFrameInfo* frameInfo, const TransportProfile& profile) {
+    int nRet = MV_CC_SetImageNodeNum(frameInfo->handle, profile.imageNodes);
+    if (nRet != MV_OK) {
+        QString errorMsg = QString("Не удалось установить число буферов кадров для %1. Ошибка: %2")
+                               .arg(frameInfo->name).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+    }
+
+    if (m_deviceList.pDeviceInfo[frameInfo->id]->nTLayerType != MV_GIGE_DEVICE) {
+        return true;
+    }
+
+    int nPacketSize = profile.packetSize;
+    if (nPacketSize == 0) {
+        nPacketSize = MV_CC_GetOptimalPacketSize(frameInfo->handle);
+        if (nPacketSize <= 0) {
+            QString errorMsg = QString("Не удалось определить оптимальный размер пакета для %1. Код ошибки: %2")
+                                   .arg(frameInfo->name).arg(nPacketSize);
+            qDebug() << errorMsg;
+            emit errorOccurred("Camera", errorMsg);
+        }
+    }
+    if (nPacketSize > 0) {
+        nRet = MV_CC_SetIntValue(frameInfo->handle, "GevSCPSPacketSize", nPacketSize);
+        if (nRet != MV_OK) {
+            QString errorMsg = QString("Не удалось установить размер пакета для %1. Ошибка: %2")
+                                   .arg(frameInfo->name).arg(nRet);
+            qDebug() << errorMsg;
+            emit errorOccurred("Camera", errorMsg);
+            return false;
         }
     }
-    if (!anyCameraInitialized) {
-        QString errorMsg = "Не удалось открыть ни одну камеру";
+
+    nRet = MV_CC_SetIntValue(frameInfo->handle, "GevSCPD", profile.packetDelay);
+    if (nRet != MV_OK) {
+        QString errorMsg = QString("Не удалось установить задержку между пакетами для %1. Ошибка: %2")
+                               .arg(frameInfo->name).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+    }
+
+    nRet = MV_GIGE_SetResend(frameInfo->handle, profile.resend ? 1 : 0, profile.resendMaxPercent, profile.resendTimeoutMs);
+    if (nRet != MV_OK) {
+        QString errorMsg = QString("Не удалось настроить повторную передачу пакетов для %1. Ошибка: %2")
+                               .arg(frameInfo->name).arg(nRet);
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
-        return;
     }
+
+    qDebug() << "Транспорт" << frameInfo->name << ": пакет" << nPacketSize << ", задержка" << profile.packetDelay
+             << ", буферов" << profile.imageNodes << ", повтор" << profile.resend
+             << "(" << profile.resendMaxPercent << "%," << profile.resendTimeoutMs << "мс)";
+    return true;
 }
 
 void Camera::setCameraNames(const QStringList& names) {
@@ -250,41 +722,35 @@ void Camera::setCameraNames(const QStringList& names) {
 }
 
 void Camera::start() {
-    qDebug() << "Запуск всех потоков захвата...";
-    for (size_t i = 0; i < m_cameras.size(); ++i) {
-        CameraFrameInfo* frameInfo = m_cameras[i];
-        if (frameInfo->worker && frameInfo->thread) {
-            connect(frameInfo->thread, &QThread::started, frameInfo->worker, &CameraWorker::capture, Qt::UniqueConnection);
-            connect(frameInfo->worker, &CameraWorker::frameReady, this, [this, frameInfo]() {
-                emit frameReady(frameInfo);
-            }, Qt::QueuedConnection);
-            connect(frameInfo->worker, &CameraWorker::captureFailed, this, &Camera::handleCaptureFailure, Qt::QueuedConnection);
-            frameInfo->thread->start();
-            qDebug() << "Поток захвата для камеры" << frameInfo->name << "запущен.";
-        } else {
-            QString errorMsg = QString("Поток захвата для камеры %1 не запущен: не инициализирован").arg(frameInfo->name);
-            qDebug() << errorMsg;
-            emit errorOccurred("Camera", errorMsg);
+    qDebug() << "Подключение всех камер...";
+    for (int i = 0; i < m_cameras.size(); ++i) {
+        if (m_reconnect[i].state == LinkState::Idle) {
+            connectCamera(i);
         }
     }
 }
 
 void Camera::stopAll() {
     qDebug() << "Остановка всех потоков...";
+    m_discoveryTimer->stop();
     for (size_t i = 0; i < m_cameras.size(); ++i) {
         CameraFrameInfo* frameInfo = m_cameras[i];
         StreamFrameInfo* streamInfo = m_streamInfos[i];
         RecordFrameInfo* recordInfo = m_recordInfos[i];
 
+        m_reconnect[i].timer->stop();
+        m_reconnect[i].state = LinkState::Idle;
+        m_reconnect[i].recording = false;
+
         // Остановка объектов
-        if (frameInfo->worker) {
-            frameInfo->worker->stop();
-            qDebug() << "Остановлен worker для камеры" << frameInfo->name;
-        }
+        disconnectCamera(i);
         if (recordInfo->recorder) {
             recordInfo->recorder->stopRecording();
             qDebug() << "Остановлен recorder для камеры" << frameInfo->name;
-            disconnect(recordInfo->recorder, nullptr, nullptr, nullptr);
+            // errorOccurred остаётся подключённым: recorder переживает остановку камер
+            disconnect(recordInfo->recorder, &VideoRecorder::recordingStarted, this, nullptr);
+            disconnect(recordInfo->recorder, &VideoRecorder::recordingFinished, this, nullptr);
+            disconnect(recordInfo->recorder, &VideoRecorder::recordingFailed, this, nullptr);
         }
         if (streamInfo->streamer) {
             streamInfo->streamer->stopStreaming();
@@ -292,14 +758,6 @@ void Camera::stopAll() {
         }
 
         // Завершение потоков с проверкой
-        if (frameInfo->thread && frameInfo->thread->isRunning()) {
-            frameInfo->thread->quit();
-            if (!frameInfo->thread->wait(5000)) {
-                qDebug() << "Поток захвата для" << frameInfo->name << "не завершился, принудительное завершение";
-                frameInfo->thread->terminate();
-                frameInfo->thread->wait();
-            }
-        }
         if (recordInfo->recorderThread && recordInfo->recorderThread->isRunning()) {
             recordInfo->recorderThread->quit();
             if (!recordInfo->recorderThread->wait(5000)) {
@@ -316,14 +774,8 @@ void Camera::stopAll() {
                 streamInfo->streamerThread->wait();
             }
         }
-
-        // Очистка объектов
-        delete frameInfo->worker;
-        frameInfo->worker = nullptr;
-        delete recordInfo->recorder;
-        recordInfo->recorder = nullptr;
-        delete streamInfo->streamer;
-        streamInfo->streamer = nullptr;
+        // Recorder и streamer не удаляются: их создаёт только createCameraSlot(), и после
+        // startCamera() запись и стриминг запускаются на тех же объектах
     }
     qDebug() << "Все потоки остановлены.";
 }
@@ -359,9 +811,16 @@ void Camera::startRecording(const QString& cameraName, int recordInterval, int s
                             emit recordingFinished(frameInfo);
                         }, Qt::QueuedConnection);
                 connect(recordInfo->recorder, &VideoRecorder::recordingFailed, this,
-                        &Camera::handleRecordingFailure, Qt::QueuedConnection);
-                // Добавлено соединение для frameReady
-                connect(frameInfo->worker, &CameraWorker::frameReady, recordInfo->recorder, &VideoRecorder::recordFrame, Qt::QueuedConnection);
+                        [this, cameraName = frameInfo->name](const QString& reason) {
+                            handleRecordingFailure(cameraName, reason);
+                        }, Qt::QueuedConnection);
+                // Кадры идут от текущего worker'а; если камера сейчас переподключается,
+                // соединение создаст startCapture()
+                m_reconnect[i].recording = true;
+                if (frameInfo->worker) {
+                    connect(frameInfo->worker, &CameraWorker::frameReady, recordInfo->recorder, &VideoRecorder::recordFrame,
+                            Qt::UniqueConnection);
+                }
 
                 if (!recordInfo->recorderThread->isRunning()) {
                     recordInfo->recorderThread->start();
@@ -389,7 +848,10 @@ void Camera::stopRecording(const QString& cameraName) {
     qDebug() << "Попытка остановки записи для камеры" << cameraName;
     for (size_t i = 0; i < m_cameras.size(); ++i) {
         if (m_cameras[i]->name == cameraName && m_recordInfos[i]->recorder) {
-            disconnect(m_cameras[i]->worker, &CameraWorker::frameReady, m_recordInfos[i]->recorder, &VideoRecorder::recordFrame);
+            m_reconnect[i].recording = false;
+            if (m_cameras[i]->worker) {
+                disconnect(m_cameras[i]->worker, &CameraWorker::frameReady, m_recordInfos[i]->recorder, &VideoRecorder::recordFrame);
+            }
             m_recordInfos[i]->recorder->stopRecording();
             if (m_recordInfos[i]->recorderThread && m_recordInfos[i]->recorderThread->isRunning()) {
                 m_recordInfos[i]->recorderThread->quit();
@@ -429,7 +891,9 @@ void Camera::startStreaming(const QString& cameraName, int port) {
                     qDebug() << "Стриминг завершен для камеры" << frameInfo->name;
                     emit streamingFinished(frameInfo);
                 }, Qt::QueuedConnection);
-                connect(streamInfo->streamer, &VideoStreamer::streamingFailed, this, &Camera::handleStreamingFailure, Qt::QueuedConnection);
+                connect(streamInfo->streamer, &VideoStreamer::streamingFailed, this, [this, cameraName = streamInfo->name](const QString& reason) {
+                    handleStreamingFailure(cameraName, reason);
+                }, Qt::QueuedConnection);
                 if (!streamInfo->streamerThread->isRunning()) {
                     streamInfo->streamerThread->start();
                     qDebug() << "Поток стриминга для камеры" << streamInfo->name << "запущен.";
@@ -463,48 +927,123 @@ void Camera::stopStreaming(const QString& cameraName) {
     }
 }
 
-void Camera::stereoShot() {
-    qDebug() << "Вызван stereoShot, формат сохранения: PNG";
-    StreamFrameInfo* lCameraInfo = nullptr;
-    StreamFrameInfo* rCameraInfo = nullptr;
-
+bool Camera::findStereoStreams(StreamFrameInfo*& left, StreamFrameInfo*& right) {
+    left = nullptr;
+    right = nullptr;
     for (size_t i = 0; i < m_cameras.size(); ++i) {
-        if (m_cameras[i]->name == "LCamera") lCameraInfo = m_streamInfos[i];
-        else if (m_cameras[i]->name == "RCamera") rCameraInfo = m_streamInfos[i];
+        if (m_cameras[i]->name == "LCamera") left = m_streamInfos[i];
+        else if (m_cameras[i]->name == "RCamera") right = m_streamInfos[i];
+    }
+    return left && right;
+}
+
+void Camera::stereoShot(quint64 requestId) {
+    qDebug() << "Вызван stereoShot, формат сохранения: PNG";
+    if (m_stereoBurst.active) {
+        qDebug() << "Серия стереокадров уже снимается, запрос пропущен";
+        if (requestId != 0) emit stereoShotRequestHandled(requestId, false);
+        return;
     }
 
-    if (!lCameraInfo || !rCameraInfo) {
+    StreamFrameInfo* lCameraInfo = nullptr;
+    StreamFrameInfo* rCameraInfo = nullptr;
+    if (!findStereoStreams(lCameraInfo, rCameraInfo)) {
         QString errorMsg = "Не найдены обе камеры LCamera и RCamera";
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
         emit stereoShotFailed(errorMsg);
+        if (requestId != 0) emit stereoShotRequestHandled(requestId, false);
+        return;
+    }
+
+    // Без оценки качества выбирать не из чего - сохраняется первая пара, как одиночный снимок
+    SettingsManager& settings = SettingsManager::instance();
+    m_stereoBurst = StereoBurst();
+    m_stereoBurst.active = true;
+    m_stereoBurst.target = settings.getBool("Camera_quality_enabled", true)
+                               ? qBound(1, settings.getInt("Camera_stereo_burst_frames", 5), 30) : 1;
+    m_stereoBurst.deadlineNs = CameraBackend::monotonicNs() +
+                               qint64(qMax(100, settings.getInt("Camera_stereo_burst_timeout_ms", 2000))) * 1000000;
+    m_stereoBurst.requestId = requestId;
+    collectStereoBurst();
+    if (m_stereoBurst.active) {
+        m_stereoBurstTimer->start(STEREO_BURST_POLL_MS);
+    }
+}
+
+void Camera::collectStereoBurst() {
+    StreamFrameInfo* lCameraInfo = nullptr;
+    StreamFrameInfo* rCameraInfo = nullptr;
+    if (!findStereoStreams(lCameraInfo, rCameraInfo)) {
+        finishStereoBurst();
         return;
     }
 
-    cv::Mat lFrame, rFrame;
     {
         QMutexLocker lLocker(lCameraInfo->mutex);
         QMutexLocker rLocker(rCameraInfo->mutex);
 
-        if (!lCameraInfo->img.empty()) {
-            lFrame = lCameraInfo->img.clone();
-        }
-        if (!rCameraInfo->img.empty()) {
-            rFrame = rCameraInfo->img.clone();
+        // В серию идут только пары, в которых обе камеры успели дать новый кадр
+        if (!lCameraInfo->shotFrame().empty() && !rCameraInfo->shotFrame().empty() &&
+            lCameraInfo->frameIndex != m_stereoBurst.lastIndex[0] && rCameraInfo->frameIndex != m_stereoBurst.lastIndex[1]) {
+            m_stereoBurst.lastIndex[0] = lCameraInfo->frameIndex;
+            m_stereoBurst.lastIndex[1] = rCameraInfo->frameIndex;
+            const double score = FrameQualityMeter::pairScore(lCameraInfo->quality, rCameraInfo->quality);
+            m_stereoBurst.scores.push_back(score);
+            if (m_stereoBurst.best < 0 || score > m_stereoBurst.scores[m_stereoBurst.best]) {
+                m_stereoBurst.best = int(m_stereoBurst.scores.size()) - 1;
+                lCameraInfo->shotFrame().copyTo(m_stereoBurst.left);
+                rCameraInfo->shotFrame().copyTo(m_stereoBurst.right);
+                m_stereoBurst.leftQuality = lCameraInfo->quality;
+                m_stereoBurst.rightQuality = rCameraInfo->quality;
+            }
         }
     }
 
-    if (lFrame.empty() || rFrame.empty()) {
-        cv::cvtColor(lFrame, lFrame, cv::COLOR_BGR2RGB);
-        cv::cvtColor(rFrame, rFrame, cv::COLOR_BGR2RGB);
-        QString errorMsg = QString("Один или оба кадра пусты (LCamera: %1, RCamera: %2)")
-                               .arg(lFrame.empty() ? "пуст" : "не пуст")
-                               .arg(rFrame.empty() ? "пуст" : "не пуст");
+    if (int(m_stereoBurst.scores.size()) >= m_stereoBurst.target || CameraBackend::monotonicNs() >= m_stereoBurst.deadlineNs) {
+        finishStereoBurst();
+    }
+}
+
+void Camera::finishStereoBurst() {
+    m_stereoBurstTimer->stop();
+    m_stereoBurst.active = false;
+
+    bool saved = false;
+    if (m_stereoBurst.best < 0) {
+        QString errorMsg = "Один или оба кадра пусты (нет новых кадров LCamera и RCamera)";
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
         emit stereoShotFailed(errorMsg);
-        return;
+    } else {
+        if (m_stereoBurst.scores.size() > 1) {
+            qDebug() << "Серия стереокадров:" << m_stereoBurst.scores.size() << "пар, выбрана пара" << m_stereoBurst.best
+                     << "с резкостью" << m_stereoBurst.scores[m_stereoBurst.best];
+        }
+        saved = saveStereoShot();
     }
+    m_stereoBurst.left.release();
+    m_stereoBurst.right.release();
+    // Автоматика засчитывает снимок, только когда оба кадра и показатели качества записаны
+    if (m_stereoBurst.requestId != 0) emit stereoShotRequestHandled(m_stereoBurst.requestId, saved);
+}
+
+static QJsonObject qualityToJson(const FrameQuality& quality, const std::string& filePath) {
+    QJsonObject object;
+    object["file"] = QString::fromStdString(std::filesystem::path(filePath).filename().string());
+    object["quality_valid"] = quality.valid;
+    object["sharpness"] = quality.sharpness;
+    object["mean_level"] = quality.meanLevel;
+    object["dark_fraction"] = quality.darkFraction;
+    object["clipped_fraction"] = quality.clippedFraction;
+    object["contrast"] = quality.contrast;
+    object["turbidity"] = quality.turbidity;
+    return object;
+}
+
+bool Camera::saveStereoShot() {
+    const cv::Mat& lFrame = m_stereoBurst.left;
+    const cv::Mat& rFrame = m_stereoBurst.right;
 
     std::filesystem::path stereoDirectory = std::filesystem::current_path() / "stereo";
     std::filesystem::path lDirectory = stereoDirectory / "L";
@@ -517,7 +1056,7 @@ void Camera::stereoShot() {
                 qDebug() << errorMsg;
                 emit errorOccurred("Camera", errorMsg);
                 emit stereoShotFailed(errorMsg);
-                return;
+                return false;
             }
         }
         if (!std::filesystem::exists(lDirectory)) {
@@ -526,7 +1065,7 @@ void Camera::stereoShot() {
                 qDebug() << errorMsg;
                 emit errorOccurred("Camera", errorMsg);
                 emit stereoShotFailed(errorMsg);
-                return;
+                return false;
             }
         }
         if (!std::filesystem::exists(rDirectory)) {
@@ -535,7 +1074,7 @@ void Camera::stereoShot() {
                 qDebug() << errorMsg;
                 emit errorOccurred("Camera", errorMsg);
                 emit stereoShotFailed(errorMsg);
-                return;
+                return false;
             }
         }
 
@@ -545,17 +1084,19 @@ void Camera::stereoShot() {
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
             emit stereoShotFailed(errorMsg);
-            return;
+            return false;
         }
     } catch (const std::filesystem::filesystem_error& e) {
         QString errorMsg = QString("Ошибка файловой системы при создании директорий: %1").arg(e.what());
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
         emit stereoShotFailed(errorMsg);
-        return;
+        return false;
     }
 
-    auto now = std::time(nullptr);
+    const auto nowPoint = std::chrono::system_clock::now();
+    auto now = std::chrono::system_clock::to_time_t(nowPoint);
+    const int millis = int(std::chrono::duration_cast<std::chrono::milliseconds>(nowPoint.time_since_epoch()).count() % 1000);
     std::tm timeInfo;
 #ifdef _MSC_VER
     localtime_s(&timeInfo, &now);
@@ -563,11 +1104,24 @@ void Camera::stereoShot() {
     timeInfo = *std::localtime(&now);
 #endif
     std::stringstream ss;
-    ss << std::put_time(&timeInfo, "%Y%m%d_%H%M%S");
+    ss << std::put_time(&timeInfo, "%Y%m%d_%H%M%S") << '_' << std::setw(3) << std::setfill('0') << millis;
     std::string timestamp = ss.str();
 
-    std::string lFileName = "LCamera_" + timestamp + ".png";
-    std::string rFileName = "RCamera_" + timestamp + ".png";
+    // Автоматика снимает до нескольких пар в секунду, а ручной снимок может совпасть с ней
+    // по времени: существующие файлы не перезаписываются, новая пара получает номер
+    std::string shotName = timestamp;
+    auto shotTaken = [&](const std::string& name) {
+        std::error_code ec;
+        return std::filesystem::exists(lDirectory / ("LCamera_" + name + ".png"), ec) ||
+               std::filesystem::exists(rDirectory / ("RCamera_" + name + ".png"), ec) ||
+               std::filesystem::exists(stereoDirectory / (name + ".json"), ec);
+    };
+    for (int sequence = 2; shotTaken(shotName); ++sequence) {
+        shotName = timestamp + "_" + std::to_string(sequence);
+    }
+
+    std::string lFileName = "LCamera_" + shotName + ".png";
+    std::string rFileName = "RCamera_" + shotName + ".png";
     std::string lFilePath = (lDirectory / lFileName).string();
     std::string rFilePath = (rDirectory / rFileName).string();
 
@@ -581,15 +1135,38 @@ void Camera::stereoShot() {
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
             emit stereoShotFailed(errorMsg);
-            return;
+            return false;
         }
         if (!cv::imwrite(rFilePath, rFrame, compression_params)) {
             QString errorMsg = QString("Не удалось сохранить кадр RCamera в %1").arg(QString::fromStdString(rFilePath));
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
             emit stereoShotFailed(errorMsg);
-            return;
+            return false;
+        }
+
+        // Показатели качества пары и оценки всей серии - рядом с парой, в stereo/<время>.json.
+        // Без них снимок неполный, поэтому ошибка записи метаданных - ошибка снимка
+        QJsonObject metadata;
+        metadata["timestamp"] = QString::fromStdString(timestamp);
+        metadata["left"] = qualityToJson(m_stereoBurst.leftQuality, lFilePath);
+        metadata["right"] = qualityToJson(m_stereoBurst.rightQuality, rFilePath);
+        QJsonArray scores;
+        for (double score : m_stereoBurst.scores) scores.append(score);
+        QJsonObject burst;
+        burst["pairs"] = int(m_stereoBurst.scores.size());
+        burst["selected"] = m_stereoBurst.best;
+        burst["scores"] = scores;
+        metadata["burst"] = burst;
+        QFile metadataFile(QString::fromStdString((stereoDirectory / (shotName + ".json")).string()));
+        if (!metadataFile.open(QIODevice::WriteOnly | QIODevice::NewOnly) || metadataFile.write(QJsonDocument(metadata).toJson()) < 0) {
+            QString errorMsg = QString("Не удалось сохранить показатели качества стереокадров в %1").arg(metadataFile.fileName());
+            qDebug() << errorMsg;
+            emit errorOccurred("Camera", errorMsg);
+            emit stereoShotFailed(errorMsg);
+            return false;
         }
+
         qDebug() << "Стереокадры успешно сохранены: " << QString::fromStdString(lFilePath) << ", " << QString::fromStdString(rFilePath);
         emit stereoShotSaved(QString::fromStdString(lFilePath) + ";" + QString::fromStdString(rFilePath));
     } catch (const cv::Exception& e) {
@@ -597,96 +1174,25 @@ void Camera::stereoShot() {
         qDebug() << errorMsg;
         emit errorOccurred("Camera", errorMsg);
         emit stereoShotFailed(errorMsg);
-        return;
+        return false;
     }
+    return true;
 }
 
 const QList<CameraFrameInfo*>& Camera::getCameras() const {
     return m_cameras;
 }
 
-QStringList Camera::getCameraNames() const {
-    return m_cameraNames;
+const QList<StreamFrameInfo*>& Camera::getStreamInfos() const {
+    return m_streamInfos;
 }
 
-int Camera::checkCameras() {
-    int nRet = MV_OK;
-    memset(&m_deviceList, 0, sizeof(MV_CC_DEVICE_INFO_LIST));
-    nRet = MV_CC_EnumDevices(MV_GIGE_DEVICE | MV_USB_DEVICE, &m_deviceList);
-
-    if (nRet != MV_OK || m_deviceList.nDeviceNum == 0) {
-        QString errorMsg = QString("Устройства не найдены или не удалось выполнить перечисление. Ошибка: %1").arg(nRet);
-        qDebug() << errorMsg;
-        emit errorOccurred("Camera", errorMsg);
-
-        if (!m_checkCameraTimer->isActive()) {
-            qDebug() << "Запуск таймера для повторной проверки камер через 10 секунд";
-            m_checkCameraTimer->start(10000);
-        }
-        return nRet;
-    }
-
-    if (m_checkCameraTimer->isActive()) {
-        qDebug() << "Камеры найдены, остановка таймера проверки";
-        m_checkCameraTimer->stop();
-    }
-
-    qDebug() << "Найдено" << m_deviceList.nDeviceNum << "устройств";
-    qDebug() << "Текущий список имен камер:" << m_cameraNames;
-
-    m_cameras.clear();
-    m_streamInfos.clear();
-    m_recordInfos.clear();
-    for (unsigned int i = 0; i < m_deviceList.nDeviceNum; i++) {
-        if (!m_deviceList.pDeviceInfo[i]) continue;
-        std::stringstream cameraName;
-        cameraName << m_deviceList.pDeviceInfo[i]->SpecialInfo.stGigEInfo.chUserDefinedName;
-        QString camName = QString::fromStdString(cameraName.str());
-        qDebug() << "Устройство" << i << "Имя:" << camName
-                 << "Серийный номер:" << m_deviceList.pDeviceInfo[i]->SpecialInfo.stGigEInfo.chSerialNumber;
-
-        if (m_cameraNames.contains(camName)) {
-            CameraFrameInfo* frameInfo = new CameraFrameInfo();
-            StreamFrameInfo* streamInfo = new StreamFrameInfo();
-            RecordFrameInfo* recordInfo = new RecordFrameInfo();
-            frameInfo->name = camName;
-            frameInfo->id = i;
-            streamInfo->name = camName;
-            streamInfo->id = i;
-            recordInfo->name = camName;
-            recordInfo->id = i;
-            m_cameras.append(frameInfo);
-            m_streamInfos.append(streamInfo);
-            m_recordInfos.append(recordInfo);
-            qDebug() << "Добавлена камера" << camName << "с ID" << i;
-        } else {
-            qDebug() << "Камера" << camName << "пропущена, так как отсутствует в m_cameraNames";
-        }
-    }
-
-    if (m_cameras.isEmpty()) {
-        QString errorMsg = QString("Не найдено ни одной камеры из списка: %1").arg(m_cameraNames.join(", "));
-        qDebug() << errorMsg;
-        emit errorOccurred("Camera", errorMsg);
-
-        if (!m_checkCameraTimer->isActive()) {
-            qDebug() << "Запуск таймера для повторной проверки камер через 10 секунд";
-            m_checkCameraTimer->start(10000);
-        }
-        return -1;
-    }
-
-    qDebug() << "Камеры найдены, вызов reconnectCameras()";
-    cleanupAllCameras();
-    reinitializeCameras();
-    start();
-    QThread::msleep(5000);
-    emit reconnectDone(this);
-
-    QString sMsg = QString("Инициализированы камеры: %1").arg(m_cameras.size());
-    emit greatSuccess("Camera", sMsg);
+const QList<RecordFrameInfo*>& Camera::getRecordInfos() const {
+    return m_recordInfos;
+}
 
-    return MV_OK;
+QStringList Camera::getCameraNames() const {
+    return m_cameraNames;
 }
 
 int Camera::destroyCameras(void* handle) {
@@ -710,7 +1216,6 @@ int Camera::destroyCameras(void* handle) {
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
         }
-        QThread::msleep(2000);
     }
     return nRet;
 }
@@ -738,13 +1243,14 @@ void Camera::getHandle(unsigned int cameraID, void** handle, const std::string&
                  << QString(" (%1.%2.%3.%4)").arg(ipBytes[0]).arg(ipBytes[1]).arg(ipBytes[2]).arg(ipBytes[3])
                  << "Маска подсети:" << m_deviceList.pDeviceInfo[cameraID]->SpecialInfo.stGigEInfo.nCurrentSubNetMask
                  << "Шлюз:" << m_deviceList.pDeviceInfo[cameraID]->SpecialInfo.stGigEInfo.nDefultGateWay;
-        if (m_usedIPs.find(currentIP) != m_usedIPs.end()) {
-            QString errorMsg = QString("Обнаружен IP-конфликт! Камера %1 использует IP, уже занятый другой камерой")
-                                   .arg(cameraName.c_str());
+        auto usedIP = m_usedIPs.find(currentIP);
+        if (usedIP != m_usedIPs.end() && usedIP->second != cameraName.c_str()) {
+            QString errorMsg = QString("Обнаружен IP-конфликт! Камера %1 использует IP, уже занятый камерой %2")
+                                   .arg(QString::fromStdString(cameraName), usedIP->second);
             qDebug() << errorMsg;
             emit errorOccurred("Camera", errorMsg);
         } else {
-            m_usedIPs.insert(currentIP);
+            m_usedIPs[currentIP] = QString::fromStdString(cameraName);
         }
     }
 
@@ -758,129 +1264,70 @@ void Camera::getHandle(unsigned int cameraID, void** handle, const std::string&
         return;
     }
 
-    int retryCount = 5;
-    for (int i = 0; i < retryCount; ++i) {
-        nRet = MV_CC_OpenDevice(*handle);
-        if (nRet == MV_OK) {
-            qDebug() << cameraName.c_str() << "успешно открыта на попытке" << (i + 1);
-
-            MVCC_ENUMVALUE pixelFormat = {0};
-            nRet = MV_CC_GetEnumValue(*handle, "PixelFormat", &pixelFormat);
-            if (nRet == MV_OK) {
-                qDebug() << "Текущий формат пикселей для" << cameraName.c_str() << ":" << pixelFormat.nCurValue;
-            } else {
-                QString errorMsg = QString("Не удалось получить текущий формат пикселей для %1. Ошибка: %2")
-                                       .arg(cameraName.c_str()).arg(nRet);
-                qDebug() << errorMsg;
-                emit errorOccurred("Camera", errorMsg);
-            }
-
-            nRet = MV_CC_SetPixelFormat(*handle, PixelType_Gvsp_BayerRG8);
-            if (nRet != MV_OK) {
-                QString errorMsg = QString("Не удалось установить формат пикселей для %1. Ошибка: %2")
-                                       .arg(cameraName.c_str()).arg(nRet);
-                qDebug() << errorMsg;
-                emit errorOccurred("Camera", errorMsg);
-            }
-
-            return;
-        }
-        qDebug() << "Не удалось открыть устройство для" << cameraName.c_str() << "Ошибка:" << nRet
-                 << "Повтор" << (i + 1) << "из" << retryCount;
-        if (nRet == MV_E_ACCESS_DENIED) {
-            QString errorMsg = QString("Ошибка доступа (MV_E_ACCESSDENIED) для %1. Возможно, камера занята другим приложением")
-                                   .arg(cameraName.c_str());
-            qDebug() << errorMsg;
-            emit errorOccurred("Camera", errorMsg);
-            destroyCameras(*handle);
-            QThread::msleep(15000);
-            nRet = MV_CC_CreateHandle(handle, m_deviceList.pDeviceInfo[cameraID]);
-            if (nRet != MV_OK) {
-                QString errorMsg = QString("Не удалось пересоздать дескриптор для %1. Ошибка: %2")
-                                       .arg(cameraName.c_str()).arg(nRet);
-                qDebug() << errorMsg;
-                emit errorOccurred("Camera", errorMsg);
-                *handle = nullptr;
-                return;
-            }
-        } else {
-            QString errorMsg = QString("Не удалось открыть устройство для %1 после %2 попыток. Ошибка: %3")
-                                   .arg(cameraName.c_str()).arg(retryCount).arg(nRet);
-            qDebug() << errorMsg;
-            emit errorOccurred("Camera", errorMsg);
-            destroyCameras(*handle);
-            *handle = nullptr;
-            return;
-        }
+    // Повторные попытки открытия - забота таймера переподключения, здесь не ждём
+    nRet = MV_CC_OpenDevice(*handle);
+    if (nRet != MV_OK) {
+        QString errorMsg = (nRet == MV_E_ACCESS_DENIED)
+            ? QString("Ошибка доступа (MV_E_ACCESSDENIED) для %1. Возможно, камера занята другим приложением")
+                  .arg(cameraName.c_str())
+            : QString("Не удалось открыть устройство для %1. Ошибка: %2").arg(cameraName.c_str()).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
+        destroyCameras(*handle);
+        *handle = nullptr;
+        return;
     }
+    qDebug() << cameraName.c_str() << "успешно открыта";
 
-    QString errorMsg = QString("Не удалось открыть устройство для %1 после %2 попыток. Ошибка: %3")
-                           .arg(cameraName.c_str()).arg(retryCount).arg(nRet);
-    qDebug() << errorMsg;
-    emit errorOccurred("Camera", errorMsg);
-    destroyCameras(*handle);
-    *handle = nullptr;
-}
-
-void Camera::cleanupAllCameras() {
-    qDebug() << "Очистка всех ресурсов камер...";
-    for (CameraFrameInfo* frameInfo : m_cameras) {
-        destroyCameras(frameInfo->handle);
-        frameInfo->handle = nullptr;
+    MVCC_ENUMVALUE pixelFormat = {0};
+    nRet = MV_CC_GetEnumValue(*handle, "PixelFormat", &pixelFormat);
+    if (nRet == MV_OK) {
+        qDebug() << "Текущий формат пикселей для" << cameraName.c_str() << ":" << pixelFormat.nCurValue;
+    } else {
+        QString errorMsg = QString("Не удалось получить текущий формат пикселей для %1. Ошибка: %2")
+                               .arg(cameraName.c_str()).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
     }
-    m_usedIPs.clear();
 
-    if (m_checkCameraTimer->isActive()) {
-        qDebug() << "Остановка таймера проверки камер во время очистки";
-        m_checkCameraTimer->stop();
+    nRet = MV_CC_SetPixelFormat(*handle, PixelType_Gvsp_BayerRG8);
+    if (nRet != MV_OK) {
+        QString errorMsg = QString("Не удалось установить формат пикселей для %1. Ошибка: %2")
+                               .arg(cameraName.c_str()).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("Camera", errorMsg);
     }
-
-    QThread::msleep(5000);
-    qDebug() << "Все ресурсы камер очищены.";
 }
 
-void Camera::reconnectCameras() {
-    qDebug() << "Переподключение камер...";
-    stopAll();
-    cleanupAllCameras();
-    reinitializeCameras();
-    start();
-    m_reconnectAttempts = 0;
-    QThread::msleep(5000);
-    emit reconnectDone(this);
-    qDebug() << "Переподключение камер завершено.";
-}
-
-void Camera::handleCaptureFailure(const QString& reason) {
-    QString errorMsg = QString("Ошибка захвата: %1").arg(reason);
+void Camera::handleCaptureFailure(int index, const QString& reason) {
+    CameraFrameInfo* frameInfo = m_cameras[index];
+    QString errorMsg = QString("Ошибка захвата %1: %2").arg(frameInfo->name, reason);
     qDebug() << errorMsg;
     emit errorOccurred("Camera", errorMsg);
 
-    if (reason.contains("Не удалось получить буфер изображения")) {
-        qDebug() << "Камера, возможно, отключена. Остановка всех операций и запуск таймера для периодической проверки.";
-        stopAll();
-        if (!m_checkCameraTimer->isActive()) {
-            m_checkCameraTimer->start(10000);
-        }
-    } else {
-        qDebug() << "Неизвестная ошибка захвата, остановка всех потоков";
-        stopAll();
-        emit finished();
+    if (m_reconnect[index].state == LinkState::Idle) {
+        return; // Камера остановлена через stopAll() или removeCameraSlot()
     }
+
+    // Останавливается и переподключается только эта камера
+    disconnectCamera(index);
+    scheduleReconnect(index);
 }
 
-void Camera::handleRecordingFailure(const QString& reason) {
-    QString errorMsg = QString("Ошибка записи видео: %1").arg(reason);
+// Сбой записи или трансляции одной камеры останавливает только её вывод:
+// захват и остальные камеры продолжают работать
+void Camera::handleRecordingFailure(const QString& cameraName, const QString& reason) {
+    QString errorMsg = QString("Ошибка записи видео камеры %1: %2").arg(cameraName, reason);
     qDebug() << errorMsg;
+    stopRecording(cameraName);
+    emit recordingFailed(errorMsg);
     emit errorOccurred("Camera", errorMsg);
-    stopAll();
-    emit finished();
 }
 
-void Camera::handleStreamingFailure(const QString& reason) {
-    QString errorMsg = QString("Ошибка стриминга видео: %1").arg(reason);
+void Camera::handleStreamingFailure(const QString& cameraName, const QString& reason) {
+    QString errorMsg = QString("Ошибка стриминга видео камеры %1: %2").arg(cameraName, reason);
     qDebug() << errorMsg;
+    stopStreaming(cameraName);
+    emit streamingFailed(errorMsg);
     emit errorOccurred("Camera", errorMsg);
-    stopAll();
-    emit finished();
 }
@@ -6,14 +6,17 @@
 #include <QList>
 #include <QStringList>
 #include <QTimer>
-#include <set>
+#include <map>
 #include <filesystem>
 #include <sstream>
+#include <chrono>
 #include <ctime>
+#include <iomanip>
 #include <windows.h>
 #include <opencv2/opencv.hpp>
 #include "MvCameraControl.h"
 #include "camera_structs.h"
+#include "auto_exposure.h"
 #include "camera_worker.h"
 #include "video_recorder.h"
 #include "video_streamer.h"
@@ -25,11 +28,14 @@ class VideoStreamer;
 class Camera : public QObject {
     Q_OBJECT
 public:
-    explicit Camera(QStringList& names, QObject* parent = nullptr);
+    explicit Camera(QStringList& names, const QString& backendType = QString(), QObject* parent = nullptr);
     ~Camera();
 
     const QList<CameraFrameInfo*>& getCameras() const;
+    const QList<StreamFrameInfo*>& getStreamInfos() const;
+    const QList<RecordFrameInfo*>& getRecordInfos() const;
     QStringList getCameraNames() const;
+    CameraParameters cameraParameters(const QString& cameraName) const;
     void setCameraNames(const QStringList& names);
 
 public slots:
@@ -40,12 +46,20 @@ public slots:
     void startStreamingSlot(const QString& cameraName, int port);
     void stopStreamingSlot(const QString& cameraName);
     void stereoShotSlot();
+    // Снимок по запросу автоматики: ответ stereoShotRequestHandled с тем же requestId
+    void stereoShotRequestSlot(quint64 requestId);
+    // Управление отдельной камерой, остальные камеры продолжают работу без перерыва
+    void addCameraSlot(const QString& cameraName);
+    void removeCameraSlot(const QString& cameraName);
+    void restartCameraSlot(const QString& cameraName);
+    // Экспозиция, усиление и частота применяются на ходу, смена геометрии перезапускает захват камеры
+    void setCameraParametersSlot(const QString& cameraName, const CameraParameters& parameters);
 
 signals:
     void frameReady(CameraFrameInfo* camera);
     void errorOccurred(const QString& component, const QString& message);
     void greatSuccess(const QString& component, const QString& message);
-    void reconnectDone(Camera* camera);
+    void cameraConnectionChanged(const QString& cameraName, bool connected);
     void recordingStarted(CameraFrameInfo* camera);
     void recordingFinished(CameraFrameInfo* camera);
     void recordingFailed(const QString& reason);
@@ -54,37 +68,96 @@ signals:
     void streamingFailed(const QString& reason);
     void stereoShotSaved(const QString& filePaths);
     void stereoShotFailed(const QString& reason);
+    // Пара и показатели качества записаны (accepted) или снимка нет: серия уже идёт,
+    // нет камер или новых кадров, ошибка записи
+    void stereoShotRequestHandled(quint64 requestId, bool accepted);
     void finished();
 
 private:
     QStringList m_cameraNames;
+    QString m_backendType;            // Источник кадров: mvs, synthetic, replay
     QList<CameraFrameInfo*> m_cameras;
     QList<StreamFrameInfo*> m_streamInfos;
     QList<RecordFrameInfo*> m_recordInfos;
     MV_CC_DEVICE_INFO_LIST m_deviceList;
-    QTimer* m_checkCameraTimer;
-    int m_reconnectAttempts;
-    const int m_maxReconnectAttempts;
-    std::set<unsigned int> m_usedIPs;
+    std::map<unsigned int, QString> m_usedIPs; // IP -> имя камеры
     std::filesystem::path m_sessionDirectory; // Путь к сессионной папке
 
-    int checkCameras();
-    void initializeCameras();
-    void reinitializeCameras();
+    // Состояние подключения камеры. Каждая камера переподключается по своему таймеру
+    // с растущей паузой, остальные камеры (захват, запись, стриминг) при этом не трогаются
+    enum class LinkState { Idle, Connecting, Running, Backoff };
+    struct ReconnectState {
+        LinkState state = LinkState::Idle;
+        int attempt = 0;          // Число неудачных попыток подряд
+        bool online = false;      // С момента подключения получен хотя бы один кадр
+        bool recording = false;   // Запись включена, кадры нового worker'а нужно отдать recorder'у
+        quint64 generation = 0;   // Номер подключения, растёт с каждым новым worker'ом
+        bool stopping = false;    // Поток захвата ещё завершается после disconnectCamera()
+        bool connectPending = false; // Подключение запрошено до остановки потока захвата
+        QTimer* timer = nullptr;
+    };
+    QList<ReconnectState> m_reconnect;
+    QList<CameraParameters> m_parameters;  // Параметры изображения, применяются при каждом подключении
+    QTimer* m_discoveryTimer;             // Поиск появившихся устройств, пока есть ожидающие камеры (MVS)
+
+    // Серия стереокадров: из нескольких пар подряд сохраняется пара с лучшей оценкой
+    // FrameQualityMeter::pairScore. В памяти только лучшая пара, а не вся серия.
+    struct StereoBurst {
+        bool active = false;
+        int target = 1;                   // Пар в серии
+        qint64 deadlineNs = 0;            // Не набралось пар к этому времени - сохраняется лучшая из снятых
+        quint64 lastIndex[2] = {0, 0};    // Номера кадров L и R в последней взятой паре
+        std::vector<double> scores;       // Оценки всех пар серии
+        int best = -1;
+        cv::Mat left;
+        cv::Mat right;
+        FrameQuality leftQuality;
+        FrameQuality rightQuality;
+        quint64 requestId = 0;            // Запрос автоматики, 0 - ручной снимок
+    };
+    StereoBurst m_stereoBurst;
+    QTimer* m_stereoBurstTimer;
+
+    static constexpr int RECONNECT_INITIAL_DELAY_MS = 1000;
+    static constexpr int RECONNECT_MAX_DELAY_MS = 30000;
+    static constexpr int DISCOVERY_INTERVAL_MS = 3000;
+    static constexpr int STEREO_BURST_POLL_MS = 5;
+
+    int createCameraSlot(const QString& name);
+    int indexOf(const QString& cameraName) const;
+    static QString deviceName(const MV_CC_DEVICE_INFO* device);
+    static QString deviceSerial(const MV_CC_DEVICE_INFO* device);
+    int findMvsDevice(const CameraFrameInfo* frameInfo) const;
+    bool enumerateMvsDevices();
+    void discoverCameras();
+    bool openBackend(CameraFrameInfo* frameInfo);
+    static TransportProfile loadTransportProfile(const QString& cameraName);
+    static AutoExposureSettings loadAutoExposureSettings(const QString& cameraName);
+    static EnhancementSettings loadEnhancementSettings(const QString& cameraName);
+    static StabilizationSettings loadStabilizationSettings(const QString& cameraName);
+    static FrameQualitySettings loadQualitySettings();
+    bool applyTransportProfile(CameraFrameInfo* frameInfo, const TransportProfile& profile);
+    void connectCamera(int index);
+    void startCapture(int index);
+    void disconnectCamera(int index);
+    void finishDisconnect(int index);
+    void scheduleReconnect(int index);
     void start();
     void stopAll();
     void startRecording(const QString& cameraName, int recordInterval, int storedVideoFilesLimit);
     void stopRecording(const QString& cameraName);
     void startStreaming(const QString& cameraName, int port);
     void stopStreaming(const QString& cameraName);
-    void stereoShot();
+    void stereoShot(quint64 requestId = 0);
+    bool findStereoStreams(StreamFrameInfo*& left, StreamFrameInfo*& right);
+    void collectStereoBurst();
+    void finishStereoBurst();
+    bool saveStereoShot();
     int destroyCameras(void* handle);
     void getHandle(unsigned int cameraID, void** handle, const std::string& cameraName);
-    void cleanupAllCameras();
-    void reconnectCameras();
-    void handleCaptureFailure(const QString& reason);
-    void handleRecordingFailure(const QString& reason);
-    void handleStreamingFailure(const QString& reason);
+    void handleCaptureFailure(int index, const QString& reason);
+    void handleRecordingFailure(const QString& cameraName, const QString& reason);
+    void handleStreamingFailure(const QString& cameraName, const QString& reason);
 };
 
 #endif // CAMERA_H
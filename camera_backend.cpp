@@ -0,0 +1,62 @@
+#include "camera_backend.h"
+#include <chrono>
+
+bool CameraParameters::sameGeometry(const CameraParameters& other) const {
+    return roiX == other.roiX && roiY == other.roiY && roiWidth == other.roiWidth && roiHeight == other.roiHeight
+           && binning == other.binning && decimation == other.decimation;
+}
+
+QJsonObject CameraParameters::toJson() const {
+    QJsonObject object;
+    object["exposure_us"] = exposureUs;
+    object["gain_db"] = gainDb;
+    object["frame_rate"] = frameRate;
+    object["roi_x"] = roiX;
+    object["roi_y"] = roiY;
+    object["roi_width"] = roiWidth;
+    object["roi_height"] = roiHeight;
+    object["binning"] = binning;
+    object["decimation"] = decimation;
+    return object;
+}
+
+CameraParameters CameraParameters::fromJson(const QJsonObject& object) {
+    // Биннинг и прореживание камеры Hikrobot поддерживают только 1, 2 и 4
+    auto factor = [](int value) { return value >= 4 ? 4 : (value >= 2 ? 2 : 1); };
+
+    CameraParameters parameters;
+    parameters.exposureUs = qMax(0.0, object["exposure_us"].toDouble(parameters.exposureUs));
+    parameters.gainDb = object["gain_db"].toDouble(parameters.gainDb);
+    parameters.frameRate = qMax(0.0, object["frame_rate"].toDouble(parameters.frameRate));
+    parameters.roiX = qMax(0, object["roi_x"].toInt(parameters.roiX));
+    parameters.roiY = qMax(0, object["roi_y"].toInt(parameters.roiY));
+    parameters.roiWidth = qMax(0, object["roi_width"].toInt(parameters.roiWidth));
+    parameters.roiHeight = qMax(0, object["roi_height"].toInt(parameters.roiHeight));
+    parameters.binning = factor(object["binning"].toInt(parameters.binning));
+    parameters.decimation = factor(object["decimation"].toInt(parameters.decimation));
+    return parameters;
+}
+
+qint64 CameraBackend::monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CameraBackend::mosaicBayerRG(const cv::Mat& bgr, unsigned char* dst) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    for (int y = 0; y < bgr.rows; ++y) {
+        const cv::Vec3b* src = bgr.ptr<cv::Vec3b>(y);
+        unsigned char* out = dst + static_cast<size_t>(y) * bgr.cols;
+        if ((y & 1) == 0) {
+            // R G R G ...
+            for (int x = 0; x < bgr.cols; ++x) {
+                out[x] = (x & 1) ? src[x][1] : src[x][2];
+            }
+        } else {
+            // G B G B ...
+            for (int x = 0; x < bgr.cols; ++x) {
+                out[x] = (x & 1) ? src[x][0] : src[x][1];
+            }
+        }
+    }
+}
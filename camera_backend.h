@@ -0,0 +1,101 @@
+#ifndef CAMERA_BACKEND_H
+#define CAMERA_BACKEND_H
+
+#include <QJsonObject>
+#include <QMetaType>
+#include <QString>
+#include <QtGlobal>
+#include <opencv2/opencv.hpp>
+#include "MvCameraControl.h"
+
+// Кадр, полученный от источника. Данные принадлежат источнику до releaseFrame().
+struct RawFrame {
+    unsigned char* data = nullptr;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int frameNum = 0;          // Номер кадра источника
+    unsigned int pixelType = PixelType_Gvsp_BayerRG8;
+    qint64 timestampNs = 0;             // Монотонное время получения кадра
+    MV_FRAME_OUT mvFrame = {0};         // Служебные данные MVS-источника
+};
+
+// Параметры изображения камеры. Нулевые значения (и отрицательное усиление) означают
+// "не менять", поэтому пустой набор оставляет камеру в её собственных настройках.
+// Экспозиция, усиление и частота меняются на ходу, геометрия (ROI, биннинг, прореживание) -
+// только с перезапуском захвата.
+struct CameraParameters {
+    double exposureUs = 0;   // ExposureTime, мкс
+    double gainDb = -1;      // Gain, дБ
+    double frameRate = 0;    // AcquisitionFrameRate, к/с
+    int roiX = 0;            // ROI на сенсоре до биннинга; ширина/высота 0 - до края сенсора
+    int roiY = 0;
+    int roiWidth = 0;
+    int roiHeight = 0;
+    int binning = 1;         // BinningHorizontal/Vertical: 1, 2, 4
+    int decimation = 1;      // DecimationHorizontal/Vertical: 1, 2, 4
+
+    bool sameGeometry(const CameraParameters& other) const;
+    QJsonObject toJson() const;
+    static CameraParameters fromJson(const QJsonObject& object);
+};
+Q_DECLARE_METATYPE(CameraParameters)
+
+// Параметры транспорта камеры. Для GigE-камер MVS применяются при открытии устройства,
+// приоритет потока захвата - для любого источника.
+struct TransportProfile {
+    int packetSize = 0;             // GevSCPSPacketSize, 0 - оптимальный по MV_CC_GetOptimalPacketSize
+    int packetDelay = 0;            // GevSCPD, задержка между пакетами в тиках камеры
+    int imageNodes = 8;             // Число буферов кадров в SDK
+    bool resend = true;             // Повторная передача потерянных пакетов
+    int resendMaxPercent = 10;      // Доля пакетов кадра, которую разрешено запрашивать повторно
+    int resendTimeoutMs = 50;
+    int grabThreadPriority = 5;     // QThread::Priority потока захвата (5 - HighPriority)
+};
+
+// Счётчики потерь на стороне источника. Для MVS - статистика приёма GigE из SDK,
+// накапливается с момента открытия камеры.
+struct TransportStats {
+    quint64 lostPackets = 0;
+    quint64 lostFrames = 0;
+    quint64 receivedFrames = 0;
+    quint64 resendRequested = 0;
+    quint64 resent = 0;
+};
+
+// Источник кадров для CameraWorker. Коды возврата совместимы с MVS SDK (MV_OK, MV_E_NODATA, ...),
+// чтобы логика повторов в CameraWorker не зависела от типа источника.
+class CameraBackend {
+public:
+    virtual ~CameraBackend() = default;
+
+    virtual QString typeName() const = 0;
+    virtual int startGrabbing() = 0;
+    virtual int grabFrame(RawFrame& frame, unsigned int timeoutMs) = 0;
+    virtual void releaseFrame(RawFrame& frame) = 0;
+    virtual int stopGrabbing() = 0;
+    virtual int close() = 0;
+    virtual bool isOpen() const = 0;
+    // Применение параметров изображения. geometry == true только при остановленном захвате.
+    // Возвращает MV_OK или код первой ошибки; неподдерживаемые источником поля пропускаются.
+    virtual int applyParameters(const CameraParameters& parameters, bool geometry) {
+        Q_UNUSED(parameters); Q_UNUSED(geometry); return MV_E_SUPPORT;
+    }
+    // Выдержка и усиление для автоэкспозиции: вызываются из потока захвата на каждом шаге
+    // регулятора, поэтому пишут только эти два узла
+    virtual int setExposure(double exposureUs, double gainDb) {
+        Q_UNUSED(exposureUs); Q_UNUSED(gainDb); return MV_E_SUPPORT;
+    }
+    virtual int getExposure(double& exposureUs, double& gainDb) const {
+        Q_UNUSED(exposureUs); Q_UNUSED(gainDb); return MV_E_SUPPORT;
+    }
+    // false, если источник не ведёт статистику транспорта
+    virtual bool transportStats(TransportStats& stats) const { Q_UNUSED(stats); return false; }
+
+    // Монотонное время в наносекундах, общее для всех источников
+    static qint64 monotonicNs();
+
+    // Мозаика BGR -> BayerRG8 для источников, не отдающих сырые кадры
+    static void mosaicBayerRG(const cv::Mat& bgr, unsigned char* dst);
+};
+
+#endif // CAMERA_BACKEND_H
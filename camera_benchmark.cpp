@@ -0,0 +1,302 @@
+#include "camera_benchmark.h"
+#include "camera.h"
+#include "SettingsManager.h"
+#include "synthetic_camera_backend.h"
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <cmath>
+
+CameraBenchmark::CameraBenchmark(int durationSec, const QString& backendType, const QString& failCamera,
+                                 int failMs, unsigned int dropEvery, bool autoExposure, bool enhance,
+                                 bool stabilize, QObject* parent)
+    : QObject(parent), m_durationSec(qMax(1, durationSec)), m_backendType(backendType),
+    m_failCamera(failCamera), m_failMs(qMax(0, failMs)), m_dropEvery(dropEvery),
+    m_autoExposure(autoExposure), m_enhance(enhance), m_stabilize(stabilize),
+    m_names({"LCamera", "RCamera"}) {}
+
+CameraBenchmark::~CameraBenchmark() {
+    m_cameraThread.quit();
+    m_cameraThread.wait();
+}
+
+void CameraBenchmark::run() {
+    qInfo() << "[CameraBenchmark] Источник" << m_backendType << ", длительность" << m_durationSec << "с";
+
+    if (m_dropEvery == 1) {
+        qWarning() << "[CameraBenchmark] Каждый 1-й кадр потерять нельзя, имитация потерь выключена";
+        m_dropEvery = 0;
+    }
+    if (m_dropEvery > 0) {
+        if (m_backendType == "synthetic") {
+            SyntheticCameraBackend::setDropInjection(m_dropEvery);
+        } else {
+            qWarning() << "[CameraBenchmark] Потери кадров имитируются только для синтетического источника";
+            m_dropEvery = 0;
+        }
+    }
+
+    if (m_autoExposure) {
+        // Только в памяти: файл настроек замер не сохраняет
+        SettingsManager::instance().setBool("Camera_ae_enabled", true);
+    }
+    if (m_enhance) {
+        SettingsManager::instance().setBool("Camera_enhance_display", true);
+        SettingsManager::instance().setBool("Camera_enhance_stream", true);
+        SettingsManager::instance().setBool("Camera_enhance_record", true);
+    }
+    if (m_stabilize) {
+        SettingsManager::instance().setBool("Camera_stabilize_stream", true);
+        SettingsManager::instance().setBool("Camera_stabilize_record", true);
+    }
+
+    m_camera = new Camera(m_names, m_backendType);
+    m_camera->moveToThread(&m_cameraThread);
+    connect(&m_cameraThread, &QThread::finished, m_camera, &QObject::deleteLater);
+    m_cameraThread.start();
+
+    QMetaObject::invokeMethod(m_camera, &Camera::startCamera, Qt::QueuedConnection);
+    for (int i = 0; i < m_names.size(); ++i) {
+        const QString name = m_names[i];
+        const int port = STREAM_BASE_PORT + i;
+        QMetaObject::invokeMethod(m_camera, [this, name, port]() {
+            m_camera->startRecordingSlot(name, 120, 0);
+            m_camera->startStreamingSlot(name, port);
+        }, Qt::QueuedConnection);
+    }
+
+    // Клиенты трансляции только вычитывают поток, иначе сервер упрётся в буфер сокета
+    QTimer::singleShot(WARMUP_MS / 2, this, [this]() {
+        for (int i = 0; i < m_names.size(); ++i) {
+            QTcpSocket* client = new QTcpSocket(this);
+            const QByteArray request = "GET /" + m_names[i].toUtf8() + " HTTP/1.1\r\n\r\n";
+            connect(client, &QTcpSocket::connected, client, [client, request]() {
+                client->write(request);
+            });
+            connect(client, &QTcpSocket::readyRead, client, [client]() {
+                client->readAll();
+            });
+            client->connectToHost("127.0.0.1", STREAM_BASE_PORT + i);
+            m_clients.append(client);
+        }
+    });
+
+    QTimer::singleShot(WARMUP_MS, this, &CameraBenchmark::startMeasurement);
+}
+
+QVector<CameraBenchmark::Counters> CameraBenchmark::snapshot() const {
+    QVector<Counters> result(m_names.size());
+    const QList<CameraFrameInfo*>& cameras = m_camera->getCameras();
+    const QList<StreamFrameInfo*>& streamInfos = m_camera->getStreamInfos();
+    const QList<RecordFrameInfo*>& recordInfos = m_camera->getRecordInfos();
+    for (int i = 0; i < m_names.size(); ++i) {
+        for (int j = 0; j < cameras.size(); ++j) {
+            if (cameras[j]->name != m_names[i]) continue;
+            result[i].captured = cameras[j]->capturedFrames;
+            result[i].written = recordInfos[j]->writtenFrames;
+            result[i].sent = streamInfos[j]->sentFrames;
+            result[i].sentBytes = streamInfos[j]->sentBytes;
+            result[i].frameGaps = cameras[j]->frameNumberGaps;
+            result[i].lostFrames = cameras[j]->lostFrames;
+            result[i].lostPackets = cameras[j]->lostPackets;
+            result[i].aeMeteredFrames = cameras[j]->aeMeteredFrames;
+            result[i].aeMeteringNs = cameras[j]->aeMeteringNs;
+            result[i].aeMaxMeteringNs = cameras[j]->aeMaxMeteringNs;
+            result[i].aeLevel = cameras[j]->aeLevel;
+            result[i].enhancedFrames = cameras[j]->enhancedFrames;
+            result[i].enhanceNs = cameras[j]->enhanceNs;
+            result[i].stabilizedFrames = cameras[j]->stabilizedFrames;
+            result[i].stabilizeNs = cameras[j]->stabilizeNs;
+            result[i].qualityFrames = cameras[j]->qualityFrames;
+            result[i].qualityNs = cameras[j]->qualityNs;
+        }
+    }
+    return result;
+}
+
+void CameraBenchmark::startMeasurement() {
+    m_start = snapshot();
+    m_timer.start();
+
+    m_gaps = QVector<WriteGap>(m_names.size());
+    for (int i = 0; i < m_names.size(); ++i) {
+        m_gaps[i].lastWritten = m_start[i].written;
+        m_gaps[i].lastChangeNs = m_timer.nsecsElapsed();
+    }
+    m_gapTimer = new QTimer(this);
+    m_gapTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_gapTimer, &QTimer::timeout, this, &CameraBenchmark::sampleWriteGaps);
+    m_gapTimer->start(GAP_SAMPLE_MS);
+
+    if (!m_failCamera.isEmpty()) {
+        if (m_backendType != "synthetic") {
+            qWarning() << "[CameraBenchmark] Пропадание камеры имитируется только для синтетического источника";
+        } else {
+            if (m_durationSec * 1000 < m_failMs * 2) {
+                qWarning() << "[CameraBenchmark] Замер короче двойной длительности пропадания, переподключение может не успеть";
+            }
+            QTimer::singleShot(m_durationSec * 1000 / 4, this, [this]() {
+                SyntheticCameraBackend::simulateOutage(m_failCamera, m_failMs);
+            });
+        }
+    }
+
+    if (m_autoExposure && m_backendType == "synthetic") {
+        if (m_durationSec * 1000 * 3 / 4 < AE_SETTLE_MS) {
+            qWarning() << "[CameraBenchmark] Замер слишком короткий, автоэкспозиция может не успеть подстроиться";
+        }
+        QTimer::singleShot(m_durationSec * 1000 / 4, this, []() {
+            SyntheticCameraBackend::setSceneBrightness(AE_SCENE_BRIGHTNESS);
+        });
+    }
+
+    QTimer::singleShot(m_durationSec * 1000, this, &CameraBenchmark::report);
+}
+
+void CameraBenchmark::sampleWriteGaps() {
+    const qint64 nowNs = m_timer.nsecsElapsed();
+    const QVector<Counters> current = snapshot();
+    for (int i = 0; i < m_names.size(); ++i) {
+        WriteGap& gap = m_gaps[i];
+        if (current[i].written != gap.lastWritten) {
+            gap.maxGapNs = qMax(gap.maxGapNs, nowNs - gap.lastChangeNs);
+            gap.lastWritten = current[i].written;
+            gap.lastChangeNs = nowNs;
+        }
+    }
+}
+
+void CameraBenchmark::report() {
+    m_gapTimer->stop();
+    sampleWriteGaps();
+    const double seconds = m_timer.nsecsElapsed() / 1e9;
+    const QVector<Counters> end = snapshot();
+
+    QTextStream out(stdout);
+    out << QString("Источник: %1, интервал: %2 с\n").arg(m_backendType).arg(seconds, 0, 'f', 2);
+    if (!m_failCamera.isEmpty()) {
+        out << QString("Имитация пропадания: %1 на %2 мс\n").arg(m_failCamera).arg(m_failMs);
+    }
+    if (m_dropEvery > 0) {
+        out << QString("Имитация потерь: каждый %1-й кадр\n").arg(m_dropEvery);
+    }
+    if (m_autoExposure) {
+        out << QString("Автоэкспозиция: цель %1, затемнение сцены x%2\n")
+                   .arg(SettingsManager::instance().getInt("Camera_ae_target", 100)).arg(AE_SCENE_BRIGHTNESS);
+    }
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg("Камера", -10).arg("Захват к/с", 12).arg("Запись к/с", 12)
+               .arg("Трансл. к/с", 12).arg("Трансл. Мбит/с", 15).arg("Пауза записи, мс", 17)
+               .arg("Разрывы №", 10).arg("Потеряно кадров", 16).arg("Потеряно пакетов", 17);
+    int exitCode = 0;
+    for (int i = 0; i < m_names.size(); ++i) {
+        const double captureFps = (end[i].captured - m_start[i].captured) / seconds;
+        const double recordFps = (end[i].written - m_start[i].written) / seconds;
+        const double streamFps = (end[i].sent - m_start[i].sent) / seconds;
+        const double streamMbit = (end[i].sentBytes - m_start[i].sentBytes) * 8.0 / 1e6 / seconds;
+        // Пауза, не закрытая к концу замера (камера так и не вернулась), тоже учитывается
+        const qint64 gapNs = qMax(m_gaps[i].maxGapNs, m_timer.nsecsElapsed() - m_gaps[i].lastChangeNs);
+        const double gapMs = gapNs / 1e6;
+        // Счётчики потерь накапливаются с момента подключения камеры, а не с начала замера
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                   .arg(m_names[i], -10)
+                   .arg(captureFps, 12, 'f', 2).arg(recordFps, 12, 'f', 2)
+                   .arg(streamFps, 12, 'f', 2).arg(streamMbit, 15, 'f', 2).arg(gapMs, 17, 'f', 1)
+                   .arg(end[i].frameGaps, 10).arg(end[i].lostFrames, 16).arg(end[i].lostPackets, 17);
+        qInfo().nospace() << "[CameraBenchmark] " << m_names[i] << ": захват " << captureFps
+                          << " к/с, запись " << recordFps << " к/с, трансляция " << streamFps
+                          << " к/с (" << streamMbit << " Мбит/с), максимальная пауза записи " << gapMs << " мс";
+        if (captureFps <= 0) exitCode = 1;
+
+        // Проверка учёта разрывов: на N-1 выданных кадров приходится один пропущенный номер
+        if (m_dropEvery > 0 && m_failCamera.isEmpty()) {
+            const double expectedGaps = double(end[i].captured) / (m_dropEvery - 1);
+            if (end[i].frameGaps == 0 || std::abs(double(end[i].frameGaps) - expectedGaps) > 2.0) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": насчитано разрывов " << end[i].frameGaps
+                                     << ", ожидалось около " << expectedGaps;
+                exitCode = 1;
+            }
+        }
+
+        // Проверка автоэкспозиции: замер укладывается во время, яркость вернулась к цели
+        if (m_autoExposure) {
+            const quint64 metered = end[i].aeMeteredFrames - m_start[i].aeMeteredFrames;
+            const double meanUs = metered ? (end[i].aeMeteringNs - m_start[i].aeMeteringNs) / 1e3 / metered : 0;
+            const int target = SettingsManager::instance().getInt("Camera_ae_target", 100);
+            out << QString("%1 автоэкспозиция: замер %2 мкс (макс. %3 мкс), яркость %4 при цели %5\n")
+                       .arg(m_names[i], -10).arg(meanUs, 0, 'f', 1).arg(end[i].aeMaxMeteringNs / 1e3, 0, 'f', 1)
+                       .arg(end[i].aeLevel).arg(target);
+            if (metered == 0 || meanUs * 1000 > AE_MAX_METERING_NS) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": замер автоэкспозиции " << meanUs
+                                     << " мкс на кадр, допустимо " << AE_MAX_METERING_NS / 1000;
+                exitCode = 1;
+            }
+            if (m_backendType == "synthetic" && std::abs(end[i].aeLevel - target) > target * 0.15) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": яркость " << end[i].aeLevel
+                                     << " не вернулась к цели " << target;
+                exitCode = 1;
+            }
+        }
+
+        // Проверка коррекции цвета: среднее время на кадр меньше периода кадра источника
+        if (m_enhance) {
+            const quint64 enhanced = end[i].enhancedFrames - m_start[i].enhancedFrames;
+            const double meanMs = enhanced ? (end[i].enhanceNs - m_start[i].enhanceNs) / 1e6 / enhanced : 0;
+            const double periodMs = captureFps > 0 ? 1000.0 / captureFps : 0;
+            out << QString("%1 коррекция цвета: %2 мс на кадр при периоде %3 мс\n")
+                       .arg(m_names[i], -10).arg(meanMs, 0, 'f', 2).arg(periodMs, 0, 'f', 2);
+            if (enhanced == 0 || meanMs > periodMs) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": коррекция " << meanMs
+                                     << " мс не укладывается в период кадра " << periodMs << " мс";
+                exitCode = 1;
+            }
+            const double sourceFps = SettingsManager::instance().getDouble("Camera_synthetic_fps", 20.0);
+            if (m_backendType == "synthetic" && captureFps < sourceFps * 0.9) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": захват " << captureFps
+                                     << " к/с отстаёт от источника " << sourceFps << " к/с";
+                exitCode = 1;
+            }
+        }
+
+        // Проверка оценки качества: доля времени одного ядра, которую она занимает
+        const quint64 measured = end[i].qualityFrames - m_start[i].qualityFrames;
+        if (measured > 0) {
+            const double corePercent = (end[i].qualityNs - m_start[i].qualityNs) / 1e9 / seconds * 100;
+            out << QString("%1 оценка качества: %2 мс на кадр, %3% ядра\n")
+                       .arg(m_names[i], -10).arg((end[i].qualityNs - m_start[i].qualityNs) / 1e6 / measured, 0, 'f', 3)
+                       .arg(corePercent, 0, 'f', 2);
+            if (corePercent > QUALITY_MAX_CORE_PERCENT) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": оценка качества занимает " << corePercent
+                                     << "% ядра, допустимо " << QUALITY_MAX_CORE_PERCENT << "%";
+                exitCode = 1;
+            }
+        }
+
+        // Проверка стабилизации: оценка движения и поворот кадров успевают за периодом кадра
+        if (m_stabilize) {
+            const quint64 stabilized = end[i].stabilizedFrames - m_start[i].stabilizedFrames;
+            const double meanMs = stabilized ? (end[i].stabilizeNs - m_start[i].stabilizeNs) / 1e6 / stabilized : 0;
+            const double periodMs = captureFps > 0 ? 1000.0 / captureFps : 0;
+            out << QString("%1 стабилизация: %2 мс на кадр при периоде %3 мс\n")
+                       .arg(m_names[i], -10).arg(meanMs, 0, 'f', 2).arg(periodMs, 0, 'f', 2);
+            if (stabilized == 0 || meanMs > periodMs) {
+                qWarning().nospace() << "[CameraBenchmark] " << m_names[i] << ": стабилизация " << meanMs
+                                     << " мс не укладывается в период кадра " << periodMs << " мс";
+                exitCode = 1;
+            }
+        }
+    }
+    out.flush();
+
+    for (QTcpSocket* client : m_clients) {
+        client->abort();
+    }
+    for (const QString& name : m_names) {
+        QMetaObject::invokeMethod(m_camera, [this, name]() {
+            m_camera->stopStreamingSlot(name);
+            m_camera->stopRecordingSlot(name);
+        }, Qt::BlockingQueuedConnection);
+    }
+    QMetaObject::invokeMethod(m_camera, &Camera::stopAllCameras, Qt::BlockingQueuedConnection);
+    emit finished(exitCode);
+}
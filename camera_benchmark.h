@@ -0,0 +1,98 @@
+#ifndef CAMERA_BENCHMARK_H
+#define CAMERA_BENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+class Camera;
+class QTcpSocket;
+
+// Замер пропускной способности конвейера захват -> запись -> трансляция.
+// Работает с синтетическим источником или воспроизведением, поэтому повторяем без камер.
+// С failCamera одна синтетическая камера на время пропадает, а замер показывает
+// самую длинную паузу записи по каждой камере. С dropEvery синтетический источник теряет
+// каждый N-й кадр, а замер проверяет, что конвейер насчитал столько же разрывов в номерах кадров.
+// С autoExposure включается автоэкспозиция, сцена синтетического источника затемняется
+// (как при выключении фар), а замер проверяет возврат яркости к цели и время замера гистограммы.
+// С enhance коррекция цвета включается для окна, трансляции и записи, а замер проверяет,
+// что она укладывается в период кадра и захват не отстаёт от источника.
+// С stabilize так же проверяется стабилизация трансляции и записи.
+// Оценка качества кадров включена по умолчанию, её доля времени ядра проверяется всегда.
+class CameraBenchmark : public QObject {
+    Q_OBJECT
+public:
+    CameraBenchmark(int durationSec, const QString& backendType, const QString& failCamera = QString(),
+                    int failMs = 3000, unsigned int dropEvery = 0, bool autoExposure = false, bool enhance = false,
+                    bool stabilize = false, QObject* parent = nullptr);
+    ~CameraBenchmark();
+
+public slots:
+    void run();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Counters {
+        quint64 captured = 0;
+        quint64 written = 0;
+        quint64 sent = 0;
+        quint64 sentBytes = 0;
+        quint64 frameGaps = 0;
+        quint64 lostFrames = 0;
+        quint64 lostPackets = 0;
+        quint64 aeMeteredFrames = 0;
+        qint64 aeMeteringNs = 0;
+        qint64 aeMaxMeteringNs = 0;
+        int aeLevel = -1;
+        quint64 enhancedFrames = 0;
+        qint64 enhanceNs = 0;
+        quint64 stabilizedFrames = 0;
+        qint64 stabilizeNs = 0;
+        quint64 qualityFrames = 0;
+        qint64 qualityNs = 0;
+    };
+
+    struct WriteGap {
+        quint64 lastWritten = 0;
+        qint64 lastChangeNs = 0;
+        qint64 maxGapNs = 0;
+    };
+
+    static const int WARMUP_MS = 3000;
+    static const int STREAM_BASE_PORT = 18080;
+    static const int GAP_SAMPLE_MS = 5;
+    static constexpr double AE_SCENE_BRIGHTNESS = 0.4;   // Затемнение сцены в проверке автоэкспозиции
+    static constexpr qint64 AE_MAX_METERING_NS = 500000; // Допустимое среднее время замера кадра
+    static const int AE_SETTLE_MS = 3000;                // Время на подстройку после затемнения
+    static constexpr double QUALITY_MAX_CORE_PERCENT = 1.0; // Допустимая доля ядра на оценку качества одной камеры
+
+    QVector<Counters> snapshot() const;
+    void startMeasurement();
+    void sampleWriteGaps();
+    void report();
+
+    int m_durationSec;
+    QString m_backendType;
+    QString m_failCamera;
+    int m_failMs;
+    unsigned int m_dropEvery;
+    bool m_autoExposure;
+    bool m_enhance;
+    bool m_stabilize;
+    QStringList m_names;
+    Camera* m_camera = nullptr;
+    QThread m_cameraThread;
+    QList<QTcpSocket*> m_clients;
+    QVector<Counters> m_start;
+    QElapsedTimer m_timer;
+    QTimer* m_gapTimer = nullptr;
+    QVector<WriteGap> m_gaps;
+};
+
+#endif // CAMERA_BENCHMARK_H
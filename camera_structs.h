@@ -8,6 +8,9 @@
 #include <opencv2/opencv.hpp>
 #include "MvCameraControl.h"
 #include <filesystem>
+#include <atomic>
+#include "camera_backend.h"
+#include "frame_quality.h"
 
 class CameraWorker;
 class FrameProcessor;
@@ -18,19 +21,39 @@ class VideoStreamer;
 struct CameraFrameInfo {
     QString name;                     // Имя камеры (LCamera, RCamera, UCamera, DCamera и т.д.)
     unsigned int id = -1;             // ID камеры в списке устройств
-    void* handle = nullptr;           // Дескриптор камеры
+    QString serialNumber;             // Серийный номер (только для MVS), запоминается при первом подключении
+    void* handle = nullptr;           // Дескриптор камеры (только для MVS)
+    CameraBackend* backend = nullptr; // Источник кадров (MVS, синтетический, воспроизведение)
     MV_DISPLAY_FRAME_INFO frame;      // Данные кадра
     QMutex* mutex = nullptr;          // Указатель на мьютекс для синхронизации
     CameraWorker* worker = nullptr;   // Рабочий объект для захвата
     QThread* thread = nullptr;        // Поток для захвата
     WId labelWinId = 0;               // Дескриптор окна для отображения
     QImage img;
+    FrameQuality quality;             // Показатели качества последнего кадра, под mutex
+    std::atomic<quint64> capturedFrames{0}; // Счётчик захваченных кадров
+    std::atomic<qint64> lastFrameNs{0};     // Монотонное время последнего кадра
+    std::atomic<quint64> frameNumberGaps{0}; // Кадров пропущено по номерам источника (nFrameNum)
+    std::atomic<quint64> lostPackets{0};     // Потери по статистике транспорта источника
+    std::atomic<quint64> lostFrames{0};
+    std::atomic<quint64> resendRequested{0};
+    std::atomic<quint64> aeMeteredFrames{0};  // Кадров, прошедших замер автоэкспозиции
+    std::atomic<qint64> aeMeteringNs{0};      // Суммарное время замера, нс
+    std::atomic<qint64> aeMaxMeteringNs{0};
+    std::atomic<int> aeLevel{-1};             // Средняя яркость зоны замера по последнему кадру
+    std::atomic<quint64> enhancedFrames{0};   // Кадров, прошедших коррекцию цвета
+    std::atomic<qint64> enhanceNs{0};         // Суммарное время коррекции, нс
+    std::atomic<quint64> stabilizedFrames{0}; // Кадров, прошедших стабилизацию
+    std::atomic<qint64> stabilizeNs{0};       // Суммарное время стабилизации, нс
+    std::atomic<quint64> qualityFrames{0};    // Кадров, прошедших оценку качества
+    std::atomic<qint64> qualityNs{0};         // Суммарное время оценки качества, нс
 
     CameraFrameInfo() {
         mutex = new QMutex();
     }
 
     ~CameraFrameInfo() {
+        delete backend;
         delete mutex;
     }
 };
@@ -40,14 +63,24 @@ struct StreamFrameInfo {
     QString name;                     // Имя камеры
     unsigned int id = -1;             // ID камеры в списке устройств
     cv::Mat img;                      // Текущий кадр для стриминга
+    // Кадр для стереоснимков при стабилизированной трансляции: img выравнивается отдельно
+    // для каждой камеры и отстаёт на упреждение, а пара должна сохранять эпиполярную
+    // геометрию калибровки. Без стабилизации пусто, снимок берётся из img
+    cv::Mat shotImg;
+    FrameQuality quality;             // Показатели качества кадра снимка (shotFrame())
+    quint64 frameIndex = 0;           // Растёт с каждым кадром камеры, под mutex
     QMutex* mutex = nullptr;          // Указатель на мьютекс для синхронизации
     VideoStreamer* streamer = nullptr; // Объект для стриминга видео
     QThread* streamerThread = nullptr; // Поток для стриминга видео
+    std::atomic<quint64> sentFrames{0};  // Счётчик отправленных кадров
+    std::atomic<quint64> sentBytes{0};   // Счётчик отправленных байт
 
     StreamFrameInfo() {
         mutex = new QMutex();
     }
 
+    const cv::Mat& shotFrame() const { return shotImg.empty() ? img : shotImg; }
+
     ~StreamFrameInfo() {
         delete mutex;
     }
@@ -62,6 +95,7 @@ struct RecordFrameInfo {
     VideoRecorder* recorder = nullptr; // Объект для записи видео
     QThread* recorderThread = nullptr; // Поток для записи видео
     std::filesystem::path sessionDirectory; // Путь к сессионной папке
+    std::atomic<quint64> writtenFrames{0};  // Счётчик записанных кадров
 
     RecordFrameInfo() {
         mutex = new QMutex();
@@ -1,4 +1,5 @@
 #include "camera_worker.h"
+#include "eventlog.h"
 
 CameraWorker::CameraWorker(CameraFrameInfo* frameInfo, StreamFrameInfo* streamInfo, RecordFrameInfo* recordInfo, QObject* parent)
     : QObject(parent), m_frameInfo(frameInfo), m_streamInfo(streamInfo), m_recordInfo(recordInfo), m_isRunning(true) {
@@ -17,7 +18,8 @@ void CameraWorker::stop() {
 void CameraWorker::capture() {
     qDebug() << "Начало потока захвата для камеры" << m_frameInfo->name;
 
-    if (!m_frameInfo->handle) {
+    CameraBackend* backend = m_frameInfo->backend;
+    if (!backend || !backend->isOpen()) {
         QString errorMsg = QString("Недействительный дескриптор камеры %1").arg(m_frameInfo->name);
         qDebug() << errorMsg;
         emit errorOccurred("CameraWorker", errorMsg);
@@ -32,7 +34,7 @@ void CameraWorker::capture() {
     int nRet = MV_OK;
 
     // Запуск захвата
-    nRet = MV_CC_StartGrabbing(m_frameInfo->handle);
+    nRet = backend->startGrabbing();
     if (nRet != MV_OK) {
         QString errorMsg = QString("Не удалось запустить захват для камеры %1. Ошибка: %2")
                                .arg(m_frameInfo->name).arg(nRet);
@@ -44,57 +46,134 @@ void CameraWorker::capture() {
     }
     QThread::msleep(100);
 
+    // Автоэкспозиция продолжает от текущих выдержки и усиления камеры
+    AutoExposure autoExposure(m_autoExposureSettings);
+    m_autoExposureActive = m_autoExposureSettings.enabled;
+    if (m_autoExposureActive) {
+        double exposureUs = 0;
+        double gainDb = 0;
+        if (backend->getExposure(exposureUs, gainDb) == MV_OK) {
+            autoExposure.reset(exposureUs, gainDb);
+        }
+        qDebug() << "Автоэкспозиция для камеры" << m_frameInfo->name << ": цель" << m_autoExposureSettings.target
+                 << ", выдержка" << exposureUs << "мкс, усиление" << gainDb << "дБ";
+    }
+
+    FrameEnhancer enhancer(m_enhancementSettings);
+    VideoStabilizer stabilizer(m_stabilizationSettings);
+    FrameQualityMeter qualityMeter(m_qualitySettings);
+    m_qualityTotals = QualityTotals();
+
     // Основной цикл захвата
-    MV_FRAME_OUT stOutFrame = {0};
+    RawFrame stOutFrame;
     int retryCount = 5;
+    bool hasFrameNum = false;
+    unsigned int lastFrameNum = 0;
+    qint64 nextStatsNs = 0;
     while (m_isRunning) {
         if (!m_isRunning) break;
 
-        nRet = MV_CC_GetImageBuffer(m_frameInfo->handle, &stOutFrame, 500);
-        if (nRet == MV_OK && stOutFrame.pBufAddr) {
+        if (CameraBackend::monotonicNs() >= nextStatsNs) {
+            nextStatsNs = CameraBackend::monotonicNs() + STATS_INTERVAL_NS;
+            updateTransportStats();
+        }
+
+        nRet = backend->grabFrame(stOutFrame, 500);
+        if (nRet == MV_OK && stOutFrame.data) {
+            // Разрыв в номерах кадров - кадр потерян до нас (в камере, сети или SDK)
+            if (hasFrameNum && stOutFrame.frameNum > lastFrameNum + 1) {
+                const unsigned int missed = stOutFrame.frameNum - lastFrameNum - 1;
+                m_frameInfo->frameNumberGaps += missed;
+                EventLog::record(EventId::FrameGap, {m_frameInfo->name, missed, stOutFrame.frameNum});
+            }
+            hasFrameNum = true;
+            lastFrameNum = stOutFrame.frameNum;
+
+            if (m_autoExposureActive) {
+                runAutoExposure(autoExposure, stOutFrame);
+            }
+            FrameQuality quality;
+            if (m_qualitySettings.enabled) {
+                quality = runQualityMeter(qualityMeter, stOutFrame);
+            }
+
+            // Буферы кадра переиспользуются: cvtColor, коррекция и copyTo выделяют память
+            // только когда меняется размер кадра (ROI, биннинг). Дебайеризация и коррекция
+            // идут без блокировки: m_bgrFrame и m_enhancedFrame принадлежат только этому потоку.
+            cv::Mat bayerMat(stOutFrame.height, stOutFrame.width, CV_8UC1, stOutFrame.data);
+            cv::cvtColor(bayerMat, m_bgrFrame, cv::COLOR_BayerRG2BGR);
+            if (m_enhancementSettings.enabled()) {
+                const qint64 startNs = CameraBackend::monotonicNs();
+                enhancer.process(m_bgrFrame, m_enhancedFrame);
+                m_frameInfo->enhancedFrames++;
+                m_frameInfo->enhanceNs += CameraBackend::monotonicNs() - startNs;
+            }
+            const cv::Mat& displayFrame = m_enhancementSettings.display ? m_enhancedFrame : m_bgrFrame;
+            const cv::Mat& streamFrame = m_enhancementSettings.stream ? m_enhancedFrame : m_bgrFrame;
+            const cv::Mat& recordFrame = m_enhancementSettings.record ? m_enhancedFrame : m_bgrFrame;
+
+            // Стабилизированные потребители получают кадр с задержкой упреждения; пока очередь
+            // стабилизатора не заполнилась, их кадр не обновляется
+            bool stabilized = false;
+            if (m_stabilizationSettings.enabled()) {
+                const qint64 startNs = CameraBackend::monotonicNs();
+                stabilized = stabilizer.process(m_bgrFrame, streamFrame, recordFrame);
+                m_frameInfo->stabilizedFrames++;
+                m_frameInfo->stabilizeNs += CameraBackend::monotonicNs() - startNs;
+            }
             {
                 QMutexLocker locker(m_frameInfo->mutex);
-                m_frameInfo->frame.pData = stOutFrame.pBufAddr;
-                m_frameInfo->frame.nWidth = stOutFrame.stFrameInfo.nWidth;
-                m_frameInfo->frame.nHeight = stOutFrame.stFrameInfo.nHeight;
-                m_frameInfo->frame.enPixelType = stOutFrame.stFrameInfo.enPixelType;
-                m_frameInfo->frame.nDataLen = stOutFrame.stFrameInfo.nWidth * stOutFrame.stFrameInfo.nHeight * 3;
+                m_frameInfo->frame.pData = stOutFrame.data;
+                m_frameInfo->frame.nWidth = stOutFrame.width;
+                m_frameInfo->frame.nHeight = stOutFrame.height;
+                m_frameInfo->frame.enPixelType = static_cast<MvGvspPixelType>(stOutFrame.pixelType);
+                m_frameInfo->frame.nDataLen = stOutFrame.width * stOutFrame.height * 3;
                 m_frameInfo->frame.enRenderMode = 0;
-
-                cv::Mat bayerMat(stOutFrame.stFrameInfo.nHeight, stOutFrame.stFrameInfo.nWidth, CV_8UC1, stOutFrame.pBufAddr);
-                cv::Mat rawFrame(stOutFrame.stFrameInfo.nHeight, stOutFrame.stFrameInfo.nWidth, CV_8UC3);
-                cv::cvtColor(bayerMat, rawFrame, cv::COLOR_BayerRG2BGR);
-                m_frameInfo->img = QImage(rawFrame.data, rawFrame.cols, rawFrame.rows, rawFrame.step, QImage::Format_RGB888).copy();
+                m_frameInfo->img = QImage(displayFrame.data, displayFrame.cols, displayFrame.rows, displayFrame.step, QImage::Format_RGB888).copy();
+                m_frameInfo->quality = quality;
 
                 {
                     QMutexLocker streamLocker(m_streamInfo->mutex);
-                    m_streamInfo->img = rawFrame.clone();
+                    if (!m_stabilizationSettings.stream) {
+                        streamFrame.copyTo(m_streamInfo->img);
+                        m_streamInfo->shotImg.release();
+                    } else {
+                        if (stabilized) stabilizer.stream().copyTo(m_streamInfo->img);
+                        // Стереоснимок берётся из кадра до стабилизации, с той же коррекцией цвета
+                        streamFrame.copyTo(m_streamInfo->shotImg);
+                    }
+                    m_streamInfo->quality = quality;
+                    m_streamInfo->frameIndex++;
                 }
-                {
+                if (!m_stabilizationSettings.record) {
+                    QMutexLocker recordLocker(m_recordInfo->mutex);
+                    recordFrame.copyTo(m_recordInfo->img);
+                } else if (stabilized) {
                     QMutexLocker recordLocker(m_recordInfo->mutex);
-                    m_recordInfo->img = rawFrame.clone();
+                    stabilizer.record().copyTo(m_recordInfo->img);
                 }
             }
 
-            if (stOutFrame.pBufAddr && stOutFrame.stFrameInfo.nWidth > 0 && stOutFrame.stFrameInfo.nHeight > 0) {
-                //QByteArray frameData(reinterpret_cast<const char*>(stOutFrame.pBufAddr), stOutFrame.stFrameInfo.nFrameLen);
+            if (stOutFrame.width > 0 && stOutFrame.height > 0) {
+                m_frameInfo->capturedFrames++;
+                m_frameInfo->lastFrameNs = stOutFrame.timestampNs;
                 emit frameReady();
-                //emit frameDataReady(frameData, stOutFrame.stFrameInfo.nWidth, stOutFrame.stFrameInfo.nHeight, stOutFrame.stFrameInfo.enPixelType);
             } else {
                 QString errorMsg = QString("Получены некорректные данные кадра для камеры %1: pData=%2, ширина=%3, высота=%4")
                                        .arg(m_frameInfo->name)
-                                       .arg((quintptr)stOutFrame.pBufAddr, 0, 16)
-                                       .arg(stOutFrame.stFrameInfo.nWidth)
-                                       .arg(stOutFrame.stFrameInfo.nHeight);
+                                       .arg((quintptr)stOutFrame.data, 0, 16)
+                                       .arg(stOutFrame.width)
+                                       .arg(stOutFrame.height);
                 qDebug() << errorMsg;
                 emit errorOccurred("CameraWorker", errorMsg);
             }
 
-            MV_CC_FreeImageBuffer(m_frameInfo->handle, &stOutFrame);
+            backend->releaseFrame(stOutFrame);
             retryCount = 5;
         } else {
-            if (nRet == -2147483641) {
+            if (nRet == MV_E_NODATA) {
                 retryCount--;
+                EventLog::record(EventId::FrameGrabRetry, {m_frameInfo->name, nRet, retryCount});
                 if (retryCount > 0) {
                     qDebug() << "Не удалось получить данные для камеры" << m_frameInfo->name
                              << ", Осталось попыток:" << retryCount;
@@ -105,7 +184,8 @@ void CameraWorker::capture() {
             QString errorMsg = QString("Не удалось получить буфер изображения для камеры %1. Ошибка: %2")
                                    .arg(m_frameInfo->name).arg(nRet);
             qDebug() << errorMsg;
-            MV_CC_FreeImageBuffer(m_frameInfo->handle, &stOutFrame);
+            EventLog::record(EventId::CameraLost, {m_frameInfo->name, nRet});
+            backend->releaseFrame(stOutFrame);
             cleanupCamera();
             emit errorOccurred("CameraWorker", errorMsg);
             emit captureFailed(errorMsg);
@@ -114,39 +194,93 @@ void CameraWorker::capture() {
     }
 
     qDebug() << "Конец потока захвата для камеры" << m_frameInfo->name;
-    if (m_frameInfo->handle) {
-        MV_CC_StopGrabbing(m_frameInfo->handle);
-    }
+    backend->stopGrabbing();
 
     cleanupCamera();
 }
 
+void CameraWorker::runAutoExposure(AutoExposure& autoExposure, const RawFrame& frame) {
+    if (frame.pixelType != PixelType_Gvsp_BayerRG8) return;
+
+    const qint64 startNs = CameraBackend::monotonicNs();
+    autoExposure.meter(frame.data, frame.width, frame.height);
+    const qint64 meteringNs = CameraBackend::monotonicNs() - startNs;
+    m_frameInfo->aeMeteredFrames++;
+    m_frameInfo->aeMeteringNs += meteringNs;
+    if (meteringNs > m_frameInfo->aeMaxMeteringNs) m_frameInfo->aeMaxMeteringNs = meteringNs;
+    m_frameInfo->aeLevel = qRound(autoExposure.meanLevel());
+
+    double exposureUs = 0;
+    double gainDb = 0;
+    if (!autoExposure.update(exposureUs, gainDb)) return;
+    int nRet = m_frameInfo->backend->setExposure(exposureUs, gainDb);
+    if (nRet != MV_OK) {
+        // Источник без управления экспозицией (воспроизведение) или камера отвергла значение
+        m_autoExposureActive = false;
+        QString errorMsg = QString("Автоэкспозиция для камеры %1 отключена: не удалось установить выдержку %2 мкс, усиление %3 дБ. Ошибка: %4")
+                               .arg(m_frameInfo->name).arg(exposureUs, 0, 'f', 0).arg(gainDb, 0, 'f', 1).arg(nRet);
+        qDebug() << errorMsg;
+        emit errorOccurred("CameraWorker", errorMsg);
+    }
+}
+
+FrameQuality CameraWorker::runQualityMeter(FrameQualityMeter& meter, const RawFrame& frame) {
+    if (frame.pixelType != PixelType_Gvsp_BayerRG8) return FrameQuality();
+
+    const qint64 startNs = CameraBackend::monotonicNs();
+    const FrameQuality quality = meter.measure(frame.data, frame.width, frame.height);
+    const qint64 endNs = CameraBackend::monotonicNs();
+    m_frameInfo->qualityFrames++;
+    m_frameInfo->qualityNs += endNs - startNs;
+    if (!quality.valid) return quality;
+
+    // В журнал событий идут средние за период: ряд показателей по каждой камере без записи на каждый кадр
+    QualityTotals& totals = m_qualityTotals;
+    if (totals.nextLogNs != 0 && endNs >= totals.nextLogNs && totals.frames > 0) {
+        const double frames = totals.frames;
+        EventLog::record(EventId::FrameQuality, {m_frameInfo->name, totals.frames, totals.sum.sharpness / frames,
+                                                 totals.sum.meanLevel / frames, totals.sum.darkFraction * 100 / frames,
+                                                 totals.sum.clippedFraction * 100 / frames, totals.sum.contrast / frames,
+                                                 totals.sum.turbidity / frames});
+        totals = QualityTotals();
+    }
+    if (totals.nextLogNs == 0) {
+        totals.nextLogNs = endNs + qint64(qMax(100, m_qualitySettings.logIntervalMs)) * 1000000;
+    }
+    totals.sum.sharpness += quality.sharpness;
+    totals.sum.meanLevel += quality.meanLevel;
+    totals.sum.darkFraction += quality.darkFraction;
+    totals.sum.clippedFraction += quality.clippedFraction;
+    totals.sum.contrast += quality.contrast;
+    totals.sum.turbidity += quality.turbidity;
+    totals.frames++;
+    return quality;
+}
+
+void CameraWorker::updateTransportStats() {
+    TransportStats stats;
+    if (!m_frameInfo->backend || !m_frameInfo->backend->transportStats(stats)) return;
+
+    if (stats.lostPackets > m_frameInfo->lostPackets || stats.lostFrames > m_frameInfo->lostFrames) {
+        qDebug() << "Потери транспорта для камеры" << m_frameInfo->name << ": пакетов" << stats.lostPackets
+                 << ", кадров" << stats.lostFrames << ", запрошено повторно" << stats.resendRequested;
+        EventLog::record(EventId::TransportLoss, {m_frameInfo->name, stats.lostPackets, stats.lostFrames, stats.resendRequested});
+    }
+    m_frameInfo->lostPackets = stats.lostPackets;
+    m_frameInfo->lostFrames = stats.lostFrames;
+    m_frameInfo->resendRequested = stats.resendRequested;
+}
+
 void CameraWorker::cleanupCamera() {
-    if (m_frameInfo->handle) {
-        int nRet = MV_OK;
-        nRet = MV_CC_StopGrabbing(m_frameInfo->handle);
-        if (nRet != MV_OK && nRet != -2147483648 && nRet != -2147483645 && nRet != -2147483133) {
-            QString errorMsg = QString("Не удалось остановить захват для камеры %1. Ошибка: %2")
-                                   .arg(m_frameInfo->name).arg(nRet);
-            qDebug() << errorMsg;
-            emit errorOccurred("CameraWorker", errorMsg);
-        }
-        nRet = MV_CC_CloseDevice(m_frameInfo->handle);
-        if (nRet != MV_OK && nRet != -2147483648 && nRet != -2147483645) {
-            QString errorMsg = QString("Не удалось закрыть устройство для камеры %1. Ошибка: %2")
-                                   .arg(m_frameInfo->name).arg(nRet);
-            qDebug() << errorMsg;
-            emit errorOccurred("CameraWorker", errorMsg);
-        }
-        nRet = MV_CC_DestroyHandle(m_frameInfo->handle);
-        if (nRet != MV_OK && nRet != -2147483648) {
-            QString errorMsg = QString("Не удалось уничтожить дескриптор для камеры %1. Ошибка: %2")
+    if (m_frameInfo->backend && m_frameInfo->backend->isOpen()) {
+        int nRet = m_frameInfo->backend->close();
+        if (nRet != MV_OK) {
+            QString errorMsg = QString("Не удалось освободить камеру %1. Ошибка: %2")
                                    .arg(m_frameInfo->name).arg(nRet);
             qDebug() << errorMsg;
             emit errorOccurred("CameraWorker", errorMsg);
         }
         m_frameInfo->handle = nullptr;
-        QThread::msleep(3000);
         qDebug() << "Ресурсы камеры очищены для" << m_frameInfo->name;
     }
 }
@@ -6,6 +6,10 @@
 #include <QThread>
 #include <QMutex>
 #include "camera_structs.h"
+#include "auto_exposure.h"
+#include "frame_enhancer.h"
+#include "video_stabilizer.h"
+#include "frame_quality.h"
 #include "MvCameraControl.h"
 
 class CameraWorker : public QObject {
@@ -14,18 +18,43 @@ public:
     explicit CameraWorker(CameraFrameInfo* frameInfo, StreamFrameInfo* streamInfo, RecordFrameInfo* recordInfo, QObject* parent = nullptr);
     ~CameraWorker();
 
+    // Вызывается до запуска потока захвата
+    void setAutoExposure(const AutoExposureSettings& settings) { m_autoExposureSettings = settings; }
+    void setEnhancement(const EnhancementSettings& settings) { m_enhancementSettings = settings; }
+    void setStabilization(const StabilizationSettings& settings) { m_stabilizationSettings = settings; }
+    void setQuality(const FrameQualitySettings& settings) { m_qualitySettings = settings; }
+
 public slots:
     void capture();
     void stop();
 
 private:
     void cleanupCamera();
+    void updateTransportStats();
+    void runAutoExposure(AutoExposure& autoExposure, const RawFrame& frame);
+    FrameQuality runQualityMeter(FrameQualityMeter& meter, const RawFrame& frame);
+
+    static constexpr qint64 STATS_INTERVAL_NS = 1000000000; // Опрос статистики транспорта раз в секунду
 
 private:
     CameraFrameInfo* m_frameInfo;
     StreamFrameInfo* m_streamInfo;
     RecordFrameInfo* m_recordInfo;
     bool m_isRunning;
+    cv::Mat m_bgrFrame;   // Буфер дебайеризации, пересоздаётся только при смене размера кадра
+    cv::Mat m_enhancedFrame;  // Кадр после коррекции цвета, если её включил хотя бы один потребитель
+    AutoExposureSettings m_autoExposureSettings;
+    EnhancementSettings m_enhancementSettings;
+    StabilizationSettings m_stabilizationSettings;
+    FrameQualitySettings m_qualitySettings;
+    // Суммы показателей качества за период записи в журнал событий
+    struct QualityTotals {
+        FrameQuality sum;
+        int frames = 0;
+        qint64 nextLogNs = 0;
+    };
+    QualityTotals m_qualityTotals;
+    bool m_autoExposureActive = false;
 
 signals:
     void frameReady();
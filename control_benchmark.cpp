@@ -0,0 +1,101 @@
+#include "control_benchmark.h"
+#include "udphandler.h"
+#include "profilemanager.h"
+#include "udptelemetryparser.h"
+#include "rovsimulator.h"
+#include <QTextStream>
+
+ControlBenchmark::ControlBenchmark(int durationSec, quint16 simulatorPort, int rateHz, QObject* parent)
+    : QObject(parent), m_durationSec(qMax(1, durationSec)), m_simulatorPort(simulatorPort),
+    m_rateHz(qBound(1, rateHz, 5000))
+{
+    m_state.primary.deviceName = "Benchmark";
+    m_state.primary.numAxes = 6;
+    m_state.primary.numButtons = 16;
+}
+
+ControlBenchmark::~ControlBenchmark() {
+    m_udpThread.quit();
+    m_udpThread.wait();
+    m_simulatorThread.quit();
+    m_simulatorThread.wait();
+    delete m_profileManager;
+}
+
+void ControlBenchmark::run() {
+    qInfo() << "[ControlBenchmark] Длительность" << m_durationSec << "с, частота ввода" << m_rateHz << "Гц";
+
+    RovSimulator* simulator = new RovSimulator(m_simulatorPort);
+    simulator->moveToThread(&m_simulatorThread);
+    connect(&m_simulatorThread, &QThread::started, simulator, &RovSimulator::start);
+    connect(&m_simulatorThread, &QThread::finished, simulator, &QObject::deleteLater);
+    m_simulatorThread.start();
+
+    // UdpHandler в отдельном потоке, как в MainWindow
+    m_profileManager = new ProfileManager();
+    m_telemetryParser = new UdpTelemetryParser();
+    m_udpHandler = new UdpHandler(m_profileManager, m_telemetryParser, &m_inputSource);
+    m_udpHandler->setEndpointOverride(QHostAddress::LocalHost, m_simulatorPort);
+    m_udpHandler->moveToThread(&m_udpThread);
+    m_telemetryParser->moveToThread(&m_udpThread);
+    connect(&m_udpThread, &QThread::finished, m_udpHandler, &QObject::deleteLater);
+    connect(&m_udpThread, &QThread::finished, m_telemetryParser, &QObject::deleteLater);
+    connect(m_udpHandler, &UdpHandler::onlineStateChanged, this, &ControlBenchmark::onOnlineStateChanged, Qt::QueuedConnection);
+    m_udpThread.start();
+
+    m_injectTimer.setTimerType(Qt::PreciseTimer);
+    m_injectTimer.setInterval(qMax(1, 1000 / m_rateHz));
+    connect(&m_injectTimer, &QTimer::timeout, this, &ControlBenchmark::injectInput);
+
+    QTimer::singleShot(CONNECT_TIMEOUT_MS, this, [this]() {
+        if (!m_started) {
+            qWarning() << "[ControlBenchmark] Имитатор не ответил за" << CONNECT_TIMEOUT_MS << "мс";
+            emit finished(1);
+        }
+    });
+}
+
+void ControlBenchmark::onOnlineStateChanged(const bool &online) {
+    if (!online || m_started)
+        return;
+    m_started = true;
+    QMetaObject::invokeMethod(m_udpHandler, &UdpHandler::resetLatencyStats, Qt::BlockingQueuedConnection);
+    m_injectTimer.start();
+    QTimer::singleShot(m_durationSec * 1000, this, &ControlBenchmark::report);
+}
+
+void ControlBenchmark::injectInput() {
+    // Каждое событие меняет ось, чтобы UdpHandler видел новое состояние
+    Uint64 nowNs = SDL_GetTicksNS();
+    m_state.primary.axes[0] = Sint16(qint64((m_injected * 97) % 65536) - 32768);
+    m_state.primary.timestampNs = nowNs;
+    m_state.timestampNs = nowNs;
+    m_state.publishedNs = SDL_GetTicksNS();
+    m_injected++;
+    emit m_inputSource.joysticksUpdated(m_state);
+}
+
+void ControlBenchmark::report() {
+    m_injectTimer.stop();
+
+    ControlLatencyStats stats;
+    QMetaObject::invokeMethod(m_udpHandler, [this, &stats]() {
+        stats = m_udpHandler->latencyStats();
+    }, Qt::BlockingQueuedConnection);
+
+    QTextStream out(stdout);
+    out << QString("Событий ввода: %1, частота: %2 Гц\n").arg(m_injected).arg(m_rateHz);
+    out << QString("%1 %2 %3 %4 %5\n").arg("Этап", -28).arg("Событий", 10)
+               .arg("p50, мкс", 12).arg("p99, мкс", 12).arg("max, мкс", 12);
+    int exitCode = 0;
+    for (const LatencyStageStats &stage : std::as_const(stats.stages)) {
+        out << QString("%1 %2 %3 %4 %5\n").arg(stage.name, -28).arg(stage.count, 10)
+                   .arg(stage.p50Us, 12, 'f', 1).arg(stage.p99Us, 12, 'f', 1).arg(stage.maxUs, 12, 'f', 1);
+        qInfo().nospace() << "[ControlBenchmark] " << stage.name << ": p50=" << stage.p50Us
+                          << " p99=" << stage.p99Us << " max=" << stage.maxUs << " мкс (" << stage.count << ")";
+        if (stage.count == 0)
+            exitCode = 1;
+    }
+    out.flush();
+    emit finished(exitCode);
+}
@@ -0,0 +1,50 @@
+#ifndef CONTROL_BENCHMARK_H
+#define CONTROL_BENCHMARK_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include "gamepadworker.h"
+
+class UdpHandler;
+class ProfileManager;
+class UdpTelemetryParser;
+
+// Замер задержки тракта управления: синтетические события ввода -> UdpHandler -> UDP
+// до встроенного имитатора аппарата. Печатает p50/p99/max по этапам.
+class ControlBenchmark : public QObject {
+    Q_OBJECT
+public:
+    ControlBenchmark(int durationSec, quint16 simulatorPort, int rateHz = 500, QObject* parent = nullptr);
+    ~ControlBenchmark();
+
+public slots:
+    void run();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    void onOnlineStateChanged(const bool &online);
+    void injectInput();
+    void report();
+
+    static const int CONNECT_TIMEOUT_MS = 5000;
+
+    int m_durationSec;
+    quint16 m_simulatorPort;
+    int m_rateHz;
+    bool m_started = false;
+    quint64 m_injected = 0;
+
+    QThread m_simulatorThread;
+    QThread m_udpThread;
+    GamepadWorker m_inputSource;   // Не запускается: используется только как источник сигнала joysticksUpdated
+    ProfileManager* m_profileManager = nullptr;
+    UdpTelemetryParser* m_telemetryParser = nullptr;
+    UdpHandler* m_udpHandler = nullptr;
+    QTimer m_injectTimer;
+    DualJoystickState m_state;
+};
+
+#endif // CONTROL_BENCHMARK_H
@@ -0,0 +1,178 @@
+#include "controlbindings.h"
+#include <QHash>
+#include <QJsonArray>
+#include <QStringList>
+#include <cmath>
+
+namespace {
+
+// Имя действия в "Control mapping.cfg" и подстроки, по которым кнопки делятся на "+" и "-"
+struct ActionDefinition {
+    ControlAction action;
+    const char* name;
+    const char* inc;
+    const char* dec;
+};
+
+const ActionDefinition ACTIONS[] = {
+    {ControlAction::ManipulatorRotate, "manipulator_rotate", "Right", "Left"},
+    {ControlAction::ManipulatorGrip, "manipulator_grip", "Open", "Close"},
+    {ControlAction::PowerLimit, "power_limit", "inc", "dec"},
+    {ControlAction::CameraRotate, "camera_rotate", "Up", "Down"},
+    {ControlAction::PositionReset, "position_reset", "PosReset", "dec"},
+    {ControlAction::Lights, "lights", "On", "dec"},
+    {ControlAction::Recording, "recording", "Start", "dec"},
+    {ControlAction::TakeFrame, "take_frame", "Stereoframe", "dec"},
+    {ControlAction::MasterSwitch, "master_switch", "Master", "dec"},
+    {ControlAction::ForwardThrust, "forward_thrust", "Forward", "Backward"},
+    {ControlAction::SideThrust, "side_thrust", "Right", "Left"},
+    {ControlAction::VerticalThrust, "vertical_thrust", "Up", "Down"},
+    {ControlAction::RotateYaw, "rotate_yaw", "Right", "Left"},
+    {ControlAction::RotateRoll, "rotate_roll", "dec", "inc"},
+    {ControlAction::RotatePitch, "rotate_pitch", "inc", "dec"},
+};
+
+bool isDeviceConfigured(const QString& name) {
+    return !(name.contains("[offline]", Qt::CaseInsensitive) || name == "No Device");
+}
+
+float mapSInt16ToFloat(Sint16 x, Sint16 in_min, Sint16 in_max, float out_min, float out_max)
+{
+    if (in_max == in_min)
+        return out_min; // защита от деления на 0
+
+    return float(x - in_min) * (out_max - out_min) / float(in_max - in_min) + out_min;
+}
+
+} // namespace
+
+std::shared_ptr<const ControlBindings> ControlBindings::compile(const QJsonObject& mapping, const QJsonObject& profile) {
+    auto bindings = std::make_shared<ControlBindings>();
+    bindings->m_profileName = profile["profileName"].toString();
+    bindings->m_primaryDevice = profile["devices"]["primary"].toString();
+    bindings->m_secondaryDevice = profile["devices"]["secondary"].toString();
+    bindings->m_primaryConfigured = isDeviceConfigured(bindings->m_primaryDevice);
+    bindings->m_secondaryConfigured = isDeviceConfigured(bindings->m_secondaryDevice);
+
+    // Имя входа профиля -> (строка входа джойстика, инверсия); при повторах действует первая запись
+    QHash<QString, std::pair<QString, bool>> profileInputs;
+    const QJsonArray inputs = profile["inputs"].toArray();
+    for (const QJsonValue& val : inputs) {
+        QJsonObject obj = val.toObject();
+        QString name = obj["inputName"].toString();
+        if (!profileInputs.contains(name))
+            profileInputs.insert(name, std::make_pair(obj["input"].toString(), obj["inversion"].toBool(false)));
+    }
+
+    for (const ActionDefinition& definition : ACTIONS) {
+        Binding& binding = bindings->m_bindings[size_t(definition.action)];
+        const QJsonArray controls = mapping[definition.name].toArray();
+        const QString inc = definition.inc;
+        const QString dec = definition.dec;
+
+        // Если на одну роль назначено несколько входов, действует первый в файле раскладки
+        auto assign = [](Input& slot, const Input& input) {
+            if (slot.kind == Input::None)
+                slot = input;
+        };
+
+        for (const QJsonValue& control : controls) {
+            const QString str = control.toString();
+            auto found = profileInputs.constFind(str);
+            if (found == profileInputs.constEnd() || found->first.isEmpty())
+                continue;
+            const Input input = parseInput(found->first, found->second);
+            if (input.kind == Input::None)
+                continue;
+
+            const bool isSecondary = str.contains("secondary", Qt::CaseInsensitive);
+            const bool isPrimary = str.contains("primary", Qt::CaseInsensitive);
+            const bool isButton = str.contains("but", Qt::CaseInsensitive);
+            if (isButton) {
+                if (isSecondary && str.contains(inc, Qt::CaseInsensitive)) assign(binding.secondaryInc, input);
+                if (isSecondary && str.contains(dec, Qt::CaseInsensitive)) assign(binding.secondaryDec, input);
+                if (isPrimary && str.contains(inc, Qt::CaseInsensitive)) assign(binding.primaryInc, input);
+                if (isPrimary && str.contains(dec, Qt::CaseInsensitive)) assign(binding.primaryDec, input);
+            } else {
+                if (isPrimary) assign(binding.primaryAxis, input);
+                if (isSecondary) assign(binding.secondaryAxis, input);
+            }
+        }
+    }
+
+    return bindings;
+}
+
+ControlBindings::Input ControlBindings::parseInput(const QString& joyInput, bool inversion) {
+    Input input;
+    input.inversion = inversion;
+
+    const QStringList parts = joyInput.split(' ', Qt::SkipEmptyParts);
+    if (parts.size() < 2)
+        return input;
+    bool ok = false;
+    input.index = parts[1].toInt(&ok);
+    if (!ok)
+        return input;
+
+    const QString& inputType = parts[0];
+    if (inputType.contains("hat", Qt::CaseInsensitive)) {
+        const QStringList hatParts = inputType.split('_', Qt::SkipEmptyParts);
+        if (hatParts.size() < 2)
+            return input;
+        input.hatMask = JoystickState::hatDirectionMask(hatParts[1]);
+        input.kind = Input::Hat;
+    } else if (inputType.contains("button", Qt::CaseInsensitive)) {
+        input.kind = Input::Button;
+    } else if (inputType.contains("axis", Qt::CaseInsensitive)) {
+        input.kind = Input::Axis;
+    }
+    return input;
+}
+
+bool ControlBindings::buttonValue(const Input& input, const JoystickState& state) {
+    switch (input.kind) {
+    case Input::Button: return state.button(input.index);
+    case Input::Hat: return (state.hat(input.index) & input.hatMask) != 0;
+    default: return false; // Ось на месте кнопки не срабатывает
+    }
+}
+
+Sint16 ControlBindings::axisValue(const Input& input, const JoystickState& state) {
+    if (input.kind != Input::Axis)
+        return 0; // Кнопка на месте оси не срабатывает
+    float value = mapSInt16ToFloat(state.axis(input.index), -32768, 32767, -100.0f, 100.0f);
+    return Sint16(input.inversion ? -value : value);
+}
+
+void ControlBindings::evaluate(const DualJoystickState& state, ControlValues& values) const {
+    values.fill(0);
+
+    const bool isPrimaryOnline = m_primaryConfigured && state.primary.deviceName == m_primaryDevice;
+    const bool isSecondaryOnline = m_secondaryConfigured && state.secondary.deviceName == m_secondaryDevice;
+    if (!(isPrimaryOnline || isSecondaryOnline))
+        return;
+
+    for (size_t i = 0; i < m_bindings.size(); ++i) {
+        const Binding& binding = m_bindings[i];
+
+        bool primaryIncBut = isPrimaryOnline && buttonValue(binding.primaryInc, state.primary);
+        bool primaryDecBut = isPrimaryOnline && buttonValue(binding.primaryDec, state.primary);
+        bool secondaryIncBut = isSecondaryOnline && buttonValue(binding.secondaryInc, state.secondary);
+        bool secondaryDecBut = isSecondaryOnline && buttonValue(binding.secondaryDec, state.secondary);
+        Sint16 primaryAxis = isPrimaryOnline ? axisValue(binding.primaryAxis, state.primary) : 0;
+        Sint16 secondaryAxis = isSecondaryOnline ? axisValue(binding.secondaryAxis, state.secondary) : 0;
+
+        if (std::abs(primaryAxis) < DEADZONE)
+            primaryAxis = 0;
+        if (std::abs(secondaryAxis) < DEADZONE)
+            secondaryAxis = 0;
+
+        //axis > buttons, primary > secondary
+        float value = (secondaryIncBut - secondaryDecBut) * 100;
+        value = value == 0 ? ((primaryIncBut - primaryDecBut) * 100) : value;
+        value = secondaryAxis == 0 ? value : secondaryAxis;
+        value = primaryAxis == 0 ? value : primaryAxis;
+        values[i] = value / 100.0f;
+    }
+}
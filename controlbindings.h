@@ -0,0 +1,77 @@
+#ifndef CONTROLBINDINGS_H
+#define CONTROLBINDINGS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <array>
+#include <memory>
+#include "gamepadworker.h"
+
+// Действия аппарата, которыми управляют джойстики
+enum class ControlAction : int {
+    ManipulatorRotate,
+    ManipulatorGrip,
+    PowerLimit,
+    CameraRotate,
+    PositionReset,
+    Lights,
+    Recording,
+    TakeFrame,
+    MasterSwitch,
+    ForwardThrust,
+    SideThrust,
+    VerticalThrust,
+    RotateYaw,
+    RotateRoll,
+    RotatePitch,
+    Count
+};
+
+using ControlValues = std::array<float, size_t(ControlAction::Count)>;
+
+// Таблица привязок, собранная из "Control mapping.cfg" и профиля управления.
+// Строки вида "axis 1" / "button 3" / "hat_Up 0" разбираются один раз при сборке,
+// в цикле управления остаются только чтения из состояния джойстика. Таблица неизменяема,
+// новая версия подменяет старую целиком через shared_ptr.
+class ControlBindings {
+public:
+    static std::shared_ptr<const ControlBindings> compile(const QJsonObject& mapping, const QJsonObject& profile);
+
+    // Значения всех действий для текущего состояния джойстиков, -1..1
+    void evaluate(const DualJoystickState& state, ControlValues& values) const;
+
+    const QString& profileName() const { return m_profileName; }
+
+private:
+    struct Input {
+        enum Kind : quint8 { None, Axis, Button, Hat };
+        Kind kind = None;
+        int index = 0;
+        quint8 hatMask = 0;
+        bool inversion = false;
+    };
+
+    struct Binding {
+        Input primaryInc;
+        Input primaryDec;
+        Input secondaryInc;
+        Input secondaryDec;
+        Input primaryAxis;
+        Input secondaryAxis;
+    };
+
+    static Input parseInput(const QString& joyInput, bool inversion);
+    static bool buttonValue(const Input& input, const JoystickState& state);
+    static Sint16 axisValue(const Input& input, const JoystickState& state);
+
+    static constexpr float DEADZONE = 5;
+
+    std::array<Binding, size_t(ControlAction::Count)> m_bindings;
+    QString m_profileName;
+    QString m_primaryDevice;
+    QString m_secondaryDevice;
+    bool m_primaryConfigured = false;
+    bool m_secondaryConfigured = false;
+};
+
+#endif // CONTROLBINDINGS_H
@@ -56,9 +56,9 @@ ControlWindow::ControlWindow(GamepadWorker *worker, ProfileManager *profileManag
     checkForDeviceChanges();
 
     //Тут подключаем джойстик после загрузки из конфига
-    _worker->setPrimaryDevice(currentPrimaryDeviceName);
+    QMetaObject::invokeMethod(_worker, "setPrimaryDevice", Qt::QueuedConnection, Q_ARG(QString, currentPrimaryDeviceName));
     ui->primaryDeviceList->setCurrentIndex(ui->primaryDeviceList->findText(currentPrimaryDeviceName));
-    _worker->setSecondaryDevice(currentSecondaryDeviceName);
+    QMetaObject::invokeMethod(_worker, "setSecondaryDevice", Qt::QueuedConnection, Q_ARG(QString, currentSecondaryDeviceName));
     ui->secondaryDeviceList->setCurrentIndex(ui->secondaryDeviceList->findText(currentSecondaryDeviceName));
 }
 
@@ -176,7 +176,7 @@ void ControlWindow::onPrimaryDeviceChanged(int index)
 {
     QString deviceName = ui->primaryDeviceList->itemText(index);
     qDebug() << "Primary device changed to:" << deviceName;
-    _worker->setPrimaryDevice(deviceName);
+    QMetaObject::invokeMethod(_worker, "setPrimaryDevice", Qt::QueuedConnection, Q_ARG(QString, deviceName));
     currentPrimaryDeviceName = deviceName;
 }
 
@@ -184,7 +184,7 @@ void ControlWindow::onSecondaryDeviceChanged(int index)
 {
     QString deviceName = ui->secondaryDeviceList->itemText(index);
     qDebug() << "Secondary device changed to:" << deviceName;
-    _worker->setSecondaryDevice(deviceName);
+    QMetaObject::invokeMethod(_worker, "setSecondaryDevice", Qt::QueuedConnection, Q_ARG(QString, deviceName));
     currentSecondaryDeviceName = deviceName;
 }
 
@@ -192,7 +192,7 @@ void ControlWindow::checkForDeviceChanges()
 {
     if (_worker->hasDeviceListChanged()) {
         qDebug() << "Device list changed, requesting update";
-        _worker->updateDeviceList();
+        QMetaObject::invokeMethod(_worker, "updateDeviceList", Qt::QueuedConnection);
     }
 }
 
@@ -258,18 +258,18 @@ void ControlWindow::updateProfileOnGUI()
         ui->primaryDeviceList->addItem("[offline]" + currentPrimaryDeviceName);
         ui->primaryDeviceList->setCurrentIndex(ui->primaryDeviceList->findText("[offline]" + currentPrimaryDeviceName));
         currentPrimaryDeviceName = "No Device";
-        _worker->setPrimaryDevice("No Device");
+        QMetaObject::invokeMethod(_worker, "setPrimaryDevice", Qt::QueuedConnection, Q_ARG(QString, QString("No Device")));
     } else {
         ui->primaryDeviceList->setCurrentIndex(ui->primaryDeviceList->findText(currentPrimaryDeviceName));
-        _worker->setSecondaryDevice(currentPrimaryDeviceName);
+        QMetaObject::invokeMethod(_worker, "setSecondaryDevice", Qt::QueuedConnection, Q_ARG(QString, currentPrimaryDeviceName));
     }
     if (ui->secondaryDeviceList->findText(currentSecondaryDeviceName) == -1){
         ui->secondaryDeviceList->addItem("[offline]" + currentSecondaryDeviceName);
         ui->secondaryDeviceList->setCurrentIndex(ui->secondaryDeviceList->findText("[offline]" + currentSecondaryDeviceName));
         currentSecondaryDeviceName = "No Device";
-        _worker->setSecondaryDevice("No Device");
+        QMetaObject::invokeMethod(_worker, "setSecondaryDevice", Qt::QueuedConnection, Q_ARG(QString, QString("No Device")));
     } else {
-        _worker->setSecondaryDevice(currentSecondaryDeviceName);
+        QMetaObject::invokeMethod(_worker, "setSecondaryDevice", Qt::QueuedConnection, Q_ARG(QString, currentSecondaryDeviceName));
         ui->secondaryDeviceList->setCurrentIndex(ui->secondaryDeviceList->findText(currentSecondaryDeviceName));
     }
 
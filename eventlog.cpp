@@ -0,0 +1,469 @@
+#include "eventlog.h"
+#include "logger.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QThread>
+#include <QtEndian>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+QString EventLog::logDirectory = "logs";
+qint64 EventLog::maxLogFileSize = 16 * 1024 * 1024; // 16 МБ по умолчанию
+int EventLog::maxLogFiles = 10;
+
+namespace {
+
+const char FILE_MAGIC[8] = {'C', 'H', 'E', 'V', 'L', 'O', 'G', '\0'};
+const quint16 FILE_VERSION = 1;
+const int FLUSH_INTERVAL_MS = 500;
+const int FLUSH_THRESHOLD = 256 * 1024;   // Сбрасываем раньше таймера, если буфер вырос
+const int MAX_BUFFER = 8 * 1024 * 1024;   // Выше этого события отбрасываются, а не копятся в памяти
+
+struct EventSchema {
+    EventId id;
+    const char* name;
+    const char* fields; // Имена полей через запятую, в порядке передачи в record()
+};
+
+const EventSchema SCHEMA[] = {
+    {EventId::SessionStarted, "session_started", "pid"},
+    {EventId::CameraOpened, "camera_opened", "camera,backend"},
+    {EventId::CameraOpenFailed, "camera_open_failed", "camera,backend"},
+    {EventId::CameraLost, "camera_lost", "camera,error"},
+    {EventId::FrameGrabRetry, "frame_grab_retry", "camera,error,retries_left"},
+    {EventId::RecordingSegmentStarted, "recording_segment_started", "camera,file,width,height"},
+    {EventId::RecordingStopped, "recording_stopped", "camera,frames"},
+    {EventId::StreamClientConnected, "stream_client_connected", "camera,clients"},
+    {EventId::StreamClientDisconnected, "stream_client_disconnected", "camera,clients"},
+    {EventId::LinkOnlineChanged, "link_online_changed", "online,since_last_rx_ms"},
+    {EventId::LinkFailsafeChanged, "link_failsafe_changed", "failsafe,loss_percent,rtt_p95_ms"},
+    {EventId::CameraReconnectScheduled, "camera_reconnect_scheduled", "camera,attempt,delay_ms"},
+    {EventId::FrameGap, "frame_gap", "camera,missed,frame_num"},
+    {EventId::TransportLoss, "transport_loss", "camera,lost_packets,lost_frames,resend_requested"},
+    {EventId::FrameQuality, "frame_quality", "camera,frames,sharpness,mean_level,dark_pct,clipped_pct,contrast,turbidity"},
+};
+
+std::mutex bufferMutex;
+std::condition_variable wakeCondition;
+QByteArray buffer;
+quint64 droppedEvents = 0;
+std::atomic<bool> running{false};
+std::thread writerThread;
+QFile logFile;
+
+qint64 monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+quint32 currentThreadTag() {
+    thread_local quint32 tag = quint32(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    return tag;
+}
+
+template <typename T>
+void put(QByteArray& out, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+void putDouble(QByteArray& out, double value) {
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put<quint64>(out, bits);
+}
+
+void putShortString(QByteArray& out, const QByteArray& value) {
+    int size = qMin<int>(value.size(), 255);
+    put<quint8>(out, quint8(size));
+    out.append(value.constData(), size);
+}
+
+// Чтение с проверкой границ: при выходе за конец данных ok сбрасывается
+struct Reader {
+    const uchar* data;
+    qsizetype size;
+    qsizetype pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        if (!ok || pos + qsizetype(sizeof(T)) > size) {
+            ok = false;
+            return T();
+        }
+        T value = qFromLittleEndian<T>(data + pos);
+        pos += sizeof(T);
+        return value;
+    }
+    double getDouble() {
+        quint64 bits = get<quint64>();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    QByteArray getBytes(qsizetype count) {
+        if (!ok || pos + count > size) {
+            ok = false;
+            return QByteArray();
+        }
+        QByteArray value(reinterpret_cast<const char*>(data + pos), count);
+        pos += count;
+        return value;
+    }
+};
+
+struct DecodedSchema {
+    QString name;
+    QStringList fields;
+};
+
+// Файл журнала с разобранным заголовком; записи начинаются с recordsPos
+struct DecodedLog {
+    QByteArray data;
+    qint64 baseWallMs = 0;
+    qint64 baseMonoNs = 0;
+    QMap<quint16, DecodedSchema> schemas;
+    qsizetype recordsPos = 0;
+};
+
+bool readLogHeader(const QString& fileName, DecodedLog& log) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[EventLog] Не удалось открыть" << fileName << ":" << file.errorString();
+        return false;
+    }
+    log.data = file.readAll();
+    Reader reader{reinterpret_cast<const uchar*>(log.data.constData()), log.data.size()};
+
+    if (reader.getBytes(sizeof(FILE_MAGIC)) != QByteArray(FILE_MAGIC, sizeof(FILE_MAGIC))) {
+        qWarning() << "[EventLog] Файл" << fileName << "не является журналом событий";
+        return false;
+    }
+    const quint16 version = reader.get<quint16>();
+    if (version != FILE_VERSION) {
+        qWarning() << "[EventLog] Неподдерживаемая версия журнала" << version << "в" << fileName;
+        return false;
+    }
+    log.baseWallMs = reader.get<qint64>();
+    log.baseMonoNs = reader.get<qint64>();
+
+    // Схема берётся из самого файла, поэтому старые журналы читаются и после добавления событий
+    const quint16 schemaCount = reader.get<quint16>();
+    for (int i = 0; i < schemaCount && reader.ok; ++i) {
+        quint16 id = reader.get<quint16>();
+        DecodedSchema schema;
+        schema.name = QString::fromUtf8(reader.getBytes(reader.get<quint8>()));
+        const quint8 fieldCount = reader.get<quint8>();
+        for (int f = 0; f < fieldCount && reader.ok; ++f)
+            schema.fields << QString::fromUtf8(reader.getBytes(reader.get<quint8>()));
+        log.schemas.insert(id, schema);
+    }
+    log.recordsPos = reader.pos;
+    return true;
+}
+
+QString jsonEscape(const QString& value) {
+    QString result;
+    result.reserve(value.size() + 2);
+    result += '"';
+    for (QChar c : value) {
+        switch (c.unicode()) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (c.unicode() < 0x20)
+                result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+            else
+                result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+QString csvEscape(const QString& value) {
+    if (!value.contains(',') && !value.contains('"') && !value.contains('\n'))
+        return value;
+    QString escaped = value;
+    escaped.replace("\"", "\"\"");
+    return "\"" + escaped + "\"";
+}
+
+} // namespace
+
+void EventLog::start() {
+    if (running.exchange(true))
+        return;
+    writerThread = std::thread(&EventLog::writerLoop);
+    std::atexit(&EventLog::shutdown);
+    record(EventId::SessionStarted, {qint64(QCoreApplication::applicationPid())});
+}
+
+void EventLog::shutdown() {
+    if (running.exchange(false)) {
+        wakeCondition.notify_one();
+        if (writerThread.joinable())
+            writerThread.join();
+    }
+    flushBuffer();
+    if (logFile.isOpen())
+        logFile.close();
+}
+
+void EventLog::setLogDirectory(const QString& directory) {
+    logDirectory = directory;
+}
+
+void EventLog::setMaxLogFileSize(qint64 size) {
+    maxLogFileSize = size > 0 ? size : maxLogFileSize;
+}
+
+void EventLog::setMaxLogFiles(int count) {
+    maxLogFiles = count > 0 ? count : maxLogFiles;
+}
+
+void EventLog::record(EventId id, std::initializer_list<EventValue> fields) {
+    if (!running.load(std::memory_order_relaxed))
+        return;
+
+    const qint64 nowNs = monotonicNs();
+    const quint32 thread = currentThreadTag();
+
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (buffer.size() >= MAX_BUFFER) {
+        droppedEvents++;
+        return;
+    }
+
+    // Длина записи заполняется после кодирования полей
+    const qsizetype start = buffer.size();
+    put<quint16>(buffer, 0);
+    put<quint16>(buffer, quint16(id));
+    put<qint64>(buffer, nowNs);
+    put<quint32>(buffer, thread);
+    put<quint8>(buffer, quint8(fields.size()));
+    for (const EventValue& field : fields) {
+        put<quint8>(buffer, field.type);
+        switch (field.type) {
+        case EventValue::Int: put<qint64>(buffer, field.intValue); break;
+        case EventValue::Double: putDouble(buffer, field.doubleValue); break;
+        case EventValue::String: putShortString(buffer, field.stringValue); break;
+        }
+    }
+    qToLittleEndian<quint16>(quint16(buffer.size() - start - 2), buffer.data() + start);
+
+    const bool flushNow = buffer.size() >= FLUSH_THRESHOLD;
+    lock.unlock();
+    if (flushNow)
+        wakeCondition.notify_one();
+}
+
+void EventLog::writerLoop() {
+    while (running.load(std::memory_order_acquire)) {
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex);
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [] {
+                return buffer.size() >= FLUSH_THRESHOLD || !running.load(std::memory_order_acquire);
+            });
+        }
+        flushBuffer();
+    }
+}
+
+void EventLog::flushBuffer() {
+    QByteArray batch;
+    quint64 dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        batch.swap(buffer);
+        dropped = droppedEvents;
+        droppedEvents = 0;
+    }
+    if (dropped > 0)
+        qWarning() << "[EventLog] Буфер журнала событий переполнен, отброшено событий:" << dropped;
+    if (batch.isEmpty())
+        return;
+
+    // Пачка состоит из целых записей, поэтому ротация между пачками не разрывает записи
+    if (logFile.isOpen() && logFile.size() + batch.size() > maxLogFileSize)
+        logFile.close();
+    if (!openLogFile())
+        return;
+
+    if (logFile.write(batch) != batch.size())
+        qWarning() << "[EventLog] Ошибка записи журнала событий:" << logFile.errorString();
+    logFile.flush();
+}
+
+bool EventLog::openLogFile() {
+    if (logFile.isOpen())
+        return true;
+
+    QDir().mkpath(logDirectory);
+    Logger::rotateLogs(logDirectory, ".evlog", maxLogFiles);
+
+    QString fileName = QString("chersonesos_%1.evlog").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz"));
+    logFile.setFileName(QDir(logDirectory).filePath(fileName));
+    if (!logFile.open(QIODevice::WriteOnly)) {
+        qWarning() << "[EventLog] Не удалось открыть журнал событий" << logFile.fileName() << ":" << logFile.errorString();
+        return false;
+    }
+    logFile.write(makeFileHeader());
+    return true;
+}
+
+QByteArray EventLog::makeFileHeader() {
+    QByteArray header;
+    header.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+    put<quint16>(header, FILE_VERSION);
+    // Привязка монотонного времени записей к настенному
+    put<qint64>(header, QDateTime::currentMSecsSinceEpoch());
+    put<qint64>(header, monotonicNs());
+
+    const int schemaCount = int(sizeof(SCHEMA) / sizeof(SCHEMA[0]));
+    put<quint16>(header, quint16(schemaCount));
+    for (const EventSchema& schema : SCHEMA) {
+        put<quint16>(header, quint16(schema.id));
+        putShortString(header, QByteArray(schema.name));
+        const QList<QByteArray> fields = QByteArray(schema.fields).split(',');
+        put<quint8>(header, quint8(fields.size()));
+        for (const QByteArray& field : fields)
+            putShortString(header, field);
+    }
+    return header;
+}
+
+int EventLog::decode(const QString& path, const QString& format, QTextStream& out) {
+    const bool csv = format.compare("csv", Qt::CaseInsensitive) == 0;
+    if (!csv && format.compare("json", Qt::CaseInsensitive) != 0) {
+        qWarning() << "[EventLog] Неизвестный формат" << format << "(ожидается json или csv)";
+        return 1;
+    }
+
+    QStringList files;
+    QFileInfo info(path);
+    if (info.isDir()) {
+        for (const QFileInfo& entry : QDir(path).entryInfoList({"*.evlog"}, QDir::Files, QDir::Name))
+            files << entry.absoluteFilePath();
+    } else {
+        files << path;
+    }
+    if (files.isEmpty()) {
+        qWarning() << "[EventLog] Нет файлов журнала событий в" << path;
+        return 1;
+    }
+
+    // Журналы ротируются и переживают обновления: в старых файлах нет событий, добавленных
+    // позже, поэтому столбцы CSV - объединение схем всех файлов, а не схема первого
+    int exitCode = 0;
+    QStringList readable = files;
+    QStringList csvColumns;
+    for (const QString& fileName : std::as_const(files)) {
+        if (!csv) break;
+        DecodedLog log;
+        if (!readLogHeader(fileName, log)) {
+            readable.removeOne(fileName);
+            exitCode = 1;
+            continue;
+        }
+        for (const DecodedSchema& schema : std::as_const(log.schemas)) {
+            for (const QString& field : schema.fields) {
+                if (!csvColumns.contains(field))
+                    csvColumns << field;
+            }
+        }
+    }
+    if (csv) {
+        out << "time,mono_ns,thread,event";
+        for (const QString& column : std::as_const(csvColumns))
+            out << ',' << column;
+        out << '\n';
+    }
+
+    for (const QString& fileName : std::as_const(readable)) {
+        DecodedLog log;
+        if (!readLogHeader(fileName, log)) {
+            exitCode = 1;
+            continue;
+        }
+        Reader reader{reinterpret_cast<const uchar*>(log.data.constData()), log.data.size(), log.recordsPos};
+        const qint64 baseWallMs = log.baseWallMs;
+        const qint64 baseMonoNs = log.baseMonoNs;
+        const QMap<quint16, DecodedSchema>& schemas = log.schemas;
+
+        while (reader.ok && reader.pos < reader.size) {
+            const quint16 length = reader.get<quint16>();
+            if (!reader.ok || reader.pos + length > reader.size) {
+                qWarning() << "[EventLog] Обрезанная запись в конце" << fileName;
+                break;
+            }
+            const qsizetype recordEnd = reader.pos + length;
+            const quint16 id = reader.get<quint16>();
+            const qint64 monoNs = reader.get<qint64>();
+            const quint32 thread = reader.get<quint32>();
+            const quint8 fieldCount = reader.get<quint8>();
+
+            const DecodedSchema schema = schemas.value(id, DecodedSchema{QString("event_%1").arg(id), {}});
+            QStringList names;
+            QStringList jsonValues;
+            QStringList textValues;
+            for (int f = 0; f < fieldCount && reader.ok; ++f) {
+                const quint8 type = reader.get<quint8>();
+                names << (f < schema.fields.size() ? schema.fields[f] : QString("field%1").arg(f));
+                if (type == EventValue::Int) {
+                    QString value = QString::number(reader.get<qint64>());
+                    jsonValues << value;
+                    textValues << value;
+                } else if (type == EventValue::Double) {
+                    QString value = QString::number(reader.getDouble(), 'g', 10);
+                    jsonValues << value;
+                    textValues << value;
+                } else if (type == EventValue::String) {
+                    QString value = QString::fromUtf8(reader.getBytes(reader.get<quint8>()));
+                    jsonValues << jsonEscape(value);
+                    textValues << value;
+                } else {
+                    reader.ok = false;
+                }
+            }
+            if (!reader.ok) {
+                qWarning() << "[EventLog] Повреждённая запись в" << fileName;
+                exitCode = 1;
+                break;
+            }
+            reader.pos = recordEnd;
+
+            const QString time = QDateTime::fromMSecsSinceEpoch(baseWallMs + (monoNs - baseMonoNs) / 1000000)
+                                     .toString(Qt::ISODateWithMs);
+            if (csv) {
+                out << time << ',' << monoNs << ',' << thread << ',' << schema.name;
+                for (const QString& column : std::as_const(csvColumns)) {
+                    int index = names.indexOf(column);
+                    out << ',' << (index >= 0 ? csvEscape(textValues[index]) : QString());
+                }
+                out << '\n';
+            } else {
+                out << "{\"time\":" << jsonEscape(time) << ",\"mono_ns\":" << monoNs << ",\"thread\":" << thread
+                    << ",\"event\":" << jsonEscape(schema.name);
+                for (int f = 0; f < names.size(); ++f)
+                    out << ',' << jsonEscape(names[f]) << ':' << jsonValues[f];
+                out << "}\n";
+            }
+        }
+    }
+    out.flush();
+    return exitCode;
+}
@@ -0,0 +1,77 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QByteArray>
+#include <QString>
+#include <QTextStream>
+#include <initializer_list>
+
+// Идентификаторы структурированных событий. Значения записываются в файл,
+// поэтому существующие номера не меняются, новые добавляются в конец.
+enum class EventId : quint16 {
+    SessionStarted = 1,
+    CameraOpened,
+    CameraOpenFailed,
+    CameraLost,
+    FrameGrabRetry,
+    RecordingSegmentStarted,
+    RecordingStopped,
+    StreamClientConnected,
+    StreamClientDisconnected,
+    LinkOnlineChanged,
+    LinkFailsafeChanged,
+    CameraReconnectScheduled,
+    FrameGap,
+    TransportLoss,
+    FrameQuality,
+};
+
+// Типизированное значение поля события
+class EventValue {
+public:
+    enum Type : quint8 { Int = 1, Double = 2, String = 3 };
+
+    EventValue(int value) : type(Int), intValue(value) {}
+    EventValue(unsigned int value) : type(Int), intValue(value) {}
+    EventValue(qint64 value) : type(Int), intValue(value) {}
+    EventValue(quint64 value) : type(Int), intValue(qint64(value)) {}
+    EventValue(bool value) : type(Int), intValue(value ? 1 : 0) {}
+    EventValue(double value) : type(Double), doubleValue(value) {}
+    EventValue(const char* value) : type(String), stringValue(value) {}
+    EventValue(const QString& value) : type(String), stringValue(value.toUtf8()) {}
+
+    Type type;
+    qint64 intValue = 0;
+    double doubleValue = 0;
+    QByteArray stringValue;
+};
+
+// Двоичный журнал событий рядом с текстовым Logger'ом.
+// Файл: заголовок (сигнатура, версия, привязка монотонного времени к настенному, схема событий),
+// затем записи: длина, id, монотонное время (нс), поток, типизированные поля. Little-endian.
+// record() только кодирует запись в общий буфер, на диск буфер сбрасывает фоновый поток.
+class EventLog {
+public:
+    static void start();
+    static void shutdown();
+    static void setLogDirectory(const QString& directory);
+    static void setMaxLogFileSize(qint64 size); // В байтах
+    static void setMaxLogFiles(int count);
+
+    static void record(EventId id, std::initializer_list<EventValue> fields = {});
+
+    // Перевод журнала (файла или каталога с *.evlog) в JSON Lines или CSV, возвращает код выхода
+    static int decode(const QString& path, const QString& format, QTextStream& out);
+
+private:
+    static void writerLoop();
+    static void flushBuffer();
+    static bool openLogFile();
+    static QByteArray makeFileHeader();
+
+    static QString logDirectory;
+    static qint64 maxLogFileSize;
+    static int maxLogFiles;
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,190 @@
+#include "frame_enhancer.h"
+#include <algorithm>
+
+FrameEnhancer::FrameEnhancer(const EnhancementSettings& settings)
+    : m_settings(settings) {
+    m_settings.claheTiles = std::clamp(settings.claheTiles, 1, 32);
+    m_clahe = cv::createCLAHE(std::max(0.1, settings.claheClipLimit), cv::Size(m_settings.claheTiles, m_settings.claheTiles));
+    m_lut.create(1, 256, CV_8UC3);
+}
+
+void FrameEnhancer::process(const cv::Mat& bgr, cv::Mat& out) {
+    CV_Assert(bgr.type() == CV_8UC3);
+
+    // Оценки по уменьшенному кадру; INTER_AREA с целым множителем - быстрый путь OpenCV
+    cv::resize(bgr, m_small, cv::Size(std::max(1, bgr.cols / DOWNSCALE), std::max(1, bgr.rows / DOWNSCALE)),
+               0, 0, cv::INTER_AREA);
+    updateWhiteBalance();
+    if (m_settings.dehaze) {
+        updateDehaze();
+    }
+
+    applyColor(bgr, out);
+    if (m_settings.clahe) {
+        applyClahe(out);
+    }
+}
+
+void FrameEnhancer::updateWhiteBalance() {
+    double target[3] = {1, 1, 1};
+    switch (m_settings.whiteBalance) {
+    case EnhancementSettings::WhiteBalance::Off:
+        break;
+    case EnhancementSettings::WhiteBalance::Learned:
+        std::copy(m_settings.learnedGains, m_settings.learnedGains + 3, target);
+        break;
+    case EnhancementSettings::WhiteBalance::GrayWorld: {
+        // "Серый мир": средний цвет сцены считается серым. Под водой красный канал
+        // ослаблен сильнее всего, поэтому коэффициенты ограничены, чтобы не вытягивать шум.
+        const cv::Scalar mean = cv::mean(m_small);
+        const double gray = (mean[0] + mean[1] + mean[2]) / 3;
+        for (int c = 0; c < 3; ++c) {
+            target[c] = std::clamp(gray / std::max(1.0, mean[c]), 0.5, 4.0);
+        }
+        break;
+    }
+    }
+
+    // Сглаживание по кадрам: баланс не прыгает, когда в кадр заходит яркий объект
+    const double alpha = m_hasGains && m_settings.whiteBalance == EnhancementSettings::WhiteBalance::GrayWorld
+                             ? std::clamp(m_settings.wbAdaptation, 0.01, 1.0) : 1.0;
+    cv::Vec3b* lut = m_lut.ptr<cv::Vec3b>();
+    for (int c = 0; c < 3; ++c) {
+        m_gains[c] += (target[c] - m_gains[c]) * alpha;
+    }
+    for (int v = 0; v < 256; ++v) {
+        for (int c = 0; c < 3; ++c) {
+            lut[v][c] = cv::saturate_cast<uchar>(v * m_gains[c]);
+        }
+    }
+    m_hasGains = true;
+}
+
+void FrameEnhancer::updateDehaze() {
+    cv::LUT(m_small, m_lut, m_smallBalanced);
+
+    // Тёмный канал: минимум по каналам и по окрестности 3x3 уменьшенного кадра (~24x24 в полном)
+    cv::Mat channels[3];
+    cv::split(m_smallBalanced, channels);
+    cv::Mat dark;
+    cv::min(channels[0], channels[1], dark);
+    cv::min(dark, channels[2], dark);
+    cv::erode(dark, dark, cv::Mat());
+
+    // Цвет дымки - средний цвет самых ярких точек тёмного канала
+    int histogram[256] = {};
+    for (int y = 0; y < dark.rows; ++y) {
+        const uchar* row = dark.ptr<uchar>(y);
+        for (int x = 0; x < dark.cols; ++x) ++histogram[row[x]];
+    }
+    const int topCount = std::max(1, int(dark.total() * HAZE_TOP_FRACTION));
+    int threshold = 255;
+    for (int count = 0; threshold > 0; --threshold) {
+        count += histogram[threshold];
+        if (count >= topCount) break;
+    }
+    double sum[3] = {0, 0, 0};
+    int selected = 0;
+    for (int y = 0; y < dark.rows; ++y) {
+        const uchar* darkRow = dark.ptr<uchar>(y);
+        const cv::Vec3b* row = m_smallBalanced.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < dark.cols; ++x) {
+            if (darkRow[x] < threshold) continue;
+            for (int c = 0; c < 3; ++c) sum[c] += row[x][c];
+            ++selected;
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        // Тёмная сцена без дымки не должна давать огромного усиления
+        m_airlight[c] = std::clamp(int(sum[c] / std::max(1, selected) + 0.5), 64, 255);
+    }
+
+    // Пропускание t = 1 - omega * min_c(I_c / A_c), в масштабе 0..255
+    const int omega = int(std::clamp(m_settings.dehazeStrength, 0.0, 1.0) * 256);
+    const int minT = int(std::clamp(m_settings.minTransmission, 0.05, 1.0) * 255);
+    m_transmissionSmall.create(m_smallBalanced.size(), CV_8UC1);
+    for (int y = 0; y < m_smallBalanced.rows; ++y) {
+        const cv::Vec3b* row = m_smallBalanced.ptr<cv::Vec3b>(y);
+        uchar* t = m_transmissionSmall.ptr<uchar>(y);
+        for (int x = 0; x < m_smallBalanced.cols; ++x) {
+            int normalized = 255;
+            for (int c = 0; c < 3; ++c) {
+                normalized = std::min(normalized, row[x][c] * 255 / m_airlight[c]);
+            }
+            t[x] = uchar(normalized);
+        }
+    }
+    cv::erode(m_transmissionSmall, m_transmissionSmall, cv::Mat());
+    for (int y = 0; y < m_transmissionSmall.rows; ++y) {
+        uchar* t = m_transmissionSmall.ptr<uchar>(y);
+        for (int x = 0; x < m_transmissionSmall.cols; ++x) {
+            t[x] = uchar(std::max(minT, 255 - ((t[x] * omega) >> 8)));
+        }
+    }
+    // Размытие убирает ступеньки на границах блоков после увеличения
+    cv::GaussianBlur(m_transmissionSmall, m_transmissionSmall, cv::Size(5, 5), 0);
+}
+
+void FrameEnhancer::applyColor(const cv::Mat& bgr, cv::Mat& out) {
+    if (!m_settings.dehaze) {
+        cv::LUT(bgr, m_lut, out);
+        return;
+    }
+
+    cv::resize(m_transmissionSmall, m_transmission, bgr.size(), 0, 0, cv::INTER_LINEAR);
+    out.create(bgr.size(), CV_8UC3);
+
+    // J = A + (I - A) / t; 1/t в формате 8.8 из таблицы, без деления на пиксель
+    int inverseT[256];
+    for (int t = 0; t < 256; ++t) {
+        inverseT[t] = 256 * 255 / std::max(1, t);
+    }
+    uchar lut[3][256];
+    const cv::Vec3b* lutRow = m_lut.ptr<cv::Vec3b>();
+    for (int v = 0; v < 256; ++v) {
+        for (int c = 0; c < 3; ++c) lut[c][v] = lutRow[v][c];
+    }
+    const int airlight[3] = {m_airlight[0], m_airlight[1], m_airlight[2]};
+
+    cv::parallel_for_(cv::Range(0, bgr.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            const uchar* src = bgr.ptr<uchar>(y);
+            const uchar* t = m_transmission.ptr<uchar>(y);
+            uchar* dst = out.ptr<uchar>(y);
+            for (int x = 0; x < bgr.cols; ++x) {
+                const int inv = inverseT[t[x]];
+                for (int c = 0; c < 3; ++c) {
+                    const int v = lut[c][src[3 * x + c]];
+                    const int j = airlight[c] + (((v - airlight[c]) * inv) >> 8);
+                    dst[3 * x + c] = uchar(std::clamp(j, 0, 255));
+                }
+            }
+        }
+    });
+}
+
+void FrameEnhancer::applyClahe(cv::Mat& frame) {
+    // CLAHE по яркости (тайлы OpenCV обрабатывает параллельно), цвет масштабируется
+    // отношением новой яркости к старой - без перевода кадра в Lab и обратно
+    cv::cvtColor(frame, m_gray, cv::COLOR_BGR2GRAY);
+    m_clahe->apply(m_gray, m_grayEqualized);
+
+    unsigned int reciprocal[256];
+    for (int g = 0; g < 256; ++g) {
+        reciprocal[g] = 65536u / unsigned(std::max(1, g));
+    }
+
+    cv::parallel_for_(cv::Range(0, frame.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            uchar* row = frame.ptr<uchar>(y);
+            const uchar* gray = m_gray.ptr<uchar>(y);
+            const uchar* equalized = m_grayEqualized.ptr<uchar>(y);
+            for (int x = 0; x < frame.cols; ++x) {
+                const unsigned int gain = equalized[x] * reciprocal[gray[x]]; // 16.16
+                for (int c = 0; c < 3; ++c) {
+                    row[3 * x + c] = uchar(std::min(255u, (row[3 * x + c] * gain) >> 16));
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,62 @@
+#ifndef FRAME_ENHANCER_H
+#define FRAME_ENHANCER_H
+
+#include <opencv2/opencv.hpp>
+
+// Настройки коррекции цвета подводного кадра. Каждый потребитель кадра
+// (окно, трансляция, запись) включает коррекцию отдельно.
+struct EnhancementSettings {
+    enum class WhiteBalance { Off, GrayWorld, Learned };
+
+    bool display = false;
+    bool stream = false;
+    bool record = false;
+
+    WhiteBalance whiteBalance = WhiteBalance::GrayWorld;
+    double learnedGains[3] = {1, 1, 1}; // B, G, R - коэффициенты, подобранные заранее по эталонным кадрам
+    double wbAdaptation = 0.1;          // Скорость подстройки баланса "серого мира" за кадр, 0..1
+    bool dehaze = true;
+    double dehazeStrength = 0.8;        // Доля убираемой дымки (omega темного канала), 0..1
+    double minTransmission = 0.3;       // Нижняя граница пропускания: меньше - шум в дальних планах
+    bool clahe = true;
+    double claheClipLimit = 2.0;
+    int claheTiles = 8;                 // Тайлов по каждой стороне кадра
+
+    bool enabled() const { return display || stream || record; }
+};
+
+// Коррекция кадра BGR: баланс белого, удаление дымки по тёмному каналу, CLAHE по яркости.
+// Все оценки (баланс, цвет дымки, карта пропускания) строятся по кадру, уменьшенному в
+// DOWNSCALE раз; в полном разрешении остаются два прохода по пикселям с таблицами
+// и целочисленной арифметикой, разбитые на полосы для cv::parallel_for_.
+// Состояние (сглаженный баланс белого) своё у каждой камеры.
+class FrameEnhancer {
+public:
+    explicit FrameEnhancer(const EnhancementSettings& settings);
+
+    void process(const cv::Mat& bgr, cv::Mat& out);
+
+private:
+    static const int DOWNSCALE = 8;
+    static constexpr double HAZE_TOP_FRACTION = 0.001; // Доля самых ярких точек тёмного канала для цвета дымки
+
+    void updateWhiteBalance();
+    void updateDehaze();
+    void applyColor(const cv::Mat& bgr, cv::Mat& out);
+    void applyClahe(cv::Mat& frame);
+
+    EnhancementSettings m_settings;
+    cv::Ptr<cv::CLAHE> m_clahe;
+    double m_gains[3] = {1, 1, 1};
+    bool m_hasGains = false;
+    cv::Mat m_lut;            // 1x256, CV_8UC3: баланс белого по каналам
+    int m_airlight[3] = {255, 255, 255};
+    cv::Mat m_small;          // Уменьшенный кадр
+    cv::Mat m_smallBalanced;
+    cv::Mat m_transmissionSmall;
+    cv::Mat m_transmission;   // Пропускание 0..255 в полном разрешении
+    cv::Mat m_gray;
+    cv::Mat m_grayEqualized;
+};
+
+#endif // FRAME_ENHANCER_H
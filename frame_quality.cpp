@@ -0,0 +1,220 @@
+#include "frame_quality.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+
+FrameQualityMeter::FrameQualityMeter(const FrameQualitySettings& settings)
+    : m_settings(settings) {
+    m_settings.gridColumns = std::clamp(settings.gridColumns, 1, 32);
+    m_settings.gridRows = std::clamp(settings.gridRows, 1, 32);
+    m_settings.patchSize = std::clamp(settings.patchSize, 8, 64);
+    m_patch.resize(size_t(m_settings.patchSize) * m_settings.patchSize);
+    m_contrasts.reserve(size_t(m_settings.gridColumns) * m_settings.gridRows);
+    m_histogram.fill(0);
+}
+
+FrameQuality FrameQualityMeter::measure(const unsigned char* data, unsigned int width, unsigned int height) {
+    FrameQuality quality;
+    const int patch = m_settings.patchSize;
+    const unsigned int span = 2 * patch; // Участок в пикселях кадра
+    if (!data || width < span + 2 || height < span) return quality;
+
+    m_histogram.fill(0);
+    m_contrasts.clear();
+    qint64 laplacianSum = 0;
+    qint64 laplacianSquares = 0;
+    for (int gy = 0; gy < m_settings.gridRows; ++gy) {
+        for (int gx = 0; gx < m_settings.gridColumns; ++gx) {
+            // Начало участка чётное: в строке RGGB с чётным номером зелёные пиксели стоят на нечётных x
+            const unsigned int x0 = ((width - span - 1) * (2 * gx + 1) / (2 * m_settings.gridColumns)) & ~1u;
+            const unsigned int y0 = ((height - span) * (2 * gy + 1) / (2 * m_settings.gridRows)) & ~1u;
+            unsigned char* p = m_patch.data();
+            for (int j = 0; j < patch; ++j) {
+                const unsigned char* row = data + size_t(y0 + 2 * j) * width + x0 + 1;
+                unsigned char* dst = p + j * patch;
+                for (int i = 0; i < patch; ++i) dst[i] = row[2 * i];
+            }
+
+            for (int k = 0; k < patch * patch; ++k) ++m_histogram[p[k]];
+
+            // Лапласиан по решётке зелёных отсчётов; на строку участка суммы помещаются в int
+            for (int j = 1; j < patch - 1; ++j) {
+                const unsigned char* up = p + (j - 1) * patch;
+                const unsigned char* mid = p + j * patch;
+                const unsigned char* down = p + (j + 1) * patch;
+                int rowSum = 0;
+                int rowSquares = 0;
+                for (int i = 1; i < patch - 1; ++i) {
+                    const int laplacian = 4 * mid[i] - mid[i - 1] - mid[i + 1] - up[i] - down[i];
+                    rowSum += laplacian;
+                    rowSquares += laplacian * laplacian;
+                }
+                laplacianSum += rowSum;
+                laplacianSquares += rowSquares;
+            }
+
+            // Контраст участка по суммам 2x2: шум отдельных отсчётов не раздувает размах
+            int low = 4 * 255;
+            int high = 0;
+            for (int j = 0; j + 1 < patch; ++j) {
+                const unsigned char* a = p + j * patch;
+                const unsigned char* b = a + patch;
+                for (int i = 0; i + 1 < patch; ++i) {
+                    const int v = a[i] + a[i + 1] + b[i] + b[i + 1];
+                    low = std::min(low, v);
+                    high = std::max(high, v);
+                }
+            }
+            // В тёмном участке размах даёт шум, в пересвеченном размаха нет - оба не учитываются
+            if (high >= 4 * DARK_LEVEL && low < 4 * CLIP_LEVEL) {
+                m_contrasts.push_back(double(high - low) / (high + low));
+            }
+        }
+    }
+
+    quint64 samples = 0;
+    quint64 sum = 0;
+    quint64 dark = 0;
+    quint64 clipped = 0;
+    for (int level = 0; level < 256; ++level) {
+        const quint32 count = m_histogram[level];
+        samples += count;
+        sum += quint64(count) * level;
+        if (level < DARK_LEVEL) dark += count;
+        if (level >= CLIP_LEVEL) clipped += count;
+    }
+    int low = -1;
+    int high = 255;
+    quint64 cumulative = 0;
+    for (int level = 0; level < 256; ++level) {
+        cumulative += m_histogram[level];
+        if (low < 0 && cumulative * 50 >= samples) low = level;
+        if (cumulative * 50 >= samples * 49) {
+            high = level;
+            break;
+        }
+    }
+
+    const qint64 laplacianCount = qint64(m_settings.gridColumns) * m_settings.gridRows * (patch - 2) * (patch - 2);
+    const double laplacianMean = double(laplacianSum) / laplacianCount;
+    quality.valid = true;
+    quality.sharpness = double(laplacianSquares) / laplacianCount - laplacianMean * laplacianMean;
+    quality.meanLevel = double(sum) / samples;
+    quality.darkFraction = double(dark) / samples;
+    quality.clippedFraction = double(clipped) / samples;
+    quality.contrast = std::max(0, high - low) / 255.0;
+    if (m_contrasts.empty()) {
+        quality.turbidity = 1;
+    } else {
+        auto middle = m_contrasts.begin() + m_contrasts.size() / 2;
+        std::nth_element(m_contrasts.begin(), middle, m_contrasts.end());
+        quality.turbidity = 1 - *middle;
+    }
+    return quality;
+}
+
+double FrameQualityMeter::pairScore(const FrameQuality& left, const FrameQuality& right) {
+    if (!left.valid || !right.valid) return 0;
+    return std::min(left.sharpness, right.sharpness);
+}
+
+int FrameQualityMeter::selfCheck(QTextStream& out) {
+    // Дно - шум нескольких масштабов, кадр BayerRG8 с одинаковыми каналами
+    const cv::Size frameSize(2448, 2048);
+    cv::RNG rng(7);
+    cv::Mat scene(frameSize, CV_32F, cv::Scalar(0));
+    for (int scale : {4, 16, 64}) {
+        cv::Mat noise(frameSize.height / scale + 2, frameSize.width / scale + 2, CV_32F);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 1);
+        cv::Mat resized;
+        cv::resize(noise, resized, cv::Size(), scale, scale, cv::INTER_CUBIC);
+        scene += resized(cv::Rect(cv::Point(0, 0), frameSize));
+    }
+    cv::normalize(scene, scene, 0, 1, cv::NORM_MINMAX);
+
+    auto frame = [&](double blurSigma, double haze, double gain) {
+        cv::Mat image = scene.clone();
+        if (blurSigma > 0) cv::GaussianBlur(image, image, cv::Size(), blurSigma);
+        image = (image * (1 - haze) + 0.7 * haze) * gain;
+        cv::Mat noise(frameSize, CV_32F);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 2.0 / 255);
+        cv::Mat raw;
+        cv::Mat(image + noise).convertTo(raw, CV_8U, 255);
+        return raw;
+    };
+
+    FrameQualityMeter meter{FrameQualitySettings()};
+    auto measureFrame = [&](const cv::Mat& raw) { return meter.measure(raw.data, raw.cols, raw.rows); };
+
+    int exitCode = 0;
+    auto check = [&](const QString& name, bool ok) {
+        out << QString("%1: %2\n").arg(name, -48).arg(ok ? "OK" : "ОШИБКА");
+        if (!ok) exitCode = 1;
+    };
+
+    // Резкость падает со смазом, мутность растёт с дымкой, контраст падает
+    const double sigmas[] = {0, 1, 2, 4};
+    double previousSharpness = 1e300;
+    bool sharpnessOrdered = true;
+    for (double sigma : sigmas) {
+        const FrameQuality quality = measureFrame(frame(sigma, 0, 0.8));
+        out << QString("Смаз %1 пикс.: резкость %2, мутность %3\n").arg(sigma)
+                   .arg(quality.sharpness, 0, 'f', 1).arg(quality.turbidity, 0, 'f', 3);
+        sharpnessOrdered = sharpnessOrdered && quality.sharpness < previousSharpness;
+        previousSharpness = quality.sharpness;
+    }
+    check("Резкость убывает со смазом", sharpnessOrdered);
+
+    const double hazes[] = {0, 0.3, 0.6, 0.85};
+    double previousTurbidity = -1;
+    double previousContrast = 2;
+    bool turbidityOrdered = true;
+    for (double haze : hazes) {
+        const FrameQuality quality = measureFrame(frame(0, haze, 1));
+        out << QString("Дымка %1: мутность %2, контраст %3, резкость %4\n").arg(haze)
+                   .arg(quality.turbidity, 0, 'f', 3).arg(quality.contrast, 0, 'f', 3).arg(quality.sharpness, 0, 'f', 1);
+        turbidityOrdered = turbidityOrdered && quality.turbidity > previousTurbidity && quality.contrast < previousContrast;
+        previousTurbidity = quality.turbidity;
+        previousContrast = quality.contrast;
+    }
+    check("Мутность растёт, контраст падает с дымкой", turbidityOrdered);
+
+    const FrameQuality overexposed = measureFrame(frame(0, 0, 3));
+    const FrameQuality underexposed = measureFrame(frame(0, 0, 0.05));
+    out << QString("Пересвет: %1% отсчётов, недосвет: %2% отсчётов\n")
+               .arg(overexposed.clippedFraction * 100, 0, 'f', 1).arg(underexposed.darkFraction * 100, 0, 'f', 1);
+    check("Пересвеченный кадр распознан", overexposed.clippedFraction > 0.3);
+    check("Тёмный кадр распознан", underexposed.darkFraction > 0.5);
+
+    // Серия: лучшая пара - та, где худший из двух кадров резче всего (пара 3)
+    const double leftSigmas[] = {2, 0, 1, 0, 3};
+    const double rightSigmas[] = {2, 3, 1, 0.5, 0};
+    int best = -1;
+    double bestScore = 0;
+    for (int i = 0; i < 5; ++i) {
+        const double score = pairScore(measureFrame(frame(leftSigmas[i], 0, 0.8)), measureFrame(frame(rightSigmas[i], 0, 0.8)));
+        if (best < 0 || score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    out << QString("Выбрана пара %1 из серии\n").arg(best);
+    check("Выбрана самая резкая пара серии", best == 3);
+
+    // Бюджет - 1% ядра на камеру при 30 к/с
+    const cv::Mat raw = frame(0, 0, 0.8);
+    const int runs = 200;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < runs; ++i) measureFrame(raw);
+    const double meanMs = timer.nsecsElapsed() / 1e6 / runs;
+    const double budgetMs = 1000.0 / 30 * 0.01;
+    out << QString("Замер кадра %1x%2: %3 мс (бюджет %4 мс)\n").arg(frameSize.width).arg(frameSize.height)
+               .arg(meanMs, 0, 'f', 3).arg(budgetMs, 0, 'f', 3);
+    check("Замер укладывается в бюджет", meanMs <= budgetMs);
+
+    out.flush();
+    return exitCode;
+}
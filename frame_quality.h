@@ -0,0 +1,64 @@
+#ifndef FRAME_QUALITY_H
+#define FRAME_QUALITY_H
+
+#include <QtGlobal>
+#include <array>
+#include <vector>
+
+class QTextStream;
+
+// Настройки оценки качества кадра (ключи Camera_quality_*)
+struct FrameQualitySettings {
+    bool enabled = true;
+    int gridColumns = 8;            // Участков замера по ширине и высоте кадра
+    int gridRows = 6;
+    int patchSize = 32;             // Сторона участка в зелёных отсчётах (в пикселях кадра вдвое больше)
+    int logIntervalMs = 1000;       // Период записи средних показателей в журнал событий
+};
+
+// Показатели качества одного кадра
+struct FrameQuality {
+    bool valid = false;
+    double sharpness = 0;           // Дисперсия лапласиана: меньше - смаз или расфокусировка
+    double meanLevel = 0;           // Средняя яркость, 0..255
+    double darkFraction = 0;        // Доля отсчётов темнее DARK_LEVEL
+    double clippedFraction = 0;     // Доля пересвеченных отсчётов
+    double contrast = 0;            // Размах гистограммы между 2% и 98%, доля 0..1
+    double turbidity = 0;           // 1 - медианный контраст участков: 0 - чистая вода, 1 - деталей не видно
+};
+
+// Оценка качества кадра BayerRG8 для отбора снимков и записи.
+// Как и замер автоэкспозиции, работает по зелёным пикселям, но не по разреженной сетке
+// отсчётов, а по сетке небольших участков в полном разрешении: лапласиан требует соседей.
+// Зелёные отсчёты участка собираются в непрерывный буфер, дальше простые целочисленные
+// циклы без ветвлений, которые компилятор векторизует. Для кадра 5 Мп это около 50 тыс.
+// отсчётов вместо 5 млн, замер занимает десятки микросекунд.
+// Мутность - медиана контраста Майкельсона по участкам: взвесь добавляет к каждой точке
+// рассеянный свет и сжимает размах яркостей в каждом участке, а не только в среднем по кадру.
+class FrameQualityMeter {
+public:
+    explicit FrameQualityMeter(const FrameQualitySettings& settings);
+
+    // Замер кадра BayerRG8 (строки без выравнивания)
+    FrameQuality measure(const unsigned char* data, unsigned int width, unsigned int height);
+    const std::array<quint32, 256>& histogram() const { return m_histogram; }
+
+    // Оценка стереопары для выбора лучшей в серии: резкость худшего из двух кадров,
+    // размытый кадр портит сопоставление точек так же, как два размытых
+    static double pairScore(const FrameQuality& left, const FrameQuality& right);
+
+    // Проверка на синтетических кадрах: порядок показателей при росте смаза и мутности,
+    // выбор пары в серии и время замера. Возвращает код выхода.
+    static int selfCheck(QTextStream& out);
+
+private:
+    static constexpr int DARK_LEVEL = 16;
+    static constexpr int CLIP_LEVEL = 250;
+
+    FrameQualitySettings m_settings;
+    std::vector<unsigned char> m_patch;
+    std::vector<double> m_contrasts;
+    std::array<quint32, 256> m_histogram;
+};
+
+#endif // FRAME_QUALITY_H
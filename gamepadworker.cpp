@@ -1,26 +1,26 @@
 #include "gamepadworker.h"
-#include <QTimer>
+#include <QCoreApplication>
 #include <QDebug>
+#include <cstdlib>
 
 const QString GamepadWorker::NO_DEVICE_NAME = "No Device";
 
-GamepadWorker::GamepadWorker(QObject *parent) : QObject(parent)
+quint8 JoystickState::hatDirectionMask(const QString &direction)
 {
-    if (SDL_Init(SDL_INIT_JOYSTICK) < 0) {
-        qDebug() << "SDL3 Init failed in worker:" << SDL_GetError();
-        return;
-    }
+    if (direction.compare("Up", Qt::CaseInsensitive) == 0) return SDL_HAT_UP;
+    if (direction.compare("Down", Qt::CaseInsensitive) == 0) return SDL_HAT_DOWN;
+    if (direction.compare("Left", Qt::CaseInsensitive) == 0) return SDL_HAT_LEFT;
+    if (direction.compare("Right", Qt::CaseInsensitive) == 0) return SDL_HAT_RIGHT;
+    return 0;
+}
 
+GamepadWorker::GamepadWorker(QObject *parent) : QObject(parent)
+{
     qRegisterMetaType<JoystickState>("JoystickState");
     qRegisterMetaType<DualJoystickState>("DualJoystickState");
 
     currentPrimaryName = NO_DEVICE_NAME;
     currentSecondaryName = NO_DEVICE_NAME;
-    updateDeviceList();
-
-    timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &GamepadWorker::pollDevices);
-    timer->start(16);
 }
 
 GamepadWorker::~GamepadWorker()
@@ -28,16 +28,46 @@ GamepadWorker::~GamepadWorker()
     for (SDL_Joystick *joystick : joysticks.values()) {
         if (joystick) SDL_CloseJoystick(joystick);
     }
-    SDL_Quit();
+    if (sdlReady)
+        SDL_Quit();
+}
+
+void GamepadWorker::run()
+{
+    // Без окна SDL иначе может не доставлять события джойстика
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if (!SDL_Init(SDL_INIT_JOYSTICK)) {
+        qDebug() << "SDL3 Init failed in worker:" << SDL_GetError();
+        return;
+    }
+    sdlReady = true;
+    updateDeviceList();
+
+    SDL_Event event;
+    while (running) {
+        if (SDL_WaitEventTimeout(&event, WAIT_TIMEOUT_MS)) {
+            handleEvent(event);
+            while (SDL_PollEvent(&event))
+                handleEvent(event);
+        }
+        publish();
+        // Выбор устройств и обновление списка приходят из GUI через очередь событий потока
+        QCoreApplication::processEvents();
+    }
+    qDebug() << "GamepadWorker loop finished";
+}
+
+void GamepadWorker::stop()
+{
+    running = false;
+    qDebug() << "GamepadWorker stopped";
 }
 
 void GamepadWorker::setPrimaryDevice(const QString &deviceName)
 {
     if (deviceName != NO_DEVICE_NAME) {
-        if(primaryJoystick != secondaryJoystick)
-            deactivateJoystick(primaryJoystick);
-        primaryJoystick = joysticks.value(deviceName, nullptr);
-        if (primaryJoystick) {
+        bindSlot(primarySlot, deviceName);
+        if (primarySlot.joystick) {
             qDebug() << "Primary Joystick opened:" << deviceName;
             currentPrimaryName = deviceName;
         } else {
@@ -45,19 +75,17 @@ void GamepadWorker::setPrimaryDevice(const QString &deviceName)
             currentPrimaryName = NO_DEVICE_NAME;
         }
     } else {
-        if(primaryJoystick != secondaryJoystick)
-            deactivateJoystick(primaryJoystick);
+        clearSlot(primarySlot);
         currentPrimaryName = NO_DEVICE_NAME;
     }
+    publish();
 }
 
 void GamepadWorker::setSecondaryDevice(const QString &deviceName)
 {
     if (deviceName != NO_DEVICE_NAME) {
-        if(primaryJoystick != secondaryJoystick)
-            deactivateJoystick(secondaryJoystick);
-        secondaryJoystick = joysticks.value(deviceName, nullptr);
-        if (secondaryJoystick) {
+        bindSlot(secondarySlot, deviceName);
+        if (secondarySlot.joystick) {
             qDebug() << "Secondary Joystick opened:" << deviceName;
             currentSecondaryName = deviceName;
         } else {
@@ -65,184 +93,208 @@ void GamepadWorker::setSecondaryDevice(const QString &deviceName)
             currentSecondaryName = NO_DEVICE_NAME;
         }
     } else {
-        if(primaryJoystick != secondaryJoystick)
-            deactivateJoystick(secondaryJoystick);
+        clearSlot(secondarySlot);
         currentSecondaryName = NO_DEVICE_NAME;
     }
+    publish();
 }
 
-void GamepadWorker::stop()
+void GamepadWorker::bindSlot(Slot &slot, const QString &deviceName)
 {
-    running = false;
-    timer->stop();
-    qDebug() << "GamepadWorker stopped";
-}
-
-void GamepadWorker::pollDevices() {
-    if (!running) return;
-
-    SDL_UpdateJoysticks();
-
-    int numJoysticks = 0;
-    SDL_GetJoysticks(&numJoysticks);
-    if (numJoysticks != lastNumJoysticks) {
-        updateDeviceList();
-    }
-    if (numJoysticks == 0){
+    clearSlot(slot);
+    SDL_Joystick *joystick = joysticks.value(deviceName, nullptr);
+    if (!joystick)
         return;
-    }
 
-    JoystickState primaryState, secondaryState;
-
-    if (primaryJoystick) {
-        primaryState.deviceName = currentPrimaryName;
-        int numAxes = SDL_GetNumJoystickAxes(primaryJoystick);
-        int numButtons = SDL_GetNumJoystickButtons(primaryJoystick);
-        int numHats = SDL_GetNumJoystickHats(primaryJoystick);
-
-        primaryState.axes.resize(numAxes);
-        primaryState.buttons.resize(numButtons);
-        primaryState.hats.resize(numHats);
-
-        for (int i = 0; i < numAxes; ++i)
-            primaryState.axes[i] = SDL_GetJoystickAxis(primaryJoystick, i);
-        for (int i = 0; i < numButtons; ++i)
-            primaryState.buttons[i] = SDL_GetJoystickButton(primaryJoystick, i);
-        for (int i = 0; i < numHats; ++i) {
-            Uint8 hat = SDL_GetJoystickHat(primaryJoystick, i);
-            QString hatDir;
-            if (hat & SDL_HAT_UP) hatDir += "Up ";
-            if (hat & SDL_HAT_DOWN) hatDir += "Down ";
-            if (hat & SDL_HAT_LEFT) hatDir += "Left ";
-            if (hat & SDL_HAT_RIGHT) hatDir += "Right ";
-            primaryState.hats[i] = hatDir.trimmed();
-        }
+    slot.joystick = joystick;
+    slot.id = SDL_GetJoystickID(joystick);
+
+    // Начальное состояние читается один раз, дальше оно обновляется только событиями
+    JoystickState &state = slot.state;
+    state.deviceName = deviceName;
+    state.numAxes = quint8(qBound(0, SDL_GetNumJoystickAxes(joystick), JoystickState::MAX_AXES));
+    state.numButtons = quint8(qBound(0, SDL_GetNumJoystickButtons(joystick), JoystickState::MAX_BUTTONS));
+    state.numHats = quint8(qBound(0, SDL_GetNumJoystickHats(joystick), JoystickState::MAX_HATS));
+    for (int i = 0; i < state.numAxes; ++i)
+        state.axes[i] = SDL_GetJoystickAxis(joystick, i);
+    for (int i = 0; i < state.numButtons; ++i) {
+        if (SDL_GetJoystickButton(joystick, i))
+            state.buttons |= quint64(1) << i;
     }
+    for (int i = 0; i < state.numHats; ++i)
+        state.hats |= quint32(SDL_GetJoystickHat(joystick, i) & 0xF) << (4 * i);
+    state.timestampNs = SDL_GetTicksNS();
+    stateChanged = true;
+}
 
-    if (secondaryJoystick) {
-        secondaryState.deviceName = currentSecondaryName;
-        int numAxes = SDL_GetNumJoystickAxes(secondaryJoystick);
-        int numButtons = SDL_GetNumJoystickButtons(secondaryJoystick);
-        int numHats = SDL_GetNumJoystickHats(secondaryJoystick);
-
-        secondaryState.axes.resize(numAxes);
-        secondaryState.buttons.resize(numButtons);
-        secondaryState.hats.resize(numHats);
-
-        for (int i = 0; i < numAxes; ++i)
-            secondaryState.axes[i] = SDL_GetJoystickAxis(secondaryJoystick, i);
-        for (int i = 0; i < numButtons; ++i)
-            secondaryState.buttons[i] = SDL_GetJoystickButton(secondaryJoystick, i);
-        for (int i = 0; i < numHats; ++i) {
-            Uint8 hat = SDL_GetJoystickHat(secondaryJoystick, i);
-            QString hatDir;
-            if (hat & SDL_HAT_UP) hatDir += "Up ";
-            if (hat & SDL_HAT_DOWN) hatDir += "Down ";
-            if (hat & SDL_HAT_LEFT) hatDir += "Left ";
-            if (hat & SDL_HAT_RIGHT) hatDir += "Right ";
-            secondaryState.hats[i] = hatDir.trimmed();
-        }
-    }
+void GamepadWorker::clearSlot(Slot &slot)
+{
+    slot = Slot();
+    stateChanged = true;
+}
 
-    if(primaryJoystick || secondaryJoystick){
-        DualJoystickState combined;
-        combined.primary = primaryState;
-        combined.secondary = secondaryState;
-        emit joysticksUpdated(combined);
+void GamepadWorker::rebindSlots()
+{
+    // Выбранное устройство снова подключено - восстанавливаем привязку по имени
+    if (!primarySlot.joystick && currentPrimaryName != NO_DEVICE_NAME && joysticks.contains(currentPrimaryName)) {
+        bindSlot(primarySlot, currentPrimaryName);
+        qDebug() << "Primary Joystick reconnected:" << currentPrimaryName;
+    }
+    if (!secondarySlot.joystick && currentSecondaryName != NO_DEVICE_NAME && joysticks.contains(currentSecondaryName)) {
+        bindSlot(secondarySlot, currentSecondaryName);
+        qDebug() << "Secondary Joystick reconnected:" << currentSecondaryName;
     }
+}
 
-    if (primaryJoystick) {
-        if (primaryAxisValues.empty()) {
-            primaryAxisValues.resize(SDL_GetNumJoystickAxes(primaryJoystick), 0);
+void GamepadWorker::handleEvent(const SDL_Event &event)
+{
+    switch (event.type) {
+    case SDL_EVENT_JOYSTICK_ADDED:
+        updateDeviceList();
+        rebindSlots();
+        break;
+
+    case SDL_EVENT_JOYSTICK_REMOVED: {
+        SDL_JoystickID id = event.jdevice.which;
+        SDL_Joystick *removed = SDL_GetJoystickFromID(id);
+        if (primarySlot.joystick && primarySlot.id == id) {
+            qDebug() << "Primary Joystick disconnected:" << currentPrimaryName;
+            clearSlot(primarySlot);
         }
-
-        for (int i = 0; i < SDL_GetNumJoystickButtons(primaryJoystick); ++i) {
-            if (SDL_GetJoystickButton(primaryJoystick, i)) {
-                emit primaryButtonPressed(i);
-            }
+        if (secondarySlot.joystick && secondarySlot.id == id) {
+            qDebug() << "Secondary Joystick disconnected:" << currentSecondaryName;
+            clearSlot(secondarySlot);
         }
-
-        for (int i = 0; i < SDL_GetNumJoystickAxes(primaryJoystick); ++i) {
-            Sint16 axisValue = SDL_GetJoystickAxis(primaryJoystick, i);
-            if (abs(axisValue) > 1000 && abs(axisValue - primaryAxisValues[i]) > 5000) {
-                emit primaryAxisMoved(i, axisValue);
-                primaryAxisValues[i] = axisValue;
-            } else if (abs(axisValue) <= 1000 && primaryAxisValues[i] != 0) {
-                emit primaryAxisMoved(i, 0);
-                primaryAxisValues[i] = 0;
+        for (auto it = joysticks.begin(); it != joysticks.end(); ++it) {
+            if (it.value() && (it.value() == removed || SDL_GetJoystickID(it.value()) == id)) {
+                SDL_CloseJoystick(it.value());
+                joysticks.erase(it);
+                break;
             }
         }
+        updateDeviceList();
+        break;
+    }
 
-        for (int i = 0; i < SDL_GetNumJoystickHats(primaryJoystick); ++i) {
-            Uint8 hatState = SDL_GetJoystickHat(primaryJoystick, i);
-            if (hatState != SDL_HAT_CENTERED) {
-                if (hatState & SDL_HAT_UP) {
-                    emit primaryHatPressed(i, "Up");
-                }
-                if (hatState & SDL_HAT_DOWN) {
-                    emit primaryHatPressed(i, "Down");
-                }
-                if (hatState & SDL_HAT_LEFT) {
-                    emit primaryHatPressed(i, "Left");
-                }
-                if (hatState & SDL_HAT_RIGHT) {
-                    emit primaryHatPressed(i, "Right");
-                }
-            }
-        }
-    } else {
-        primaryAxisValues.clear();
+    case SDL_EVENT_JOYSTICK_AXIS_MOTION:
+        if (primarySlot.joystick && event.jaxis.which == primarySlot.id)
+            onAxis(primarySlot, true, event.jaxis.axis, event.jaxis.value, event.jaxis.timestamp);
+        if (secondarySlot.joystick && event.jaxis.which == secondarySlot.id)
+            onAxis(secondarySlot, false, event.jaxis.axis, event.jaxis.value, event.jaxis.timestamp);
+        break;
+
+    case SDL_EVENT_JOYSTICK_BUTTON_DOWN:
+    case SDL_EVENT_JOYSTICK_BUTTON_UP:
+        if (primarySlot.joystick && event.jbutton.which == primarySlot.id)
+            onButton(primarySlot, true, event.jbutton.button, event.jbutton.down, event.jbutton.timestamp);
+        if (secondarySlot.joystick && event.jbutton.which == secondarySlot.id)
+            onButton(secondarySlot, false, event.jbutton.button, event.jbutton.down, event.jbutton.timestamp);
+        break;
+
+    case SDL_EVENT_JOYSTICK_HAT_MOTION:
+        if (primarySlot.joystick && event.jhat.which == primarySlot.id)
+            onHat(primarySlot, true, event.jhat.hat, event.jhat.value, event.jhat.timestamp);
+        if (secondarySlot.joystick && event.jhat.which == secondarySlot.id)
+            onHat(secondarySlot, false, event.jhat.hat, event.jhat.value, event.jhat.timestamp);
+        break;
+
+    default:
+        break;
     }
+}
 
-    if (secondaryJoystick) {
-        if (secondaryAxisValues.empty()) {
-            secondaryAxisValues.resize(SDL_GetNumJoystickAxes(secondaryJoystick), 0);
-        }
+void GamepadWorker::onAxis(Slot &slot, bool primary, int axis, Sint16 value, Uint64 timestamp)
+{
+    JoystickState &state = slot.state;
+    if (axis >= state.numAxes || state.axes[axis] == value)
+        return;
+    state.axes[axis] = value;
+    state.timestampNs = timestamp;
+    stateChanged = true;
+
+    // Для назначения осей в ControlWindow - с мёртвой зоной и гистерезисом, как раньше
+    Sint16 &reported = slot.reportedAxes[axis];
+    if (abs(value) > 1000 && abs(value - reported) > 5000) {
+        reported = value;
+        if (primary)
+            emit primaryAxisMoved(axis, value);
+        else
+            emit secondaryAxisMoved(axis, value);
+    } else if (abs(value) <= 1000 && reported != 0) {
+        reported = 0;
+        if (primary)
+            emit primaryAxisMoved(axis, 0);
+        else
+            emit secondaryAxisMoved(axis, 0);
+    }
+}
 
-        for (int i = 0; i < SDL_GetNumJoystickButtons(secondaryJoystick); ++i) {
-            if (SDL_GetJoystickButton(secondaryJoystick, i)) {
-                emit secondaryButtonPressed(i);
-            }
-        }
+void GamepadWorker::onButton(Slot &slot, bool primary, int button, bool down, Uint64 timestamp)
+{
+    JoystickState &state = slot.state;
+    if (button >= state.numButtons)
+        return;
+    quint64 bit = quint64(1) << button;
+    quint64 buttons = down ? (state.buttons | bit) : (state.buttons & ~bit);
+    if (buttons == state.buttons)
+        return;
+    state.buttons = buttons;
+    state.timestampNs = timestamp;
+    stateChanged = true;
 
-        for (int i = 0; i < SDL_GetNumJoystickAxes(secondaryJoystick); ++i) {
-            Sint16 axisValue = SDL_GetJoystickAxis(secondaryJoystick, i);
-            if (abs(axisValue) > 1000 && abs(axisValue - secondaryAxisValues[i]) > 5000) {
-                emit secondaryAxisMoved(i, axisValue);
-                secondaryAxisValues[i] = axisValue;
-            } else if (abs(axisValue) <= 1000 && secondaryAxisValues[i] != 0) {
-                emit secondaryAxisMoved(i, 0);
-                secondaryAxisValues[i] = 0;
-            }
-        }
+    if (!down)
+        return;
+    if (primary)
+        emit primaryButtonPressed(button);
+    else
+        emit secondaryButtonPressed(button);
+}
 
-        for (int i = 0; i < SDL_GetNumJoystickHats(secondaryJoystick); ++i) {
-            Uint8 hatState = SDL_GetJoystickHat(secondaryJoystick, i);
-            if (hatState != SDL_HAT_CENTERED) {
-                if (hatState & SDL_HAT_UP) {
-                    emit secondaryHatPressed(i, "Up");
-                }
-                if (hatState & SDL_HAT_DOWN) {
-                    emit secondaryHatPressed(i, "Down");
-                }
-                if (hatState & SDL_HAT_LEFT) {
-                    emit secondaryHatPressed(i, "Left");
-                }
-                if (hatState & SDL_HAT_RIGHT) {
-                    emit secondaryHatPressed(i, "Right");
-                }
-            }
-        }
-    } else {
-        secondaryAxisValues.clear();
+void GamepadWorker::onHat(Slot &slot, bool primary, int hat, quint8 value, Uint64 timestamp)
+{
+    JoystickState &state = slot.state;
+    if (hat >= state.numHats)
+        return;
+    int shift = 4 * hat;
+    quint32 hats = (state.hats & ~(quint32(0xF) << shift)) | (quint32(value & 0xF) << shift);
+    if (hats == state.hats)
+        return;
+    state.hats = hats;
+    state.timestampNs = timestamp;
+    stateChanged = true;
+
+    static const struct { quint8 mask; const char *name; } directions[] = {
+        {SDL_HAT_UP, "Up"}, {SDL_HAT_DOWN, "Down"}, {SDL_HAT_LEFT, "Left"}, {SDL_HAT_RIGHT, "Right"}
+    };
+    for (const auto &direction : directions) {
+        if (!(value & direction.mask))
+            continue;
+        if (primary)
+            emit primaryHatPressed(hat, direction.name);
+        else
+            emit secondaryHatPressed(hat, direction.name);
     }
+}
 
-
-
+void GamepadWorker::publish()
+{
+    if (!stateChanged)
+        return;
+    stateChanged = false;
+
+    DualJoystickState combined;
+    combined.primary = primarySlot.state;
+    combined.secondary = secondarySlot.state;
+    combined.timestampNs = qMax(combined.primary.timestampNs, combined.secondary.timestampNs);
+    combined.publishedNs = SDL_GetTicksNS();
+    emit joysticksUpdated(combined);
 }
 
 void GamepadWorker::updateDeviceList()
 {
+    if (!sdlReady)
+        return;
+
     int numJoysticks = 0;
     SDL_JoystickID *joystickIds = SDL_GetJoysticks(&numJoysticks);
     if (numJoysticks == lastNumJoysticks && !deviceListChanged) {
@@ -281,27 +333,8 @@ void GamepadWorker::updateDeviceList()
                 deviceNames << deviceName;
             }
         }
-        SDL_free(joystickIds);
     }
+    SDL_free(joystickIds);
 
     emit deviceListUpdated(deviceNames);
 }
-
-void GamepadWorker::deactivateJoystick(SDL_Joystick *&joystick)
-{
-    // if (joystick) {
-    //     QString nameToRemove;
-    //     for (const QString &name : joysticks.keys()) {
-    //         if (joysticks[name] == joystick && name != currentPrimaryName && name != currentSecondaryName) {
-    //             nameToRemove = name;
-    //             break;
-    //         }
-    //     }
-    //     if (!nameToRemove.isEmpty()) {
-    //         joysticks.remove(nameToRemove);
-    //         SDL_CloseJoystick(joystick);
-    //     }
-    //     joystick = nullptr;
-    //     qDebug() << "Joystick deactivated";
-    // }
-}
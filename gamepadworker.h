@@ -4,22 +4,44 @@
 #include <QObject>
 #include <SDL3/SDL.h>
 #include <QMap>
+#include <array>
+#include <atomic>
 
+// Состояние одного джойстика фиксированного размера: без аллокаций при каждом изменении
 struct JoystickState {
+    static const int MAX_AXES = 16;
+    static const int MAX_BUTTONS = 64;
+    static const int MAX_HATS = 8;
+
     QString deviceName;
-    QVector<Sint16> axes;
-    QVector<bool> buttons;
-    QVector<QString> hats;
+    quint8 numAxes = 0;
+    quint8 numButtons = 0;
+    quint8 numHats = 0;
+    std::array<Sint16, MAX_AXES> axes{};
+    quint64 buttons = 0;        // Бит i - кнопка i нажата
+    quint32 hats = 0;           // По 4 бита на хатку, значения SDL_HAT_*
+    Uint64 timestampNs = 0;     // Время последнего изменения (SDL_GetTicksNS)
+
+    Sint16 axis(int i) const { return (i >= 0 && i < numAxes) ? axes[i] : 0; }
+    bool button(int i) const { return i >= 0 && i < numButtons && ((buttons >> i) & 1); }
+    quint8 hat(int i) const { return (i >= 0 && i < numHats) ? quint8((hats >> (4 * i)) & 0xF) : 0; }
+
+    // "Up", "Down", "Left", "Right" -> маска SDL_HAT_*
+    static quint8 hatDirectionMask(const QString &direction);
 };
 
 struct DualJoystickState {
     JoystickState primary;
     JoystickState secondary;
+    Uint64 timestampNs = 0;     // Время самого свежего изменения
+    Uint64 publishedNs = 0;     // Время публикации состояния потоком ввода
 };
 
 Q_DECLARE_METATYPE(JoystickState)
 Q_DECLARE_METATYPE(DualJoystickState)
 
+// Поток ввода на событиях SDL: ждёт события через SDL_WaitEventTimeout
+// и публикует состояние только при изменении
 class GamepadWorker : public QObject {
     Q_OBJECT
 
@@ -27,15 +49,15 @@ public:
     explicit GamepadWorker(QObject *parent = nullptr);
     ~GamepadWorker();
 
-    void setPrimaryDevice(const QString &deviceName);
-    void setSecondaryDevice(const QString &deviceName);
     bool hasDeviceListChanged() const { return deviceListChanged; }
-    void pollDevices();
-    void updateDeviceList();
     void resetDeviceListChanged() { deviceListChanged = false; }
 
 public slots:
+    void run();
     void stop();
+    void setPrimaryDevice(const QString &deviceName);
+    void setSecondaryDevice(const QString &deviceName);
+    void updateDeviceList();
 
 signals:
     void primaryButtonPressed(int button);
@@ -48,20 +70,36 @@ signals:
     void joysticksUpdated(const DualJoystickState &state);
 
 private:
-    void deactivateJoystick(SDL_Joystick *&joystick);
+    // Джойстик, выбранный как основной или дополнительный, и его текущее состояние
+    struct Slot {
+        SDL_Joystick *joystick = nullptr;
+        SDL_JoystickID id = 0;
+        JoystickState state;
+        std::array<Sint16, JoystickState::MAX_AXES> reportedAxes{}; // Для сигналов *AxisMoved с гистерезисом
+    };
+
+    void handleEvent(const SDL_Event &event);
+    void bindSlot(Slot &slot, const QString &deviceName);
+    void clearSlot(Slot &slot);
+    void rebindSlots();
+    void publish();
+
+    void onAxis(Slot &slot, bool primary, int axis, Sint16 value, Uint64 timestamp);
+    void onButton(Slot &slot, bool primary, int button, bool down, Uint64 timestamp);
+    void onHat(Slot &slot, bool primary, int hat, quint8 value, Uint64 timestamp);
 
-    SDL_Joystick *primaryJoystick = nullptr;
-    SDL_Joystick *secondaryJoystick = nullptr;
+    Slot primarySlot;
+    Slot secondarySlot;
     QString currentPrimaryName;
     QString currentSecondaryName;
     int lastNumJoysticks = -1;
-    bool deviceListChanged = false;
-    QTimer *timer;
-    bool running = true;
+    std::atomic<bool> deviceListChanged{false};
+    std::atomic<bool> running{true};
+    bool stateChanged = false;
+    bool sdlReady = false;
     QMap<QString, SDL_Joystick*> joysticks;
-    std::vector<Sint16> primaryAxisValues;
-    std::vector<Sint16> secondaryAxisValues;
 
+    static const int WAIT_TIMEOUT_MS = 100;
     static const QString NO_DEVICE_NAME;
 };
 
@@ -0,0 +1,57 @@
+#include "latencyhistogram.h"
+#include <algorithm>
+#include <cmath>
+
+int LatencyHistogram::bucketIndex(double us)
+{
+    if (us <= 1.0)
+        return 0;
+    int index = 1 + int(std::log10(us) * BUCKETS_PER_DECADE);
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+double LatencyHistogram::bucketUpperUs(int index)
+{
+    return std::pow(10.0, double(index) / BUCKETS_PER_DECADE);
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if (ns < 0)
+        ns = 0;
+    buckets[bucketIndex(ns / 1000.0)]++;
+    count++;
+    maxNs = std::max(maxNs, ns);
+}
+
+void LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    count = 0;
+    maxNs = 0;
+}
+
+double LatencyHistogram::percentileUs(double p) const
+{
+    if (count == 0)
+        return 0;
+    quint64 target = quint64(std::ceil(p * count));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return std::min(bucketUpperUs(i), maxNs / 1000.0);
+    }
+    return maxNs / 1000.0;
+}
+
+LatencyStageStats LatencyHistogram::stats(const QString &name) const
+{
+    LatencyStageStats s;
+    s.name = name;
+    s.count = count;
+    s.p50Us = percentileUs(0.50);
+    s.p99Us = percentileUs(0.99);
+    s.maxUs = maxNs / 1000.0;
+    return s;
+}
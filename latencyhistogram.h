@@ -0,0 +1,46 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QVector>
+#include <QMetaType>
+#include <array>
+
+// Сводка по одному этапу тракта управления, микросекунды
+struct LatencyStageStats {
+    QString name;
+    quint64 count = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+};
+
+struct ControlLatencyStats {
+    QVector<LatencyStageStats> stages;
+};
+
+Q_DECLARE_METATYPE(ControlLatencyStats)
+
+// Гистограмма задержек с логарифмическими корзинами: 1 мкс .. ~10 с, 16 корзин на декаду.
+// Запись без аллокаций, перцентили с точностью до ширины корзины (~15%).
+class LatencyHistogram {
+public:
+    void record(qint64 ns);
+    void reset();
+    LatencyStageStats stats(const QString &name) const;
+
+private:
+    static const int BUCKETS_PER_DECADE = 16;
+    static const int DECADES = 7;
+    static const int BUCKET_COUNT = BUCKETS_PER_DECADE * DECADES + 1;
+
+    static int bucketIndex(double us);
+    static double bucketUpperUs(int index);
+    double percentileUs(double p) const;
+
+    std::array<quint64, BUCKET_COUNT> buckets{};
+    quint64 count = 0;
+    qint64 maxNs = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
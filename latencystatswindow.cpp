@@ -0,0 +1,52 @@
+#include "latencystatswindow.h"
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+LatencyStatsWindow::LatencyStatsWindow(QWidget *parent)
+    : QWidget(parent)
+{
+    setWindowTitle("Задержки управления");
+    resize(560, 220);
+
+    table = new QTableWidget(0, 5, this);
+    table->setHorizontalHeaderLabels({"Этап", "Событий", "p50, мкс", "p99, мкс", "max, мкс"});
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table->verticalHeader()->setVisible(false);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+
+    resetButton = new QPushButton("Сбросить", this);
+    connect(resetButton, &QPushButton::clicked, this, &LatencyStatsWindow::resetRequested);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addWidget(resetButton, 0, Qt::AlignRight);
+}
+
+void LatencyStatsWindow::updateStats(const ControlLatencyStats &stats)
+{
+    if (!isVisible())
+        return;
+
+    table->setRowCount(stats.stages.size());
+    for (int row = 0; row < stats.stages.size(); ++row) {
+        const LatencyStageStats &stage = stats.stages[row];
+        const QStringList values = {
+            stage.name,
+            QString::number(stage.count),
+            QString::number(stage.p50Us, 'f', 1),
+            QString::number(stage.p99Us, 'f', 1),
+            QString::number(stage.maxUs, 'f', 1)
+        };
+        for (int column = 0; column < values.size(); ++column) {
+            QTableWidgetItem *item = table->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                if (column > 0)
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                table->setItem(row, column, item);
+            }
+            item->setText(values[column]);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef LATENCYSTATSWINDOW_H
+#define LATENCYSTATSWINDOW_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include "latencyhistogram.h"
+
+// Окно статистики задержек тракта управления (F3)
+class LatencyStatsWindow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit LatencyStatsWindow(QWidget *parent = nullptr);
+
+public slots:
+    void updateStats(const ControlLatencyStats &stats);
+
+signals:
+    void resetRequested();
+
+private:
+    QTableWidget *table;
+    QPushButton *resetButton;
+};
+
+#endif // LATENCYSTATSWINDOW_H
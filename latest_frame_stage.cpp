@@ -0,0 +1,27 @@
+#include "latest_frame_stage.h"
+
+LatestFrameStage::LatestFrameStage(QThread::Priority priority, QObject* parent)
+    : QObject(parent), m_timer(new QTimer(this)) {
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(priority);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &LatestFrameStage::tick);
+}
+
+LatestFrameStage::~LatestFrameStage() {
+    m_timer->stop();
+    m_pool.waitForDone();
+}
+
+void LatestFrameStage::start(double rateHz) {
+    m_generation++;
+    m_busy = false;
+    m_lastFrameNs = 0;
+    m_skipped = 0;
+    m_timer->start(qRound(1000.0 / rateHz));
+}
+
+void LatestFrameStage::stop() {
+    m_timer->stop();
+    m_generation++;
+}
@@ -0,0 +1,79 @@
+#ifndef LATEST_FRAME_STAGE_H
+#define LATEST_FRAME_STAGE_H
+
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+// Основа фоновых стадий, которые по таймеру берут последний кадр камеры.
+// Обработка идёт в собственном пуле из одного потока. Очереди кадров нет: пока обрабатывается
+// предыдущий кадр, новые пропускаются и считаются в skipped(), стадия отстаёт по частоте,
+// но не по задержке. Результат возвращается в поток стадии; результаты обработок, начатых
+// до stop() или нового start(), отбрасываются. Работа в пуле получает всё нужное копией
+// и не обращается к владельцу стадии.
+class LatestFrameStage : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LatestFrameStage(QThread::Priority priority, QObject* parent = nullptr);
+    ~LatestFrameStage() override;
+
+    void start(double rateHz);
+    void stop();
+    bool isActive() const { return m_timer->isActive(); }
+    quint64 skipped() const { return m_skipped; }
+    void waitForDone() { m_pool.waitForDone(); }
+
+    // Обработка кадра со временем frameNs: work() в пуле, done(результат) в потоке стадии.
+    // false - этот кадр уже брался или обработка предыдущего ещё идёт
+    template <typename Work, typename Done>
+    bool process(qint64 frameNs, Work work, Done done);
+    // Задание вне кадров (например, запись результата): не пропускается и не отбрасывается,
+    // выполняется после уже запущенной обработки
+    template <typename Work, typename Done>
+    void post(Work work, Done done);
+
+signals:
+    void tick();
+
+private:
+    QTimer* m_timer;
+    QThreadPool m_pool;
+    bool m_busy = false;
+    quint64 m_generation = 0;   // Меняется при start()/stop(), устаревшие результаты не применяются
+    qint64 m_lastFrameNs = 0;
+    quint64 m_skipped = 0;
+};
+
+template <typename Work, typename Done>
+bool LatestFrameStage::process(qint64 frameNs, Work work, Done done) {
+    if (frameNs == m_lastFrameNs) return false;
+    m_lastFrameNs = frameNs;
+    if (m_busy) {
+        m_skipped++;
+        return false;
+    }
+    m_busy = true;
+
+    const quint64 generation = m_generation;
+    m_pool.start([this, generation, work, done]() {
+        const auto result = work();
+        QMetaObject::invokeMethod(this, [this, generation, done, result]() {
+            if (generation != m_generation) return;
+            m_busy = false;
+            done(result);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+template <typename Work, typename Done>
+void LatestFrameStage::post(Work work, Done done) {
+    m_pool.start([this, work, done]() {
+        const auto result = work();
+        QMetaObject::invokeMethod(this, [done, result]() { done(result); }, Qt::QueuedConnection);
+    });
+}
+
+#endif // LATEST_FRAME_STAGE_H
@@ -0,0 +1,162 @@
+#include "linkmonitor.h"
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+LinkMonitor::LinkMonitor(QObject *parent)
+    : QObject(parent),
+    heartbeats(WINDOW_SIZE),
+    rttSamples(WINDOW_SIZE, 0.0)
+{
+    qRegisterMetaType<LinkStats>("LinkStats");
+    clock.start();
+    logTimer.start();
+}
+
+bool LinkMonitor::isHeartbeat(const QByteArray &data)
+{
+    return data.size() == HEARTBEAT_SIZE &&
+           quint8(data[0]) == 0xAA &&
+           quint8(data[1]) == 0xFE;
+}
+
+QByteArray LinkMonitor::makeHeartbeat()
+{
+    quint32 seq = nextSeq++;
+    qint64 nowNs = clock.nsecsElapsed();
+
+    HeartbeatSlot &slot = heartbeats[seq % WINDOW_SIZE];
+    slot.seq = seq;
+    slot.sentNs = nowNs;
+    slot.acked = false;
+    slot.used = true;
+
+    QByteArray packet;
+    QDataStream stream(&packet, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint8(0xAA) << quint8(0xFE) << seq << nowNs;
+    return packet;
+}
+
+void LinkMonitor::heartbeatEchoReceived(const QByteArray &data)
+{
+    if (!isHeartbeat(data))
+        return;
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint8 header0, header1;
+    quint32 seq;
+    qint64 sentNs;
+    stream >> header0 >> header1 >> seq >> sentNs;
+
+    qint64 nowNs = clock.nsecsElapsed();
+    lastRxNs = nowNs;
+
+    HeartbeatSlot &slot = heartbeats[seq % WINDOW_SIZE];
+    // Слот уже перезаписан более новым heartbeat'ом или эхо продублировано
+    if (!slot.used || slot.seq != seq || slot.acked)
+        return;
+    slot.acked = true;
+    echoSupported = true;
+
+    double rttMs = double(nowNs - slot.sentNs) / 1e6;
+    rttSamples[rttHead] = rttMs;
+    rttHead = (rttHead + 1) % WINDOW_SIZE;
+    rttCount = std::min(rttCount + 1, int(WINDOW_SIZE));
+
+    if (prevRttMs >= 0) {
+        double d = std::abs(rttMs - prevRttMs);
+        jitterMs += (d - jitterMs) / 16.0;
+    }
+    prevRttMs = rttMs;
+    currentStats.rttLastMs = rttMs;
+}
+
+void LinkMonitor::packetReceived()
+{
+    lastRxNs = clock.nsecsElapsed();
+}
+
+void LinkMonitor::setThresholds(int timeoutMs, double maxLossPercent, double maxRttMs)
+{
+    LinkMonitor::timeoutMs = timeoutMs > 0 ? timeoutMs : LinkMonitor::timeoutMs;
+    LinkMonitor::maxLossPercent = maxLossPercent > 0 ? maxLossPercent : LinkMonitor::maxLossPercent;
+    LinkMonitor::maxRttMs = maxRttMs > 0 ? maxRttMs : LinkMonitor::maxRttMs;
+    qDebug() << "[LinkMonitor] Пороги: таймаут" << LinkMonitor::timeoutMs << "мс, потери"
+             << LinkMonitor::maxLossPercent << "%, RTT" << LinkMonitor::maxRttMs << "мс";
+}
+
+static double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    int idx = std::clamp(int(std::ceil(p * sorted.size())) - 1, 0, int(sorted.size()) - 1);
+    return sorted[idx];
+}
+
+void LinkMonitor::evaluate()
+{
+    qint64 nowNs = clock.nsecsElapsed();
+    qint64 timeoutNs = qint64(timeoutMs) * 1000000;
+
+    LinkStats s;
+    s.echoSupported = echoSupported;
+    s.rttLastMs = currentStats.rttLastMs;
+    s.sinceLastRxMs = lastRxNs < 0 ? -1 : double(nowNs - lastRxNs) / 1e6;
+    s.online = lastRxNs >= 0 && (nowNs - lastRxNs) <= timeoutNs;
+
+    // Без связи окно потерь не копим, иначе после восстановления оно будет забито потерями
+    if (!s.online) {
+        for (HeartbeatSlot &slot : heartbeats)
+            slot.used = false;
+    }
+
+    // Heartbeat считается потерянным, если эхо не пришло за время таймаута
+    for (const HeartbeatSlot &slot : std::as_const(heartbeats)) {
+        if (!slot.used || nowNs - slot.sentNs < timeoutNs)
+            continue;
+        s.windowSent++;
+        if (!slot.acked)
+            s.windowLost++;
+    }
+    s.lossPercent = s.windowSent ? 100.0 * s.windowLost / s.windowSent : 0;
+
+    QVector<double> sorted(rttSamples.begin(), rttSamples.begin() + rttCount);
+    std::sort(sorted.begin(), sorted.end());
+    s.rttP50Ms = percentile(sorted, 0.50);
+    s.rttP95Ms = percentile(sorted, 0.95);
+    s.rttP99Ms = percentile(sorted, 0.99);
+    s.rttMaxMs = sorted.isEmpty() ? 0 : sorted.last();
+    s.jitterMs = jitterMs;
+
+    // Пока аппарат не ответил ни на один heartbeat, RTT и потери недостоверны.
+    // Полная потеря связи отражается в online, а не в failsafe.
+    s.failsafe = s.online && echoSupported &&
+                 (s.lossPercent > maxLossPercent || s.rttP95Ms > maxRttMs);
+
+    bool failsafeChangedFlag = s.failsafe != currentStats.failsafe;
+    currentStats = s;
+
+    if (failsafeChangedFlag) {
+        if (s.failsafe) {
+            qWarning() << "[LinkMonitor] Деградация связи: потери" << s.lossPercent << "% RTT p95" << s.rttP95Ms << "мс";
+        } else {
+            qInfo() << "[LinkMonitor] Связь в норме";
+        }
+        emit failsafeChanged(s.failsafe);
+    }
+
+    if (logTimer.elapsed() >= 10000) {
+        logTimer.restart();
+        if (s.online) {
+            qInfo().nospace() << "[LinkMonitor] RTT p50=" << s.rttP50Ms << " p95=" << s.rttP95Ms
+                              << " p99=" << s.rttP99Ms << " max=" << s.rttMaxMs << " мс, джиттер="
+                              << s.jitterMs << " мс, потери=" << s.lossPercent << "% ("
+                              << s.windowLost << "/" << s.windowSent << ")";
+        }
+    }
+
+    emit statsUpdated(s);
+}
@@ -0,0 +1,83 @@
+#ifndef LINKMONITOR_H
+#define LINKMONITOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+
+// Сводка качества канала связи с аппаратом
+struct LinkStats {
+    bool online = false;          // Есть пакеты от аппарата в пределах таймаута
+    bool failsafe = false;        // Превышен один из порогов качества связи
+    bool echoSupported = false;   // Аппарат отвечает на heartbeat (RTT/потери достоверны)
+    quint32 windowSent = 0;       // Heartbeat'ов в окне оценки потерь
+    quint32 windowLost = 0;       // Из них потеряно
+    double lossPercent = 0;       // Потери, %
+    double rttLastMs = 0;         // Последний RTT, мс
+    double rttP50Ms = 0;
+    double rttP95Ms = 0;
+    double rttP99Ms = 0;
+    double rttMaxMs = 0;
+    double jitterMs = 0;          // Сглаженный джиттер RTT (RFC 3550), мс
+    double sinceLastRxMs = 0;     // Время с последнего пакета от аппарата, мс
+};
+
+Q_DECLARE_METATYPE(LinkStats)
+
+// Измерение RTT, потерь и джиттера по нумерованным heartbeat-пакетам.
+// Формат heartbeat: 0xAA 0xFE, quint32 seq, qint64 время отправки (нс), little-endian.
+// Аппарат возвращает пакет без изменений.
+class LinkMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LinkMonitor(QObject *parent = nullptr);
+
+    static const int HEARTBEAT_SIZE = 14;
+    static bool isHeartbeat(const QByteArray &data);
+
+    QByteArray makeHeartbeat();
+    void heartbeatEchoReceived(const QByteArray &data);
+    void packetReceived();
+    void setThresholds(int timeoutMs, double maxLossPercent, double maxRttMs);
+    void evaluate();
+
+    LinkStats stats() const { return currentStats; }
+    bool isOnline() const { return currentStats.online; }
+    bool isFailsafe() const { return currentStats.failsafe; }
+
+signals:
+    void statsUpdated(const LinkStats &stats);
+    void failsafeChanged(const bool &failsafe);
+
+private:
+    struct HeartbeatSlot {
+        quint32 seq = 0;
+        qint64 sentNs = 0;
+        bool acked = false;
+        bool used = false;
+    };
+
+    static const int WINDOW_SIZE = 200;
+
+    QElapsedTimer clock;
+    QElapsedTimer logTimer;
+    QVector<HeartbeatSlot> heartbeats;
+    QVector<double> rttSamples;
+    int rttHead = 0;
+    int rttCount = 0;
+    quint32 nextSeq = 0;
+    qint64 lastRxNs = -1;
+    double prevRttMs = -1;
+    double jitterMs = 0;
+    bool echoSupported = false;
+
+    int timeoutMs = 1000;
+    double maxLossPercent = 20.0;
+    double maxRttMs = 250.0;
+
+    LinkStats currentStats;
+};
+
+#endif // LINKMONITOR_H
@@ -1,15 +1,141 @@
 #include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 
 QFile Logger::logFile;
 QMutex Logger::logMutex;
 QString Logger::logDirectory = "logs";
 qint64 Logger::maxLogFileSize = 5 * 1024 * 1024; // 5 МБ по умолчанию
 int Logger::maxLogFiles = 10; // Хранить до 10 лог-файлов
+int Logger::flushIntervalMs = 200;
+int Logger::rateLimitPerSecond = 20;
+
+namespace {
+
+// Запись очереди. Форматирование строки откладывается до фонового потока.
+struct LogRecord {
+    std::atomic<LogRecord*> next{nullptr};
+    QtMsgType type = QtDebugMsg;
+    qint64 timeMs = 0;
+    const char* file = nullptr;   // Строковый литерал __FILE__, живёт всё время работы программы
+    int line = 0;
+    quint32 suppressed = 0;       // Сколько повторов с этого места было подавлено перед записью
+    QString message;
+};
+
+// Intrusive MPSC-очередь Вьюкова: производители делают один atomic exchange, без блокировок
+LogRecord queueStub;
+std::atomic<LogRecord*> queueHead{&queueStub};
+LogRecord* queueTail = &queueStub;
+std::atomic<int> pendingCount{0};
+std::atomic<quint64> droppedCount{0};
+const int MAX_PENDING = 100000;
+
+void pushRecord(LogRecord* record) {
+    record->next.store(nullptr, std::memory_order_relaxed);
+    LogRecord* prev = queueHead.exchange(record, std::memory_order_acq_rel);
+    prev->next.store(record, std::memory_order_release);
+}
+
+// Вызывается только из потока-писателя (или под logMutex)
+LogRecord* popRecord() {
+    LogRecord* tail = queueTail;
+    LogRecord* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &queueStub) {
+        if (!next)
+            return nullptr;
+        queueTail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        queueTail = next;
+        return tail;
+    }
+    if (tail != queueHead.load(std::memory_order_acquire))
+        return nullptr; // Производитель ещё не связал свою запись, заберём на следующем проходе
+    pushRecord(&queueStub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        queueTail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+// Ограничение частоты по месту вызова: фиксированная таблица слотов на атомиках, коллизии допустимы
+struct SiteSlot {
+    std::atomic<quint64> key{0};
+    std::atomic<qint64> windowStartMs{0};
+    std::atomic<int> count{0};
+    std::atomic<quint32> suppressed{0};
+};
+const int SITE_COUNT = 1024;
+SiteSlot sites[SITE_COUNT];
+
+// Возвращает false, если сообщение нужно подавить; в suppressed - сколько повторов было подавлено до него
+bool admitSite(quint64 key, qint64 nowMs, int limit, quint32& suppressed) {
+    SiteSlot& slot = sites[key % SITE_COUNT];
+    if (slot.key.load(std::memory_order_relaxed) != key) {
+        slot.key.store(key, std::memory_order_relaxed);
+        slot.windowStartMs.store(nowMs, std::memory_order_relaxed);
+        slot.count.store(0, std::memory_order_relaxed);
+        slot.suppressed.store(0, std::memory_order_relaxed);
+    }
+    qint64 start = slot.windowStartMs.load(std::memory_order_relaxed);
+    if (nowMs - start >= 1000 && slot.windowStartMs.compare_exchange_strong(start, nowMs, std::memory_order_relaxed))
+        slot.count.store(0, std::memory_order_relaxed);
+    if (slot.count.fetch_add(1, std::memory_order_relaxed) < limit) {
+        suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+std::thread writerThread;
+std::mutex wakeMutex;
+std::condition_variable wakeCondition;
+std::atomic<bool> writerRunning{false};
+std::atomic<bool> urgentPending{false};
+
+const char* typeName(QtMsgType type) {
+    switch (type) {
+    case QtDebugMsg: return "DEBUG";
+    case QtInfoMsg: return "INFO";
+    case QtWarningMsg: return "WARNING";
+    case QtCriticalMsg: return "CRITICAL";
+    case QtFatalMsg: return "FATAL";
+    }
+    return "DEBUG";
+}
+
+} // namespace
 
 void Logger::installMessageHandler() {
+    if (!writerRunning.exchange(true)) {
+        writerThread = std::thread(&Logger::writerLoop);
+        std::atexit(&Logger::shutdown);
+    }
     qInstallMessageHandler(messageHandler);
 }
 
+void Logger::shutdown() {
+    if (writerRunning.exchange(false)) {
+        wakeCondition.notify_one();
+        if (writerThread.joinable())
+            writerThread.join();
+    }
+    // Всё, что успело попасть в очередь после остановки потока
+    drainQueue();
+}
+
 void Logger::setLogDirectory(const QString& directory) {
     logDirectory = directory;
 }
@@ -22,63 +148,144 @@ void Logger::setMaxLogFiles(int count) {
     maxLogFiles = count > 0 ? count : maxLogFiles;
 }
 
+void Logger::setFlushInterval(int ms) {
+    flushIntervalMs = ms > 0 ? ms : flushIntervalMs;
+}
+
+void Logger::setRateLimit(int perSecond) {
+    rateLimitPerSecond = perSecond >= 0 ? perSecond : rateLimitPerSecond;
+}
+
 void Logger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
-    QMutexLocker locker(&logMutex);
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const bool urgent = type == QtWarningMsg || type == QtCriticalMsg || type == QtFatalMsg;
 
-    // Открываем лог-файл, если он ещё не открыт
-    if (!logFile.isOpen()) {
-        logFile.setFileName(getLogFilePath());
-        if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            // Если файл не открывается, выводим в stderr
-            fprintf(stderr, "Не удалось открыть лог-файл: %s\n", qPrintable(logFile.errorString()));
+    // Критические сообщения не подавляются никогда
+    quint32 suppressed = 0;
+    if (rateLimitPerSecond > 0 && type != QtCriticalMsg && type != QtFatalMsg) {
+        // Без QT_MESSAGELOGCONTEXT файла и строки нет - место вызова определяем по началу текста
+        quint64 key = context.file
+                          ? (quint64(reinterpret_cast<quintptr>(context.file)) * 31 + quint64(context.line)) * 2654435761ULL
+                          : quint64(qHash(QStringView(msg).left(48))) * 2654435761ULL + 1;
+        if (!admitSite(key, nowMs, rateLimitPerSecond, suppressed))
             return;
-        }
     }
 
-    // Проверяем размер файла и выполняем ротацию при необходимости
-    if (logFile.size() >= maxLogFileSize) {
-        logFile.close();
-        rotateLogs();
-        logFile.setFileName(getLogFilePath());
-        if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            fprintf(stderr, "Не удалось открыть лог-файл после ротации: %s\n", qPrintable(logFile.errorString()));
-            return;
-        }
+    // Если писатель не успевает, отбрасываем отладочные сообщения, а не растим память
+    if (!urgent && pendingCount.load(std::memory_order_relaxed) >= MAX_PENDING) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
 
-    QTextStream out(&logFile);
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    QString messageType;
-    switch (type) {
-    case QtDebugMsg: messageType = "DEBUG"; break;
-    case QtInfoMsg: messageType = "INFO"; break;
-    case QtWarningMsg: messageType = "WARNING"; break;
-    case QtCriticalMsg: messageType = "CRITICAL"; break;
-    case QtFatalMsg: messageType = "FATAL"; break;
+    LogRecord* record = new LogRecord;
+    record->type = type;
+    record->timeMs = nowMs;
+    record->file = context.file;
+    record->line = context.line;
+    record->suppressed = suppressed;
+    record->message = msg;
+    pendingCount.fetch_add(1, std::memory_order_relaxed);
+    pushRecord(record);
+
+    if (type == QtFatalMsg) {
+        shutdown();
+        abort();
+    }
+
+    if (!writerRunning.load(std::memory_order_relaxed)) {
+        // Поток-писатель уже остановлен (завершение программы) - пишем синхронно
+        drainQueue();
+    } else if (urgent) {
+        urgentPending.store(true, std::memory_order_release);
+        wakeCondition.notify_one();
+    }
+}
+
+void Logger::writerLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (true) {
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(flushIntervalMs), [] {
+            return urgentPending.load(std::memory_order_acquire) || !writerRunning.load(std::memory_order_acquire);
+        });
+        const bool stopping = !writerRunning.load(std::memory_order_acquire);
+        urgentPending.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        drainQueue();
+        lock.lock();
+        if (stopping)
+            break;
+    }
+}
+
+void Logger::drainQueue() {
+    QMutexLocker locker(&logMutex);
+
+    QByteArray batch;
+    int drained = 0;
+    while (LogRecord* record = popRecord()) {
+        // Формат: [Время] [Тип] [Файл:Строка] Сообщение
+        QString logMessage = QString("[%1] [%2] [%3:%4] %5")
+                                 .arg(QDateTime::fromMSecsSinceEpoch(record->timeMs).toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                                 .arg(typeName(record->type))
+                                 .arg(record->file ? QString(record->file) : "unknown")
+                                 .arg(record->line)
+                                 .arg(record->message);
+        if (record->suppressed > 0)
+            logMessage += QString(" [подавлено повторов: %1]").arg(record->suppressed);
+        batch += logMessage.toUtf8();
+        batch += '\n';
+        ++drained;
+        if (record != &queueStub)
+            delete record;
+    }
+    pendingCount.fetch_sub(drained, std::memory_order_relaxed);
+
+    quint64 dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        batch += QString("[%1] [WARNING] [logger] Очередь лога переполнена, отброшено сообщений: %2\n")
+                     .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                     .arg(dropped)
+                     .toUtf8();
     }
 
-    // Формат: [Время] [Тип] [Файл:Строка] Сообщение
-    QString logMessage = QString("[%1] [%2] [%3:%4] %5\n")
-                             .arg(timestamp)
-                             .arg(messageType)
-                             .arg(context.file ? QString(context.file) : "unknown")
-                             .arg(context.line)
-                             .arg(msg);
+    if (!batch.isEmpty())
+        writeBatch(batch, true);
+}
 
-    out << logMessage;
-    out.flush();
+bool Logger::openLogFile() {
+    if (logFile.isOpen())
+        return true;
+    logFile.setFileName(getLogFilePath());
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        // Если файл не открывается, выводим в stderr
+        fprintf(stderr, "Не удалось открыть лог-файл: %s\n", qPrintable(logFile.errorString()));
+        return false;
+    }
+    return true;
+}
 
+void Logger::writeBatch(const QByteArray& batch, bool flush) {
     // Также выводим в консоль для отладки
-    fprintf(stderr, "%s", qPrintable(logMessage));
+    fwrite(batch.constData(), 1, batch.size(), stderr);
 
-    if (type == QtFatalMsg) {
+    if (!openLogFile())
+        return;
+
+    // Проверяем размер файла и выполняем ротацию при необходимости
+    if (logFile.size() >= maxLogFileSize) {
         logFile.close();
-        abort();
+        rotateLogs(logDirectory, ".log", maxLogFiles);
+        if (!openLogFile())
+            return;
     }
+
+    logFile.write(batch);
+    if (flush)
+        logFile.flush();
 }
 
-void Logger::rotateLogs() {
-    std::filesystem::path logDir = logDirectory.toStdString();
+void Logger::rotateLogs(const QString& directory, const QString& extension, int maxFiles) {
+    std::filesystem::path logDir = directory.toStdString();
     if (!std::filesystem::exists(logDir)) {
         std::filesystem::create_directory(logDir);
     }
@@ -86,7 +293,7 @@ void Logger::rotateLogs() {
     // Получаем список существующих лог-файлов
     std::vector<std::filesystem::path> logFiles;
     for (const auto& entry : std::filesystem::directory_iterator(logDir)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".log") {
+        if (entry.is_regular_file() && entry.path().extension() == extension.toStdString()) {
             logFiles.push_back(entry.path());
         }
     }
@@ -96,14 +303,14 @@ void Logger::rotateLogs() {
         return std::filesystem::last_write_time(a) < std::filesystem::last_write_time(b);
     });
 
-    // Удаляем старые файлы, если их больше maxLogFiles
-    while (logFiles.size() >= static_cast<size_t>(maxLogFiles)) {
+    // Удаляем старые файлы, если их больше maxFiles
+    while (!logFiles.empty() && logFiles.size() >= static_cast<size_t>(maxFiles)) {
         try {
             std::filesystem::remove(logFiles.front());
-            logFiles.erase(logFiles.begin());
         } catch (const std::filesystem::filesystem_error& e) {
             fprintf(stderr, "Ошибка удаления старого лог-файла: %s\n", e.what());
         }
+        logFiles.erase(logFiles.begin());
     }
 }
 
@@ -124,4 +331,3 @@ QString Logger::getLogFilePath() {
     ss << std::put_time(&timeInfo, "chersonesos_%Y%m%d_%H%M%S.log");
     return QString::fromStdString((logDir / ss.str()).string());
 }
-
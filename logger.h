@@ -10,22 +10,35 @@
 #include <filesystem>
 #include <sstream>
 
+// Асинхронный логгер: обработчик сообщений Qt только ставит запись в lock-free очередь (MPSC),
+// форматирование и запись в файл пачками выполняет фоновый поток.
+// Повторяющиеся сообщения из одного места кода ограничиваются по частоте.
 class Logger {
 public:
     static void installMessageHandler();
+    static void shutdown();                     // Дописывает очередь и останавливает фоновый поток
     static void setLogDirectory(const QString& directory);
     static void setMaxLogFileSize(qint64 size); // В байтах
     static void setMaxLogFiles(int count);
+    static void setFlushInterval(int ms);       // Период сброса пачки на диск
+    static void setRateLimit(int perSecond);    // Сообщений в секунду с одного места кода, 0 - без ограничения
+    // Удаляет самые старые файлы с расширением extension, чтобы после создания нового их было не больше maxFiles
+    static void rotateLogs(const QString& directory, const QString& extension, int maxFiles);
 
 private:
     static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
-    static void rotateLogs();
+    static void writerLoop();
+    static void drainQueue();
+    static bool openLogFile();
+    static void writeBatch(const QByteArray& batch, bool flush);
     static QString getLogFilePath();
     static QFile logFile;
     static QMutex logMutex;
     static QString logDirectory;
     static qint64 maxLogFileSize;
     static int maxLogFiles;
+    static int flushIntervalMs;
+    static int rateLimitPerSecond;
 };
 
 #endif // LOGGER_H
@@ -1,20 +1,172 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+#include <memory>
 #include "logger.h"
+#include "eventlog.h"
+#include "persistenceservice.h"
 #include "settingsmanager.h"
+#include "rovsimulator.h"
+#include "camera_benchmark.h"
+#include "control_benchmark.h"
+#include "stereo_calibrator.h"
+#include "frame_quality.h"
+#include "visual_odometry.h"
+#include "stereo_auto_capture.h"
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    // Без GUI работают имитатор аппарата и замеры, поэтому QApplication не нужен
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--simulator-only") == 0 || qstrcmp(argv[i], "--bench-camera") == 0 ||
+            qstrcmp(argv[i], "--bench-control") == 0 || qstrcmp(argv[i], "--decode-events") == 0 ||
+            qstrcmp(argv[i], "--stereo-selfcheck") == 0 || qstrcmp(argv[i], "--odometry-check") == 0 ||
+            qstrcmp(argv[i], "--quality-check") == 0 || qstrcmp(argv[i], "--auto-capture-check") == 0)
+            headless = true;
+    }
+    std::unique_ptr<QCoreApplication> a(headless ? new QCoreApplication(argc, argv)
+                                                 : new QApplication(argc, argv));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption simulatorOption("simulator", "Запустить встроенный имитатор аппарата на 127.0.0.1");
+    QCommandLineOption simulatorOnlyOption("simulator-only", "Запустить только имитатор аппарата, без интерфейса");
+    QCommandLineOption simulatorPortOption("simulator-port", "UDP-порт имитатора аппарата", "port", "1337");
+    QCommandLineOption simulatorRateOption("simulator-rate", "Частота телеметрии имитатора, Гц", "hz", "50");
+    QCommandLineOption benchCameraOption("bench-camera", "Замер конвейера захват/запись/трансляция, длительность в секундах", "seconds");
+    QCommandLineOption benchControlOption("bench-control", "Замер задержки тракта управления до имитатора аппарата, длительность в секундах", "seconds");
+    QCommandLineOption benchSourceOption("bench-source", "Источник кадров для замера: synthetic или replay", "source", "synthetic");
+    QCommandLineOption benchFailCameraOption("bench-fail-camera", "Имитировать пропадание камеры во время замера (только synthetic)", "camera");
+    QCommandLineOption benchFailMsOption("bench-fail-ms", "Длительность имитируемого пропадания камеры, мс", "ms", "3000");
+    QCommandLineOption benchDropEveryOption("bench-drop-every", "Терять каждый N-й кадр синтетического источника (N >= 2) и проверить учёт разрывов", "N", "0");
+    QCommandLineOption benchEnhanceOption("bench-enhance", "Включить коррекцию цвета для всех потребителей и проверить, что она успевает за частотой кадров");
+    QCommandLineOption benchStabilizeOption("bench-stabilize", "Включить стабилизацию трансляции и записи и проверить, что она успевает за частотой кадров");
+    QCommandLineOption benchAutoExposureOption("bench-auto-exposure", "Включить автоэкспозицию, затемнить сцену синтетического источника и проверить подстройку и время замера");
+    QCommandLineOption decodeEventsOption("decode-events", "Перевести журнал событий (файл .evlog или каталог) в текст и выйти", "path");
+    QCommandLineOption stereoSelfCheckOption("stereo-selfcheck", "Проверить калибровку стереопары и кэш карт выпрямления на синтетических кадрах и выйти");
+    QCommandLineOption qualityCheckOption("quality-check", "Проверить оценку качества кадра и выбор лучшей стереопары на синтетических кадрах и выйти");
+    QCommandLineOption odometryCheckOption("odometry-check", "Проверить точность и время визуальной одометрии на воспроизведении маршрута с известной траекторией и выйти");
+    QCommandLineOption odometrySourceOption("odometry-source", "Кадр записи (AVI или снимок) для текстуры дна в проверке одометрии", "path");
+    QCommandLineOption autoCaptureCheckOption("auto-capture-check", "Проверить автоматическую стереосъёмку на синтетическом разрезе с известным маршрутом и выйти");
+    QCommandLineOption decodeFormatOption("decode-format", "Формат вывода журнала событий: json или csv", "format", "json");
+    parser.addOption(simulatorOption);
+    parser.addOption(simulatorOnlyOption);
+    parser.addOption(simulatorPortOption);
+    parser.addOption(simulatorRateOption);
+    parser.addOption(benchCameraOption);
+    parser.addOption(benchSourceOption);
+    parser.addOption(benchFailCameraOption);
+    parser.addOption(benchFailMsOption);
+    parser.addOption(benchDropEveryOption);
+    parser.addOption(benchAutoExposureOption);
+    parser.addOption(benchEnhanceOption);
+    parser.addOption(benchStabilizeOption);
+    parser.addOption(benchControlOption);
+    parser.addOption(decodeEventsOption);
+    parser.addOption(decodeFormatOption);
+    parser.addOption(stereoSelfCheckOption);
+    parser.addOption(qualityCheckOption);
+    parser.addOption(odometryCheckOption);
+    parser.addOption(odometrySourceOption);
+    parser.addOption(autoCaptureCheckOption);
+    parser.process(*a);
+
+    if (parser.isSet(decodeEventsOption)) {
+        QTextStream out(stdout);
+        return EventLog::decode(parser.value(decodeEventsOption), parser.value(decodeFormatOption), out);
+    }
+
+    if (parser.isSet(stereoSelfCheckOption)) {
+        QTextStream out(stdout);
+        return StereoCalibrator::selfCheck(out);
+    }
+
+    if (parser.isSet(qualityCheckOption)) {
+        QTextStream out(stdout);
+        return FrameQualityMeter::selfCheck(out);
+    }
+
+    if (parser.isSet(odometryCheckOption)) {
+        QTextStream out(stdout);
+        return VisualOdometry::replayCheck(out, parser.value(odometrySourceOption));
+    }
+
+    if (parser.isSet(autoCaptureCheckOption)) {
+        QTextStream out(stdout);
+        return StereoAutoCapture::replayCheck(out);
+    }
 
     // Настройка логирования
     Logger::setLogDirectory("logs");
     Logger::setMaxLogFileSize(5 * 1024 * 1024); // 5 MB
     Logger::setMaxLogFiles(10);
     Logger::installMessageHandler();
+    EventLog::setLogDirectory("logs");
+    EventLog::setMaxLogFileSize(16 * 1024 * 1024); // 16 MB
+    EventLog::setMaxLogFiles(10);
+    EventLog::start();
+
+    if (parser.isSet(benchCameraOption)) {
+        // Потерять каждый первый кадр нельзя, а проверка разрывов делит на N-1
+        if (parser.value(benchDropEveryOption).toUInt() == 1) {
+            qWarning() << "--bench-drop-every: N должно быть не меньше 2, 0 - без потерь";
+            return 1;
+        }
+        if (!SettingsManager::instance().initialize()) {
+            qWarning() << "Не удалось загрузить настройки";
+            return 1;
+        }
+        CameraBenchmark benchmark(parser.value(benchCameraOption).toInt(), parser.value(benchSourceOption),
+                                  parser.value(benchFailCameraOption), parser.value(benchFailMsOption).toInt(),
+                                  parser.value(benchDropEveryOption).toUInt(), parser.isSet(benchAutoExposureOption),
+                                  parser.isSet(benchEnhanceOption), parser.isSet(benchStabilizeOption));
+        QObject::connect(&benchmark, &CameraBenchmark::finished, a.get(), &QCoreApplication::exit, Qt::QueuedConnection);
+        QTimer::singleShot(0, &benchmark, &CameraBenchmark::run);
+        return a->exec();
+    }
+
+    if (parser.isSet(benchControlOption)) {
+        if (!SettingsManager::instance().initialize()) {
+            qWarning() << "Не удалось загрузить настройки";
+            return 1;
+        }
+        ControlBenchmark benchmark(parser.value(benchControlOption).toInt(), parser.value(simulatorPortOption).toUShort());
+        QObject::connect(&benchmark, &ControlBenchmark::finished, a.get(), &QCoreApplication::exit, Qt::QueuedConnection);
+        QTimer::singleShot(0, &benchmark, &ControlBenchmark::run);
+        return a->exec();
+    }
+
+    // Имитатор аппарата работает в собственном потоке, как и настоящий аппарат — вне GUI
+    QThread simulatorThread;
+    bool useSimulator = headless || parser.isSet(simulatorOption);
+    quint16 simulatorPort = parser.value(simulatorPortOption).toUShort();
+    if (useSimulator) {
+        RovSimulator *simulator = new RovSimulator(simulatorPort, parser.value(simulatorRateOption).toInt());
+        simulator->moveToThread(&simulatorThread);
+        QObject::connect(&simulatorThread, &QThread::started, simulator, &RovSimulator::start);
+        QObject::connect(&simulatorThread, &QThread::finished, simulator, &QObject::deleteLater);
+        simulatorThread.start();
+    }
 
-    MainWindow w;
-    w.show();
+    int result = 0;
+    if (headless) {
+        result = a->exec();
+    } else {
+        MainWindow w;
+        if (useSimulator)
+            w.useSimulator(simulatorPort);
+        w.show();
+        result = a->exec();
+    }
 
-    return a.exec();
+    simulatorThread.quit();
+    simulatorThread.wait();
+    PersistenceService::instance().shutdown();
+    EventLog::shutdown();
+    Logger::shutdown();
+    return result;
 }
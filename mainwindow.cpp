@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "typedsettings.h"
 
 void setMasterButtonState(QPushButton *button, const bool masterState, const bool isPanelHidden);
 void setRecordButtonState(QPushButton *button, const bool isRecording, const bool isPanelHidden);
@@ -30,11 +31,10 @@ MainWindow::MainWindow(QWidget *parent)
     lightsState = false;
 
     worker->moveToThread(workerThread);
-    workerThread->start();
     connect(workerThread, &QThread::finished, worker, &QObject::deleteLater);
-    connect(workerThread, &QThread::started, worker, &GamepadWorker::pollDevices);
-    connect(workerThread, &QThread::finished, worker, &GamepadWorker::deleteLater);
+    connect(workerThread, &QThread::started, worker, &GamepadWorker::run);
     connect(worker, &GamepadWorker::joysticksUpdated, this, &MainWindow::onJoystickUpdate);
+    workerThread->start();
 
     connect(ui->enableStabCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::setStabState);
 
@@ -52,12 +52,12 @@ MainWindow::MainWindow(QWidget *parent)
     connect(this, &MainWindow::startStreamingSignal, m_camera, &Camera::startStreamingSlot, Qt::QueuedConnection);
     connect(this, &MainWindow::stopStreamingSignal, m_camera, &Camera::stopStreamingSlot, Qt::QueuedConnection);
     connect(this, &MainWindow::stereoShotSignal, m_camera, &Camera::stereoShotSlot, Qt::QueuedConnection);
+    connect(this, &MainWindow::setCameraParametersSignal, m_camera, &Camera::setCameraParametersSlot, Qt::QueuedConnection);
 
     // Подключение сигналов Camera к слотам MainWindow
     connect(m_camera, &Camera::greatSuccess, this, &MainWindow::handleCameraSuccess);
     connect(m_camera, &Camera::frameReady, this, &MainWindow::processFrame);
     connect(m_camera, &Camera::errorOccurred, this, &MainWindow::handleCameraError);
-    connect(m_camera, &Camera::reconnectDone, this, &MainWindow::afterReconnect);
     connect(m_camera, &Camera::finished, this, &QMainWindow::close);
 
     cameraThread->start();
@@ -80,6 +80,51 @@ MainWindow::MainWindow(QWidget *parent)
     m_overlay->setGeometry(0, 0, m_label->width(), m_label->height());
     m_overlay->show();
 
+    // Живое выпрямление стереопары и измерения (F4) - в собственном потоке
+    stereoMeasurementMode = false;
+    stereoMeasurementThread = new QThread(this);
+    stereoMeasurement = new StereoMeasurement;
+    stereoMeasurement->moveToThread(stereoMeasurementThread);
+    connect(stereoMeasurementThread, &QThread::finished, stereoMeasurement, &QObject::deleteLater);
+    connect(this, &MainWindow::startStereoMeasurementSignal, stereoMeasurement, &StereoMeasurement::start, Qt::QueuedConnection);
+    connect(this, &MainWindow::stopStereoMeasurementSignal, stereoMeasurement, &StereoMeasurement::stop, Qt::QueuedConnection);
+    connect(this, &MainWindow::stereoMeasureSignal, stereoMeasurement, &StereoMeasurement::measure, Qt::QueuedConnection);
+    connect(stereoMeasurement, &StereoMeasurement::readyChanged, this, &MainWindow::stereoMeasurementReadyChanged, Qt::QueuedConnection);
+    connect(stereoMeasurement, &StereoMeasurement::rectifiedFrameReady, this, &MainWindow::showRectifiedFrame, Qt::QueuedConnection);
+    connect(stereoMeasurement, &StereoMeasurement::measured, this, &MainWindow::stereoMeasured, Qt::QueuedConnection);
+    connect(stereoMeasurement, &StereoMeasurement::errorOccurred, this, [this](const QString &, const QString &message) {
+        if (stereoMeasurementMode)
+            m_overlay->setMeasurementMode(true, message);
+    }, Qt::QueuedConnection);
+    connect(m_overlay, &OverlayWidget::measurementRequested, this, [this](const QPointF &a, const QPointF &b) {
+        emit stereoMeasureSignal(a, b, CameraBackend::monotonicNs());
+    });
+    stereoMeasurementThread->start();
+
+    // Грубая карта глубины для предупреждения о близости конструкций
+    proximityMonitor = new ProximityMonitor(this);
+    connect(proximityMonitor, &ProximityMonitor::proximityUpdated, m_overlay, &OverlayWidget::proximityUpdate);
+    connect(proximityMonitor, &ProximityMonitor::errorOccurred, this, &MainWindow::handleCameraError);
+    proximityMonitor->start();
+
+    // Фотомозаика по нижней камере (F5)
+    mosaicBuilder = new MosaicBuilder(this);
+    connect(mosaicBuilder, &MosaicBuilder::cameraRequired, m_camera, &Camera::addCameraSlot, Qt::QueuedConnection);
+    mosaicWindow = new MosaicWindow(mosaicBuilder);
+
+    // Визуальная одометрия по нижней камере и удержание позиции (F6)
+    visualOdometry = new VisualOdometry(this);
+    connect(visualOdometry, &VisualOdometry::cameraRequired, m_camera, &Camera::addCameraSlot, Qt::QueuedConnection);
+    connect(visualOdometry, &VisualOdometry::stateUpdated, m_overlay, &OverlayWidget::odometryUpdate);
+
+    // Автоматическая стереосъёмка по перекрытию и резкости при движении вдоль разреза (F7)
+    stereoAutoCapture = new StereoAutoCapture(this);
+    connect(stereoAutoCapture, &StereoAutoCapture::cameraRequired, m_camera, &Camera::addCameraSlot, Qt::QueuedConnection);
+    connect(stereoAutoCapture, &StereoAutoCapture::captureRequested, m_camera, &Camera::stereoShotRequestSlot, Qt::QueuedConnection);
+    connect(m_camera, &Camera::stereoShotRequestHandled, stereoAutoCapture, &StereoAutoCapture::captureHandled, Qt::QueuedConnection);
+    connect(stereoAutoCapture, &StereoAutoCapture::stateUpdated, m_overlay, &OverlayWidget::autoCaptureUpdate);
+    connect(stereoAutoCapture, &StereoAutoCapture::errorOccurred, this, &MainWindow::handleCameraError);
+
     const QList<CameraFrameInfo*>& cameras = m_camera->getCameras();
     for (CameraFrameInfo* cam : cameras) {
         if (cam->name == "LCamera") {
@@ -106,6 +151,13 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->hideShowButton, &QPushButton::pressed, this, &MainWindow::showHideLeftPanel);
     connect(ui->masterButton, &QPushButton::pressed, this, &MainWindow::masterSwitch);
 
+    stereoProcessingWindow = new StereoProcessingWindow;
+    connect(stereoProcessingWindow, &StereoProcessingWindow::calibrationSaved, proximityMonitor, &ProximityMonitor::start);
+    connect(ui->openStereoProcessingButton, &QPushButton::pressed, this, [this]() {
+        stereoProcessingWindow->show();
+        stereoProcessingWindow->raise();
+    });
+
     ui->powerGroupBox->setStyleSheet("QGroupBox { border: 0px; }");
 
     QIcon locked(":/Resources/Icons/lock_closed.ico");
@@ -148,6 +200,7 @@ MainWindow::MainWindow(QWidget *parent)
     controlsWindow->loadProfile(settingsManager.getLastActiveProfile());
 
     connect(controlsWindow->profileManager, &ProfileManager::profileNameChange, this, &MainWindow::activeProfileChanged);
+    connect(settingsDialog, &SettingsDialog::cameraParametersChanged, this, &MainWindow::applyCameraParameters);
 
     connect(udpHandler, &UdpHandler::updateMaster, this, &MainWindow::updateMasterFromControl);
     connect(udpHandler, &UdpHandler::updatePowerLimit, ui->powerSlider, &QSlider::setValue);
@@ -168,6 +221,31 @@ MainWindow::MainWindow(QWidget *parent)
     connect(udpHandler, &UdpHandler::lightStateChanged,
             this, &MainWindow::updateLightState,
             Qt::QueuedConnection);
+    connect(udpHandler, &UdpHandler::linkStatsUpdated,
+            this, &MainWindow::updateLinkStats,
+            Qt::QueuedConnection);
+
+    latencyStatsWindow = new LatencyStatsWindow;
+    connect(udpHandler, &UdpHandler::controlLatencyUpdated,
+            latencyStatsWindow, &LatencyStatsWindow::updateStats,
+            Qt::QueuedConnection);
+    connect(latencyStatsWindow, &LatencyStatsWindow::resetRequested,
+            udpHandler, &UdpHandler::resetLatencyStats,
+            Qt::QueuedConnection);
+
+    connect(visualOdometry, &VisualOdometry::holdCorrection,
+            udpHandler, &UdpHandler::setHoldCorrection,
+            Qt::QueuedConnection);
+    connect(udpHandler, &UdpHandler::manualTranslationChanged,
+            visualOdometry, &VisualOdometry::setPilotOverride,
+            Qt::QueuedConnection);
+}
+
+void MainWindow::useSimulator(quint16 port)
+{
+    QMetaObject::invokeMethod(udpHandler, [this, port]() {
+        udpHandler->setEndpointOverride(QHostAddress::LocalHost, port);
+    }, Qt::QueuedConnection);
 }
 
 MainWindow::~MainWindow()
@@ -182,8 +260,15 @@ MainWindow::~MainWindow()
         m_camera = nullptr;
     }
 
+    stereoMeasurementThread->quit();
+    stereoMeasurementThread->wait();
+
     delete m_overlay;
+    delete latencyStatsWindow;
+    delete stereoProcessingWindow;
+    delete mosaicWindow;
     delete ui;
+    worker->stop();
     workerThread->quit();
     workerThread->wait();
     udpThread->quit();
@@ -203,6 +288,15 @@ void MainWindow::onlineStateChanged(const bool &onlineState){
 void MainWindow::processFrame(CameraFrameInfo* camera)
 {
     QMutexLocker lock(camera->mutex);
+    proximityMonitor->submitFrame(camera->name, camera->img, camera->lastFrameNs);
+    mosaicBuilder->submitFrame(camera->name, camera->img, camera->lastFrameNs);
+    visualOdometry->submitFrame(camera->name, camera->img, camera->lastFrameNs);
+    stereoAutoCapture->submitFrame(camera->name, camera->img, camera->lastFrameNs, camera->quality);
+    // В режиме измерения показывается выпрямленный левый кадр из StereoMeasurement
+    if (stereoMeasurementMode && stereoMeasurement->isReady()) {
+        stereoMeasurement->submitFrame(camera->name, camera->img, camera->lastFrameNs);
+        return;
+    }
     if (camera->name == "LCamera") {
         m_label->setPixmap(QPixmap::fromImage(camera->img));
         // Обновляем геометрию оверлея при каждом обновлении изображения
@@ -275,25 +369,28 @@ void MainWindow::handleCameraSuccess(const QString& component, const QString& me
 {
 }
 
-void MainWindow::afterReconnect(Camera* camera)
-{
-    if (isRecording) {
-        emit startRecordingSignal("LCamera", 120, 0);
-        if (isStereoRecording) {
-            emit startRecordingSignal("RCamera", 120, 0);
-        }
-    }
-    emit startStreamingSignal("LCamera", 8080);
-    emit startStreamingSignal("RCamera", 8081);
-    qDebug() << "Переподключение выполнено";
-}
-
 void MainWindow::keyPressEvent(QKeyEvent* event)
 {
     if (event->key() == Qt::Key_Escape) {
         emit stopAllCamerasSignal();
         close();
     }
+    if (event->key() == Qt::Key_F3) {
+        latencyStatsWindow->setVisible(!latencyStatsWindow->isVisible());
+    }
+    if (event->key() == Qt::Key_F4) {
+        toggleStereoMeasurement();
+    }
+    if (event->key() == Qt::Key_F5) {
+        mosaicWindow->show();
+        mosaicWindow->raise();
+    }
+    if (event->key() == Qt::Key_F6) {
+        visualOdometry->setHoldEnabled(!visualOdometry->isHoldEnabled());
+    }
+    if (event->key() == Qt::Key_F7) {
+        stereoAutoCapture->setEnabled(!stereoAutoCapture->isEnabled());
+    }
     QMainWindow::keyPressEvent(event);
 }
 
@@ -392,7 +489,21 @@ void MainWindow::activeProfileChanged(){
     QJsonObject profile = profileManager->getProfile();
     QString profileName = profile["profileName"].toString();
     settingsManager.updateLastActiveProfile(profileName);
-    settingsDialog->SaveSetting();
+    // Сохраняем только настройки; несохранённые правки в окне настроек не трогаем
+    settingsManager.saveToFile("settings.json");
+
+    // Профиль может переопределять параметры изображения камер
+    for (const QString& name : {QStringLiteral("LCamera"), QStringLiteral("RCamera")})
+        applyCameraParameters(name);
+}
+
+void MainWindow::applyCameraParameters(const QString& cameraName){
+    // Параметры из настроек, поверх них - поля из "cameraParameters" активного профиля
+    QJsonObject params = SettingsManager::instance().getObject("Camera_params_" + cameraName);
+    const QJsonObject overrides = profileManager->getProfile()["cameraParameters"][cameraName].toObject();
+    for (auto it = overrides.constBegin(); it != overrides.constEnd(); ++it)
+        params.insert(it.key(), it.value());
+    emit setCameraParametersSignal(cameraName, CameraParameters::fromJson(params));
 }
 
 void MainWindow::settingsChanged(){
@@ -423,6 +534,7 @@ void MainWindow::updateOverlayData(){
                               powerLimit,
                               camAngle,
                               lightsState);
+    m_overlay->linkUpdate(linkStats);
 }
 
 void MainWindow::updateMasterFromControl(const bool &masterState){
@@ -440,9 +552,12 @@ float mapValueF(float x, float in_min, float in_max, float out_min, float out_ma
 
 void MainWindow::telemetryReceived(const TelemetryPacket &packet){
     telemetryPacket = packet;
+    mosaicBuilder->setTelemetry(packet.yaw, packet.depth);
+    visualOdometry->setTelemetry(packet.roll, packet.pitch, packet.yaw);
+    VideoStabilizer::setAttitude(packet.roll, packet.pitch);
     float tCamAngle = packet.cameraAngle;
-    float tCamMin = SettingsManager::instance().getDouble("Cam_angle_minus");
-    float tCamMax = SettingsManager::instance().getDouble("Cam_angle_plus");
+    float tCamMin = Settings::CamAngleMinus.value();
+    float tCamMax = Settings::CamAnglePlus.value();
     camAngle = mapValueF(tCamAngle, tCamMin, tCamMax, -90, 90);
 }
 
@@ -474,3 +589,49 @@ void MainWindow::updateLightState(const bool &lightState)
 {
     lightsState = lightState;
 }
+
+void MainWindow::updateLinkStats(const LinkStats &stats)
+{
+    linkStats = stats;
+}
+
+void MainWindow::toggleStereoMeasurement()
+{
+    stereoMeasurementMode = !stereoMeasurementMode;
+    if (stereoMeasurementMode) {
+        m_overlay->setMeasurementMode(true, "Измерение: загрузка калибровки...");
+        emit startStereoMeasurementSignal();
+    } else {
+        m_overlay->setMeasurementMode(false);
+        emit stopStereoMeasurementSignal();
+    }
+}
+
+void MainWindow::stereoMeasurementReadyChanged(bool ready)
+{
+    if (stereoMeasurementMode && ready)
+        m_overlay->setMeasurementMode(true);
+}
+
+void MainWindow::showRectifiedFrame(const QImage &left)
+{
+    if (!stereoMeasurementMode)
+        return;
+    m_label->setPixmap(QPixmap::fromImage(left));
+    m_overlay->setGeometry(0, 0, m_label->width(), m_label->height());
+}
+
+void MainWindow::stereoMeasured(const StereoMeasurementResult &result)
+{
+    if (!stereoMeasurementMode)
+        return;
+    // Задержка до появления результата на экране, а не только до конца расчёта
+    StereoMeasurementResult shown = result;
+    shown.latencyMs = (CameraBackend::monotonicNs() - result.clickNs) / 1e6;
+    m_overlay->measurementUpdate(shown);
+    if (result.ok)
+        qDebug() << "Стереоизмерение:" << result.distanceMm << "мм, погрешность" << result.errorMm
+                 << "мм, расчёт" << result.latencyMs << "мс, до экрана" << shown.latencyMs << "мс";
+    else
+        qDebug() << "Стереоизмерение не удалось:" << result.message;
+}
@@ -22,6 +22,14 @@
 #include <QResizeEvent>
 #include "SettingsManager.h"
 #include "overlaywidget.h"
+#include "latencystatswindow.h"
+#include "stereoprocessingwindow.h"
+#include "stereo_measurement.h"
+#include "stereo_proximity.h"
+#include "mosaicwindow.h"
+#include "visual_odometry.h"
+#include "stereo_auto_capture.h"
+#include "video_stabilizer.h"
 
 class OverlayWidget;
 
@@ -34,6 +42,7 @@ class MainWindow : public QMainWindow {
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    void useSimulator(quint16 port);
 
 signals:
     void startCameraSignal();
@@ -43,6 +52,10 @@ signals:
     void startStreamingSignal(const QString& cameraName, int port);
     void stopStreamingSignal(const QString& cameraName);
     void stereoShotSignal();
+    void setCameraParametersSignal(const QString& cameraName, const CameraParameters& parameters);
+    void startStereoMeasurementSignal();
+    void stopStereoMeasurementSignal();
+    void stereoMeasureSignal(const QPointF& a, const QPointF& b, qint64 clickNs);
     void masterChanged(const bool& masterState);
     void stabUpdated(const bool& stabAllState,
                      const bool& stabRollState,
@@ -54,7 +67,6 @@ private slots:
     void processFrame(CameraFrameInfo* camera);
     void handleCameraError(const QString& component, const QString& message);
     void handleCameraSuccess(const QString& component, const QString& message);
-    void afterReconnect(Camera* camera);
     void on_takeStereoframeButton_clicked();
     void onDatagramReceived(const QByteArray &data, const QHostAddress &sender, quint16 port);
     void onJoystickUpdate(const DualJoystickState &state);
@@ -63,11 +75,17 @@ private slots:
     void updatePID();
     void resetAngle();
     void activeProfileChanged();
+    void applyCameraParameters(const QString& cameraName);
     void updateOverlayData();
     void updateMasterFromControl(const bool &masterState);
     void telemetryReceived(const TelemetryPacket &packet);
     void setStabState();
     void updateLightState(const bool &lightState);
+    void updateLinkStats(const LinkStats &stats);
+    void toggleStereoMeasurement();
+    void stereoMeasurementReadyChanged(bool ready);
+    void showRectifiedFrame(const QImage &left);
+    void stereoMeasured(const StereoMeasurementResult &result);
 
 protected:
     void keyPressEvent(QKeyEvent* event) override;
@@ -97,6 +115,7 @@ private:
     bool stabPitchEnabled;
     bool stabYawEnabled;
     bool stabDepthEnabled;
+    LinkStats linkStats;
 
     UdpTelemetryParser *telemetryParser;
     TelemetryPacket telemetryPacket;
@@ -107,6 +126,16 @@ private:
     QThread *workerThread;
     GamepadWorker *worker;
     OverlayWidget* m_overlay;
+    LatencyStatsWindow *latencyStatsWindow;
+    StereoProcessingWindow *stereoProcessingWindow;
+    QThread *stereoMeasurementThread;
+    StereoMeasurement *stereoMeasurement;
+    bool stereoMeasurementMode;
+    ProximityMonitor *proximityMonitor;
+    MosaicBuilder *mosaicBuilder;
+    MosaicWindow *mosaicWindow;
+    VisualOdometry *visualOdometry;
+    StereoAutoCapture *stereoAutoCapture;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,300 @@
+#include "mosaic_builder.h"
+#include "camera_backend.h"
+#include "SettingsManager.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double wrapDegrees(double angle) {
+    angle = std::fmod(angle + 180.0, 360.0);
+    if (angle < 0) angle += 360.0;
+    return angle - 180.0;
+}
+
+} // namespace
+
+MosaicSettings MosaicSettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    MosaicSettings s;
+    s.cameraName = settings.getString("Mosaic_camera", s.cameraName);
+    s.directory = settings.getString("Mosaic_directory", s.directory);
+    s.rateHz = qBound(0.5, settings.getDouble("Mosaic_rate_hz", s.rateHz), 30.0);
+    s.workWidth = qBound(160, settings.getInt("Mosaic_work_width", s.workWidth), 2048);
+    s.features = qBound(100, settings.getInt("Mosaic_features", s.features), 10000);
+    s.minInliers = qBound(6, settings.getInt("Mosaic_min_inliers", s.minInliers), 1000);
+    s.yawSign = qBound(-1, settings.getInt("Mosaic_yaw_sign", s.yawSign), 1);
+    s.maxYawErrorDeg = qMax(1.0, settings.getDouble("Mosaic_max_yaw_error_deg", s.maxYawErrorDeg));
+    s.steadyDepthM = qMax(0.0, settings.getDouble("Mosaic_steady_depth_m", s.steadyDepthM));
+    s.memoryMb = qBound(16, settings.getInt("Mosaic_memory_mb", s.memoryMb), 8192);
+    return s;
+}
+
+MosaicBuilder::MosaicBuilder(QObject* parent)
+    : QObject(parent), m_stage(new LatestFrameStage(QThread::LowPriority, this)) {
+    qRegisterMetaType<MosaicStatus>("MosaicStatus");
+    // Пониженный приоритет: мозаика не должна отнимать процессор у захвата и записи
+    connect(m_stage, &LatestFrameStage::tick, this, &MosaicBuilder::tick);
+    m_settings = MosaicSettings::load();
+}
+
+MosaicBuilder::~MosaicBuilder() {
+    m_stage->stop();
+    m_stage->waitForDone();
+}
+
+void MosaicBuilder::start() {
+    if (m_running) return;
+    m_stage->waitForDone(); // Запись предыдущей мозаики должна закончиться
+
+    m_settings = MosaicSettings::load();
+    const QString directory = QDir(m_settings.directory).filePath(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    if (!QDir().mkpath(QDir(directory).filePath("tiles/0"))) {
+        QString errorMsg = QString("Не удалось создать директорию %1").arg(directory);
+        qDebug() << errorMsg;
+        emit errorOccurred("MosaicBuilder", errorMsg);
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->settings = m_settings;
+    job->canvas = std::make_shared<MosaicCanvas>(directory, qint64(m_settings.memoryMb) * 1024 * 1024);
+    job->orb = cv::ORB::create(m_settings.features);
+    m_job = job;
+
+    m_status = MosaicStatus();
+    m_status.running = true;
+    m_status.directory = directory;
+    m_totalMs = 0;
+    m_frame = QImage();
+    m_running = true;
+    // Нижняя камера не входит в стандартный набор и подключается по требованию
+    emit cameraRequired(m_settings.cameraName);
+    m_stage->start(m_settings.rateHz);
+    qDebug() << "Мозаика: камера" << m_settings.cameraName << ", папка" << directory;
+    publishStatus();
+}
+
+void MosaicBuilder::stop() {
+    if (!m_running) return;
+    m_running = false;
+    m_stage->stop();
+    m_frame = QImage();
+    m_status.running = false;
+    publishStatus();
+
+    // Запись начнётся после кадра, который ещё обрабатывается
+    const std::shared_ptr<Job> job = m_job;
+    m_stage->post([job]() {
+        int levels = 0;
+        QString error;
+        const bool ok = job->canvas->finish(levels, error);
+        const QString message = ok ? QString("Мозаика сохранена в %1, уровней пирамиды: %2").arg(job->canvas->directory()).arg(levels)
+                                   : QString("Мозаика %1 сохранена не полностью: %2").arg(job->canvas->directory(), error);
+        return qMakePair(ok, message);
+    }, [this](const QPair<bool, QString>& result) {
+        qDebug() << result.second;
+        if (!result.first) emit errorOccurred("MosaicBuilder", result.second);
+        emit finished(result.first, result.second);
+    });
+}
+
+void MosaicBuilder::submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs) {
+    if (!m_running || cameraName != m_settings.cameraName) return;
+    m_frame = image;
+    m_frameNs = timestampNs;
+}
+
+void MosaicBuilder::setTelemetry(float yawDeg, float depthM) {
+    m_yawDeg = yawDeg;
+    m_depthM = depthM;
+    m_hasTelemetry = true;
+}
+
+QImage MosaicBuilder::render(const QRectF& canvasRect, const QSize& size) const {
+    if (!m_job) return QImage();
+    return m_job->canvas->render(canvasRect, size);
+}
+
+QRect MosaicBuilder::bounds() const {
+    return m_job ? m_job->canvas->bounds() : QRect();
+}
+
+void MosaicBuilder::tick() {
+    if (!m_running || m_frame.isNull()) return;
+
+    Input input;
+    input.image = m_frame;
+    input.yawDeg = m_yawDeg;
+    input.depthM = m_depthM;
+    input.hasTelemetry = m_hasTelemetry;
+    const std::shared_ptr<Job> job = m_job;
+    m_stage->process(m_frameNs, [job, input]() {
+        const qint64 startNs = CameraBackend::monotonicNs();
+        Output output;
+        output.ok = process(*job, input, output.error);
+        output.ms = (CameraBackend::monotonicNs() - startNs) / 1e6;
+        return output;
+    }, [this](const Output& output) {
+        m_status.lastMs = output.ms;
+        m_totalMs += output.ms;
+        if (output.ok) {
+            m_status.processed++;
+            m_status.lost = false;
+        } else {
+            // Потеря привязки пишется в журнал один раз, а не на каждый кадр
+            if (!m_status.lost) qDebug() << "Мозаика: кадр не привязан:" << output.error;
+            m_status.failed++;
+            m_status.lost = true;
+        }
+        m_status.averageMs = m_totalMs / (m_status.processed + m_status.failed);
+        publishStatus();
+    });
+}
+
+void MosaicBuilder::publishStatus() {
+    m_status.skipped = m_stage->skipped();
+    if (m_job) {
+        m_status.tilesInMemory = m_job->canvas->tilesInMemory();
+        m_status.tilesOnDisk = m_job->canvas->tilesOnDisk();
+        m_status.bounds = m_job->canvas->bounds();
+    }
+    emit statusUpdated(m_status);
+}
+
+bool MosaicBuilder::process(Job& job, const Input& input, QString& error) {
+    const QImage& image = input.image;
+    if (image.format() != QImage::Format_RGB888 || image.isNull()) {
+        error = "неподдерживаемый формат кадра";
+        return false;
+    }
+
+    try {
+        const cv::Mat source(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), image.bytesPerLine());
+        const cv::Size workSize(job.settings.workWidth, qRound(double(job.settings.workWidth) * image.height() / image.width()));
+        cv::Mat frame, gray;
+        cv::resize(source, frame, workSize, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+        if (job.weights.size() != workSize) {
+            // Вес 1 в середине кадра, к краям линейно падает до 0
+            job.weights.create(workSize, CV_32F);
+            const float feather = 0.15f * std::min(workSize.width, workSize.height);
+            for (int y = 0; y < workSize.height; ++y) {
+                float* row = job.weights.ptr<float>(y);
+                for (int x = 0; x < workSize.width; ++x) {
+                    const int border = std::min({x, y, workSize.width - 1 - x, workSize.height - 1 - y});
+                    row[x] = std::min(1.0f, border / feather);
+                }
+            }
+        }
+
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        job.orb->detectAndCompute(gray, cv::noArray(), keypoints, descriptors);
+        if (int(keypoints.size()) < job.settings.minInliers) {
+            error = QString("мало особенностей в кадре (%1)").arg(qulonglong(keypoints.size()));
+            return false;
+        }
+
+        // Первый кадр задаёт систему координат холста
+        cv::Matx33d toKeyframe = cv::Matx33d::eye();
+        if (job.keyframe.valid && !estimate(job, input, keypoints, descriptors, toKeyframe, error)) return false;
+        const cv::Matx33d toCanvas = job.keyframe.toCanvas * toKeyframe;
+        if (!job.canvas->blend(frame, job.weights, toCanvas)) {
+            error = "преобразование кадра вырождено";
+            return false;
+        }
+
+        // Новый опорный кадр, когда перекрытие с прежним заметно уменьшилось
+        const cv::Vec3d center(workSize.width / 2.0, workSize.height / 2.0, 1.0);
+        const cv::Vec3d moved = toKeyframe * center;
+        const double shift = std::hypot(moved[0] - center[0], moved[1] - center[1]);
+        const double angle = std::abs(std::atan2(toKeyframe(1, 0), toKeyframe(0, 0))) * 180.0 / CV_PI;
+        if (!job.keyframe.valid || shift > 0.25 * workSize.width || angle > 10.0) {
+            job.keyframe.keypoints = std::move(keypoints);
+            job.keyframe.descriptors = descriptors;
+            job.keyframe.toCanvas = toCanvas;
+            job.keyframe.yawDeg = input.yawDeg;
+            job.keyframe.depthM = input.depthM;
+            job.keyframe.hasTelemetry = input.hasTelemetry;
+            job.keyframe.valid = true;
+        }
+    } catch (const cv::Exception& e) {
+        error = QString("ошибка OpenCV: %1").arg(e.what());
+        return false;
+    }
+    return true;
+}
+
+bool MosaicBuilder::estimate(const Job& job, const Input& input, const std::vector<cv::KeyPoint>& keypoints,
+                             const cv::Mat& descriptors, cv::Matx33d& toKeyframe, QString& error) {
+    const Keyframe& keyframe = job.keyframe;
+    const MosaicSettings& settings = job.settings;
+
+    std::vector<std::vector<cv::DMatch>> knn;
+    cv::BFMatcher(cv::NORM_HAMMING).knnMatch(descriptors, keyframe.descriptors, knn, 2);
+    std::vector<cv::Point2f> from, to;
+    for (const std::vector<cv::DMatch>& match : knn) {
+        if (match.size() == 2 && match[0].distance < 0.8f * match[1].distance) {
+            from.push_back(keypoints[match[0].queryIdx].pt);
+            to.push_back(keyframe.keypoints[match[0].trainIdx].pt);
+        }
+    }
+    if (int(from.size()) < settings.minInliers) {
+        error = QString("мало совпадений с опорным кадром (%1)").arg(qulonglong(from.size()));
+        return false;
+    }
+
+    cv::Mat inliers;
+    const cv::Mat model = cv::estimateAffinePartial2D(from, to, inliers, cv::RANSAC, 3.0, 2000, 0.99, 10);
+    const int inlierCount = model.empty() ? 0 : cv::countNonZero(inliers);
+    if (inlierCount < settings.minInliers) {
+        error = QString("мало согласованных совпадений (%1)").arg(inlierCount);
+        return false;
+    }
+
+    cv::Matx23d M = model;
+    const double scale = std::hypot(M(0, 0), M(1, 0));
+    const double angle = std::atan2(M(1, 0), M(0, 0)) * 180.0 / CV_PI;
+    if (scale < 0.5 || scale > 2.0) {
+        error = QString("неправдоподобный масштаб %1").arg(scale, 0, 'f', 2);
+        return false;
+    }
+
+    const bool telemetry = input.hasTelemetry && keyframe.hasTelemetry;
+    // Поворот кадра должен совпадать с изменением курса (знак зависит от установки камеры)
+    if (telemetry && settings.yawSign != 0) {
+        const double expected = settings.yawSign * wrapDegrees(input.yawDeg - keyframe.yawDeg);
+        if (std::abs(wrapDegrees(angle - expected)) > settings.maxYawErrorDeg) {
+            error = QString("поворот кадра %1° не согласуется с изменением курса %2°").arg(angle, 0, 'f', 1).arg(expected, 0, 'f', 1);
+            return false;
+        }
+    }
+    // Глубина не менялась - высота над дном тоже почти та же, масштаб фиксируется равным 1.
+    // Сдвиг пересчитывается так, чтобы центр согласованных точек остался на месте.
+    if (telemetry && std::abs(input.depthM - keyframe.depthM) < settings.steadyDepthM) {
+        cv::Point2d centroid(0, 0);
+        for (int i = 0; i < int(from.size()); ++i) {
+            if (inliers.at<uchar>(i)) centroid += cv::Point2d(from[i]);
+        }
+        centroid *= 1.0 / inlierCount;
+        const cv::Point2d target(M(0, 0) * centroid.x + M(0, 1) * centroid.y + M(0, 2),
+                                 M(1, 0) * centroid.x + M(1, 1) * centroid.y + M(1, 2));
+        for (int r = 0; r < 2; ++r) {
+            M(r, 0) /= scale;
+            M(r, 1) /= scale;
+        }
+        M(0, 2) = target.x - (M(0, 0) * centroid.x + M(0, 1) * centroid.y);
+        M(1, 2) = target.y - (M(1, 0) * centroid.x + M(1, 1) * centroid.y);
+    }
+
+    toKeyframe = cv::Matx33d(M(0, 0), M(0, 1), M(0, 2),
+                             M(1, 0), M(1, 1), M(1, 2),
+                             0, 0, 1);
+    return true;
+}
@@ -0,0 +1,129 @@
+#ifndef MOSAIC_BUILDER_H
+#define MOSAIC_BUILDER_H
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+#include "latest_frame_stage.h"
+#include "mosaic_canvas.h"
+
+// Параметры фотомозаики (ключи Mosaic_* в настройках)
+struct MosaicSettings {
+    QString cameraName = "DCamera"; // Камера, смотрящая вниз
+    QString directory = "mosaic";   // Каждая мозаика - в своей папке <directory>/<время>
+    double rateHz = 6;              // Кадров в секунду на регистрацию
+    int workWidth = 640;            // Ширина кадра для поиска особенностей и наложения
+    int features = 1000;            // Особенностей ORB на кадр
+    int minInliers = 25;            // Меньше совпадений после RANSAC - кадр не регистрируется
+    int yawSign = 1;                // Направление поворота кадра при росте курса; 0 - курс не используется
+    double maxYawErrorDeg = 10;     // Допустимое расхождение поворота кадра с изменением курса
+    double steadyDepthM = 0.05;     // Глубина изменилась меньше - масштаб кадра считается неизменным
+    int memoryMb = 256;             // Объём плиток в памяти, остальные - на диске
+
+    static MosaicSettings load();
+};
+
+// Состояние построения мозаики для окна просмотра
+struct MosaicStatus {
+    bool running = false;
+    quint64 processed = 0;      // Кадров наложено
+    quint64 failed = 0;         // Кадров не удалось привязать
+    quint64 skipped = 0;        // Кадров пропущено, пока шла обработка предыдущего
+    double lastMs = 0;          // Время обработки последнего кадра
+    double averageMs = 0;
+    bool lost = false;          // Последний кадр не привязан
+    int tilesInMemory = 0;
+    int tilesOnDisk = 0;
+    QRect bounds;
+    QString directory;
+};
+Q_DECLARE_METATYPE(MosaicStatus)
+
+// Построение фотомозаики дна в реальном времени по кадрам нижней камеры.
+// По таймеру последний кадр уменьшается до workWidth, на нём ищутся особенности ORB
+// и сопоставляются с опорным кадром. Преобразование между кадрами - подобие (поворот,
+// масштаб, сдвиг) по RANSAC; курс и глубина с аппарата служат априорными данными:
+// поворот проверяется по изменению курса, а при неизменной глубине масштаб фиксируется
+// равным 1, что гасит накопление ошибки масштаба в цепочке. Цепочка преобразований
+// переводит кадр в координаты холста MosaicCanvas.
+// Обработка кадров и запись мозаики идут в LatestFrameStage с пониженным приоритетом.
+class MosaicBuilder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MosaicBuilder(QObject* parent = nullptr);
+    ~MosaicBuilder() override;
+
+    bool isRunning() const { return m_running; }
+    QString cameraName() const { return m_settings.cameraName; }
+    // Вызываются из потока интерфейса
+    void submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs);
+    void setTelemetry(float yawDeg, float depthM);
+    QImage render(const QRectF& canvasRect, const QSize& size) const;
+    QRect bounds() const;
+
+public slots:
+    void start();
+    // Остановка: дописывает плитки и пирамиду на диск, затем finished
+    void stop();
+
+signals:
+    void cameraRequired(const QString& cameraName);
+    void statusUpdated(const MosaicStatus& status);
+    void finished(bool ok, const QString& message);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    struct Input {
+        QImage image;
+        float yawDeg = 0;
+        float depthM = 0;
+        bool hasTelemetry = false;
+    };
+    struct Output {
+        bool ok = false;
+        QString error;
+        double ms = 0;
+    };
+    // Опорный кадр: с ним сопоставляются следующие, пока они перекрываются достаточно
+    struct Keyframe {
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        cv::Matx33d toCanvas = cv::Matx33d::eye();
+        float yawDeg = 0;
+        float depthM = 0;
+        bool hasTelemetry = false;
+        bool valid = false;
+    };
+    struct Job {
+        MosaicSettings settings;
+        std::shared_ptr<MosaicCanvas> canvas;
+        cv::Ptr<cv::ORB> orb;
+        cv::Mat weights;        // Веса смешивания для кадра рабочего размера
+        Keyframe keyframe;
+    };
+
+    void tick();
+    static bool process(Job& job, const Input& input, QString& error);
+    static bool estimate(const Job& job, const Input& input, const std::vector<cv::KeyPoint>& keypoints,
+                         const cv::Mat& descriptors, cv::Matx33d& toKeyframe, QString& error);
+    void publishStatus();
+
+    MosaicSettings m_settings;
+    std::shared_ptr<Job> m_job;
+    LatestFrameStage* m_stage;
+    bool m_running = false;
+
+    QImage m_frame;
+    qint64 m_frameNs = 0;
+    std::atomic<float> m_yawDeg{0};
+    std::atomic<float> m_depthM{0};
+    std::atomic<bool> m_hasTelemetry{false};
+
+    MosaicStatus m_status;
+    double m_totalMs = 0;
+};
+
+#endif // MOSAIC_BUILDER_H
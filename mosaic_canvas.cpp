@@ -0,0 +1,290 @@
+#include "mosaic_canvas.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cmath>
+
+MosaicCanvas::MosaicCanvas(const QString& directory, qint64 memoryBudgetBytes)
+    : m_directory(directory),
+      m_maxTiles(int(qMax<qint64>(16, memoryBudgetBytes / (qint64(TILE_SIZE) * TILE_SIZE * 4)))) {}
+
+QString MosaicCanvas::tilePath(int level, int tx, int ty) const {
+    return QDir(m_directory).filePath(QString("tiles/%1/%2_%3.png").arg(level).arg(tx).arg(ty));
+}
+
+cv::Mat* MosaicCanvas::tile(int tx, int ty, bool create) {
+    const qint64 tileKey = key(tx, ty);
+    auto it = m_tiles.find(tileKey);
+    if (it != m_tiles.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return &it->second.image;
+    }
+
+    cv::Mat image;
+    if (m_onDisk.contains(tileKey)) {
+        image = cv::imread(tilePath(0, tx, ty).toStdString(), cv::IMREAD_UNCHANGED);
+        if (image.type() != CV_8UC4 || image.rows != TILE_SIZE || image.cols != TILE_SIZE) {
+            qDebug() << "Мозаика: повреждена плитка" << tilePath(0, tx, ty);
+            image.release();
+        }
+    }
+    if (image.empty()) {
+        if (!create) return nullptr;
+        image = cv::Mat::zeros(TILE_SIZE, TILE_SIZE, CV_8UC4);
+    }
+
+    m_lru.push_front(tileKey);
+    Tile& inserted = m_tiles[tileKey];
+    inserted.image = image;
+    inserted.lru = m_lru.begin();
+    // Новая плитка стоит первой в очереди и вытеснена не будет
+    evict();
+    return &inserted.image;
+}
+
+bool MosaicCanvas::writeTile(int tx, int ty, const Tile& tile) {
+    try {
+        // Слабое сжатие: запись идёт в потоке мозаики и не должна его задерживать
+        if (cv::imwrite(tilePath(0, tx, ty).toStdString(), tile.image, {cv::IMWRITE_PNG_COMPRESSION, 1})) {
+            m_onDisk.insert(key(tx, ty));
+            return true;
+        }
+    } catch (const cv::Exception& e) {
+        qDebug() << "Мозаика: ошибка записи плитки:" << e.what();
+    }
+    if (m_writeErrors++ == 0) {
+        qDebug() << "Мозаика: не удалось записать плитку" << tilePath(0, tx, ty);
+    }
+    return false;
+}
+
+void MosaicCanvas::evict() {
+    while (int(m_tiles.size()) > m_maxTiles) {
+        const qint64 tileKey = m_lru.back();
+        auto it = m_tiles.find(tileKey);
+        // Объём памяти важнее: плитка, которую не удалось записать, всё равно выгружается
+        if (it->second.dirty) writeTile(keyX(tileKey), keyY(tileKey), it->second);
+        m_lru.pop_back();
+        m_tiles.erase(it);
+    }
+}
+
+void MosaicCanvas::readRect(const cv::Rect& rect, cv::Mat& region, bool create) {
+    region = cv::Mat::zeros(rect.size(), CV_8UC4);
+    for (int ty = floorDiv(rect.y, TILE_SIZE); ty <= floorDiv(rect.y + rect.height - 1, TILE_SIZE); ++ty) {
+        for (int tx = floorDiv(rect.x, TILE_SIZE); tx <= floorDiv(rect.x + rect.width - 1, TILE_SIZE); ++tx) {
+            const cv::Mat* image = tile(tx, ty, create);
+            if (!image) continue;
+            const cv::Rect tileRect(tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+            const cv::Rect common = rect & tileRect;
+            (*image)(common - tileRect.tl()).copyTo(region(common - rect.tl()));
+        }
+    }
+}
+
+void MosaicCanvas::writeRect(const cv::Rect& rect, const cv::Mat& region) {
+    for (int ty = floorDiv(rect.y, TILE_SIZE); ty <= floorDiv(rect.y + rect.height - 1, TILE_SIZE); ++ty) {
+        for (int tx = floorDiv(rect.x, TILE_SIZE); tx <= floorDiv(rect.x + rect.width - 1, TILE_SIZE); ++tx) {
+            cv::Mat* image = tile(tx, ty, true);
+            const cv::Rect tileRect(tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+            const cv::Rect common = rect & tileRect;
+            region(common - rect.tl()).copyTo((*image)(common - tileRect.tl()));
+            m_tiles[key(tx, ty)].dirty = true;
+        }
+    }
+}
+
+bool MosaicCanvas::blend(const cv::Mat& frame, const cv::Mat& weights, const cv::Matx33d& toCanvas) {
+    std::vector<cv::Point2f> corners = {{0, 0}, {float(frame.cols), 0}, {float(frame.cols), float(frame.rows)}, {0, float(frame.rows)}};
+    cv::perspectiveTransform(corners, corners, cv::Mat(toCanvas));
+    const cv::Rect box = cv::boundingRect(corners);
+    // Разошедшаяся цепочка преобразований даёт огромный кадр - такой не накладываем
+    if (box.area() <= 0 || box.area() > 16 * qint64(frame.total())) return false;
+
+    const cv::Matx33d shift = cv::Matx33d(1, 0, -box.x, 0, 1, -box.y, 0, 0, 1) * toCanvas;
+    cv::Mat warped, warpedWeights;
+    cv::warpPerspective(frame, warped, cv::Mat(shift), box.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    cv::warpPerspective(weights, warpedWeights, cv::Mat(shift), box.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+    QMutexLocker locker(&m_mutex);
+    cv::Mat region;
+    readRect(box, region, true);
+    // Новый кадр заполняет пустое место целиком, а с уже покрытым смешивается по весу:
+    // в середине кадра вес 1, к краям падает до 0 - швы между кадрами сглаживаются
+    for (int y = 0; y < region.rows; ++y) {
+        cv::Vec4b* target = region.ptr<cv::Vec4b>(y);
+        const cv::Vec3b* source = warped.ptr<cv::Vec3b>(y);
+        const float* weight = warpedWeights.ptr<float>(y);
+        for (int x = 0; x < region.cols; ++x) {
+            const float w = weight[x];
+            if (w <= 0.0f) continue;
+            if (target[x][3] == 0 || w >= 1.0f) {
+                target[x] = cv::Vec4b(source[x][0], source[x][1], source[x][2], 255);
+            } else {
+                for (int c = 0; c < 3; ++c)
+                    target[x][c] = cv::saturate_cast<uchar>(target[x][c] + (source[x][c] - target[x][c]) * w);
+            }
+        }
+    }
+    writeRect(box, region);
+    m_bounds = m_bounds.empty() ? box : (m_bounds | box);
+    updateOverview(box, region);
+    return true;
+}
+
+void MosaicCanvas::updateOverview(const cv::Rect& rect, const cv::Mat& region) {
+    if (m_overview.empty() || (m_overviewArea & rect) != rect) {
+        // Обзорная копия растёт с запасом; если не помещается в OVERVIEW_MAX - уменьшается вдвое
+        const int margin = 2 * TILE_SIZE;
+        cv::Rect area = m_overview.empty() ? rect : (m_overviewArea | rect);
+        area = cv::Rect(area.x - margin, area.y - margin, area.width + 2 * margin, area.height + 2 * margin);
+        double scale = m_overview.empty() ? 1.0 : m_overviewScale;
+        while (area.width * scale > OVERVIEW_MAX || area.height * scale > OVERVIEW_MAX) scale /= 2;
+
+        cv::Mat overview = cv::Mat::zeros(int(std::ceil(area.height * scale)), int(std::ceil(area.width * scale)), CV_8UC4);
+        if (!m_overview.empty()) {
+            const cv::Rect target = cv::Rect(qRound((m_overviewArea.x - area.x) * scale), qRound((m_overviewArea.y - area.y) * scale),
+                                             qRound(m_overviewArea.width * scale), qRound(m_overviewArea.height * scale)) &
+                                    cv::Rect(0, 0, overview.cols, overview.rows);
+            if (!target.empty()) {
+                cv::Mat resized;
+                cv::resize(m_overview, resized, target.size(), 0, 0, cv::INTER_AREA);
+                resized.copyTo(overview(target));
+            }
+        }
+        m_overview = overview;
+        m_overviewArea = area;
+        m_overviewScale = scale;
+    }
+
+    const int x0 = int(std::floor((rect.x - m_overviewArea.x) * m_overviewScale));
+    const int y0 = int(std::floor((rect.y - m_overviewArea.y) * m_overviewScale));
+    const int x1 = int(std::ceil((rect.x + rect.width - m_overviewArea.x) * m_overviewScale));
+    const int y1 = int(std::ceil((rect.y + rect.height - m_overviewArea.y) * m_overviewScale));
+    const cv::Rect target = cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(0, 0, m_overview.cols, m_overview.rows);
+    if (target.empty()) return;
+    cv::Mat resized, mask;
+    cv::resize(region, resized, target.size(), 0, 0, cv::INTER_AREA);
+    cv::extractChannel(resized, mask, 3);
+    resized.copyTo(m_overview(target), mask);
+}
+
+QImage MosaicCanvas::render(const QRectF& canvasRect, const QSize& size) {
+    QImage image(size, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    if (size.isEmpty() || canvasRect.isEmpty()) return image;
+
+    // Байты ARGB32 в памяти идут как BGRA - совпадают с плитками
+    cv::Mat output(size.height(), size.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+    const double pixelX = canvasRect.width() / size.width();
+    const double pixelY = canvasRect.height() / size.height();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_overview.empty()) return image;
+    if (pixelX > 2.0) {
+        // Крупный масштаб - из обзорной копии, плитки не трогаются
+        const cv::Matx23d toOverview(pixelX * m_overviewScale, 0, (canvasRect.x() - m_overviewArea.x) * m_overviewScale,
+                                     0, pixelY * m_overviewScale, (canvasRect.y() - m_overviewArea.y) * m_overviewScale);
+        cv::warpAffine(m_overview, output, cv::Mat(toOverview), output.size(),
+                       cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_TRANSPARENT);
+    } else {
+        // Подробный масштаб - из плиток полного разрешения; участок не больше двух экранов
+        const cv::Rect rect(int(std::floor(canvasRect.x())), int(std::floor(canvasRect.y())),
+                            int(std::ceil(canvasRect.width())) + 1, int(std::ceil(canvasRect.height())) + 1);
+        cv::Mat region;
+        readRect(rect, region, false);
+        const cv::Matx23d toRegion(pixelX, 0, canvasRect.x() - rect.x, 0, pixelY, canvasRect.y() - rect.y);
+        cv::warpAffine(region, output, cv::Mat(toRegion), output.size(),
+                       cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_TRANSPARENT);
+    }
+    return image;
+}
+
+bool MosaicCanvas::finish(int& levels, QString& error) {
+    QMutexLocker locker(&m_mutex);
+    for (auto& [tileKey, tile] : m_tiles) {
+        if (tile.dirty && writeTile(keyX(tileKey), keyY(tileKey), tile)) tile.dirty = false;
+    }
+    if (m_onDisk.isEmpty()) {
+        error = "Мозаика пуста";
+        return false;
+    }
+
+    // Пирамида: каждый уровень - плитки предыдущего, сведённые 2x2 в одну
+    QSet<qint64> current = m_onDisk;
+    int level = 0;
+    try {
+        while (current.size() > 1) {
+            ++level;
+            if (!QDir().mkpath(QDir(m_directory).filePath(QString("tiles/%1").arg(level)))) {
+                error = QString("Не удалось создать директорию уровня %1 в %2").arg(level).arg(m_directory);
+                return false;
+            }
+            QSet<qint64> parents;
+            for (qint64 child : current) parents.insert(key(floorDiv(keyX(child), 2), floorDiv(keyY(child), 2)));
+            for (qint64 parent : parents) {
+                cv::Mat composed = cv::Mat::zeros(2 * TILE_SIZE, 2 * TILE_SIZE, CV_8UC4);
+                for (int dy = 0; dy < 2; ++dy) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        const int tx = 2 * keyX(parent) + dx;
+                        const int ty = 2 * keyY(parent) + dy;
+                        if (!current.contains(key(tx, ty))) continue;
+                        const cv::Mat child = cv::imread(tilePath(level - 1, tx, ty).toStdString(), cv::IMREAD_UNCHANGED);
+                        if (child.type() == CV_8UC4 && child.rows == TILE_SIZE && child.cols == TILE_SIZE)
+                            child.copyTo(composed(cv::Rect(dx * TILE_SIZE, dy * TILE_SIZE, TILE_SIZE, TILE_SIZE)));
+                    }
+                }
+                cv::Mat reduced;
+                cv::resize(composed, reduced, cv::Size(TILE_SIZE, TILE_SIZE), 0, 0, cv::INTER_AREA);
+                if (!cv::imwrite(tilePath(level, keyX(parent), keyY(parent)).toStdString(), reduced)) {
+                    error = QString("Не удалось записать плитку %1").arg(tilePath(level, keyX(parent), keyY(parent)));
+                    return false;
+                }
+            }
+            current = parents;
+        }
+        cv::imwrite(QDir(m_directory).filePath("overview.png").toStdString(), m_overview);
+    } catch (const cv::Exception& e) {
+        error = QString("Ошибка записи мозаики: %1").arg(e.what());
+        return false;
+    }
+
+    QJsonObject description;
+    description["tile_size"] = TILE_SIZE;
+    description["levels"] = level + 1;
+    description["x"] = m_bounds.x;
+    description["y"] = m_bounds.y;
+    description["width"] = m_bounds.width;
+    description["height"] = m_bounds.height;
+    description["overview_x"] = m_overviewArea.x;
+    description["overview_y"] = m_overviewArea.y;
+    description["overview_scale"] = m_overviewScale;
+    QFile file(QDir(m_directory).filePath("mosaic.json"));
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(description).toJson()) < 0) {
+        error = QString("Не удалось записать %1").arg(file.fileName());
+        return false;
+    }
+    if (m_writeErrors > 0) {
+        error = QString("Не удалось записать плиток: %1").arg(m_writeErrors);
+        return false;
+    }
+    levels = level + 1;
+    return true;
+}
+
+QRect MosaicCanvas::bounds() const {
+    QMutexLocker locker(&m_mutex);
+    return QRect(m_bounds.x, m_bounds.y, m_bounds.width, m_bounds.height);
+}
+
+int MosaicCanvas::tilesInMemory() const {
+    QMutexLocker locker(&m_mutex);
+    return int(m_tiles.size());
+}
+
+int MosaicCanvas::tilesOnDisk() const {
+    QMutexLocker locker(&m_mutex);
+    return m_onDisk.size();
+}
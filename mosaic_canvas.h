@@ -0,0 +1,73 @@
+#ifndef MOSAIC_CANVAS_H
+#define MOSAIC_CANVAS_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRectF>
+#include <QSet>
+#include <QString>
+#include <list>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+// Холст фотомозаики: неограниченная плоскость из плиток BGRA (альфа - покрытие).
+// В памяти держится не больше заданного объёма плиток, давно не тронутые сбрасываются
+// на диск (tiles/0/<x>_<y>.png) и подгружаются при следующем обращении. Для живого
+// просмотра поддерживается уменьшенная обзорная копия всего холста; по завершении
+// плитки собираются в пирамиду tiles/<уровень>/ с уменьшением в 2 раза на уровень.
+// Все методы потокобезопасны: наложение кадров идёт в потоке мозаики, просмотр - в потоке интерфейса.
+class MosaicCanvas {
+public:
+    static constexpr int TILE_SIZE = 512;
+    static constexpr int OVERVIEW_MAX = 4096;   // Наибольшая сторона обзорной копии
+
+    MosaicCanvas(const QString& directory, qint64 memoryBudgetBytes);
+
+    // Наложение кадра BGR с весами CV_32F (0..1) по преобразованию кадр -> холст.
+    // false, если кадр после преобразования вырожден или неправдоподобно велик.
+    bool blend(const cv::Mat& frame, const cv::Mat& weights, const cv::Matx33d& toCanvas);
+    // Участок холста в изображение заданного размера (ARGB32, непокрытое - прозрачное)
+    QImage render(const QRectF& canvasRect, const QSize& size);
+    // Запись всех плиток, пирамиды, обзорной копии и описания mosaic.json
+    bool finish(int& levels, QString& error);
+
+    QRect bounds() const;
+    QString directory() const { return m_directory; }
+    int tilesInMemory() const;
+    int tilesOnDisk() const;
+
+private:
+    struct Tile {
+        cv::Mat image;
+        bool dirty = false;
+        std::list<qint64>::iterator lru;
+    };
+
+    static qint64 key(int tx, int ty) { return (qint64(tx) << 32) | quint32(ty); }
+    static int keyX(qint64 tileKey) { return int(tileKey >> 32); }
+    static int keyY(qint64 tileKey) { return int(qint32(quint32(tileKey))); }
+    static int floorDiv(int value, int divisor) { return value >= 0 ? value / divisor : (value - divisor + 1) / divisor; }
+    QString tilePath(int level, int tx, int ty) const;
+
+    cv::Mat* tile(int tx, int ty, bool create);
+    bool writeTile(int tx, int ty, const Tile& tile);
+    void evict();
+    void readRect(const cv::Rect& rect, cv::Mat& region, bool create);
+    void writeRect(const cv::Rect& rect, const cv::Mat& region);
+    void updateOverview(const cv::Rect& rect, const cv::Mat& region);
+
+    QString m_directory;
+    int m_maxTiles;
+    mutable QMutex m_mutex;
+    std::unordered_map<qint64, Tile> m_tiles;
+    std::list<qint64> m_lru;        // Спереди - недавно использованные
+    QSet<qint64> m_onDisk;
+    cv::Rect m_bounds;              // Покрытая область холста
+
+    cv::Mat m_overview;             // BGRA
+    cv::Rect m_overviewArea;        // Область холста, которую покрывает обзорная копия
+    double m_overviewScale = 1.0;
+    int m_writeErrors = 0;
+};
+
+#endif // MOSAIC_CANVAS_H
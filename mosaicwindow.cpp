@@ -0,0 +1,141 @@
+#include "mosaicwindow.h"
+#include <QHBoxLayout>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <cmath>
+
+MosaicView::MosaicView(MosaicBuilder *builder, QWidget *parent)
+    : QWidget(parent), builder(builder), center(0, 0), scale(1.0), userView(false)
+{
+    setMinimumSize(400, 300);
+}
+
+void MosaicView::fitToMosaic()
+{
+    userView = false;
+    const QRect bounds = builder->bounds();
+    if (bounds.isEmpty() || width() <= 0 || height() <= 0)
+        return;
+    center = QRectF(bounds).center();
+    scale = qMax(double(bounds.width()) / width(), double(bounds.height()) / height()) * 1.05;
+    update();
+}
+
+void MosaicView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(32, 32, 32));
+
+    // Пока пользователь не двигал вид, мозаика целиком вписана в окно
+    if (!userView)
+        fitToMosaic();
+    const QRectF canvasRect(center.x() - width() * scale / 2, center.y() - height() * scale / 2,
+                            width() * scale, height() * scale);
+    const QImage image = builder->render(canvasRect, size());
+    if (!image.isNull())
+        painter.drawImage(0, 0, image);
+
+    painter.setPen(Qt::gray);
+    painter.drawText(rect().adjusted(8, 8, -8, -8), Qt::AlignLeft | Qt::AlignBottom,
+                     QString("Масштаб 1:%1").arg(scale, 0, 'f', scale < 10 ? 2 : 0));
+}
+
+void MosaicView::wheelEvent(QWheelEvent *event)
+{
+    // Точка холста под курсором остаётся на месте
+    const QPointF offset = event->position() - QPointF(width() / 2.0, height() / 2.0);
+    const QPointF anchor = center + offset * scale;
+    scale = qBound(0.05, scale * std::pow(1.0015, -event->angleDelta().y()), 1000.0);
+    center = anchor - offset * scale;
+    userView = true;
+    update();
+}
+
+void MosaicView::mousePressEvent(QMouseEvent *event)
+{
+    lastMousePos = event->position();
+    if (event->button() == Qt::RightButton)
+        fitToMosaic();
+}
+
+void MosaicView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton))
+        return;
+    center -= (event->position() - lastMousePos) * scale;
+    lastMousePos = event->position();
+    userView = true;
+    update();
+}
+
+MosaicWindow::MosaicWindow(MosaicBuilder *builder, QWidget *parent)
+    : QWidget(parent), builder(builder)
+{
+    setWindowTitle("Фотомозаика");
+    resize(900, 700);
+
+    view = new MosaicView(builder, this);
+    statusLabel = new QLabel(this);
+    messageLabel = new QLabel(this);
+    messageLabel->setWordWrap(true);
+    startButton = new QPushButton("Начать", this);
+    stopButton = new QPushButton("Завершить и сохранить", this);
+    stopButton->setEnabled(false);
+    QPushButton *fitButton = new QPushButton("Вписать", this);
+
+    connect(startButton, &QPushButton::clicked, this, [this]() {
+        messageLabel->clear();
+        this->builder->start();
+        view->fitToMosaic();
+    });
+    connect(stopButton, &QPushButton::clicked, builder, &MosaicBuilder::stop);
+    connect(fitButton, &QPushButton::clicked, view, &MosaicView::fitToMosaic);
+    connect(builder, &MosaicBuilder::statusUpdated, this, &MosaicWindow::onStatusUpdated);
+    connect(builder, &MosaicBuilder::finished, this, &MosaicWindow::onFinished);
+    connect(builder, &MosaicBuilder::errorOccurred, this, [this](const QString &, const QString &message) {
+        messageLabel->setText(message);
+    });
+
+    // Мозаика растёт непрерывно, вид перерисовывается с частотой обработки кадров
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, view, QOverload<>::of(&QWidget::update));
+    refreshTimer->start(200);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(startButton);
+    buttonLayout->addWidget(stopButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(fitButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(view, 1);
+    layout->addWidget(statusLabel);
+    layout->addWidget(messageLabel);
+    layout->addLayout(buttonLayout);
+
+    statusLabel->setText(QString("Камера: %1. Колесо мыши - масштаб, левая кнопка - перемещение, правая - вписать")
+                             .arg(builder->cameraName()));
+}
+
+void MosaicWindow::onStatusUpdated(const MosaicStatus &status)
+{
+    startButton->setEnabled(!status.running);
+    stopButton->setEnabled(status.running);
+    statusLabel->setText(QString("%1 | кадров: %2, не привязано: %3, пропущено: %4 | обработка %5 мс (средн. %6 мс) | "
+                                 "плиток в памяти: %7, на диске: %8 | %9x%10")
+                             .arg(status.running ? (status.lost ? "потеря привязки" : "идёт построение") : "остановлено")
+                             .arg(status.processed).arg(status.failed).arg(status.skipped)
+                             .arg(status.lastMs, 0, 'f', 0).arg(status.averageMs, 0, 'f', 0)
+                             .arg(status.tilesInMemory).arg(status.tilesOnDisk)
+                             .arg(status.bounds.width()).arg(status.bounds.height()));
+}
+
+void MosaicWindow::onFinished(bool ok, const QString &message)
+{
+    messageLabel->setText(message);
+    startButton->setEnabled(true);
+    if (ok)
+        view->fitToMosaic();
+}
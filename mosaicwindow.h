@@ -0,0 +1,53 @@
+#ifndef MOSAICWINDOW_H
+#define MOSAICWINDOW_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include "mosaic_builder.h"
+
+// Просмотр мозаики с масштабированием колесом мыши и перемещением перетаскиванием
+class MosaicView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MosaicView(MosaicBuilder *builder, QWidget *parent = nullptr);
+    void fitToMosaic();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    MosaicBuilder *builder;
+    QPointF center;         // Центр вида в координатах холста
+    double scale;           // Пикселей холста на пиксель экрана
+    QPointF lastMousePos;
+    bool userView;          // Пользователь сам выбрал вид - автоматически не вписываем
+};
+
+// Окно фотомозаики по нижней камере
+class MosaicWindow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MosaicWindow(MosaicBuilder *builder, QWidget *parent = nullptr);
+
+private slots:
+    void onStatusUpdated(const MosaicStatus &status);
+    void onFinished(bool ok, const QString &message);
+
+private:
+    MosaicBuilder *builder;
+    MosaicView *view;
+    QLabel *statusLabel;
+    QLabel *messageLabel;
+    QPushButton *startButton;
+    QPushButton *stopButton;
+    QTimer *refreshTimer;
+};
+
+#endif // MOSAICWINDOW_H
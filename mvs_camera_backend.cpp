@@ -0,0 +1,188 @@
+#include "mvs_camera_backend.h"
+#include <QDebug>
+
+namespace {
+
+// Значение целочисленного узла, приведённое к его границам и шагу
+int64_t alignToNode(void* handle, const char* key, int64_t value) {
+    MVCC_INTVALUE_EX info;
+    memset(&info, 0, sizeof(info));
+    if (MV_CC_GetIntValueEx(handle, key, &info) != MV_OK) return value;
+    const int64_t inc = info.nInc > 0 ? info.nInc : 1;
+    value = qBound(info.nMin, value, info.nMax);
+    return info.nMin + (value - info.nMin) / inc * inc;
+}
+
+} // namespace
+
+MvsCameraBackend::MvsCameraBackend(void* handle, const QString& cameraName)
+    : m_handle(handle), m_cameraName(cameraName) {}
+
+MvsCameraBackend::~MvsCameraBackend() {
+    close();
+}
+
+int MvsCameraBackend::startGrabbing() {
+    if (!m_handle) return MV_E_HANDLE;
+    return MV_CC_StartGrabbing(m_handle);
+}
+
+int MvsCameraBackend::grabFrame(RawFrame& frame, unsigned int timeoutMs) {
+    if (!m_handle) return MV_E_HANDLE;
+    memset(&frame.mvFrame, 0, sizeof(MV_FRAME_OUT));
+    int nRet = MV_CC_GetImageBuffer(m_handle, &frame.mvFrame, timeoutMs);
+    if (nRet != MV_OK) {
+        frame.data = nullptr;
+        return nRet;
+    }
+    frame.data = frame.mvFrame.pBufAddr;
+    frame.width = frame.mvFrame.stFrameInfo.nWidth;
+    frame.height = frame.mvFrame.stFrameInfo.nHeight;
+    frame.frameNum = frame.mvFrame.stFrameInfo.nFrameNum;
+    frame.pixelType = frame.mvFrame.stFrameInfo.enPixelType;
+    frame.timestampNs = monotonicNs();
+    return MV_OK;
+}
+
+void MvsCameraBackend::releaseFrame(RawFrame& frame) {
+    if (m_handle && frame.mvFrame.pBufAddr) {
+        MV_CC_FreeImageBuffer(m_handle, &frame.mvFrame);
+    }
+    memset(&frame.mvFrame, 0, sizeof(MV_FRAME_OUT));
+    frame.data = nullptr;
+}
+
+int MvsCameraBackend::applyParameters(const CameraParameters& parameters, bool geometry) {
+    if (!m_handle) return MV_E_HANDLE;
+
+    int result = MV_OK;
+    auto check = [&](int nRet, const char* node) {
+        if (nRet != MV_OK) {
+            qDebug() << "Не удалось установить" << node << "для камеры" << m_cameraName << "Ошибка:" << nRet;
+            if (result == MV_OK) result = nRet;
+        }
+    };
+
+    if (geometry) {
+        // Биннинг и прореживание меняют максимальный размер кадра, поэтому идут первыми,
+        // а смещения сбрасываются, чтобы новый размер поместился в сенсор
+        check(MV_CC_SetEnumValue(m_handle, "BinningHorizontal", parameters.binning), "BinningHorizontal");
+        check(MV_CC_SetEnumValue(m_handle, "BinningVertical", parameters.binning), "BinningVertical");
+        check(MV_CC_SetEnumValue(m_handle, "DecimationHorizontal", parameters.decimation), "DecimationHorizontal");
+        check(MV_CC_SetEnumValue(m_handle, "DecimationVertical", parameters.decimation), "DecimationVertical");
+        check(MV_CC_SetIntValueEx(m_handle, "OffsetX", 0), "OffsetX");
+        check(MV_CC_SetIntValueEx(m_handle, "OffsetY", 0), "OffsetY");
+
+        // ROI задан в пикселях сенсора, узлы камеры считаются после биннинга и прореживания
+        const int scale = parameters.binning * parameters.decimation;
+        auto applyAxis = [&](const char* sizeNode, const char* maxNode, const char* offsetNode, int roiOffset, int roiSize) {
+            MVCC_INTVALUE_EX maxInfo;
+            memset(&maxInfo, 0, sizeof(maxInfo));
+            int nRet = MV_CC_GetIntValueEx(m_handle, maxNode, &maxInfo);
+            if (nRet != MV_OK) {
+                check(nRet, maxNode);
+                return;
+            }
+            const int64_t maxSize = maxInfo.nCurValue;
+            const int64_t offset = qBound<int64_t>(0, roiOffset / scale, maxSize - 1);
+            const int64_t size = roiSize > 0 ? qMin<int64_t>(roiSize / scale, maxSize - offset) : maxSize - offset;
+            check(MV_CC_SetIntValueEx(m_handle, sizeNode, alignToNode(m_handle, sizeNode, size)), sizeNode);
+            check(MV_CC_SetIntValueEx(m_handle, offsetNode, alignToNode(m_handle, offsetNode, offset)), offsetNode);
+        };
+        applyAxis("Width", "WidthMax", "OffsetX", parameters.roiX, parameters.roiWidth);
+        applyAxis("Height", "HeightMax", "OffsetY", parameters.roiY, parameters.roiHeight);
+    }
+
+    if (parameters.exposureUs > 0) {
+        check(MV_CC_SetEnumValue(m_handle, "ExposureAuto", MV_EXPOSURE_AUTO_MODE_OFF), "ExposureAuto");
+        check(MV_CC_SetFloatValue(m_handle, "ExposureTime", float(parameters.exposureUs)), "ExposureTime");
+    }
+    if (parameters.gainDb >= 0) {
+        check(MV_CC_SetEnumValue(m_handle, "GainAuto", MV_GAIN_MODE_OFF), "GainAuto");
+        check(MV_CC_SetFloatValue(m_handle, "Gain", float(parameters.gainDb)), "Gain");
+    }
+    check(MV_CC_SetBoolValue(m_handle, "AcquisitionFrameRateEnable", parameters.frameRate > 0), "AcquisitionFrameRateEnable");
+    if (parameters.frameRate > 0) {
+        check(MV_CC_SetFloatValue(m_handle, "AcquisitionFrameRate", float(parameters.frameRate)), "AcquisitionFrameRate");
+    }
+    return result;
+}
+
+int MvsCameraBackend::setExposure(double exposureUs, double gainDb) {
+    if (!m_handle) return MV_E_HANDLE;
+
+    // Встроенная автоэкспозиция камеры отключается один раз, дальше пишутся только значения
+    if (!m_manualExposure) {
+        int nRet = MV_CC_SetEnumValue(m_handle, "ExposureAuto", MV_EXPOSURE_AUTO_MODE_OFF);
+        if (nRet == MV_OK) nRet = MV_CC_SetEnumValue(m_handle, "GainAuto", MV_GAIN_MODE_OFF);
+        if (nRet != MV_OK) return nRet;
+        m_manualExposure = true;
+    }
+    int nRet = MV_CC_SetFloatValue(m_handle, "ExposureTime", float(exposureUs));
+    if (nRet != MV_OK) return nRet;
+    return MV_CC_SetFloatValue(m_handle, "Gain", float(gainDb));
+}
+
+int MvsCameraBackend::getExposure(double& exposureUs, double& gainDb) const {
+    if (!m_handle) return MV_E_HANDLE;
+
+    MVCC_FLOATVALUE value;
+    memset(&value, 0, sizeof(value));
+    int nRet = MV_CC_GetFloatValue(m_handle, "ExposureTime", &value);
+    if (nRet != MV_OK) return nRet;
+    exposureUs = value.fCurValue;
+    nRet = MV_CC_GetFloatValue(m_handle, "Gain", &value);
+    if (nRet != MV_OK) return nRet;
+    gainDb = value.fCurValue;
+    return MV_OK;
+}
+
+bool MvsCameraBackend::transportStats(TransportStats& stats) const {
+    if (!m_handle) return false;
+
+    MV_MATCH_INFO_NET_DETECT netInfo;
+    memset(&netInfo, 0, sizeof(netInfo));
+    MV_ALL_MATCH_INFO matchInfo;
+    memset(&matchInfo, 0, sizeof(matchInfo));
+    matchInfo.nType = MV_MATCH_TYPE_NET_DETECT;
+    matchInfo.pInfo = &netInfo;
+    matchInfo.nInfoSize = sizeof(netInfo);
+    if (MV_CC_GetAllMatchInfo(m_handle, &matchInfo) != MV_OK) {
+        return false; // USB-камеры и камеры без статистики приёма
+    }
+
+    stats.lostPackets = quint64(qMax<int64_t>(0, netInfo.nLostPacketCount));
+    stats.lostFrames = netInfo.nLostFrameCount;
+    stats.receivedFrames = netInfo.nNetRecvFrameCount;
+    stats.resendRequested = quint64(qMax<int64_t>(0, netInfo.nRequestResendPacketCount));
+    stats.resent = quint64(qMax<int64_t>(0, netInfo.nResendPacketCount));
+    return true;
+}
+
+int MvsCameraBackend::stopGrabbing() {
+    if (!m_handle) return MV_OK;
+    return MV_CC_StopGrabbing(m_handle);
+}
+
+int MvsCameraBackend::close() {
+    if (!m_handle) return MV_OK;
+
+    int result = MV_OK;
+    int nRet = MV_CC_StopGrabbing(m_handle);
+    if (nRet != MV_OK && nRet != -2147483648 && nRet != -2147483645 && nRet != -2147483133) {
+        qDebug() << "Не удалось остановить захват для камеры" << m_cameraName << "Ошибка:" << nRet;
+        result = nRet;
+    }
+    nRet = MV_CC_CloseDevice(m_handle);
+    if (nRet != MV_OK && nRet != -2147483648 && nRet != -2147483645) {
+        qDebug() << "Не удалось закрыть устройство для камеры" << m_cameraName << "Ошибка:" << nRet;
+        result = nRet;
+    }
+    nRet = MV_CC_DestroyHandle(m_handle);
+    if (nRet != MV_OK && nRet != -2147483648) {
+        qDebug() << "Не удалось уничтожить дескриптор для камеры" << m_cameraName << "Ошибка:" << nRet;
+        result = nRet;
+    }
+    m_handle = nullptr;
+    return result;
+}
@@ -0,0 +1,32 @@
+#ifndef MVS_CAMERA_BACKEND_H
+#define MVS_CAMERA_BACKEND_H
+
+#include "camera_backend.h"
+
+// Источник кадров Hikrobot MVS. Принимает во владение уже открытый дескриптор камеры.
+class MvsCameraBackend : public CameraBackend {
+public:
+    MvsCameraBackend(void* handle, const QString& cameraName);
+    ~MvsCameraBackend() override;
+
+    QString typeName() const override { return "mvs"; }
+    int startGrabbing() override;
+    int grabFrame(RawFrame& frame, unsigned int timeoutMs) override;
+    void releaseFrame(RawFrame& frame) override;
+    int stopGrabbing() override;
+    int close() override;
+    bool isOpen() const override { return m_handle != nullptr; }
+    int applyParameters(const CameraParameters& parameters, bool geometry) override;
+    int setExposure(double exposureUs, double gainDb) override;
+    int getExposure(double& exposureUs, double& gainDb) const override;
+    bool transportStats(TransportStats& stats) const override;
+
+    void* handle() const { return m_handle; }
+
+private:
+    void* m_handle;
+    QString m_cameraName;
+    bool m_manualExposure = false; // ExposureAuto/GainAuto камеры уже выключены
+};
+
+#endif // MVS_CAMERA_BACKEND_H
@@ -1,6 +1,7 @@
 #include "overlaywidget.h"
 #include <QScreen>
 #include <QWindow>
+#include <cmath>
 
 OverlayWidget::OverlayWidget(QWidget *parent) : QWidget(parent)
 {
@@ -26,6 +27,8 @@ OverlayWidget::OverlayWidget(QWidget *parent) : QWidget(parent)
     oBatLevel = 0;
     prevYaw = 0;
     revolutionCount = 0;
+    oMeasurementMode = false;
+    oMeasurementPending = false;
     parentWidget = parent;
     qreal refreshRate = 60;
     QScreen *screen = QGuiApplication::primaryScreen(); // или QApplication::screenAt(...)
@@ -1126,6 +1129,33 @@ void OverlayWidget::paintEvent(QPaintEvent *event)
         painter.drawText(lightsRect, Qt::AlignLeft, "Освещение: вкл.");
     else
         painter.drawText(lightsRect, Qt::AlignLeft, "Освещение: выкл.");
+
+    //Качество связи
+    QRect linkRect(screenWidth / 30, screenHeight/12 + 60, 600, 20);
+    QFont linkFont("Consolas", 12, QFont::Bold);
+    QColor linkColor = oLinkStats.failsafe ? QColor(Qt::red) : defaultColor;
+    painter.setFont(linkFont);
+    painter.setPen(linkColor);
+    if(!oLinkStats.online)
+        painter.drawText(linkRect, Qt::AlignLeft, "Связь: нет");
+    else if(!oLinkStats.echoSupported)
+        painter.drawText(linkRect, Qt::AlignLeft, "Связь: есть, RTT н/д");
+    else
+        painter.drawText(linkRect, Qt::AlignLeft,
+                         QString("Связь: RTT %1/%2 мс, джиттер %3 мс, потери %4%")
+                             .arg(oLinkStats.rttP50Ms, 0, 'f', 1)
+                             .arg(oLinkStats.rttP99Ms, 0, 'f', 1)
+                             .arg(oLinkStats.jitterMs, 0, 'f', 1)
+                             .arg(oLinkStats.lossPercent, 0, 'f', 1));
+    if (oProximityAge.isValid())
+        drawProximity(painter);
+    if (oOdometry.running)
+        drawOdometry(painter);
+    if (oAutoCapture.running)
+        drawAutoCapture(painter);
+    if (oMeasurementMode)
+        drawMeasurement(painter);
+
     // // Рисуем оверлей на всей доступной области виджета
     // painter.setBrush(QBrush(QColor(255, 0, 0, 100))); // Будет красить
     // painter.drawRect(rect()); // Используем rect() для получения текущих размеров виджета
@@ -1178,6 +1208,10 @@ void OverlayWidget::controlsUpdate(const bool& stabEnabled,
     oLightsState = lightsState;
 }
 
+void OverlayWidget::linkUpdate(const LinkStats& linkStats){
+    oLinkStats = linkStats;
+}
+
 void OverlayWidget::updateOverlay(){
     emit requestOverlayDataUpdate();
     this->setGeometry(0, 0, parentWidget->width(), parentWidget->height());
@@ -1192,3 +1226,204 @@ void OverlayWidget::countRevolutions(){
         revolutionCount++;
     prevYaw = oYaw;
 }
+
+void OverlayWidget::setMeasurementMode(bool enabled, const QString& status){
+    oMeasurementMode = enabled;
+    oMeasurementStatus = status;
+    oMeasurementPoints.clear();
+    oMeasurementPending = false;
+    oMeasurement = StereoMeasurementResult();
+    // Вне режима измерения щелчки проходят к видео под оверлеем
+    setAttribute(Qt::WA_TransparentForMouseEvents, !enabled);
+    setCursor(enabled ? Qt::CrossCursor : Qt::ArrowCursor);
+}
+
+void OverlayWidget::measurementUpdate(const StereoMeasurementResult& result){
+    // Ответ на уже сброшенные точки не показываем
+    if (oMeasurementPoints.size() != 2 || oMeasurementPoints[0] != result.a || oMeasurementPoints[1] != result.b)
+        return;
+    oMeasurementPending = false;
+    oMeasurement = result;
+    update();
+}
+
+void OverlayWidget::mousePressEvent(QMouseEvent *event){
+    if (!oMeasurementMode || width() <= 0 || height() <= 0) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    if (event->button() == Qt::RightButton) {
+        oMeasurementPoints.clear();
+        oMeasurementPending = false;
+    } else if (event->button() == Qt::LeftButton) {
+        if (oMeasurementPoints.size() >= 2)
+            oMeasurementPoints.clear();
+        oMeasurementPoints.append(QPointF(event->position().x() / width(), event->position().y() / height()));
+        if (oMeasurementPoints.size() == 2) {
+            oMeasurementPending = true;
+            emit measurementRequested(oMeasurementPoints[0], oMeasurementPoints[1]);
+        }
+    }
+    oMeasurement = StereoMeasurementResult();
+    update();
+}
+
+void OverlayWidget::drawMeasurement(QPainter& painter){
+    QColor measureColor(Qt::yellow);
+    QFont measureFont("Consolas", 12, QFont::Bold);
+    painter.setFont(measureFont);
+
+    QList<QPoint> points;
+    for (const QPointF& point : oMeasurementPoints)
+        points.append(QPoint(qRound(point.x() * width()), qRound(point.y() * height())));
+    for (const QPoint& point : points)
+        drawCrosshair(&painter, point, 12, 2, 3, measureColor);
+    if (points.size() == 2) {
+        QPen pen(measureColor);
+        pen.setWidth(1);
+        pen.setStyle(Qt::DashLine);
+        painter.setPen(pen);
+        painter.drawLine(points[0], points[1]);
+    }
+
+    QString text;
+    if (oMeasurementPending)
+        text = "Измерение...";
+    else if (oMeasurement.ok)
+        text = QString("%1 \u00b1 %2 мм (дальность %3 / %4 м, %5 мс)")
+                   .arg(oMeasurement.distanceMm, 0, 'f', 0)
+                   .arg(oMeasurement.errorMm, 0, 'f', 0)
+                   .arg(oMeasurement.depthAMm / 1000.0, 0, 'f', 2)
+                   .arg(oMeasurement.depthBMm / 1000.0, 0, 'f', 2)
+                   .arg(oMeasurement.latencyMs, 0, 'f', 0);
+    else if (!oMeasurement.message.isEmpty())
+        text = "Измерение не удалось: " + oMeasurement.message;
+    else if (!oMeasurementStatus.isEmpty())
+        text = oMeasurementStatus;
+    else
+        text = "Измерение: отметьте две точки, правая кнопка - сброс";
+
+    QPoint textPosition = points.isEmpty() ? QPoint(width() / 30, height() - height() / 12)
+                                           : (points.size() == 2 ? (points[0] + points[1]) / 2 : points[0]) + QPoint(12, -12);
+    painter.setPen(oMeasurement.ok || oMeasurementPending || oMeasurement.message.isEmpty() ? measureColor : QColor(Qt::red));
+    painter.drawText(textPosition, text);
+}
+
+void OverlayWidget::proximityUpdate(const ProximityMap& map){
+    oProximity = map;
+    oProximityAge.start();
+}
+
+void OverlayWidget::drawProximity(QPainter& painter){
+    // Устаревшая карта хуже отсутствующей: сектора показываются только по свежим данным
+    const bool fresh = oProximityAge.elapsed() < 1000;
+    const int screenWidth = width();
+    const int screenHeight = height();
+
+    if (fresh && oProximity.columns > 0 && oProximity.rows > 0) {
+        QFont sectorFont("Consolas", 14, QFont::Bold);
+        painter.setFont(sectorFont);
+        for (int row = 0; row < oProximity.rows; ++row) {
+            for (int column = 0; column < oProximity.columns; ++column) {
+                const float distance = oProximity.distanceM.value(row * oProximity.columns + column, -1.0f);
+                if (distance < 0 || distance >= oProximity.cautionM)
+                    continue;
+                QColor sectorColor = distance < oProximity.warnM ? QColor(Qt::red) : QColor(Qt::yellow);
+                const QRect sectorRect(column * screenWidth / oProximity.columns, row * screenHeight / oProximity.rows,
+                                       screenWidth / oProximity.columns, screenHeight / oProximity.rows);
+                QPen pen(sectorColor);
+                pen.setWidth(3);
+                painter.setPen(pen);
+                sectorColor.setAlpha(40);
+                painter.setBrush(sectorColor);
+                painter.drawRect(sectorRect.adjusted(4, 4, -4, -4));
+                painter.drawText(sectorRect, Qt::AlignCenter, QString("%1 м").arg(distance, 0, 'f', 1));
+            }
+        }
+        painter.setBrush(Qt::NoBrush);
+    }
+
+    //Состояние оценки близости
+    QRect proximityRect(screenWidth / 30, screenHeight/12 + 80, 600, 20);
+    QFont proximityFont("Consolas", 12, QFont::Bold);
+    painter.setFont(proximityFont);
+    painter.setPen(fresh ? QColor(Qt::gray) : QColor(Qt::red));
+    if (fresh)
+        painter.drawText(proximityRect, Qt::AlignLeft,
+                         QString("Близость: задержка %1 мс, расчёт %2 мс, пропущено %3")
+                             .arg(oProximity.latencyMs, 0, 'f', 0)
+                             .arg(oProximity.computeMs, 0, 'f', 0)
+                             .arg(oProximity.skipped));
+    else
+        painter.drawText(proximityRect, Qt::AlignLeft, "Близость: нет данных");
+}
+
+void OverlayWidget::odometryUpdate(const OdometryState& state){
+    oOdometry = state;
+    oOdometryAge.start();
+}
+
+void OverlayWidget::drawOdometry(QPainter& painter){
+    // Одометрия обновляется 20+ раз в секунду, пауза дольше полсекунды - данных нет
+    const bool fresh = oOdometryAge.elapsed() < 500;
+    QRect odometryRect(width() / 30, height()/12 + 100, 900, 20);
+    QFont odometryFont("Consolas", 12, QFont::Bold);
+    painter.setFont(odometryFont);
+    if (!fresh) {
+        painter.setPen(Qt::red);
+        painter.drawText(odometryRect, Qt::AlignLeft, "Удержание: нет кадров нижней камеры");
+    } else if (!oOdometry.tracking) {
+        painter.setPen(Qt::red);
+        painter.drawText(odometryRect, Qt::AlignLeft,
+                         QString("Удержание: нет привязки к дну, потеряно кадров %1").arg(oOdometry.lost));
+    } else {
+        painter.setPen(Qt::green);
+        painter.drawText(odometryRect, Qt::AlignLeft,
+                         QString("Удержание: снос %1 м (С %2, В %3), марш %4, лаг %5 | %6 Гц, расчёт %7 мс, точек %8")
+                             .arg(std::hypot(oOdometry.driftNorthM, oOdometry.driftEastM), 0, 'f', 2)
+                             .arg(oOdometry.driftNorthM, 0, 'f', 2)
+                             .arg(oOdometry.driftEastM, 0, 'f', 2)
+                             .arg(oOdometry.forward, 0, 'f', 2)
+                             .arg(oOdometry.side, 0, 'f', 2)
+                             .arg(oOdometry.rateHz, 0, 'f', 0)
+                             .arg(oOdometry.computeMs, 0, 'f', 1)
+                             .arg(oOdometry.features));
+    }
+}
+
+void OverlayWidget::autoCaptureUpdate(const StereoAutoState& state){
+    oAutoCapture = state;
+    oAutoCaptureAge.start();
+}
+
+void OverlayWidget::drawAutoCapture(QPainter& painter){
+    // Оценка идёт с частотой Stereo_auto_rate_hz, пауза дольше секунды - кадров нет
+    const bool fresh = oAutoCaptureAge.elapsed() < 1000;
+    QRect autoCaptureRect(width() / 30, height()/12 + 125, 900, 20);
+    QFont autoCaptureFont("Consolas", 12, QFont::Bold);
+    painter.setFont(autoCaptureFont);
+    const QString counters = QString("снимков %1 (без резкого кадра %2, отклонено %3, разрывов %4)")
+                                 .arg(oAutoCapture.shots)
+                                 .arg(oAutoCapture.forcedShots)
+                                 .arg(oAutoCapture.rejectedShots)
+                                 .arg(oAutoCapture.gaps);
+    if (!fresh) {
+        painter.setPen(Qt::red);
+        painter.drawText(autoCaptureRect, Qt::AlignLeft, QString("Автосъёмка: нет кадров камеры, %1").arg(counters));
+    } else if (!oAutoCapture.tracking) {
+        painter.setPen(Qt::yellow);
+        painter.drawText(autoCaptureRect, Qt::AlignLeft,
+                         QString("Автосъёмка: сдвиг не найден, перекрытие ~%1% | %2")
+                             .arg(oAutoCapture.overlap * 100, 0, 'f', 0)
+                             .arg(counters));
+    } else {
+        painter.setPen(oAutoCapture.gaps > 0 ? Qt::yellow : Qt::green);
+        painter.drawText(autoCaptureRect, Qt::AlignLeft,
+                         QString("Автосъёмка: перекрытие %1%, резкость %2/%3 | %4, расчёт %5 мс")
+                             .arg(oAutoCapture.overlap * 100, 0, 'f', 0)
+                             .arg(oAutoCapture.sharpness, 0, 'f', 0)
+                             .arg(oAutoCapture.bestSharpness, 0, 'f', 0)
+                             .arg(counters)
+                             .arg(oAutoCapture.computeMs, 0, 'f', 1));
+    }
+}
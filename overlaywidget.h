@@ -5,8 +5,16 @@
 #include <QPainter>
 #include <QTimer>
 #include "udptelemetryparser.h"
+#include "linkmonitor.h"
+#include "stereo_measurement.h"
+#include "stereo_proximity.h"
+#include "visual_odometry.h"
+#include "stereo_auto_capture.h"
+#include <QElapsedTimer>
 #include <QColor>
 #include <QPoint>
+#include <QPointF>
+#include <QMouseEvent>
 
 class OverlayWidget : public QWidget
 {
@@ -24,11 +32,20 @@ public:
                         const float& powerLimit,
                         const float& camAngle,
                         const bool &lightsState);
+    void linkUpdate(const LinkStats& linkStats);
+    // Режим измерения: левый щелчок ставит точку, после второй запрашивается расстояние,
+    // правый щелчок сбрасывает точки
+    void setMeasurementMode(bool enabled, const QString& status = QString());
+    void measurementUpdate(const StereoMeasurementResult& result);
+    void proximityUpdate(const ProximityMap& map);
+    void odometryUpdate(const OdometryState& state);
+    void autoCaptureUpdate(const StereoAutoState& state);
 
 public slots:
 
 signals:
     void requestOverlayDataUpdate();
+    void measurementRequested(const QPointF& a, const QPointF& b);
 
 private:
     QTimer *frameTimer;
@@ -55,12 +72,29 @@ private:
     float oBatLevel;
     float prevYaw;
     float revolutionCount;
+    LinkStats oLinkStats;
+    bool oMeasurementMode;
+    QString oMeasurementStatus;
+    QList<QPointF> oMeasurementPoints;     // Нормированные координаты кадра
+    bool oMeasurementPending;
+    StereoMeasurementResult oMeasurement;
+    ProximityMap oProximity;
+    QElapsedTimer oProximityAge;
+    OdometryState oOdometry;
+    QElapsedTimer oOdometryAge;
+    StereoAutoState oAutoCapture;
+    QElapsedTimer oAutoCaptureAge;
     QWidget *parentWidget;
 
     void countRevolutions();
+    void drawMeasurement(QPainter& painter);
+    void drawProximity(QPainter& painter);
+    void drawOdometry(QPainter& painter);
+    void drawAutoCapture(QPainter& painter);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
 };
 
 #endif // OVERLAYWIDGET_H
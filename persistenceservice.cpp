@@ -0,0 +1,154 @@
+#include "persistenceservice.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+PersistenceService::PersistenceService(QObject* parent)
+    : QObject(parent)
+{
+    m_debounceTimer = new QTimer(this);
+    m_debounceTimer->setSingleShot(true);
+    connect(m_debounceTimer, &QTimer::timeout, this, &PersistenceService::flushPending);
+
+    m_thread.setObjectName("PersistenceService");
+    moveToThread(&m_thread);
+    m_thread.start(QThread::LowPriority);
+}
+
+PersistenceService::~PersistenceService()
+{
+    shutdown();
+}
+
+PersistenceService& PersistenceService::instance()
+{
+    static PersistenceService instance;
+    return instance;
+}
+
+void PersistenceService::scheduleWrite(const QString& filePath, const QJsonObject& object, QJsonDocument::JsonFormat format)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_stopped) {
+            // Более свежая версия того же файла заменяет ещё не записанную
+            m_pending.insert(filePath, PendingWrite{object, format});
+            QMetaObject::invokeMethod(this, [this]() {
+                // Таймер не перезапускается, чтобы при непрерывных изменениях запись не откладывалась бесконечно
+                if (!m_debounceTimer->isActive())
+                    m_debounceTimer->start(DEBOUNCE_MS);
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    // Поток уже остановлен (завершение программы) - пишем сразу
+    writeFile(filePath, QJsonDocument(object).toJson(format));
+}
+
+void PersistenceService::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopped)
+            return;
+        m_stopped = true;
+    }
+    if (m_thread.isRunning()) {
+        QMetaObject::invokeMethod(this, [this]() { m_debounceTimer->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    m_thread.quit();
+    m_thread.wait();
+    // Поток остановлен, отложенные записи выполняем в вызывающем потоке
+    flushPending();
+}
+
+void PersistenceService::flushPending()
+{
+    QHash<QString, PendingWrite> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it)
+        writeFile(it.key(), QJsonDocument(it.value().object).toJson(it.value().format));
+}
+
+bool PersistenceService::writeFile(const QString& filePath, const QByteArray& data)
+{
+    QFileInfo info(filePath);
+    if (!QDir().mkpath(info.absolutePath())) {
+        QString reason = QString("Не удалось создать папку %1").arg(info.absolutePath());
+        qWarning() << "[PersistenceService]" << reason;
+        emit writeFailed(filePath, reason);
+        return false;
+    }
+
+    // Текущая версия становится резервной, только если она читается - иначе затрём хорошую копию
+    if (info.exists()) {
+        QFile current(filePath);
+        if (current.open(QIODevice::ReadOnly)) {
+            QJsonParseError error;
+            QJsonDocument::fromJson(current.readAll(), &error);
+            current.close();
+            if (error.error == QJsonParseError::NoError) {
+                QString backup = backupPath(filePath);
+                QFile::remove(backup);
+                if (!QFile::copy(filePath, backup))
+                    qWarning() << "[PersistenceService] Не удалось сохранить резервную копию" << backup;
+            }
+        }
+    }
+
+    // Временный файл рядом с целевым и атомарная замена при commit()
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QString reason = file.errorString();
+        qWarning() << "[PersistenceService] Не удалось открыть для записи" << filePath << ":" << reason;
+        emit writeFailed(filePath, reason);
+        return false;
+    }
+    if (file.write(data) != data.size() || !file.commit()) {
+        QString reason = file.errorString();
+        qWarning() << "[PersistenceService] Не удалось записать" << filePath << ":" << reason;
+        emit writeFailed(filePath, reason);
+        return false;
+    }
+
+    qDebug() << "[PersistenceService] Файл сохранён:" << filePath;
+    return true;
+}
+
+QString PersistenceService::backupPath(const QString& filePath)
+{
+    return filePath + ".bak";
+}
+
+bool PersistenceService::readJsonWithBackup(const QString& filePath, QJsonObject& object)
+{
+    for (const QString& path : {filePath, backupPath(filePath)}) {
+        QFile file(path);
+        if (!file.exists())
+            continue;
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "[PersistenceService] Не удалось открыть файл:" << path;
+            continue;
+        }
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+        file.close();
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            qWarning() << "[PersistenceService] Ошибка разбора JSON в" << path << ":" << error.errorString();
+            continue;
+        }
+        if (path != filePath)
+            qWarning() << "[PersistenceService] Файл" << filePath << "повреждён, загружена резервная копия";
+        object = doc.object();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef PERSISTENCESERVICE_H
+#define PERSISTENCESERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+
+// Фоновая запись JSON-файлов (настройки, профили управления).
+// Частые изменения одного файла объединяются: пишется только последняя версия после паузы.
+// Запись идёт через временный файл с атомарной заменой (QSaveFile), предыдущая
+// версия сохраняется рядом как <файл>.bak и используется при чтении повреждённого файла.
+class PersistenceService : public QObject {
+    Q_OBJECT
+
+public:
+    static PersistenceService& instance();
+    ~PersistenceService() override;
+
+    // Можно вызывать из любого потока, не блокирует вызывающего
+    void scheduleWrite(const QString& filePath, const QJsonObject& object,
+                       QJsonDocument::JsonFormat format = QJsonDocument::Indented);
+    // Синхронно дописывает всё отложенное и останавливает поток (при завершении программы)
+    void shutdown();
+
+    static QString backupPath(const QString& filePath);
+    // Читает JSON-объект из файла, при ошибке разбора - из резервной копии
+    static bool readJsonWithBackup(const QString& filePath, QJsonObject& object);
+
+signals:
+    void writeFailed(const QString& filePath, const QString& reason);
+
+private slots:
+    void flushPending();
+
+private:
+    explicit PersistenceService(QObject* parent = nullptr);
+    bool writeFile(const QString& filePath, const QByteArray& data);
+
+    struct PendingWrite {
+        QJsonObject object;
+        QJsonDocument::JsonFormat format;
+    };
+
+    static const int DEBOUNCE_MS = 300;
+
+    QThread m_thread;
+    QTimer* m_debounceTimer = nullptr;
+    QMutex m_mutex;
+    QHash<QString, PendingWrite> m_pending;
+    bool m_stopped = false;
+};
+
+#endif // PERSISTENCESERVICE_H
@@ -5,6 +5,7 @@
 #include <QJsonArray>
 #include <QDir>
 #include <QDebug>
+#include "persistenceservice.h"
 
 bool ProfileManager::load(const QString& filePath) {
     QFile file(filePath);
@@ -31,32 +32,21 @@ bool ProfileManager::loadFromProfileName(const QString& profileName) {
         return false;
     }
 
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString targetFile = baseDir + QDir::separator() +
-                         "Control Profiles" + QDir::separator() +
-                         profileName + ".json";
+    QString targetFile = profileFilePath(profileName);
 
-    QFile file(targetFile);
-    if (!file.exists()) {
+    if (!QFile::exists(targetFile) && !QFile::exists(PersistenceService::backupPath(targetFile))) {
         qWarning() << "Файл профиля не найден:" << targetFile;
         return false;
     }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "Не удалось открыть файл:" << targetFile;
-        return false;
-    }
-
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-
-    if (!doc.isObject()) {
+    QJsonObject loaded;
+    if (!PersistenceService::readJsonWithBackup(targetFile, loaded)) {
         qWarning() << "Ошибка парсинга JSON в файле:" << targetFile;
         return false;
     }
 
-    profileObject = doc.object();
-    emit profileNameChange();
+    profileObject = loaded;
+    emit profileNameChange(profileObject);
     return true;
 }
 
@@ -67,29 +57,11 @@ bool ProfileManager::save() {
         return false;
     }
 
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString targetDirPath = baseDir + QDir::separator() + "Control Profiles";
+    QString targetFile = profileFilePath(profileName);
 
-    QDir dir;
-    if (!dir.exists(targetDirPath)) {
-        if (!dir.mkpath(targetDirPath)) {
-            qWarning() << "Не удалось создать папку Control Profiles";
-            return false;
-        }
-    }
-
-    QString targetFile = targetDirPath + QDir::separator() + profileName + ".json";
-    QFile file(targetFile);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Не удалось сохранить файл в" << targetFile;
-        return false;
-    }
-
-    QJsonDocument doc(profileObject);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
-
-    qDebug() << "Файл успешно сохранён в:" << targetFile;
+    // Запись в фоновом потоке с атомарной заменой файла, ошибки сообщает PersistenceService
+    lastSavedProfile = profileObject;
+    PersistenceService::instance().scheduleWrite(targetFile, profileObject, QJsonDocument::Indented);
     return true;
 }
 
@@ -104,6 +76,7 @@ void ProfileManager::setDevices(const QString& primary, const QString& secondary
     devices["primary"] = primary;
     devices["secondary"] = secondary;
     profileObject["devices"] = devices;
+    emit profileChanged(profileObject);
 }
 
 void ProfileManager::addInput(const QString& name, const QString& input, const bool isSecondaryInput) {
@@ -130,6 +103,7 @@ void ProfileManager::addInput(const QString& name, const QString& input, const b
     }
 
     profileObject["inputs"] = inputs;
+    emit profileChanged(profileObject);
 }
 
 void ProfileManager::setInversion(const QString& inputName, bool inversion)
@@ -149,6 +123,7 @@ void ProfileManager::setInversion(const QString& inputName, bool inversion)
 
     if (found) {
         profileObject["inputs"] = inputs;
+        emit profileChanged(profileObject);
     }
 }
 
@@ -169,6 +144,7 @@ bool ProfileManager::removeInput(const QString& name) {
 
     if (found) {
         profileObject["inputs"] = newInputs;
+        emit profileChanged(profileObject);
     }
 
     return found;
@@ -193,6 +169,28 @@ QJsonObject ProfileManager::getProfile() const {
     return profileObject;
 }
 
+void ProfileManager::setProfile(const QJsonObject& profile) {
+    if (profile == profileObject)
+        return;
+    profileObject = profile;
+    emit profileChanged(profileObject);
+}
+
+void ProfileManager::reloadFromFile(const QString& path, const QJsonObject& profile) {
+    if (path != profileFilePath(profileObject["profileName"].toString()))
+        return;
+    // Файл после собственного сохранения: перечитывание вернуло бы правки, сделанные после него
+    if (profile == lastSavedProfile)
+        return;
+    qDebug() << "Профиль изменён на диске, загружен заново:" << path;
+    setProfile(profile);
+}
+
+QString ProfileManager::profileFilePath(const QString& profileName) {
+    QString baseDir = QCoreApplication::applicationDirPath();
+    return baseDir + QDir::separator() + "Control Profiles" + QDir::separator() + profileName + ".json";
+}
+
 // void ProfileManager::profileNameChange()
 // {
 //     return;
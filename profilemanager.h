@@ -25,15 +25,25 @@ public:
                   const QString& input,
                   const bool isSecondaryInput);
     void setInversion(const QString& inputName, const bool inversion);
+    // Замена профиля целиком
+    void setProfile(const QJsonObject& profile);
+    // Файл профиля изменён на диске. Вызывается в потоке ProfileManager; собственное
+    // сохранение и файл другого профиля не применяются
+    void reloadFromFile(const QString& path, const QJsonObject& profile);
     // Утилиты
     QStringList listAvailableProfiles();
     QJsonObject getProfile() const;
+    static QString profileFilePath(const QString& profileName);
 
 signals:
-    void profileNameChange();
+    void profileNameChange(const QJsonObject& profile);
+    // Изменились устройства или привязки текущего профиля. Профиль передаётся копией:
+    // слушатели в других потоках не обращаются к profileObject
+    void profileChanged(const QJsonObject& profile);
 
 private:
     QJsonObject profileObject;
+    QJsonObject lastSavedProfile;   // Последний отданный на запись снимок
 };
 
 
@@ -0,0 +1,166 @@
+#include "replay_camera_backend.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <thread>
+
+ReplayCameraBackend::ReplayCameraBackend(const QString& cameraName, const QString& path,
+                                         unsigned int rawWidth, unsigned int rawHeight, double rawFps, bool loop)
+    : m_cameraName(cameraName), m_path(path), m_loop(loop)
+{
+    QFileInfo info(path);
+    if (info.isDir()) {
+        m_rawFiles = QDir(path).entryList(QStringList() << "*.raw", QDir::Files, QDir::Name);
+        for (QString& file : m_rawFiles) {
+            file = QDir(path).filePath(file);
+        }
+        m_width = rawWidth & ~1u;
+        m_height = rawHeight & ~1u;
+        m_periodNs = static_cast<qint64>(1e9 / std::max(0.1, rawFps));
+        m_open = !m_rawFiles.isEmpty() && m_width > 0 && m_height > 0;
+        if (!m_open) {
+            qDebug() << "Воспроизведение для камеры" << m_cameraName << ": в каталоге" << path << "нет кадров *.raw или не задан размер кадра";
+        }
+    } else {
+        m_open = m_video.open(path.toStdString());
+        if (m_open) {
+            m_width = static_cast<unsigned int>(m_video.get(cv::CAP_PROP_FRAME_WIDTH)) & ~1u;
+            m_height = static_cast<unsigned int>(m_video.get(cv::CAP_PROP_FRAME_HEIGHT)) & ~1u;
+            const double fps = m_video.get(cv::CAP_PROP_FPS);
+            if (fps > 0) {
+                m_periodNs = static_cast<qint64>(1e9 / fps);
+            }
+        } else {
+            qDebug() << "Воспроизведение для камеры" << m_cameraName << ": не удалось открыть файл" << path;
+        }
+    }
+
+    if (m_open) {
+        m_buffer.resize(static_cast<size_t>(m_width) * m_height);
+        qDebug() << "Воспроизведение для камеры" << m_cameraName << "из" << path << ":" << m_width << "x" << m_height;
+    }
+}
+
+int ReplayCameraBackend::startGrabbing() {
+    if (!m_open) return MV_E_HANDLE;
+    m_grabbing = true;
+    m_frameNum = 0;
+    m_pendingTimeNs = -1;
+    m_lastTimeNs = 0;
+    m_startNs = monotonicNs();
+    return MV_OK;
+}
+
+bool ReplayCameraBackend::rewind() {
+    if (!m_rawFiles.isEmpty()) {
+        m_rawIndex = 0;
+        return true;
+    }
+    return m_video.set(cv::CAP_PROP_POS_FRAMES, 0);
+}
+
+bool ReplayCameraBackend::readVideoFrame(qint64& frameTimeNs) {
+    if (!m_video.read(m_bgr) || m_bgr.empty()) {
+        return false;
+    }
+    // Исходный темп записи: метка времени кадра в файле (после чтения указывает на следующий кадр)
+    double posMs = m_video.get(cv::CAP_PROP_POS_MSEC);
+    double fps = m_video.get(cv::CAP_PROP_FPS);
+    if (fps > 0) {
+        posMs -= 1000.0 / fps;
+    }
+    frameTimeNs = static_cast<qint64>(std::max(0.0, posMs) * 1e6);
+
+    if (static_cast<unsigned int>(m_bgr.cols) != m_width || static_cast<unsigned int>(m_bgr.rows) != m_height) {
+        cv::resize(m_bgr, m_bgr, cv::Size(static_cast<int>(m_width), static_cast<int>(m_height)));
+    }
+    mosaicBayerRG(m_bgr, m_buffer.data());
+    return true;
+}
+
+bool ReplayCameraBackend::readRawFrame(qint64& frameTimeNs) {
+    if (m_rawIndex >= m_rawFiles.size()) {
+        return false;
+    }
+    QFile file(m_rawFiles[m_rawIndex]);
+    frameTimeNs = static_cast<qint64>(m_rawIndex) * m_periodNs;
+    ++m_rawIndex;
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Воспроизведение для камеры" << m_cameraName << ": не удалось открыть" << file.fileName();
+        return false;
+    }
+    const qint64 expected = static_cast<qint64>(m_buffer.size());
+    if (file.read(reinterpret_cast<char*>(m_buffer.data()), expected) != expected) {
+        qDebug() << "Воспроизведение для камеры" << m_cameraName << ": размер кадра" << file.fileName() << "не совпадает с"
+                 << m_width << "x" << m_height;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayCameraBackend::readNextFrame(qint64& frameTimeNs) {
+    if (m_rawFiles.isEmpty() ? readVideoFrame(frameTimeNs) : readRawFrame(frameTimeNs)) {
+        return true;
+    }
+    if (!m_loop || !rewind()) {
+        return false;
+    }
+    // Следующий круг продолжает шкалу времени после последнего кадра
+    m_startNs += m_lastTimeNs + m_periodNs;
+    return m_rawFiles.isEmpty() ? readVideoFrame(frameTimeNs) : readRawFrame(frameTimeNs);
+}
+
+int ReplayCameraBackend::grabFrame(RawFrame& frame, unsigned int timeoutMs) {
+    if (!m_open || !m_grabbing) return MV_E_CALLORDER;
+
+    if (m_pendingTimeNs < 0) {
+        qint64 frameTimeNs = 0;
+        if (!readNextFrame(frameTimeNs)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return MV_E_NODATA;
+        }
+        m_pendingTimeNs = frameTimeNs;
+    }
+
+    const qint64 dueNs = m_startNs + m_pendingTimeNs;
+    const qint64 nowNs = monotonicNs();
+    const qint64 timeoutNs = static_cast<qint64>(timeoutMs) * 1000000;
+    if (dueNs - nowNs > timeoutNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(timeoutNs));
+        return MV_E_NODATA;
+    }
+    if (dueNs > nowNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - nowNs));
+    }
+
+    m_lastTimeNs = m_pendingTimeNs;
+    m_pendingTimeNs = -1;
+
+    frame.data = m_buffer.data();
+    frame.width = m_width;
+    frame.height = m_height;
+    frame.frameNum = m_frameNum++;
+    frame.pixelType = PixelType_Gvsp_BayerRG8;
+    frame.timestampNs = monotonicNs();
+    return MV_OK;
+}
+
+void ReplayCameraBackend::releaseFrame(RawFrame& frame) {
+    frame.data = nullptr;
+}
+
+int ReplayCameraBackend::stopGrabbing() {
+    m_grabbing = false;
+    return MV_OK;
+}
+
+int ReplayCameraBackend::close() {
+    m_grabbing = false;
+    m_open = false;
+    if (m_video.isOpened()) {
+        m_video.release();
+    }
+    return MV_OK;
+}
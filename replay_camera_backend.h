@@ -0,0 +1,56 @@
+#ifndef REPLAY_CAMERA_BACKEND_H
+#define REPLAY_CAMERA_BACKEND_H
+
+#include "camera_backend.h"
+#include <QStringList>
+#include <vector>
+
+// Воспроизведение записанного материала как камеры.
+// Источник - AVI-файл (темп по меткам времени кадров файла) либо каталог
+// сырых кадров *.raw (BayerRG8 без заголовка, как сохраняет клиент MVS) с заданными размером и частотой.
+class ReplayCameraBackend : public CameraBackend {
+public:
+    ReplayCameraBackend(const QString& cameraName, const QString& path,
+                        unsigned int rawWidth, unsigned int rawHeight, double rawFps, bool loop);
+
+    QString typeName() const override { return "replay"; }
+    int startGrabbing() override;
+    int grabFrame(RawFrame& frame, unsigned int timeoutMs) override;
+    void releaseFrame(RawFrame& frame) override;
+    int stopGrabbing() override;
+    int close() override;
+    bool isOpen() const override { return m_open; }
+
+private:
+    bool readNextFrame(qint64& frameTimeNs);
+    bool readVideoFrame(qint64& frameTimeNs);
+    bool readRawFrame(qint64& frameTimeNs);
+    bool rewind();
+
+    QString m_cameraName;
+    QString m_path;
+    bool m_loop;
+    bool m_open = false;
+    bool m_grabbing = false;
+
+    // AVI
+    cv::VideoCapture m_video;
+    cv::Mat m_bgr;
+
+    // Каталог *.raw
+    QStringList m_rawFiles;
+    int m_rawIndex = 0;
+
+    qint64 m_periodNs = 50000000; // Номинальный период кадров
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    std::vector<unsigned char> m_buffer;
+
+    unsigned int m_frameNum = 0;
+    qint64 m_startNs = 0;        // Монотонное время начала (текущего круга) воспроизведения
+    qint64 m_pendingTimeNs = -1; // Метка времени прочитанного, но ещё не выданного кадра
+    qint64 m_lastTimeNs = 0;     // Метка последнего выданного кадра, для сдвига при зацикливании
+};
+
+#endif // REPLAY_CAMERA_BACKEND_H
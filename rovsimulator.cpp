@@ -0,0 +1,221 @@
+#include "rovsimulator.h"
+#include "linkmonitor.h"
+#include <QDataStream>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+bool ControlPacket::parse(const QByteArray &data, ControlPacket &packet)
+{
+    if (data.size() != PACKET_SIZE)
+        return false;
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream >> packet.flags;
+    stream >> packet.forward >> packet.strafe >> packet.vertical;
+    stream >> packet.yaw >> packet.roll >> packet.pitch;
+    stream >> packet.powerLimit >> packet.cameraRotate;
+    stream >> packet.manipulatorGrip >> packet.manipulatorRotate;
+    for (float &gain : packet.pid)
+        stream >> gain;
+    return stream.status() == QDataStream::Ok;
+}
+
+RovSimulator::RovSimulator(quint16 port, int telemetryRateHz, QObject *parent)
+    : QObject(parent),
+    port(port),
+    telemetryRateHz(telemetryRateHz > 0 ? telemetryRateHz : 50)
+{
+}
+
+void RovSimulator::start()
+{
+    socket = new QUdpSocket(this);
+    if (!socket->bind(QHostAddress::LocalHost, port)) {
+        qWarning() << "[RovSimulator] Bind failed:" << socket->errorString();
+        return;
+    }
+    connect(socket, &QUdpSocket::readyRead, this, &RovSimulator::onReadyRead);
+
+    stepTimer = new QTimer(this);
+    stepTimer->setTimerType(Qt::PreciseTimer);
+    connect(stepTimer, &QTimer::timeout, this, &RovSimulator::step);
+    stepTimer->start(1000 / telemetryRateHz);
+
+    stepClock.start();
+    statsClock.start();
+    qDebug() << "[RovSimulator] Имитатор аппарата слушает 127.0.0.1:" << port
+             << ", телеметрия" << telemetryRateHz << "Гц";
+}
+
+void RovSimulator::onReadyRead()
+{
+    while (socket->hasPendingDatagrams()) {
+        QByteArray buffer;
+        buffer.resize(socket->pendingDatagramSize());
+        QHostAddress sender;
+        quint16 senderPort;
+        qint64 bytesRead = socket->readDatagram(buffer.data(), buffer.size(), &sender, &senderPort);
+        if (bytesRead <= 0)
+            continue;
+
+        if (LinkMonitor::isHeartbeat(buffer)) {
+            heartbeats++;
+            socket->writeDatagram(buffer, sender, senderPort);
+            continue;
+        }
+
+        // Пакет подключения (0xAA 0xFF) и управляющие пакеты задают адрес для телеметрии
+        clientAddress = sender;
+        clientPort = senderPort;
+
+        ControlPacket packet;
+        if (ControlPacket::parse(buffer, packet)) {
+            handleControl(packet);
+        }
+    }
+}
+
+void RovSimulator::handleControl(const ControlPacket &packet)
+{
+    if (controlClock.isValid()) {
+        maxControlGapNs = std::max(maxControlGapNs, controlClock.nsecsElapsed());
+    }
+    controlClock.restart();
+    controlPackets++;
+
+    bool posReset = packet.flags & (1 << 6);
+    bool resetIMU = packet.flags & (1 << 7);
+    // Включение стабилизации фиксирует текущее положение как задание
+    if (!(control.flags & (1 << 2)) || posReset) state.rollSP = state.roll;
+    if (!(control.flags & (1 << 3)) || posReset) state.pitchSP = state.pitch;
+    if (!(control.flags & (1 << 4)) || posReset) state.yawSP = state.yaw;
+    if (!(control.flags & (1 << 5)) || posReset) state.depthSP = state.depth;
+    if (resetIMU) {
+        state.yaw = 0;
+        state.yawSP = 0;
+    }
+    control = packet;
+}
+
+static float wrapAngle(float angle)
+{
+    angle = std::fmod(angle + 180.0f, 360.0f);
+    if (angle < 0)
+        angle += 360.0f;
+    return angle - 180.0f;
+}
+
+static float noise(float amplitude)
+{
+    return float(QRandomGenerator::global()->generateDouble() * 2.0 - 1.0) * amplitude;
+}
+
+void RovSimulator::step()
+{
+    float dt = float(stepClock.nsecsElapsed()) / 1e9f;
+    stepClock.restart();
+    dt = std::min(dt, 0.1f);
+
+    // Без управляющих пакетов дольше секунды аппарат останавливает движители
+    bool controlAlive = controlClock.isValid() && controlClock.elapsed() < 1000;
+    bool master = controlAlive && (control.flags & 1);
+    float gain = master ? std::clamp(control.powerLimit, 0.0f, 1.0f) : 0.0f;
+
+    bool rollStab = control.flags & (1 << 2);
+    bool pitchStab = control.flags & (1 << 3);
+    bool yawStab = control.flags & (1 << 4);
+    bool depthStab = control.flags & (1 << 5);
+
+    float forwardCmd = gain * control.forward;
+    float strafeCmd = gain * control.strafe;
+    float verticalCmd = gain * control.vertical;
+    float yawCmd = gain * control.yaw;
+    float rollCmd = gain * control.roll;
+    float pitchCmd = gain * control.pitch;
+
+    // Стабилизация: команда пилота смещает задание, регулятор удерживает его
+    if (master && rollStab) {
+        state.rollSP = std::clamp(state.rollSP + rollCmd * 30.0f * dt, -90.0f, 90.0f);
+        rollCmd = std::clamp(0.05f * (state.rollSP - state.roll) - 0.02f * state.rollRate, -1.0f, 1.0f);
+    }
+    if (master && pitchStab) {
+        state.pitchSP = std::clamp(state.pitchSP + pitchCmd * 30.0f * dt, -90.0f, 90.0f);
+        pitchCmd = std::clamp(0.05f * (state.pitchSP - state.pitch) - 0.02f * state.pitchRate, -1.0f, 1.0f);
+    }
+    if (master && yawStab) {
+        state.yawSP = wrapAngle(state.yawSP + yawCmd * 45.0f * dt);
+        yawCmd = std::clamp(0.03f * wrapAngle(state.yawSP - state.yaw) - 0.02f * state.yawRate, -1.0f, 1.0f);
+    }
+    if (master && depthStab) {
+        state.depthSP = std::max(0.0f, state.depthSP - verticalCmd * 0.5f * dt);
+        verticalCmd = std::clamp(1.5f * (state.depth - state.depthSP) - 0.8f * state.heave, -1.0f, 1.0f);
+    }
+
+    // Линейное движение: тяга против квадратичного сопротивления воды
+    const float thrustAccel = 1.5f;   // м/с^2 при полной тяге
+    const float linearDrag = 2.0f;
+    const float buoyancyAccel = 0.02f; // небольшая положительная плавучесть
+    state.surge += (thrustAccel * forwardCmd - linearDrag * state.surge * std::abs(state.surge)) * dt;
+    state.sway += (thrustAccel * strafeCmd - linearDrag * state.sway * std::abs(state.sway)) * dt;
+    state.heave += (thrustAccel * verticalCmd + buoyancyAccel - linearDrag * state.heave * std::abs(state.heave)) * dt;
+    state.depth = std::max(0.0f, state.depth - state.heave * dt);
+    if (state.depth == 0.0f && state.heave > 0)
+        state.heave = 0;
+
+    // Курс: без восстанавливающего момента
+    const float yawAccel = 90.0f;     // град/с^2
+    state.yawRate += (yawAccel * yawCmd - 0.05f * state.yawRate * std::abs(state.yawRate)) * dt;
+    state.yaw = wrapAngle(state.yaw + state.yawRate * dt);
+
+    // Крен и дифферент: метацентрическая остойчивость возвращает аппарат в горизонт
+    const float attitudeAccel = 60.0f;
+    state.rollRate += (attitudeAccel * rollCmd - 2.0f * state.roll - 1.5f * state.rollRate) * dt;
+    state.pitchRate += (attitudeAccel * pitchCmd - 2.0f * state.pitch - 1.5f * state.pitchRate) * dt;
+    state.roll = std::clamp(state.roll + state.rollRate * dt, -90.0f, 90.0f);
+    state.pitch = std::clamp(state.pitch + state.pitchRate * dt, -90.0f, 90.0f);
+
+    state.cameraAngle = std::clamp(state.cameraAngle + control.cameraRotate * 60.0f * dt, -90.0f, 90.0f);
+
+    float load = std::abs(forwardCmd) + std::abs(strafeCmd) + std::abs(verticalCmd) +
+                 std::abs(yawCmd) + std::abs(rollCmd) + std::abs(pitchCmd);
+    state.batCharge = std::max(0.0f, state.batCharge - (0.001f + 0.02f * load) * dt);
+    state.batVoltage = 13.2f + 3.6f * state.batCharge / 100.0f;
+
+    if (clientPort != 0) {
+        TelemetryPacket telemetry;
+        telemetry.flags = control.flags;
+        telemetry.roll = state.roll + noise(0.1f);
+        telemetry.pitch = state.pitch + noise(0.1f);
+        telemetry.yaw = wrapAngle(state.yaw + noise(0.2f));
+        telemetry.depth = std::max(0.0f, state.depth + noise(0.01f));
+        telemetry.batVoltage = state.batVoltage + noise(0.02f);
+        telemetry.batCharge = state.batCharge;
+        telemetry.cameraAngle = state.cameraAngle;
+        telemetry.rollSP = state.rollSP;
+        telemetry.pitchSP = state.pitchSP;
+        socket->writeDatagram(UdpTelemetryParser::pack(telemetry), clientAddress, clientPort);
+        telemetryPackets++;
+    }
+
+    if (statsClock.elapsed() >= 10000)
+        logStats();
+}
+
+void RovSimulator::logStats()
+{
+    double seconds = statsClock.elapsed() / 1000.0;
+    qInfo().nospace() << "[RovSimulator] управление " << controlPackets / seconds << " пак/с (макс. интервал "
+                      << maxControlGapNs / 1e6 << " мс), телеметрия " << telemetryPackets / seconds
+                      << " пак/с, heartbeat " << heartbeats / seconds << " пак/с, глубина "
+                      << state.depth << " м, курс " << state.yaw;
+    controlPackets = 0;
+    telemetryPackets = 0;
+    heartbeats = 0;
+    maxControlGapNs = 0;
+    statsClock.restart();
+}
@@ -0,0 +1,82 @@
+#ifndef ROVSIMULATOR_H
+#define ROVSIMULATOR_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "udptelemetryparser.h"
+
+// Управляющий пакет в том виде, как его формирует UdpHandler::packControlData()
+struct ControlPacket {
+    quint64 flags = 0;
+    float forward = 0;
+    float strafe = 0;
+    float vertical = 0;
+    float yaw = 0;
+    float roll = 0;
+    float pitch = 0;
+    float powerLimit = 0;
+    float cameraRotate = 0;
+    float manipulatorGrip = 0;
+    float manipulatorRotate = 0;
+    float pid[12] = {};   // Roll, Pitch, Yaw, Depth: kP, kI, kD
+
+    static const int PACKET_SIZE = 8 + 22 * 4;
+    static bool parse(const QByteArray &data, ControlPacket &packet);
+};
+
+// Имитатор аппарата на loopback для проверки канала связи, контура управления,
+// оверлея и логирования без ТНПА. Возвращает heartbeat-пакеты без изменений,
+// интегрирует команды тяги в простую 6-DoF модель и отправляет 44-байтную
+// телеметрию с заданной частотой на адрес последнего управляющего пакета.
+class RovSimulator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RovSimulator(quint16 port, int telemetryRateHz = 50, QObject *parent = nullptr);
+
+public slots:
+    void start();
+
+private slots:
+    void onReadyRead();
+    void step();
+
+private:
+    struct State {
+        float surge = 0, sway = 0, heave = 0;         // Линейные скорости, м/с
+        float rollRate = 0, pitchRate = 0, yawRate = 0; // Угловые скорости, град/с
+        float depth = 0;                              // м
+        float roll = 0, pitch = 0, yaw = 0;           // град
+        float cameraAngle = 0;                        // град
+        float batVoltage = 16.8f;
+        float batCharge = 100.0f;
+        float rollSP = 0, pitchSP = 0, yawSP = 0, depthSP = 0;
+    };
+
+    void handleControl(const ControlPacket &packet);
+    void logStats();
+
+    QUdpSocket *socket = nullptr;
+    QTimer *stepTimer = nullptr;
+    quint16 port;
+    int telemetryRateHz;
+
+    QHostAddress clientAddress;
+    quint16 clientPort = 0;
+
+    ControlPacket control;
+    State state;
+    QElapsedTimer stepClock;
+    QElapsedTimer statsClock;
+    QElapsedTimer controlClock;
+
+    quint64 controlPackets = 0;
+    quint64 telemetryPackets = 0;
+    quint64 heartbeats = 0;
+    qint64 maxControlGapNs = 0;
+};
+
+#endif // ROVSIMULATOR_H
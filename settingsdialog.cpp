@@ -44,6 +44,8 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     });
 
     connect(ui->pushButton_UpdatePID, &QPushButton::pressed, this, &SettingsDialog::onPushButtonUpdatePIDClicked);
+    connect(ui->comboBoxCamParams, &QComboBox::currentIndexChanged, this, &SettingsDialog::onCamParamsCameraChanged);
+    connect(ui->pushButtonApplyCamParams, &QPushButton::pressed, this, &SettingsDialog::onPushButtonApplyCamParamsClicked);
 }
 void saveLineEditSettings(const QString& key, QLineEdit* lineEdit) {
     SettingsManager::instance().setString(key, lineEdit->text());
@@ -84,6 +86,7 @@ void SettingsDialog::loadSettings()
     ui->doubleSpinBox_kP_Depth->setValue(SettingsManager::instance().getDouble("DepthkP"));
     ui->doubleSpinBox_kI_Depth->setValue(SettingsManager::instance().getDouble("DepthkI"));
     ui->doubleSpinBox_kD_Depth->setValue(SettingsManager::instance().getDouble("DepthkD"));
+    loadCameraParameters();
     emit settingsChanged();
    // qDebug() << ui->comboBoxCam->currentIndex();
 }
@@ -116,8 +119,11 @@ void SettingsDialog::SaveSetting()
     SettingsManager::instance().setDouble("DepthkI", ui->doubleSpinBox_kI_Depth->value());
     SettingsManager::instance().setDouble("DepthkD", ui->doubleSpinBox_kD_Depth->value());
 
+    saveCameraParameters();
+
     SettingsManager::instance().saveToFile("settings.json");
     emit settingsChanged();
+    emit cameraParametersChanged(ui->comboBoxCamParams->currentText());
 }
 void SettingsDialog::onButtonClicked(QAbstractButton *button) {
     // Определяем какая кнопка была нажата
@@ -157,3 +163,49 @@ void SettingsDialog::onPushButtonClicked()
 
 }
 
+// Множитель биннинга/прореживания <-> индекс в списке 1x1, 2x2, 4x4
+static int factorToIndex(int factor) {
+    return factor >= 4 ? 2 : (factor >= 2 ? 1 : 0);
+}
+
+void SettingsDialog::loadCameraParameters()
+{
+    const QString name = ui->comboBoxCamParams->currentText();
+    const CameraParameters params = CameraParameters::fromJson(SettingsManager::instance().getObject("Camera_params_" + name));
+    ui->doubleSpinBoxExposure->setValue(params.exposureUs);
+    ui->doubleSpinBoxGain->setValue(params.gainDb);
+    ui->doubleSpinBoxFrameRate->setValue(params.frameRate);
+    ui->spinBoxRoiX->setValue(params.roiX);
+    ui->spinBoxRoiY->setValue(params.roiY);
+    ui->spinBoxRoiWidth->setValue(params.roiWidth);
+    ui->spinBoxRoiHeight->setValue(params.roiHeight);
+    ui->comboBoxBinning->setCurrentIndex(factorToIndex(params.binning));
+    ui->comboBoxDecimation->setCurrentIndex(factorToIndex(params.decimation));
+}
+
+void SettingsDialog::saveCameraParameters()
+{
+    CameraParameters params;
+    params.exposureUs = ui->doubleSpinBoxExposure->value();
+    params.gainDb = ui->doubleSpinBoxGain->value();
+    params.frameRate = ui->doubleSpinBoxFrameRate->value();
+    params.roiX = ui->spinBoxRoiX->value();
+    params.roiY = ui->spinBoxRoiY->value();
+    params.roiWidth = ui->spinBoxRoiWidth->value();
+    params.roiHeight = ui->spinBoxRoiHeight->value();
+    params.binning = 1 << ui->comboBoxBinning->currentIndex();
+    params.decimation = 1 << ui->comboBoxDecimation->currentIndex();
+    SettingsManager::instance().setObject("Camera_params_" + ui->comboBoxCamParams->currentText(), params.toJson());
+}
+
+void SettingsDialog::onCamParamsCameraChanged()
+{
+    loadCameraParameters();
+}
+
+void SettingsDialog::onPushButtonApplyCamParamsClicked()
+{
+    saveCameraParameters();
+    SettingsManager::instance().saveToFile("settings.json");
+    emit cameraParametersChanged(ui->comboBoxCamParams->currentText());
+}
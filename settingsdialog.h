@@ -9,6 +9,7 @@
 #include "profilemanager.h"
 #include <QTabWidget>
 #include "SettingsManager.h"
+#include "camera_backend.h"
 
 
 namespace Ui {
@@ -29,12 +30,15 @@ signals:
     void settingsChanged();
     void settingsChangedPID();
     void settingsChangedAngle();
+    void cameraParametersChanged(const QString& cameraName);
 
 private slots:
     void onButtonClicked(QAbstractButton *button);
     void onPushButtonUpdatePIDClicked();
     void onPushButtonResetAngleClicked();
     void onPushButtonClicked();
+    void onCamParamsCameraChanged();
+    void onPushButtonApplyCamParamsClicked();
 
 private:
     Ui::SettingsDialog *ui;
@@ -42,6 +46,8 @@ private:
     void setupIpLineEdit();
     void loadSettings();  // Метод для загрузки настроек
     void setupUi(); // Объявление без параметров
+    void loadCameraParameters();
+    void saveCameraParameters();
 
 QVector<QLineEdit*> m_lineEdits;
 
@@ -0,0 +1,380 @@
+#include "stereo_auto_capture.h"
+#include "camera_backend.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Кадр камеры (BGR) -> уменьшенный кадр в оттенках серого для фазовой корреляции
+cv::Mat workFrame(const cv::Mat& bgr, int width) {
+    const cv::Size workSize(width, qRound(double(width) * bgr.rows / bgr.cols));
+    cv::Mat reduced, gray;
+    cv::resize(bgr, reduced, workSize, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(reduced, gray, cv::COLOR_BGR2GRAY);
+    return gray;
+}
+
+} // namespace
+
+StereoAutoSettings StereoAutoSettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    StereoAutoSettings s;
+    s.cameraName = settings.getString("Stereo_auto_camera", s.cameraName);
+    s.rateHz = qBound(1.0, settings.getDouble("Stereo_auto_rate_hz", s.rateHz), 30.0);
+    s.workWidth = qBound(128, settings.getInt("Stereo_auto_work_width", s.workWidth), 1024);
+    s.targetOverlap = qBound(0.1, settings.getDouble("Stereo_auto_target_overlap", s.targetOverlap), 0.95);
+    s.minOverlap = qBound(0.0, settings.getDouble("Stereo_auto_min_overlap", s.minOverlap), s.targetOverlap);
+    s.maxRateHz = qBound(0.05, settings.getDouble("Stereo_auto_max_rate_hz", s.maxRateHz), 10.0);
+    s.sharpnessWindow = qBound(1, settings.getInt("Stereo_auto_sharpness_window", s.sharpnessWindow), 100);
+    s.sharpnessRatio = qBound(0.0, settings.getDouble("Stereo_auto_sharpness_ratio", s.sharpnessRatio), 1.0);
+    s.minResponse = qBound(0.0, settings.getDouble("Stereo_auto_min_response", s.minResponse), 1.0);
+    return s;
+}
+
+StereoCaptureTrigger::StereoCaptureTrigger(const StereoAutoSettings& settings)
+    : m_settings(settings) {
+}
+
+void StereoCaptureTrigger::reset() {
+    m_previous.release();
+    m_previousNs = 0;
+    m_offset = cv::Point2d();
+    m_velocity = cv::Point2d();
+    m_tracking = false;
+    m_overlap = 1;
+    m_sharpness.clear();
+    m_lastShotNs = 0;
+    m_gapReported = false;
+}
+
+double StereoCaptureTrigger::bestSharpness() const {
+    return m_sharpness.empty() ? 0 : *std::max_element(m_sharpness.begin(), m_sharpness.end());
+}
+
+double StereoCaptureTrigger::overlapOf(const cv::Point2d& offset) {
+    return std::max(0.0, 1 - std::abs(offset.x)) * std::max(0.0, 1 - std::abs(offset.y));
+}
+
+bool StereoCaptureTrigger::update(const cv::Mat& gray, double sharpness, qint64 frameNs) {
+    cv::Mat frame;
+    gray.convertTo(frame, CV_32F);
+    if (m_window.size() != frame.size()) {
+        cv::createHanningWindow(m_window, frame.size(), CV_32F);
+        m_previous.release();
+    }
+
+    const double dt = m_previousNs > 0 ? (frameNs - m_previousNs) / 1e9 : 0;
+    if (!m_previous.empty() && dt > 0) {
+        double response = 0;
+        const cv::Point2d shift = cv::phaseCorrelate(m_previous, frame, m_window, &response);
+        if (response >= m_settings.minResponse) {
+            const cv::Point2d step(shift.x / frame.cols, shift.y / frame.rows);
+            m_velocity = step / dt;
+            m_offset += step;
+            m_tracking = true;
+        } else {
+            // Сдвиг не найден: движение продолжается с прежней скоростью, перекрытие всё равно убывает
+            m_offset += m_velocity * dt;
+            m_tracking = false;
+            ++m_lost;
+        }
+    }
+    m_previous = frame;
+    m_previousNs = frameNs;
+
+    if (sharpness > 0) {
+        m_sharpness.push_back(sharpness);
+        while (int(m_sharpness.size()) > m_settings.sharpnessWindow) m_sharpness.pop_front();
+    }
+    m_overlap = overlapOf(m_offset);
+
+    // Пара выбирается в серии позже запроса: перекрытие к этому моменту предсказывается по скорости
+    const cv::Point2d lead = m_velocity * m_leadSeconds;
+    const bool due = m_lastShotNs == 0 || overlapOf(m_offset + lead) <= m_settings.targetOverlap;
+    const bool sharp = sharpness <= 0 || sharpness >= m_settings.sharpnessRatio * bestSharpness();
+    const bool urgent = m_lastShotNs != 0 && m_overlap <= m_settings.minOverlap;
+    const bool rateAllowed = m_lastShotNs == 0 || frameNs - m_lastShotNs >= qint64(1e9 / m_settings.maxRateHz);
+
+    if (!m_pending && rateAllowed && ((due && sharp) || urgent)) {
+        m_pending = true;
+        m_pendingForced = !(due && sharp);
+        m_pendingNs = frameNs;
+        // Новая точка отсчёта - положение ожидаемой пары серии
+        m_pendingOrigin = m_offset + lead;
+        return true;
+    }
+    if (urgent && !rateAllowed && !m_gapReported) {
+        ++m_gaps;
+        m_gapReported = true;
+    }
+    return false;
+}
+
+void StereoCaptureTrigger::shotAccepted() {
+    if (!m_pending) return;
+    m_pending = false;
+    ++m_shots;
+    if (m_pendingForced) ++m_forcedShots;
+    m_lastShotNs = m_pendingNs;
+    // Сдвиг, накопленный за время ответа камеры, сохраняется
+    m_offset -= m_pendingOrigin;
+    m_overlap = overlapOf(m_offset);
+    m_gapReported = false;
+}
+
+void StereoCaptureTrigger::shotRejected() {
+    if (!m_pending) return;
+    m_pending = false;
+    ++m_rejectedShots;
+    // Пока камера занята, перекрытие продолжает убывать: ниже предела - разрыв покрытия
+    if (m_overlap <= m_settings.minOverlap && !m_gapReported) {
+        ++m_gaps;
+        m_gapReported = true;
+    }
+}
+
+StereoAutoCapture::StereoAutoCapture(QObject* parent)
+    : QObject(parent), m_stage(new LatestFrameStage(QThread::LowPriority, this)) {
+    qRegisterMetaType<StereoAutoState>("StereoAutoState");
+    // Пониженный приоритет: съёмка не должна отнимать время у захвата
+    connect(m_stage, &LatestFrameStage::tick, this, &StereoAutoCapture::tick);
+    m_settings = StereoAutoSettings::load();
+}
+
+StereoAutoCapture::~StereoAutoCapture() {
+    m_stage->stop();
+    m_stage->waitForDone();
+}
+
+void StereoAutoCapture::setEnabled(bool enabled) {
+    if (enabled == m_enabled) return;
+    m_enabled = enabled;
+
+    if (!enabled) {
+        m_stage->stop();
+        m_frame = QImage();
+        m_pendingRequestId = 0;
+        m_trigger.reset();
+        m_state.running = false;
+        emit stateUpdated(m_state);
+        qDebug() << "Автоматическая стереосъёмка выключена, снимков:" << m_state.shots;
+        return;
+    }
+
+    m_settings = StereoAutoSettings::load();
+    m_trigger = std::make_shared<StereoCaptureTrigger>(m_settings);
+    m_burstFrames = qBound(1, SettingsManager::instance().getInt("Camera_stereo_burst_frames", 5), 30);
+    m_frame = QImage();
+    m_pendingRequestId = 0;
+    m_framePeriodS = 0;
+    m_previousSubmitNs = 0;
+    m_state = StereoAutoState();
+    m_state.running = true;
+    emit cameraRequired(m_settings.cameraName);
+    m_stage->start(m_settings.rateHz);
+    emit stateUpdated(m_state);
+    qDebug() << "Автоматическая стереосъёмка включена: перекрытие" << m_settings.targetOverlap
+             << ", не чаще" << m_settings.maxRateHz << "снимков/с";
+}
+
+void StereoAutoCapture::submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs, const FrameQuality& quality) {
+    if (!m_stage->isActive() || cameraName != m_settings.cameraName) return;
+    if (m_previousSubmitNs > 0 && timestampNs > m_previousSubmitNs) {
+        const double period = (timestampNs - m_previousSubmitNs) / 1e9;
+        m_framePeriodS = m_framePeriodS > 0 ? 0.9 * m_framePeriodS + 0.1 * period : period;
+    }
+    m_previousSubmitNs = timestampNs;
+    m_frame = image;
+    m_frameNs = timestampNs;
+    m_sharpness = quality.valid ? quality.sharpness : 0;
+}
+
+void StereoAutoCapture::tick() {
+    if (m_frame.isNull()) return;
+
+    const std::shared_ptr<StereoCaptureTrigger> trigger = m_trigger;
+    // Выбранная пара в среднем в середине серии
+    const double leadSeconds = (m_burstFrames - 1) / 2.0 * m_framePeriodS;
+    const QImage image = m_frame;
+    const qint64 frameNs = m_frameNs;
+    const double sharpness = m_sharpness;
+    const int workWidth = m_settings.workWidth;
+    m_stage->process(frameNs, [trigger, image, frameNs, sharpness, workWidth, leadSeconds]() {
+        const qint64 startNs = CameraBackend::monotonicNs();
+        Output output;
+        output.sharpness = sharpness;
+        if (image.format() != QImage::Format_RGB888) {
+            output.error = "неподдерживаемый формат кадра";
+        } else {
+            try {
+                const cv::Mat source(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), image.bytesPerLine());
+                trigger->setLeadSeconds(leadSeconds);
+                output.capture = trigger->update(workFrame(source, workWidth), sharpness, frameNs);
+                snapshot(*trigger, output);
+            } catch (const cv::Exception& e) {
+                output.error = QString("ошибка OpenCV: %1").arg(e.what());
+            }
+        }
+        output.computeMs = (CameraBackend::monotonicNs() - startNs) / 1e6;
+        return output;
+    }, [this](const Output& output) {
+        if (!output.error.isEmpty()) {
+            QString errorMsg = QString("Автоматическая стереосъёмка выключена: %1").arg(output.error);
+            qDebug() << errorMsg;
+            setEnabled(false);
+            emit errorOccurred("StereoAutoCapture", errorMsg);
+            return;
+        }
+        m_state.sharpness = output.sharpness;
+        m_state.computeMs = output.computeMs;
+        applyOutput(output);
+        if (output.capture) {
+            m_pendingRequestId = ++m_lastRequestId;
+            emit captureRequested(m_pendingRequestId);
+        }
+    });
+}
+
+void StereoAutoCapture::captureHandled(quint64 requestId, bool accepted) {
+    if (requestId == 0 || requestId != m_pendingRequestId) return;
+    m_pendingRequestId = 0;
+    // Триггер меняется только в пуле стадии: ответ применяется после текущей обработки
+    const std::shared_ptr<StereoCaptureTrigger> trigger = m_trigger;
+    m_stage->post([trigger, accepted]() {
+        Output output;
+        if (accepted) trigger->shotAccepted();
+        else trigger->shotRejected();
+        snapshot(*trigger, output);
+        return output;
+    }, [this, trigger](const Output& output) {
+        if (trigger != m_trigger) return;
+        applyOutput(output);
+    });
+}
+
+void StereoAutoCapture::snapshot(const StereoCaptureTrigger& trigger, Output& output) {
+    output.tracking = trigger.tracking();
+    output.overlap = trigger.overlap();
+    output.bestSharpness = trigger.bestSharpness();
+    output.shots = trigger.shots();
+    output.forcedShots = trigger.forcedShots();
+    output.rejectedShots = trigger.rejectedShots();
+    output.gaps = trigger.gaps();
+}
+
+void StereoAutoCapture::applyOutput(const Output& output) {
+    m_state.tracking = output.tracking;
+    m_state.overlap = output.overlap;
+    m_state.bestSharpness = output.bestSharpness;
+    m_state.shots = output.shots;
+    m_state.forcedShots = output.forcedShots;
+    m_state.rejectedShots = output.rejectedShots;
+    m_state.skipped = m_stage->skipped();
+    if (output.gaps > m_state.gaps) {
+        qDebug() << "Автоматическая стереосъёмка: перекрытие ниже" << m_settings.minOverlap
+                 << ", снимать чаще не дают предел частоты или идущая серия";
+    }
+    m_state.gaps = output.gaps;
+    emit stateUpdated(m_state);
+}
+
+int StereoAutoCapture::replayCheck(QTextStream& out) {
+    const StereoAutoSettings settings;
+    const cv::Size frameSize(640, 480);
+    const int SLOW_SAMPLES = 400;
+    const int FAST_SAMPLES = 200;
+    const double SLOW_SPEED = 0.02;     // Доли ширины кадра за оценку: 0.2 кадра/с при 10 Гц
+    const double FAST_SPEED = 0.06;     // Быстрее, чем позволяет предел частоты снимков
+    const double BLUR_PROBABILITY = 0.3;
+
+    // Дно - шум нескольких масштабов, на весь маршрут
+    const cv::Size textureSize(frameSize.width * (2 + int(SLOW_SAMPLES * SLOW_SPEED + FAST_SAMPLES * FAST_SPEED)), 1400);
+    cv::RNG rng(3);
+    cv::Mat texture(textureSize, CV_32F, cv::Scalar(0));
+    for (int scale : {3, 12, 48}) {
+        cv::Mat noise(textureSize.height / scale + 2, textureSize.width / scale + 2, CV_32F);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 1);
+        cv::Mat resized;
+        cv::resize(noise, resized, cv::Size(), scale, scale, cv::INTER_CUBIC);
+        texture += resized(cv::Rect(cv::Point(0, 0), textureSize));
+    }
+    cv::normalize(texture, texture, 20, 220, cv::NORM_MINMAX);
+
+    struct Shot { int sample; double x; double y; bool blurred; };
+    std::vector<Shot> shots;
+    StereoCaptureTrigger trigger(settings);
+    FrameQualityMeter meter{FrameQualitySettings()};
+    double x = 100;
+    const double y0 = 300;
+    double computeMs = 0;
+    for (int k = 0; k < SLOW_SAMPLES + FAST_SAMPLES; ++k) {
+        x += (k < SLOW_SAMPLES ? SLOW_SPEED : FAST_SPEED) * frameSize.width;
+        const double y = y0 + 60 * std::sin(k / 25.0);
+        const bool blurred = rng.uniform(0.0, 1.0) < BLUR_PROBABILITY;
+
+        cv::Mat frame;
+        const cv::Matx23d shift(1, 0, -x, 0, 1, -y);
+        cv::warpAffine(texture, frame, shift, frameSize, cv::INTER_LINEAR);
+        if (blurred) cv::GaussianBlur(frame, frame, cv::Size(0, 0), 3);
+        frame.convertTo(frame, CV_8U);
+        // Резкость - тем же замером, что и в захвате: одинаковые каналы как кадр Байера
+        const FrameQuality quality = meter.measure(frame.data, frame.cols, frame.rows);
+        cv::Mat bgr;
+        cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
+
+        const qint64 startNs = CameraBackend::monotonicNs();
+        const qint64 frameNs = qint64((k + 1) * 1e9 / settings.rateHz);
+        // Камера принимает каждый запрос сразу
+        if (trigger.update(workFrame(bgr, settings.workWidth), quality.sharpness, frameNs)) {
+            trigger.shotAccepted();
+            shots.push_back({k, x, y, blurred});
+        }
+        computeMs += (CameraBackend::monotonicNs() - startNs) / 1e6;
+    }
+
+    int exitCode = 0;
+    auto check = [&](const QString& name, bool ok) {
+        out << QString("%1: %2\n").arg(name, -48).arg(ok ? "OK" : "ОШИБКА");
+        if (!ok) exitCode = 1;
+    };
+
+    // Перекрытие соседних снимков по известному маршруту, только на медленном участке
+    double minOverlap = 1;
+    double sumOverlap = 0;
+    int pairs = 0;
+    double minIntervalS = 1e9;
+    int blurredShots = 0;
+    for (size_t i = 0; i < shots.size(); ++i) {
+        if (shots[i].blurred) ++blurredShots;
+        if (i == 0) continue;
+        minIntervalS = std::min(minIntervalS, (shots[i].sample - shots[i - 1].sample) / settings.rateHz);
+        if (shots[i].sample >= SLOW_SAMPLES) continue;
+        const double overlap = std::max(0.0, 1 - std::abs(shots[i].x - shots[i - 1].x) / frameSize.width) *
+                               std::max(0.0, 1 - std::abs(shots[i].y - shots[i - 1].y) / frameSize.height);
+        minOverlap = std::min(minOverlap, overlap);
+        sumOverlap += overlap;
+        ++pairs;
+    }
+    const double meanOverlap = pairs ? sumOverlap / pairs : 0;
+    out << QString("Оценок: %1 (%2 Гц), снимков %3, из них без резкого кадра %4, смазанных %5\n")
+               .arg(SLOW_SAMPLES + FAST_SAMPLES).arg(settings.rateHz).arg(shots.size())
+               .arg(trigger.forcedShots()).arg(blurredShots);
+    out << QString("Перекрытие на медленном участке: среднее %1, наименьшее %2 (цель %3, предел %4)\n")
+               .arg(meanOverlap, 0, 'f', 3).arg(minOverlap, 0, 'f', 3)
+               .arg(settings.targetOverlap).arg(settings.minOverlap);
+    out << QString("Наименьший интервал между снимками %1 с, разрывов покрытия %2, потерь привязки %3, "
+                   "оценка %4 мс на кадр\n")
+               .arg(minIntervalS, 0, 'f', 2).arg(trigger.gaps()).arg(trigger.lost())
+               .arg(computeMs / (SLOW_SAMPLES + FAST_SAMPLES), 0, 'f', 2);
+
+    check("Перекрытие не ниже предела", pairs > 0 && minOverlap >= settings.minOverlap);
+    check("Среднее перекрытие близко к цели", std::abs(meanOverlap - settings.targetOverlap) <= 0.07);
+    check("Смазанные кадры - только вынужденные снимки", quint64(blurredShots) <= trigger.forcedShots());
+    check("Частота снимков не выше предела", minIntervalS >= 1 / settings.maxRateHz - 1e-6);
+    check("Разрыв покрытия на быстром участке замечен", trigger.gaps() > 0);
+    check("Привязка не теряется", trigger.lost() == 0);
+    out.flush();
+    return exitCode;
+}
@@ -0,0 +1,172 @@
+#ifndef STEREO_AUTO_CAPTURE_H
+#define STEREO_AUTO_CAPTURE_H
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <QTextStream>
+#include <deque>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include "frame_quality.h"
+#include "latest_frame_stage.h"
+
+// Параметры автоматической стереосъёмки (ключи Stereo_auto_* в настройках)
+struct StereoAutoSettings {
+    QString cameraName = "LCamera"; // По этой камере оценивается движение
+    double rateHz = 10;             // Частота оценки сдвига кадра
+    int workWidth = 256;            // Ширина кадра для фазовой корреляции
+    double targetOverlap = 0.7;     // Перекрытие соседних снимков по площади
+    double minOverlap = 0.5;        // Ниже - снимок без ожидания резкого кадра
+    double maxRateHz = 1;           // Не больше снимков в секунду
+    int sharpnessWindow = 10;       // Оценок резкости в окне
+    double sharpnessRatio = 0.7;    // Кадр годится, если не хуже этой доли лучшей резкости окна
+    double minResponse = 0.05;      // Отклик фазовой корреляции, ниже - сдвиг не найден
+
+    static StereoAutoSettings load();
+};
+
+// Решение, когда снимать: сдвиг между соседними уменьшенными кадрами ищется фазовой
+// корреляцией и копится с момента последнего снимка в долях кадра. Снимок нужен, когда
+// перекрытие с последним снимком к моменту выбора пары в серии дойдёт до targetOverlap,
+// и берётся на кадре, резкость которого близка к лучшей в окне последних кадров.
+// Если резкого кадра нет, а перекрытие упало до minOverlap, снимок делается сразу.
+// Частота снимков ограничена maxRateHz. Если сдвиг не найден (муть, однородное дно),
+// движение продолжается с прежней скоростью. Приближение к дну (масштаб) и поворот кадра
+// не учитываются: при съёмке вдоль разреза основное движение - сдвиг.
+class StereoCaptureTrigger {
+public:
+    explicit StereoCaptureTrigger(const StereoAutoSettings& settings);
+
+    void reset();
+    // Кадр в оттенках серого, его резкость (0 - неизвестна) и время. true - пора снимать;
+    // пока на запрос нет ответа камеры, новых запросов нет
+    bool update(const cv::Mat& gray, double sharpness, qint64 frameNs);
+    // Камера записала пару: снимок засчитывается, перекрытие отсчитывается от его пары
+    void shotAccepted();
+    // Снимок не сохранён (уже идёт серия, ошибка записи): снимка нет, запрос повторится
+    void shotRejected();
+    // Время от запроса снимка до выбранной пары серии: на него перекрытие предсказывается вперёд
+    void setLeadSeconds(double seconds) { m_leadSeconds = seconds; }
+
+    double overlap() const { return m_overlap; }
+    bool tracking() const { return m_tracking; }
+    double bestSharpness() const;
+    quint64 shots() const { return m_shots; }
+    quint64 forcedShots() const { return m_forcedShots; }
+    quint64 rejectedShots() const { return m_rejectedShots; }
+    quint64 gaps() const { return m_gaps; }
+    quint64 lost() const { return m_lost; }
+
+private:
+    static double overlapOf(const cv::Point2d& offset);
+
+    StereoAutoSettings m_settings;
+    double m_leadSeconds = 0;
+    cv::Mat m_previous;
+    cv::Mat m_window;               // Окно Ханна для фазовой корреляции
+    qint64 m_previousNs = 0;
+    cv::Point2d m_offset;           // Сдвиг от последнего снимка, доли кадра
+    cv::Point2d m_velocity;         // Доли кадра в секунду
+    bool m_tracking = false;
+    double m_overlap = 1;
+    std::deque<double> m_sharpness;
+    qint64 m_lastShotNs = 0;
+    bool m_gapReported = false;
+    bool m_pending = false;         // Запрос отправлен, ответа камеры ещё нет
+    bool m_pendingForced = false;
+    qint64 m_pendingNs = 0;
+    cv::Point2d m_pendingOrigin;    // Ожидаемое положение пары запроса, доли кадра
+    quint64 m_shots = 0;
+    quint64 m_forcedShots = 0;
+    quint64 m_rejectedShots = 0;
+    quint64 m_gaps = 0;             // Перекрытие упало ниже minOverlap, а снимать было рано
+    quint64 m_lost = 0;
+};
+
+// Состояние автоматической съёмки для HUD
+struct StereoAutoState {
+    bool running = false;
+    bool tracking = false;
+    double overlap = 1;
+    double sharpness = 0;
+    double bestSharpness = 0;
+    double computeMs = 0;
+    quint64 shots = 0;
+    quint64 forcedShots = 0;    // Снимков без резкого кадра, чтобы не потерять перекрытие
+    quint64 rejectedShots = 0;  // Запросов без сохранённого снимка: шла предыдущая серия, ошибка записи
+    quint64 gaps = 0;           // Перекрытие не удержано из-за предела частоты
+    quint64 skipped = 0;        // Кадров пропущено, пока шла обработка предыдущего
+};
+Q_DECLARE_METATYPE(StereoAutoState)
+
+// Автоматическая стереосъёмка при движении вдоль разреза.
+// Последний кадр камеры движения уменьшается и передаётся StereoCaptureTrigger в
+// LatestFrameStage вместе с резкостью этого кадра от FrameQualityMeter.
+// Запрос снимка идёт в Camera::stereoShotRequestSlot, а серия там выбирает самую резкую пару;
+// время серии учитывается как упреждение по перекрытию. Снимок засчитывается только после
+// ответа камеры, что выбранная пара записана.
+class StereoAutoCapture : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StereoAutoCapture(QObject* parent = nullptr);
+    ~StereoAutoCapture() override;
+
+    bool isEnabled() const { return m_enabled; }
+    // Вызывается из потока интерфейса
+    void submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs, const FrameQuality& quality);
+
+    // Синтетический разрез над текстурой дна с известным маршрутом, смазанными кадрами и
+    // участком быстрее предела частоты. Сверяет перекрытие снимков, их резкость и частоту.
+    static int replayCheck(QTextStream& out);
+
+public slots:
+    void setEnabled(bool enabled);
+    // Ответ камеры на captureRequested: accepted - пара записана
+    void captureHandled(quint64 requestId, bool accepted);
+
+signals:
+    void cameraRequired(const QString& cameraName);
+    void captureRequested(quint64 requestId);
+    void stateUpdated(const StereoAutoState& state);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    // Результат обработки в пуле; счётчики триггера снимаются там же, где он меняется
+    struct Output {
+        bool capture = false;
+        bool tracking = false;
+        double overlap = 1;
+        double sharpness = 0;
+        double bestSharpness = 0;
+        double computeMs = 0;
+        quint64 shots = 0;
+        quint64 forcedShots = 0;
+        quint64 rejectedShots = 0;
+        quint64 gaps = 0;
+        QString error;
+    };
+
+    void tick();
+    static void snapshot(const StereoCaptureTrigger& trigger, Output& output);
+    void applyOutput(const Output& output);
+
+    StereoAutoSettings m_settings;
+    std::shared_ptr<StereoCaptureTrigger> m_trigger;  // Используется только одной обработкой за раз
+    LatestFrameStage* m_stage;
+    bool m_enabled = false;
+    int m_burstFrames = 1;
+    quint64 m_lastRequestId = 0;
+    quint64 m_pendingRequestId = 0;     // 0 - ответа камеры не ждём
+
+    QImage m_frame;
+    qint64 m_frameNs = 0;
+    double m_sharpness = 0;
+    double m_framePeriodS = 0;      // Сглаженный период кадров камеры
+    qint64 m_previousSubmitNs = 0;
+
+    StereoAutoState m_state;
+};
+
+#endif // STEREO_AUTO_CAPTURE_H
@@ -0,0 +1,213 @@
+#include "stereo_calibration.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace {
+
+// Заголовок кэша карт выпрямления; данные карт идут следом как есть
+struct RectificationCacheHeader {
+    char magic[8];
+    qint32 version;
+    qint32 width;
+    qint32 height;
+    char key[16];        // MD5 файла калибровки
+    double Q[16];
+};
+
+const char CACHE_MAGIC[8] = {'C', 'H', 'S', 'R', 'E', 'C', 'T', '1'};
+const qint32 CACHE_VERSION = 1;
+
+bool writeMat(QSaveFile& file, const cv::Mat& mat) {
+    const qint32 info[3] = {mat.type(), mat.rows, mat.cols};
+    if (file.write(reinterpret_cast<const char*>(info), sizeof(info)) != sizeof(info)) return false;
+    const qint64 rowBytes = qint64(mat.cols * mat.elemSize());
+    for (int y = 0; y < mat.rows; ++y) {
+        if (file.write(reinterpret_cast<const char*>(mat.ptr(y)), rowBytes) != rowBytes) return false;
+    }
+    return true;
+}
+
+bool readMat(QFile& file, cv::Mat& mat, const cv::Size& expectedSize) {
+    qint32 info[3];
+    if (file.read(reinterpret_cast<char*>(info), sizeof(info)) != sizeof(info)) return false;
+    if (info[1] != expectedSize.height || info[2] != expectedSize.width) return false;
+    if (info[0] != CV_16SC2 && info[0] != CV_16UC1) return false;
+    mat.create(info[1], info[2], info[0]);
+    const qint64 bytes = qint64(mat.total() * mat.elemSize());
+    return file.read(reinterpret_cast<char*>(mat.data), bytes) == bytes;
+}
+
+} // namespace
+
+bool StereoCalibration::isValid() const {
+    return K1.rows == 3 && K1.cols == 3 && K2.rows == 3 && K2.cols == 3 &&
+           R.total() == 9 && T.total() == 3 && imageSize.width > 0 && imageSize.height > 0;
+}
+
+StereoCalibration StereoCalibration::scaled(const cv::Size& size) const {
+    StereoCalibration result = *this;
+    const double sx = double(size.width) / imageSize.width;
+    const double sy = double(size.height) / imageSize.height;
+    for (cv::Mat* K : {&result.K1, &result.K2}) {
+        cv::Mat k;
+        K->convertTo(k, CV_64F);
+        *K = k;
+        K->at<double>(0, 0) *= sx;
+        K->at<double>(1, 1) *= sy;
+        // Центр пикселя: (c + 0.5) * s - 0.5
+        K->at<double>(0, 2) = (K->at<double>(0, 2) + 0.5) * sx - 0.5;
+        K->at<double>(1, 2) = (K->at<double>(1, 2) + 0.5) * sy - 0.5;
+    }
+    result.imageSize = size;
+    return result;
+}
+
+bool StereoCalibration::load(const QString& path, QString& error) {
+    try {
+        cv::FileStorage fs(path.toStdString(), cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            error = QString("Не удалось открыть файл калибровки %1").arg(path);
+            return false;
+        }
+        fs["K1"] >> K1;
+        fs["D1"] >> D1;
+        fs["K2"] >> K2;
+        fs["D2"] >> D2;
+        fs["R"] >> R;
+        fs["T"] >> T;
+        int width = 0;
+        int height = 0;
+        fs["image_width"] >> width;
+        fs["image_height"] >> height;
+        imageSize = cv::Size(width, height);
+        fs["pairs"] >> quality.pairs;
+        fs["left_rms"] >> quality.leftRms;
+        fs["right_rms"] >> quality.rightRms;
+        fs["stereo_rms"] >> quality.stereoRms;
+        fs["epipolar_error"] >> quality.epipolarError;
+        fs["baseline_mm"] >> quality.baselineMm;
+    } catch (const cv::Exception& e) {
+        error = QString("Ошибка чтения файла калибровки %1: %2").arg(path).arg(e.what());
+        return false;
+    }
+    if (!isValid()) {
+        error = QString("Файл калибровки %1 неполный").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool StereoCalibration::save(const QString& path, QString& error) const {
+    // Каталог stereo/ по умолчанию при первой калибровке ещё не существует
+    const QString directory = QFileInfo(path).absolutePath();
+    if (!QDir().mkpath(directory)) {
+        error = QString("Не удалось создать каталог %1 для файла калибровки").arg(directory);
+        return false;
+    }
+    try {
+        cv::FileStorage fs(path.toStdString(), cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            error = QString("Не удалось создать файл калибровки %1").arg(path);
+            return false;
+        }
+        fs << "image_width" << imageSize.width;
+        fs << "image_height" << imageSize.height;
+        fs << "K1" << K1 << "D1" << D1;
+        fs << "K2" << K2 << "D2" << D2;
+        fs << "R" << R << "T" << T;
+        fs << "pairs" << quality.pairs;
+        fs << "left_rms" << quality.leftRms;
+        fs << "right_rms" << quality.rightRms;
+        fs << "stereo_rms" << quality.stereoRms;
+        fs << "epipolar_error" << quality.epipolarError;
+        fs << "baseline_mm" << quality.baselineMm;
+    } catch (const cv::Exception& e) {
+        error = QString("Ошибка записи файла калибровки %1: %2").arg(path).arg(e.what());
+        return false;
+    }
+    return true;
+}
+
+bool StereoRectification::compute(const StereoCalibration& calibration) {
+    if (!calibration.isValid()) return false;
+
+    cv::Mat R1, R2, P1, P2;
+    // alpha = 0: в выпрямленном кадре только пиксели, видимые обеими камерами
+    cv::stereoRectify(calibration.K1, calibration.D1, calibration.K2, calibration.D2, calibration.imageSize,
+                      calibration.R, calibration.T, R1, R2, P1, P2, Q, cv::CALIB_ZERO_DISPARITY, 0);
+    // CV_16SC2 - самый быстрый формат карт для remap
+    cv::initUndistortRectifyMap(calibration.K1, calibration.D1, R1, P1, calibration.imageSize, CV_16SC2, leftMap1, leftMap2);
+    cv::initUndistortRectifyMap(calibration.K2, calibration.D2, R2, P2, calibration.imageSize, CV_16SC2, rightMap1, rightMap2);
+    imageSize = calibration.imageSize;
+    return true;
+}
+
+QByteArray StereoRectification::calibrationKey(const QString& calibrationPath) {
+    QFile file(calibrationPath);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+}
+
+bool StereoRectification::loadOrCompute(const QString& calibrationPath, const StereoCalibration& calibration) {
+    const QByteArray key = calibrationKey(calibrationPath);
+    const QString cache = cachePath(calibrationPath);
+    if (!key.isEmpty() && loadCache(cache, key) && imageSize == calibration.imageSize) {
+        qDebug() << "Карты выпрямления загружены из кэша" << cache;
+        return true;
+    }
+    if (!compute(calibration)) return false;
+    if (!key.isEmpty() && !saveCache(cache, key)) {
+        qDebug() << "Не удалось сохранить кэш карт выпрямления" << cache;
+    }
+    return true;
+}
+
+bool StereoRectification::saveCache(const QString& path, const QByteArray& key) const {
+    if (!isValid() || key.size() != 16) return false;
+
+    RectificationCacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.width = imageSize.width;
+    header.height = imageSize.height;
+    memcpy(header.key, key.constData(), sizeof(header.key));
+    cv::Mat q;
+    Q.convertTo(q, CV_64F);
+    for (int i = 0; i < 16; ++i) header.Q[i] = q.at<double>(i / 4, i % 4);
+
+    // Запись через временный файл: оборванный кэш не подменит рабочий
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) return false;
+    if (!writeMat(file, leftMap1) || !writeMat(file, leftMap2) ||
+        !writeMat(file, rightMap1) || !writeMat(file, rightMap2)) return false;
+    return file.commit();
+}
+
+bool StereoRectification::loadCache(const QString& path, const QByteArray& key) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    RectificationCacheHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)) return false;
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION) return false;
+    if (key.size() != 16 || memcmp(header.key, key.constData(), sizeof(header.key)) != 0) return false;
+
+    const cv::Size size(header.width, header.height);
+    StereoRectification loaded;
+    if (!readMat(file, loaded.leftMap1, size) || !readMat(file, loaded.leftMap2, size) ||
+        !readMat(file, loaded.rightMap1, size) || !readMat(file, loaded.rightMap2, size)) return false;
+    loaded.Q = cv::Mat(4, 4, CV_64F, header.Q).clone();
+    loaded.imageSize = size;
+    *this = loaded;
+    return true;
+}
+
+void StereoRectification::rectify(const cv::Mat& left, const cv::Mat& right, cv::Mat& leftOut, cv::Mat& rightOut) const {
+    cv::remap(left, leftOut, leftMap1, leftMap2, cv::INTER_LINEAR);
+    cv::remap(right, rightOut, rightMap1, rightMap2, cv::INTER_LINEAR);
+}
@@ -0,0 +1,55 @@
+#ifndef STEREO_CALIBRATION_H
+#define STEREO_CALIBRATION_H
+
+#include <QByteArray>
+#include <QString>
+#include <opencv2/opencv.hpp>
+
+// Показатели качества калибровки, сохраняются вместе с ней
+struct StereoCalibrationQuality {
+    int pairs = 0;              // Пар, вошедших в калибровку
+    double leftRms = 0;         // Ошибка репроекции, пикс.
+    double rightRms = 0;
+    double stereoRms = 0;
+    double epipolarError = 0;   // Среднее расстояние точки до эпиполярной линии, пикс.
+    double baselineMm = 0;
+};
+
+// Калибровка стереопары: внутренние параметры камер и положение правой относительно левой.
+// Хранится в YAML (cv::FileStorage), T - в миллиметрах.
+struct StereoCalibration {
+    cv::Mat K1, D1;   // Левая камера
+    cv::Mat K2, D2;   // Правая камера
+    cv::Mat R, T;     // Поворот и смещение правой камеры
+    cv::Size imageSize;
+    StereoCalibrationQuality quality;
+
+    bool isValid() const;
+    // Та же калибровка для кадра, уменьшенного до size (внутренние параметры масштабируются)
+    StereoCalibration scaled(const cv::Size& size) const;
+    bool load(const QString& path, QString& error);
+    bool save(const QString& path, QString& error) const;
+};
+
+// Карты выпрямления для одного размера кадра. Считаются один раз и дальше только читаются,
+// поэтому могут использоваться из нескольких потоков; выпрямление кадра - один remap.
+// Расчёт карт для 5 Мп занимает заметное время, поэтому они хранятся в двоичном кэше
+// <файл калибровки>.maps, привязанном к содержимому файла калибровки.
+struct StereoRectification {
+    cv::Mat leftMap1, leftMap2;
+    cv::Mat rightMap1, rightMap2;
+    cv::Mat Q;        // Перевод (x, y, диспаратность) в 3D, единицы T
+    cv::Size imageSize;
+
+    bool isValid() const { return !leftMap1.empty(); }
+    bool compute(const StereoCalibration& calibration);
+    // Карты из кэша, если он соответствует файлу калибровки, иначе расчёт и запись кэша
+    bool loadOrCompute(const QString& calibrationPath, const StereoCalibration& calibration);
+    bool saveCache(const QString& path, const QByteArray& key) const;
+    bool loadCache(const QString& path, const QByteArray& key);
+    static QString cachePath(const QString& calibrationPath) { return calibrationPath + ".maps"; }
+    static QByteArray calibrationKey(const QString& calibrationPath);
+    void rectify(const cv::Mat& left, const cv::Mat& right, cv::Mat& leftOut, cv::Mat& rightOut) const;
+};
+
+#endif // STEREO_CALIBRATION_H
@@ -0,0 +1,305 @@
+#include "stereo_calibrator.h"
+#include "stereo_processor.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+const int MIN_PAIRS = 5;
+
+} // namespace
+
+CalibrationBoard CalibrationBoard::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    CalibrationBoard board;
+    board.innerCorners.width = qBound(3, settings.getInt("Stereo_board_columns", board.innerCorners.width), 50);
+    board.innerCorners.height = qBound(3, settings.getInt("Stereo_board_rows", board.innerCorners.height), 50);
+    board.squareMm = qMax(1.0, settings.getDouble("Stereo_board_square_mm", board.squareMm));
+    return board;
+}
+
+StereoCalibrator::StereoCalibrator(const CalibrationBoard& board)
+    : m_board(board) {}
+
+std::vector<cv::Point3f> StereoCalibrator::boardPoints() const {
+    std::vector<cv::Point3f> points;
+    for (int y = 0; y < m_board.innerCorners.height; ++y) {
+        for (int x = 0; x < m_board.innerCorners.width; ++x) {
+            points.emplace_back(float(x * m_board.squareMm), float(y * m_board.squareMm), 0.0f);
+        }
+    }
+    return points;
+}
+
+bool StereoCalibrator::findCorners(const cv::Mat& image, std::vector<cv::Point2f>& corners) const {
+    cv::Mat gray;
+    if (image.channels() == 3) {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = image;
+    }
+    // Детектор на основе секторов (SB) сразу даёт субпиксельные углы и устойчивее к размытию под водой
+    return cv::findChessboardCornersSB(gray, m_board.innerCorners, corners,
+                                       cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_EXHAUSTIVE);
+}
+
+bool StereoCalibrator::addPair(const cv::Mat& left, const cv::Mat& right, QString& error) {
+    if (left.size() != right.size()) {
+        error = "Размеры левого и правого кадров различаются";
+        return false;
+    }
+    if (!m_leftPoints.empty() && left.size() != m_imageSize) {
+        error = "Размер кадра отличается от предыдущих пар";
+        return false;
+    }
+    std::vector<cv::Point2f> leftCorners, rightCorners;
+    if (!findCorners(left, leftCorners)) {
+        error = "Доска не найдена на левом кадре";
+        return false;
+    }
+    if (!findCorners(right, rightCorners)) {
+        error = "Доска не найдена на правом кадре";
+        return false;
+    }
+    m_imageSize = left.size();
+    m_leftPoints.push_back(leftCorners);
+    m_rightPoints.push_back(rightCorners);
+    return true;
+}
+
+bool StereoCalibrator::calibrate(StereoCalibration& calibration, QString& error) const {
+    if (pairCount() < MIN_PAIRS) {
+        error = QString("Для калибровки нужно не меньше %1 пар с найденной доской, есть %2").arg(MIN_PAIRS).arg(pairCount());
+        return false;
+    }
+
+    const std::vector<std::vector<cv::Point3f>> objectPoints(m_leftPoints.size(), boardPoints());
+    StereoCalibration result;
+    result.imageSize = m_imageSize;
+    try {
+        // Сначала каждая камера отдельно, затем только взаимное положение при зафиксированных внутренних параметрах
+        std::vector<cv::Mat> rvecs, tvecs;
+        result.quality.leftRms = cv::calibrateCamera(objectPoints, m_leftPoints, m_imageSize, result.K1, result.D1, rvecs, tvecs);
+        result.quality.rightRms = cv::calibrateCamera(objectPoints, m_rightPoints, m_imageSize, result.K2, result.D2, rvecs, tvecs);
+
+        cv::Mat E, F;
+        result.quality.stereoRms = cv::stereoCalibrate(objectPoints, m_leftPoints, m_rightPoints,
+                                                       result.K1, result.D1, result.K2, result.D2, m_imageSize,
+                                                       result.R, result.T, E, F, cv::CALIB_FIX_INTRINSIC,
+                                                       cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-6));
+
+        // Эпиполярная ошибка: точка одного кадра против эпиполярной линии соответствующей точки другого
+        double epipolarSum = 0;
+        size_t pointCount = 0;
+        for (size_t i = 0; i < m_leftPoints.size(); ++i) {
+            std::vector<cv::Point2f> left, right;
+            cv::undistortPoints(m_leftPoints[i], left, result.K1, result.D1, cv::noArray(), result.K1);
+            cv::undistortPoints(m_rightPoints[i], right, result.K2, result.D2, cv::noArray(), result.K2);
+            std::vector<cv::Vec3f> leftLines, rightLines;
+            cv::computeCorrespondEpilines(left, 1, F, leftLines);
+            cv::computeCorrespondEpilines(right, 2, F, rightLines);
+            for (size_t j = 0; j < left.size(); ++j) {
+                epipolarSum += std::abs(left[j].x * rightLines[j][0] + left[j].y * rightLines[j][1] + rightLines[j][2]) +
+                               std::abs(right[j].x * leftLines[j][0] + right[j].y * leftLines[j][1] + leftLines[j][2]);
+            }
+            pointCount += left.size() * 2;
+        }
+        result.quality.epipolarError = pointCount ? epipolarSum / pointCount : 0;
+        result.quality.baselineMm = cv::norm(result.T);
+        result.quality.pairs = pairCount();
+    } catch (const cv::Exception& e) {
+        error = QString("Ошибка калибровки: %1").arg(e.what());
+        return false;
+    }
+
+    calibration = result;
+    return true;
+}
+
+bool StereoCalibrator::calibrateDirectory(const QString& stereoDirectory, const CalibrationBoard& board,
+                                          StereoCalibration& calibration, QStringList& rejected, QString& error) {
+    const QList<StereoPair> pairs = StereoProcessor::findPairs(stereoDirectory);
+    if (pairs.isEmpty()) {
+        error = QString("В %1 нет стереопар").arg(stereoDirectory);
+        return false;
+    }
+
+    // Поиск доски - самая долгая часть, пары обрабатываются параллельно
+    StereoCalibrator calibrator(board);
+    std::vector<std::vector<cv::Point2f>> leftCorners(pairs.size()), rightCorners(pairs.size());
+    std::vector<cv::Size> sizes(pairs.size());
+    std::vector<QString> reasons(pairs.size());
+    cv::parallel_for_(cv::Range(0, pairs.size()), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            const cv::Mat left = cv::imread(pairs[i].leftPath.toStdString(), cv::IMREAD_GRAYSCALE);
+            const cv::Mat right = cv::imread(pairs[i].rightPath.toStdString(), cv::IMREAD_GRAYSCALE);
+            if (left.empty() || right.empty()) {
+                reasons[i] = "Не удалось прочитать кадры";
+            } else if (left.size() != right.size()) {
+                reasons[i] = "Размеры левого и правого кадров различаются";
+            } else if (!calibrator.findCorners(left, leftCorners[i])) {
+                reasons[i] = "Доска не найдена на левом кадре";
+            } else if (!calibrator.findCorners(right, rightCorners[i])) {
+                reasons[i] = "Доска не найдена на правом кадре";
+            }
+            sizes[i] = left.size();
+        }
+    });
+
+    for (int i = 0; i < pairs.size(); ++i) {
+        if (reasons[i].isEmpty() && calibrator.pairCount() > 0 && sizes[i] != calibrator.m_imageSize) {
+            reasons[i] = "Размер кадра отличается от предыдущих пар";
+        }
+        if (!reasons[i].isEmpty()) {
+            rejected.append(QString("%1: %2").arg(pairs[i].name, reasons[i]));
+            continue;
+        }
+        calibrator.m_imageSize = sizes[i];
+        calibrator.m_leftPoints.push_back(leftCorners[i]);
+        calibrator.m_rightPoints.push_back(rightCorners[i]);
+    }
+    qDebug() << "Калибровка стереопары: доска найдена на" << calibrator.pairCount() << "из" << pairs.size() << "пар";
+    return calibrator.calibrate(calibration, error);
+}
+
+int StereoCalibrator::selfCheck(QTextStream& out) {
+    // Известная стереопара: две камеры без дисторсии, база 100 мм, правая слегка повёрнута
+    const cv::Size imageSize(1280, 960);
+    const cv::Matx33d K1(1000, 0, 640, 0, 1000, 480, 0, 0, 1);
+    const cv::Matx33d K2(1010, 0, 630, 0, 1010, 485, 0, 0, 1);
+    const cv::Vec3d trueRotation(0.0, 0.02, 0.005);
+    const cv::Vec3d trueT(-100, 0, 0);
+    cv::Matx33d R;
+    cv::Rodrigues(trueRotation, R);
+
+    CalibrationBoard board;
+    const int squarePx = 40;
+    const int margin = 40;
+    cv::Mat texture((board.innerCorners.height + 1) * squarePx + 2 * margin,
+                    (board.innerCorners.width + 1) * squarePx + 2 * margin, CV_8UC1, cv::Scalar(255));
+    for (int y = 0; y <= board.innerCorners.height; ++y) {
+        for (int x = 0; x <= board.innerCorners.width; ++x) {
+            if ((x + y) % 2 == 0) {
+                cv::rectangle(texture, cv::Rect(margin + x * squarePx, margin + y * squarePx, squarePx, squarePx), cv::Scalar(0), cv::FILLED);
+            }
+        }
+    }
+    // Миллиметры доски (от первого внутреннего угла) -> пиксели текстуры
+    const double pxPerMm = squarePx / board.squareMm;
+    const cv::Matx33d boardToTexture(pxPerMm, 0, margin + squarePx, 0, pxPerMm, margin + squarePx, 0, 0, 1);
+    const cv::Vec3d boardCenter((board.innerCorners.width - 1) * board.squareMm / 2,
+                                (board.innerCorners.height - 1) * board.squareMm / 2, 0);
+
+    struct Pose { double rx, ry, rz, dx, dy, z; };
+    const Pose poses[] = {
+        {0, 0, 0, 0, 0, 600},          {0.3, 0, 0, 0, 0, 650},         {-0.3, 0, 0, 0, 0, 650},
+        {0, 0.35, 0, 0, 0, 650},       {0, -0.35, 0, 0, 0, 650},       {0.2, 0.2, 0.1, -60, -40, 550},
+        {-0.2, 0.25, -0.1, 60, 40, 600}, {0.25, -0.2, 0.2, -40, 50, 700}, {-0.25, -0.25, -0.2, 50, -50, 700},
+        {0.1, 0.3, 0.3, 0, 0, 800},    {-0.1, -0.3, -0.3, -30, 20, 520}, {0.35, 0.1, 0, 20, -30, 750},
+    };
+
+    auto render = [&](const cv::Matx33d& K, const cv::Matx33d& rotation, const cv::Vec3d& translation) {
+        // Гомография плоскости доски: K [r1 r2 t]
+        const cv::Matx33d H = K * cv::Matx33d(rotation(0, 0), rotation(0, 1), translation[0],
+                                              rotation(1, 0), rotation(1, 1), translation[1],
+                                              rotation(2, 0), rotation(2, 1), translation[2]);
+        cv::Mat gray;
+        cv::warpPerspective(texture, gray, cv::Mat(H * boardToTexture.inv()), imageSize, cv::INTER_LINEAR,
+                            cv::BORDER_CONSTANT, cv::Scalar(128));
+        cv::GaussianBlur(gray, gray, cv::Size(3, 3), 0.8);
+        cv::Mat bgr;
+        cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+        return bgr;
+    };
+
+    StereoCalibrator calibrator(board);
+    std::vector<std::pair<cv::Mat, cv::Mat>> rendered;
+    for (const Pose& pose : poses) {
+        cv::Matx33d boardRotation;
+        cv::Rodrigues(cv::Vec3d(pose.rx, pose.ry, pose.rz), boardRotation);
+        const cv::Vec3d t = cv::Vec3d(pose.dx, pose.dy, pose.z) - boardRotation * boardCenter;
+        const cv::Mat left = render(K1, boardRotation, t);
+        const cv::Mat right = render(K2, R * boardRotation, R * t + trueT);
+        QString error;
+        if (!calibrator.addPair(left, right, error)) {
+            out << "Синтетическая пара отклонена: " << error << "\n";
+        }
+        rendered.emplace_back(left, right);
+    }
+
+    int exitCode = 0;
+    auto check = [&](const QString& name, double value, double limit) {
+        const bool ok = value <= limit;
+        out << QString("%1: %2 (допустимо %3) %4\n").arg(name, -36).arg(value, 0, 'g', 4).arg(limit).arg(ok ? "OK" : "ОШИБКА");
+        if (!ok) exitCode = 1;
+    };
+
+    StereoCalibration calibration;
+    QString error;
+    if (!calibrator.calibrate(calibration, error)) {
+        out << error << "\n";
+        return 1;
+    }
+    cv::Mat rotationVector;
+    cv::Rodrigues(calibration.R, rotationVector);
+    out << QString("Пар: %1, ошибка репроекции L/R/стерео: %2 / %3 / %4 пикс., база %5 мм\n")
+               .arg(calibration.quality.pairs).arg(calibration.quality.leftRms, 0, 'f', 3)
+               .arg(calibration.quality.rightRms, 0, 'f', 3).arg(calibration.quality.stereoRms, 0, 'f', 3)
+               .arg(calibration.quality.baselineMm, 0, 'f', 2);
+    check("Пар с найденной доской (недостаёт)", double(std::size(poses) - calibration.quality.pairs), 0);
+    check("Ошибка репроекции стерео, пикс.", calibration.quality.stereoRms, 0.5);
+    check("Эпиполярная ошибка, пикс.", calibration.quality.epipolarError, 0.5);
+    check("Ошибка базы, мм", std::abs(calibration.quality.baselineMm - cv::norm(trueT)), 1.0);
+    check("Ошибка фокуса левой камеры, %", std::abs(calibration.K1.at<double>(0, 0) / K1(0, 0) - 1) * 100, 1.0);
+    check("Ошибка фокуса правой камеры, %", std::abs(calibration.K2.at<double>(0, 0) / K2(0, 0) - 1) * 100, 1.0);
+    check("Ошибка поворота, рад", cv::norm(rotationVector, cv::Mat(trueRotation)), 0.005);
+
+    // Выпрямление через кэш: первый вызов строит карты и пишет кэш, второй читает кэш
+    QTemporaryDir directory;
+    const QString calibrationPath = QDir(directory.path()).filePath("calibration.yml");
+    if (!directory.isValid() || !calibration.save(calibrationPath, error)) {
+        out << "Не удалось сохранить калибровку: " << error << "\n";
+        return 1;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    StereoRectification computed;
+    computed.loadOrCompute(calibrationPath, calibration);
+    const qint64 computeMs = timer.restart();
+    StereoRectification cached;
+    const bool loaded = cached.loadCache(StereoRectification::cachePath(calibrationPath),
+                                         StereoRectification::calibrationKey(calibrationPath));
+    const qint64 loadMs = timer.elapsed();
+    out << QString("Карты выпрямления: расчёт %1 мс, загрузка из кэша %2 мс\n").arg(computeMs).arg(loadMs);
+    const bool identical = loaded &&
+                           cv::norm(computed.leftMap1, cached.leftMap1, cv::NORM_INF) == 0 &&
+                           cv::norm(computed.leftMap2, cached.leftMap2, cv::NORM_INF) == 0 &&
+                           cv::norm(computed.rightMap1, cached.rightMap1, cv::NORM_INF) == 0 &&
+                           cv::norm(computed.rightMap2, cached.rightMap2, cv::NORM_INF) == 0 &&
+                           cv::norm(computed.Q, cached.Q, cv::NORM_INF) == 0;
+    check("Расхождение кэша с расчётом", identical ? 0 : 1, 0);
+
+    // После выпрямления углы доски на левом и правом кадре лежат в одних строках
+    double rowError = 0;
+    int rowPoints = 0;
+    for (const auto& pair : rendered) {
+        cv::Mat left, right;
+        cached.rectify(pair.first, pair.second, left, right);
+        std::vector<cv::Point2f> leftCorners, rightCorners;
+        if (!calibrator.findCorners(left, leftCorners) || !calibrator.findCorners(right, rightCorners)) continue;
+        for (size_t i = 0; i < leftCorners.size(); ++i) {
+            rowError += std::abs(leftCorners[i].y - rightCorners[i].y);
+            ++rowPoints;
+        }
+    }
+    check("Расхождение строк после выпрямления, пикс.", rowPoints ? rowError / rowPoints : 1e9, 0.5);
+
+    out << (exitCode == 0 ? "Проверка калибровки пройдена\n" : "Проверка калибровки не пройдена\n");
+    out.flush();
+    return exitCode;
+}
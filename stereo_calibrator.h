@@ -0,0 +1,49 @@
+#ifndef STEREO_CALIBRATOR_H
+#define STEREO_CALIBRATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <vector>
+#include "stereo_calibration.h"
+
+// Калибровочная шахматная доска (ключи Stereo_board_* в настройках)
+struct CalibrationBoard {
+    cv::Size innerCorners{9, 6};   // Внутренние углы по ширине и высоте
+    double squareMm = 25;
+
+    static CalibrationBoard load();
+};
+
+// Калибровка стереопары по снимкам шахматной доски: поиск углов на обоих кадрах пары,
+// калибровка каждой камеры, затем stereoCalibrate с найденными внутренними параметрами.
+class StereoCalibrator {
+public:
+    explicit StereoCalibrator(const CalibrationBoard& board);
+
+    // Углы доски на обоих кадрах пары; false, если доска не найдена хотя бы на одном
+    bool addPair(const cv::Mat& left, const cv::Mat& right, QString& error);
+    int pairCount() const { return int(m_leftPoints.size()); }
+    bool calibrate(StereoCalibration& calibration, QString& error) const;
+
+    // Калибровка по всем парам каталога (stereo/L, stereo/R); поиск углов идёт параллельно по парам.
+    // В rejected - пары, на которых доска не найдена, с причиной.
+    static bool calibrateDirectory(const QString& stereoDirectory, const CalibrationBoard& board,
+                                   StereoCalibration& calibration, QStringList& rejected, QString& error);
+
+    // Проверка на синтетических парах: доска известного размера отрисовывается с известными
+    // камерами и базой, результат калибровки, выпрямление и кэш карт сверяются с ними.
+    // Возвращает код выхода.
+    static int selfCheck(QTextStream& out);
+
+private:
+    bool findCorners(const cv::Mat& image, std::vector<cv::Point2f>& corners) const;
+    std::vector<cv::Point3f> boardPoints() const;
+
+    CalibrationBoard m_board;
+    cv::Size m_imageSize;
+    std::vector<std::vector<cv::Point2f>> m_leftPoints;
+    std::vector<std::vector<cv::Point2f>> m_rightPoints;
+};
+
+#endif // STEREO_CALIBRATOR_H
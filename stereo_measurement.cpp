@@ -0,0 +1,216 @@
+#include "stereo_measurement.h"
+#include "camera_backend.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <cmath>
+
+StereoMeasurementSettings StereoMeasurementSettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    StereoMeasurementSettings result;
+    result.window = qBound(5, settings.getInt("Stereo_measure_window", result.window), 101) | 1;
+    result.maxDisparity = qBound(16, settings.getInt("Stereo_measure_max_disparity", result.maxDisparity), 4096);
+    result.minScore = qBound(0.0, settings.getDouble("Stereo_measure_min_score", result.minScore), 1.0);
+    result.maxSkewMs = qMax(1, settings.getInt("Stereo_measure_max_skew_ms", result.maxSkewMs));
+    return result;
+}
+
+StereoMeasurement::StereoMeasurement(QObject* parent)
+    : QObject(parent) {
+    qRegisterMetaType<StereoMeasurementResult>("StereoMeasurementResult");
+}
+
+void StereoMeasurement::start() {
+    m_ready = false;
+    m_settings = StereoMeasurementSettings::load();
+
+    const QString calibrationPath = SettingsManager::instance().getString("Stereo_calibration_file", "stereo/calibration.yml");
+    StereoCalibration calibration;
+    QString error;
+    if (!calibration.load(calibrationPath, error)) {
+        QString errorMsg = QString("Стереоизмерения недоступны: %1").arg(error);
+        qDebug() << errorMsg;
+        emit errorOccurred("StereoMeasurement", errorMsg);
+        emit readyChanged(false);
+        return;
+    }
+    if (!m_rectification.loadOrCompute(calibrationPath, calibration)) {
+        QString errorMsg = QString("Стереоизмерения недоступны: не удалось рассчитать карты выпрямления по %1").arg(calibrationPath);
+        qDebug() << errorMsg;
+        emit errorOccurred("StereoMeasurement", errorMsg);
+        emit readyChanged(false);
+        return;
+    }
+
+    qDebug() << "Стереоизмерения готовы, кадр" << m_rectification.imageSize.width << "x" << m_rectification.imageSize.height;
+    m_ready = true;
+    emit readyChanged(true);
+}
+
+void StereoMeasurement::stop() {
+    m_ready = false;
+    QMutexLocker locker(&m_pendingMutex);
+    m_pendingLeft = QImage();
+    m_pendingRight = QImage();
+    m_rectifiedLeft = QImage();
+    m_rawRight = QImage();
+    emit readyChanged(false);
+}
+
+void StereoMeasurement::submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs) {
+    if (!m_ready || image.isNull()) return;
+
+    QMutexLocker locker(&m_pendingMutex);
+    if (cameraName == "LCamera") {
+        m_pendingLeft = image;
+        m_pendingLeftNs = timestampNs;
+    } else if (cameraName == "RCamera") {
+        m_pendingRight = image;
+        m_pendingRightNs = timestampNs;
+    } else {
+        return;
+    }
+    // Одна заявка в очереди потока: пока она не обработана, новые кадры только заменяют старые
+    if (!m_processScheduled && !m_pendingLeft.isNull() && !m_pendingRight.isNull()) {
+        m_processScheduled = true;
+        QMetaObject::invokeMethod(this, &StereoMeasurement::processPending, Qt::QueuedConnection);
+    }
+}
+
+void StereoMeasurement::processPending() {
+    QImage left, right;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        m_processScheduled = false;
+        if (m_pendingLeft.isNull() || m_pendingRight.isNull()) return;
+        // Пара собирается только из близких по времени кадров, иначе ждём следующий кадр отстающей камеры
+        if (std::abs(m_pendingLeftNs - m_pendingRightNs) > qint64(m_settings.maxSkewMs) * 1000000) {
+            if (m_pendingLeftNs < m_pendingRightNs)
+                m_pendingLeft = QImage();
+            else
+                m_pendingRight = QImage();
+            return;
+        }
+        left.swap(m_pendingLeft);
+        right.swap(m_pendingRight);
+    }
+    if (!m_ready) return;
+
+    const cv::Size size(left.width(), left.height());
+    if (size != m_rectification.imageSize || right.size() != left.size() ||
+        left.format() != QImage::Format_RGB888 || right.format() != QImage::Format_RGB888) {
+        QString errorMsg = QString("Стереоизмерения остановлены: кадр %1x%2 не совпадает с калибровкой %3x%4")
+                               .arg(size.width).arg(size.height)
+                               .arg(m_rectification.imageSize.width).arg(m_rectification.imageSize.height);
+        qDebug() << errorMsg;
+        stop();
+        emit errorOccurred("StereoMeasurement", errorMsg);
+        return;
+    }
+
+    // Выпрямление сразу в новый QImage: он же уходит на экран и остаётся для измерений без копий
+    QImage rectified(left.width(), left.height(), QImage::Format_RGB888);
+    const cv::Mat source(left.height(), left.width(), CV_8UC3, const_cast<uchar*>(left.constBits()), left.bytesPerLine());
+    cv::Mat target(rectified.height(), rectified.width(), CV_8UC3, rectified.bits(), rectified.bytesPerLine());
+    cv::remap(source, target, m_rectification.leftMap1, m_rectification.leftMap2, cv::INTER_LINEAR);
+
+    m_rectifiedLeft = rectified;
+    m_rawRight = right;
+    emit rectifiedFrameReady(rectified);
+}
+
+void StereoMeasurement::measure(const QPointF& a, const QPointF& b, qint64 clickNs) {
+    StereoMeasurementResult result;
+    result.a = a;
+    result.b = b;
+    result.clickNs = clickNs;
+    if (!m_ready || m_rectifiedLeft.isNull()) {
+        result.message = "нет выпрямленной стереопары";
+    } else {
+        const cv::Point2d pointA(a.x() * m_rectifiedLeft.width(), a.y() * m_rectifiedLeft.height());
+        const cv::Point2d pointB(b.x() * m_rectifiedLeft.width(), b.y() * m_rectifiedLeft.height());
+        cv::Point3d xyzA, xyzB;
+        double disparityA = 0, disparityB = 0;
+        QString error;
+        if (!locatePoint(pointA, xyzA, disparityA, error)) {
+            result.message = "точка 1: " + error;
+        } else if (!locatePoint(pointB, xyzB, disparityB, error)) {
+            result.message = "точка 2: " + error;
+        } else {
+            result.ok = true;
+            result.distanceMm = cv::norm(xyzA - xyzB);
+            result.depthAMm = xyzA.z;
+            result.depthBMm = xyzB.z;
+            // Ошибка глубины dZ = Z / d * dd; для отрезка - худшая из двух точек
+            const double disparityError = 0.25;
+            result.errorMm = std::max(xyzA.z / disparityA, xyzB.z / disparityB) * disparityError;
+        }
+    }
+    result.latencyMs = (CameraBackend::monotonicNs() - clickNs) / 1e6;
+    emit measured(result);
+}
+
+bool StereoMeasurement::locatePoint(const cv::Point2d& point, cv::Point3d& xyz, double& disparity, QString& error) const {
+    const int half = m_settings.window / 2;
+    const int width = m_rectifiedLeft.width();
+    const int height = m_rectifiedLeft.height();
+    const int x = qRound(point.x);
+    const int y = qRound(point.y);
+    if (x - half < 0 || y - half < 0 || x + half >= width || y + half >= height) {
+        error = "слишком близко к краю кадра";
+        return false;
+    }
+
+    // Окно левого кадра вокруг точки
+    const cv::Mat left(height, width, CV_8UC3, const_cast<uchar*>(m_rectifiedLeft.constBits()), m_rectifiedLeft.bytesPerLine());
+    cv::Mat templ;
+    cv::cvtColor(left(cv::Rect(x - half, y - half, m_settings.window, m_settings.window)), templ, cv::COLOR_BGR2GRAY);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(templ, mean, stddev);
+    if (stddev[0] < 3) {
+        error = "мало текстуры вокруг точки";
+        return false;
+    }
+
+    // Правый кадр выпрямляется только в полосе строк окна и только в диапазоне поиска
+    const int searchLeft = qMax(0, x - m_settings.maxDisparity - half);
+    const int searchRight = x + half;   // Диспаратность не меньше нуля
+    const cv::Rect stripRect(searchLeft, y - half, searchRight - searchLeft + 1, m_settings.window);
+    const cv::Mat right(height, width, CV_8UC3, const_cast<uchar*>(m_rawRight.constBits()), m_rawRight.bytesPerLine());
+    cv::Mat strip, stripGray;
+    cv::remap(right, strip, m_rectification.rightMap1(stripRect), m_rectification.rightMap2(stripRect), cv::INTER_LINEAR);
+    cv::cvtColor(strip, stripGray, cv::COLOR_BGR2GRAY);
+
+    cv::Mat scores;
+    cv::matchTemplate(stripGray, templ, scores, cv::TM_CCOEFF_NORMED);
+    double bestScore = 0;
+    cv::Point best;
+    cv::minMaxLoc(scores, nullptr, &bestScore, nullptr, &best);
+    if (bestScore < m_settings.minScore) {
+        error = QString("нет надёжного совпадения (корреляция %1)").arg(bestScore, 0, 'f', 2);
+        return false;
+    }
+
+    // Субпиксельное положение пика по параболе через соседние значения
+    double offset = 0;
+    if (best.x > 0 && best.x < scores.cols - 1) {
+        const float previous = scores.at<float>(0, best.x - 1);
+        const float next = scores.at<float>(0, best.x + 1);
+        const double denominator = previous - 2.0 * bestScore + next;
+        if (denominator < 0) offset = 0.5 * (previous - next) / denominator;
+    }
+    // Окно стоит в целом пикселе x, поэтому диспаратность считается от него
+    disparity = x - (searchLeft + best.x + offset + half);
+    if (disparity <= 0.5) {
+        error = "точка слишком далеко";
+        return false;
+    }
+
+    const cv::Matx44d Q = m_rectification.Q;
+    const cv::Vec4d homogeneous = Q * cv::Vec4d(point.x, point.y, disparity, 1.0);
+    if (std::abs(homogeneous[3]) < 1e-12) {
+        error = "вырожденная геометрия";
+        return false;
+    }
+    xyz = cv::Point3d(homogeneous[0], homogeneous[1], homogeneous[2]) / homogeneous[3];
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef STEREO_MEASUREMENT_H
+#define STEREO_MEASUREMENT_H
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <QMutex>
+#include <QPointF>
+#include <QString>
+#include <atomic>
+#include "stereo_calibration.h"
+
+// Результат измерения расстояния между двумя точками кадра
+struct StereoMeasurementResult {
+    bool ok = false;
+    QPointF a, b;               // Точки в нормированных координатах кадра (0..1)
+    double distanceMm = 0;
+    double errorMm = 0;         // Оценка погрешности при ошибке диспаратности 0.25 пикс.
+    double depthAMm = 0;
+    double depthBMm = 0;
+    qint64 clickNs = 0;         // Монотонное время щелчка
+    double latencyMs = 0;       // От щелчка до готового результата
+    QString message;
+};
+Q_DECLARE_METATYPE(StereoMeasurementResult)
+
+// Параметры живого выпрямления и измерения (ключи Stereo_measure_* в настройках)
+struct StereoMeasurementSettings {
+    int window = 21;            // Сторона окна сопоставления, пикс.
+    int maxDisparity = 640;     // Диапазон поиска по строке правого кадра, пикс.
+    double minScore = 0.7;      // Минимальная нормированная корреляция совпадения
+    int maxSkewMs = 30;         // Допустимая разница времени кадров пары
+
+    static StereoMeasurementSettings load();
+};
+
+// Живое выпрямление стереопары и измерение расстояний по двум точкам.
+// Кадры LCamera/RCamera подаются из потока интерфейса, выпрямление идёт в потоке объекта
+// по кэшированным картам; если поток не успевает, промежуточные кадры пропускаются.
+// Выпрямляется только левый кадр (он же показывается); правый выпрямляется при измерении
+// полосой строк вокруг точки. Диспаратность считается только в окнах вокруг выбранных
+// точек, поэтому измерение занимает единицы миллисекунд.
+class StereoMeasurement : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StereoMeasurement(QObject* parent = nullptr);
+
+    bool isReady() const { return m_ready; }
+    // Потокобезопасно: запоминает последний кадр камеры и будит поток выпрямления
+    void submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs);
+
+public slots:
+    // Загрузка калибровки и карт выпрямления (из кэша или расчёт)
+    void start();
+    void stop();
+    // a, b - точки выпрямленного левого кадра в нормированных координатах; clickNs - время щелчка
+    void measure(const QPointF& a, const QPointF& b, qint64 clickNs);
+
+signals:
+    void readyChanged(bool ready);
+    void rectifiedFrameReady(const QImage& left);
+    void measured(const StereoMeasurementResult& result);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    void processPending();
+    bool locatePoint(const cv::Point2d& point, cv::Point3d& xyz, double& disparity, QString& error) const;
+
+    StereoRectification m_rectification;
+    StereoMeasurementSettings m_settings;
+    std::atomic<bool> m_ready{false};
+
+    // Последние кадры камер, ещё не собранные в пару
+    QMutex m_pendingMutex;
+    QImage m_pendingLeft;
+    QImage m_pendingRight;
+    qint64 m_pendingLeftNs = 0;
+    qint64 m_pendingRightNs = 0;
+    bool m_processScheduled = false;
+
+    // Последняя пара: выпрямленный левый кадр (показан пилоту) и исходный правый
+    QImage m_rectifiedLeft;
+    QImage m_rawRight;
+};
+
+#endif // STEREO_MEASUREMENT_H
@@ -0,0 +1,281 @@
+#include "stereo_processor.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <opencv2/ximgproc.hpp>
+#include <algorithm>
+
+StereoSettings StereoSettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    StereoSettings s;
+    s.numDisparities = qBound(16, settings.getInt("Stereo_num_disparities", s.numDisparities), 1024);
+    s.blockSize = qBound(1, settings.getInt("Stereo_block_size", s.blockSize), 21) | 1;
+    s.wlsLambda = qMax(0.0, settings.getDouble("Stereo_wls_lambda", s.wlsLambda));
+    s.wlsSigma = qMax(0.1, settings.getDouble("Stereo_wls_sigma", s.wlsSigma));
+    s.downscale = qBound(1, settings.getInt("Stereo_downscale", s.downscale), 8);
+    s.maxDepthM = qMax(0.1, settings.getDouble("Stereo_max_depth_m", s.maxDepthM));
+    s.pointCloud = settings.getBool("Stereo_point_cloud", s.pointCloud);
+    s.parallelPairs = qMax(0, settings.getInt("Stereo_parallel_pairs", s.parallelPairs));
+    return s;
+}
+
+StereoProcessor::StereoProcessor(QObject* parent)
+    : QObject(parent) {
+    // Обработка не должна отнимать процессор у захвата, записи и управления
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+StereoProcessor::~StereoProcessor() {
+    cancel();
+    m_pool.waitForDone();
+}
+
+QList<StereoPair> StereoProcessor::findPairs(const QString& stereoDirectory) {
+    QList<StereoPair> pairs;
+    const QDir leftDir(QDir(stereoDirectory).filePath("L"));
+    const QDir rightDir(QDir(stereoDirectory).filePath("R"));
+    const QStringList leftFiles = leftDir.entryList({"LCamera_*.png"}, QDir::Files, QDir::Name);
+    for (const QString& leftFile : leftFiles) {
+        const QString name = QFileInfo(leftFile).completeBaseName().mid(QString("LCamera_").size());
+        const QString rightPath = rightDir.filePath("RCamera_" + name + ".png");
+        if (!QFile::exists(rightPath)) continue;
+        pairs.append({name, leftDir.filePath(leftFile), rightPath});
+    }
+    return pairs;
+}
+
+void StereoProcessor::start(const QString& stereoDirectory) {
+    if (m_job) {
+        emit errorOccurred("StereoProcessor", "Обработка стереопар уже идёт");
+        return;
+    }
+
+    const QList<StereoPair> pairs = findPairs(stereoDirectory);
+    if (pairs.isEmpty()) {
+        QString errorMsg = QString("В %1 нет стереопар (L/LCamera_*.png и R/RCamera_*.png)").arg(stereoDirectory);
+        qDebug() << errorMsg;
+        emit errorOccurred("StereoProcessor", errorMsg);
+        emit finished(0, 0, false);
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->settings = StereoSettings::load();
+    job->outputDirectory = QDir(stereoDirectory).filePath("processed");
+    if (!QDir().mkpath(job->outputDirectory)) {
+        QString errorMsg = QString("Не удалось создать директорию %1").arg(job->outputDirectory);
+        qDebug() << errorMsg;
+        emit errorOccurred("StereoProcessor", errorMsg);
+        emit finished(0, 0, false);
+        return;
+    }
+
+    job->calibrationPath = SettingsManager::instance().getString("Stereo_calibration_file", "stereo/calibration.yml");
+    QString calibrationError;
+    if (!job->calibration.load(job->calibrationPath, calibrationError)) {
+        qDebug() << calibrationError << "- пары считаются выпрямленными, глубина не вычисляется";
+        emit errorOccurred("StereoProcessor", calibrationError + ". Глубина и облака точек не будут построены");
+    }
+
+    const int threads = job->settings.parallelPairs > 0 ? job->settings.parallelPairs
+                                                        : qMax(1, QThread::idealThreadCount() / 2);
+    m_pool.setMaxThreadCount(threads);
+    m_job = job;
+    m_total = pairs.size();
+    m_done = 0;
+    m_succeeded = 0;
+    qDebug() << "Обработка" << m_total << "стереопар из" << stereoDirectory << ", потоков:" << threads;
+    emit progress(0, m_total);
+
+    for (const StereoPair& pair : pairs) {
+        m_pool.start(QRunnable::create([this, job, pair]() {
+            QString message;
+            bool ok = false;
+            if (job->cancelled) {
+                message = "Отменено";
+            } else {
+                try {
+                    ok = processPair(pair, *job, message);
+                } catch (const cv::Exception& e) {
+                    message = QString("Ошибка OpenCV: %1").arg(e.what());
+                }
+            }
+            QMetaObject::invokeMethod(this, [this, name = pair.name, ok, message]() {
+                onPairDone(name, ok, message);
+            }, Qt::QueuedConnection);
+        }));
+    }
+}
+
+void StereoProcessor::cancel() {
+    if (m_job) {
+        m_job->cancelled = true;
+    }
+}
+
+void StereoProcessor::onPairDone(const QString& name, bool ok, const QString& message) {
+    if (!m_job) return;
+    ++m_done;
+    if (ok) ++m_succeeded;
+    emit pairProcessed(name, ok, message);
+    emit progress(m_done, m_total);
+    if (m_done < m_total) return;
+
+    const bool cancelled = m_job->cancelled;
+    m_job.reset();
+    qDebug() << "Обработка стереопар завершена: успешно" << m_succeeded << "из" << m_total << (cancelled ? "(отменено)" : "");
+    emit finished(m_succeeded, m_total - m_succeeded, cancelled);
+}
+
+bool StereoProcessor::processPair(const StereoPair& pair, Job& job, QString& message) {
+    const StereoSettings& settings = job.settings;
+    cv::Mat left = cv::imread(pair.leftPath.toStdString(), cv::IMREAD_COLOR);
+    cv::Mat right = cv::imread(pair.rightPath.toStdString(), cv::IMREAD_COLOR);
+    if (left.empty() || right.empty()) {
+        message = "Не удалось прочитать кадры";
+        return false;
+    }
+    if (left.size() != right.size()) {
+        message = "Размеры левого и правого кадров различаются";
+        return false;
+    }
+
+    // Выпрямление по калибровке; карты загружает (или строит) первая пара, дальше они только читаются
+    const bool calibrated = job.calibration.isValid();
+    if (calibrated) {
+        if (job.calibration.imageSize != left.size()) {
+            message = QString("Размер кадра %1x%2 не совпадает с калибровкой %3x%4")
+                          .arg(left.cols).arg(left.rows)
+                          .arg(job.calibration.imageSize.width).arg(job.calibration.imageSize.height);
+            return false;
+        }
+        std::call_once(job.rectifyOnce, [&job]() { job.rectification.loadOrCompute(job.calibrationPath, job.calibration); });
+        cv::Mat leftRectified, rightRectified;
+        job.rectification.rectify(left, right, leftRectified, rightRectified);
+        left = leftRectified;
+        right = rightRectified;
+    }
+    if (job.cancelled) {
+        message = "Отменено";
+        return false;
+    }
+
+    const int scale = settings.downscale;
+    cv::Mat leftSmall, rightSmall;
+    if (scale > 1) {
+        cv::resize(left, leftSmall, left.size() / scale, 0, 0, cv::INTER_AREA);
+        cv::resize(right, rightSmall, right.size() / scale, 0, 0, cv::INTER_AREA);
+    } else {
+        leftSmall = left;
+        rightSmall = right;
+    }
+    cv::Mat leftGray, rightGray;
+    cv::cvtColor(leftSmall, leftGray, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(rightSmall, rightGray, cv::COLOR_BGR2GRAY);
+
+    // Диспаратность SGBM для левого и правого кадра, WLS-фильтр по левому кадру
+    const int numDisparities = std::max(16, (settings.numDisparities / scale + 15) / 16 * 16);
+    const int block = settings.blockSize;
+    cv::Ptr<cv::StereoSGBM> leftMatcher = cv::StereoSGBM::create(0, numDisparities, block,
+                                                                 8 * block * block, 32 * block * block,
+                                                                 1, 63, 10, 100, 32, cv::StereoSGBM::MODE_SGBM_3WAY);
+    cv::Ptr<cv::StereoMatcher> rightMatcher = cv::ximgproc::createRightMatcher(leftMatcher);
+    cv::Mat leftDisparity, rightDisparity;
+    leftMatcher->compute(leftGray, rightGray, leftDisparity);
+    if (job.cancelled) {
+        message = "Отменено";
+        return false;
+    }
+    rightMatcher->compute(rightGray, leftGray, rightDisparity);
+
+    cv::Ptr<cv::ximgproc::DisparityWLSFilter> wls = cv::ximgproc::createDisparityWLSFilter(leftMatcher);
+    wls->setLambda(settings.wlsLambda);
+    wls->setSigmaColor(settings.wlsSigma);
+    cv::Mat disparity;
+    wls->filter(leftDisparity, leftSmall, disparity, rightDisparity);
+
+    const QDir outputDir(job.outputDirectory);
+    const std::string disparityPath = outputDir.filePath(pair.name + "_disparity.png").toStdString();
+    cv::Mat visual;
+    cv::ximgproc::getDisparityVis(disparity, visual, 1.0);
+    cv::applyColorMap(visual, visual, cv::COLORMAP_JET);
+    if (!cv::imwrite(disparityPath, visual)) {
+        message = "Не удалось сохранить карту диспаратности";
+        return false;
+    }
+
+    if (!calibrated) {
+        message = "Диспаратность сохранена (без калибровки)";
+        return true;
+    }
+
+    // Q построена для полного кадра: для уменьшенного делятся все величины в пикселях
+    cv::Mat Q = job.rectification.Q.clone();
+    Q.at<double>(0, 3) /= scale;
+    Q.at<double>(1, 3) /= scale;
+    Q.at<double>(2, 3) /= scale;
+    Q.at<double>(3, 3) /= scale;
+    cv::Mat disparityFloat;
+    disparity.convertTo(disparityFloat, CV_32F, 1.0 / 16);
+    cv::Mat xyz;
+    cv::reprojectImageTo3D(disparityFloat, xyz, Q, true);
+
+    // Глубина в миллиметрах, 16 бит; 0 - нет данных
+    const float maxDepthMm = float(settings.maxDepthM * 1000);
+    cv::Mat depth(xyz.size(), CV_16UC1);
+    for (int y = 0; y < xyz.rows; ++y) {
+        const cv::Vec3f* point = xyz.ptr<cv::Vec3f>(y);
+        ushort* d = depth.ptr<ushort>(y);
+        for (int x = 0; x < xyz.cols; ++x) {
+            const float z = point[x][2];
+            d[x] = (z > 0 && z < maxDepthMm) ? ushort(std::min(z, 65535.0f)) : 0;
+        }
+    }
+    if (!cv::imwrite(outputDir.filePath(pair.name + "_depth_mm.png").toStdString(), depth)) {
+        message = "Не удалось сохранить карту глубины";
+        return false;
+    }
+
+    if (settings.pointCloud && !writePointCloud(outputDir.filePath(pair.name + "_cloud.ply"), xyz, leftSmall, maxDepthMm)) {
+        message = "Не удалось сохранить облако точек";
+        return false;
+    }
+    message = "Готово";
+    return true;
+}
+
+bool StereoProcessor::writePointCloud(const QString& path, const cv::Mat& xyz, const cv::Mat& colors, float maxDepth) {
+    // Двоичный PLY: x, y, z в метрах и цвет точки из левого кадра
+    std::vector<float> coordinates;
+    std::vector<uchar> rgb;
+    coordinates.reserve(xyz.total() * 3);
+    rgb.reserve(xyz.total() * 3);
+    for (int y = 0; y < xyz.rows; ++y) {
+        const cv::Vec3f* point = xyz.ptr<cv::Vec3f>(y);
+        const cv::Vec3b* color = colors.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < xyz.cols; ++x) {
+            if (!(point[x][2] > 0 && point[x][2] < maxDepth)) continue;
+            coordinates.insert(coordinates.end(), {point[x][0] / 1000, point[x][1] / 1000, point[x][2] / 1000});
+            rgb.insert(rgb.end(), {color[x][2], color[x][1], color[x][0]});
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    const size_t count = coordinates.size() / 3;
+    const QByteArray header = QString("ply\nformat binary_little_endian 1.0\nelement vertex %1\n"
+                                      "property float x\nproperty float y\nproperty float z\n"
+                                      "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n")
+                                  .arg(qulonglong(count)).toLatin1();
+    file.write(header);
+    QByteArray body;
+    body.reserve(int(count * 15));
+    for (size_t i = 0; i < count; ++i) {
+        body.append(reinterpret_cast<const char*>(&coordinates[i * 3]), 3 * sizeof(float));
+        body.append(reinterpret_cast<const char*>(&rgb[i * 3]), 3);
+    }
+    return file.write(body) == body.size();
+}
@@ -0,0 +1,80 @@
+#ifndef STEREO_PROCESSOR_H
+#define STEREO_PROCESSOR_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "stereo_calibration.h"
+
+// Сохранённая стереопара: stereo/L/LCamera_<время>.png + stereo/R/RCamera_<время>.png
+struct StereoPair {
+    QString name;       // Метка времени из имени файла
+    QString leftPath;
+    QString rightPath;
+};
+
+// Параметры пакетной обработки стереопар (ключи Stereo_* в настройках)
+struct StereoSettings {
+    int numDisparities = 256;   // Диапазон поиска в пикселях полного кадра
+    int blockSize = 5;
+    double wlsLambda = 8000;
+    double wlsSigma = 1.5;
+    int downscale = 2;          // Диспаратность считается по кадру, уменьшенному в downscale раз
+    double maxDepthM = 10;      // Дальше - шум, в карту глубины и облако точек не попадает
+    bool pointCloud = true;
+    int parallelPairs = 0;      // Пар одновременно, 0 - половина ядер
+
+    static StereoSettings load();
+};
+
+// Пакетная обработка стереопар: выпрямление, диспаратность SGBM + WLS-фильтр,
+// карта глубины и облако точек PLY. Пары обрабатываются параллельно в собственном
+// пуле потоков с пониженным приоритетом; внутри пары SGBM (режим 3WAY) и WLS-фильтр
+// делят кадр на полосы через cv::parallel_for_. Живой захват и управление не ждут обработку.
+class StereoProcessor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StereoProcessor(QObject* parent = nullptr);
+    ~StereoProcessor() override;
+
+    static QList<StereoPair> findPairs(const QString& stereoDirectory);
+    bool isRunning() const { return m_job != nullptr; }
+
+public slots:
+    void start(const QString& stereoDirectory);
+    void cancel();
+
+signals:
+    void progress(int done, int total);
+    void pairProcessed(const QString& name, bool ok, const QString& message);
+    void finished(int succeeded, int failed, bool cancelled);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    struct Job {
+        StereoSettings settings;
+        StereoCalibration calibration;
+        StereoRectification rectification;  // Пусто, если калибровки нет - пары считаются выпрямленными
+        std::once_flag rectifyOnce;
+        QString calibrationPath;
+        QString outputDirectory;
+        std::atomic<bool> cancelled{false};
+    };
+
+    static bool processPair(const StereoPair& pair, Job& job, QString& message);
+    static bool writePointCloud(const QString& path, const cv::Mat& xyz, const cv::Mat& colors, float maxDepth);
+    void onPairDone(const QString& name, bool ok, const QString& message);
+
+    QThreadPool m_pool;
+    std::shared_ptr<Job> m_job;
+    int m_total = 0;
+    int m_done = 0;
+    int m_succeeded = 0;
+};
+
+#endif // STEREO_PROCESSOR_H
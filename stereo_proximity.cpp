@@ -0,0 +1,193 @@
+#include "stereo_proximity.h"
+#include "camera_backend.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+ProximitySettings ProximitySettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    ProximitySettings s;
+    s.enabled = settings.getBool("Stereo_proximity_enabled", s.enabled);
+    s.rateHz = qBound(0.5, settings.getDouble("Stereo_proximity_rate_hz", s.rateHz), 30.0);
+    s.width = qBound(80, settings.getInt("Stereo_proximity_width", s.width), 1280);
+    s.numDisparities = qBound(16, settings.getInt("Stereo_proximity_num_disparities", s.numDisparities), 256) / 16 * 16;
+    s.blockSize = qBound(3, settings.getInt("Stereo_proximity_block_size", s.blockSize), 15) | 1;
+    s.columns = qBound(1, settings.getInt("Stereo_proximity_columns", s.columns), 8);
+    s.rows = qBound(1, settings.getInt("Stereo_proximity_rows", s.rows), 8);
+    s.warnM = qMax(0.1, settings.getDouble("Stereo_proximity_warn_m", s.warnM));
+    s.cautionM = qMax(s.warnM, settings.getDouble("Stereo_proximity_caution_m", s.cautionM));
+    s.maxSkewMs = qMax(1, settings.getInt("Stereo_measure_max_skew_ms", s.maxSkewMs));
+    return s;
+}
+
+ProximityMonitor::ProximityMonitor(QObject* parent)
+    : QObject(parent), m_stage(new LatestFrameStage(QThread::LowPriority, this)) {
+    qRegisterMetaType<ProximityMap>("ProximityMap");
+    // Пониженный приоритет: грубая карта не должна отнимать процессор у захвата и записи
+    connect(m_stage, &LatestFrameStage::tick, this, &ProximityMonitor::tick);
+}
+
+ProximityMonitor::~ProximityMonitor() {
+    m_stage->stop();
+    m_stage->waitForDone();
+}
+
+void ProximityMonitor::start() {
+    // Повторный запуск после новой калибровки: расчёт по старой калибровке отбрасывается
+    stop();
+    m_settings = ProximitySettings::load();
+    if (!m_settings.enabled) return;
+
+    const QString calibrationPath = SettingsManager::instance().getString("Stereo_calibration_file", "stereo/calibration.yml");
+    StereoCalibration calibration;
+    QString error;
+    if (!calibration.load(calibrationPath, error)) {
+        QString errorMsg = QString("Оценка близости отключена: %1").arg(error);
+        qDebug() << errorMsg;
+        emit errorOccurred("ProximityMonitor", errorMsg);
+        return;
+    }
+
+    // Карты для малого кадра считаются за миллисекунды, кэш для них не нужен.
+    // Новые карты в новых буферах: старые ещё может читать начатый расчёт
+    m_rectification = StereoRectification();
+    m_fullSize = calibration.imageSize;
+    const cv::Size smallSize(m_settings.width, qRound(double(m_settings.width) * m_fullSize.height / m_fullSize.width));
+    if (!m_rectification.compute(calibration.scaled(smallSize))) {
+        QString errorMsg = QString("Оценка близости отключена: некорректная калибровка %1").arg(calibrationPath);
+        qDebug() << errorMsg;
+        emit errorOccurred("ProximityMonitor", errorMsg);
+        return;
+    }
+    const int block = m_settings.blockSize;
+    m_matcher = cv::StereoSGBM::create(0, m_settings.numDisparities, block, 8 * block * block, 32 * block * block,
+                                       1, 63, 10, 100, 2, cv::StereoSGBM::MODE_SGBM);
+
+    m_processed = 0;
+    m_stage->start(m_settings.rateHz);
+    qDebug() << "Оценка близости: карта" << smallSize.width << "x" << smallSize.height << "," << m_settings.rateHz << "Гц";
+}
+
+void ProximityMonitor::stop() {
+    m_stage->stop();
+    m_left = QImage();
+    m_right = QImage();
+}
+
+void ProximityMonitor::submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs) {
+    if (!m_stage->isActive()) return;
+    // QImage разделяется без копирования: кадр камеры после выдачи не меняется
+    if (cameraName == "LCamera") {
+        m_left = image;
+        m_leftNs = timestampNs;
+    } else if (cameraName == "RCamera") {
+        m_right = image;
+        m_rightNs = timestampNs;
+    }
+}
+
+void ProximityMonitor::tick() {
+    if (m_left.isNull() || m_right.isNull()) return;
+    if (std::abs(m_leftNs - m_rightNs) > qint64(m_settings.maxSkewMs) * 1000000) return;
+    const qint64 pairNs = qMax(m_leftNs, m_rightNs);
+
+    const Input input{m_left, m_right, pairNs};
+    const StereoRectification rectification = m_rectification;
+    const cv::Ptr<cv::StereoSGBM> matcher = m_matcher;
+    const ProximitySettings settings = m_settings;
+    const cv::Size fullSize = m_fullSize;
+    // Пара с этим временем уже посчитана или расчёт отстаёт от частоты - пара пропускается
+    m_stage->process(pairNs, [input, rectification, matcher, settings, fullSize]() {
+        Output output;
+        const qint64 startNs = CameraBackend::monotonicNs();
+        output.ok = input.left.size() == QSize(fullSize.width, fullSize.height) && input.right.size() == input.left.size() &&
+                    input.left.format() == QImage::Format_RGB888 && input.right.format() == QImage::Format_RGB888;
+        if (!output.ok) {
+            output.error = QString("кадр %1x%2 не совпадает с калибровкой %3x%4")
+                               .arg(input.left.width()).arg(input.left.height()).arg(fullSize.width).arg(fullSize.height);
+        } else {
+            output.ok = compute(input, rectification, matcher, settings, output.map, output.error);
+        }
+        const qint64 endNs = CameraBackend::monotonicNs();
+        output.map.computeMs = (endNs - startNs) / 1e6;
+        output.map.latencyMs = (endNs - input.frameNs) / 1e6;
+        return output;
+    }, [this](const Output& output) {
+        if (!output.ok) {
+            QString errorMsg = QString("Оценка близости остановлена: %1").arg(output.error);
+            qDebug() << errorMsg;
+            stop();
+            emit errorOccurred("ProximityMonitor", errorMsg);
+            return;
+        }
+        m_processed++;
+        ProximityMap map = output.map;
+        map.processed = m_processed;
+        map.skipped = m_stage->skipped();
+        emit proximityUpdated(map);
+    });
+}
+
+bool ProximityMonitor::compute(const Input& input, const StereoRectification& rectification,
+                               const cv::Ptr<cv::StereoSGBM>& matcher, const ProximitySettings& settings,
+                               ProximityMap& map, QString& error) {
+    try {
+        // Сначала уменьшение, потом выпрямление малыми картами: полный кадр не переписывается
+        const cv::Size smallSize = rectification.imageSize;
+        cv::Mat grays[2];
+        const QImage* images[2] = {&input.left, &input.right};
+        const cv::Mat* maps[2][2] = {{&rectification.leftMap1, &rectification.leftMap2},
+                                     {&rectification.rightMap1, &rectification.rightMap2}};
+        for (int i = 0; i < 2; ++i) {
+            const QImage& image = *images[i];
+            const cv::Mat source(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), image.bytesPerLine());
+            cv::Mat reduced, gray;
+            cv::resize(source, reduced, smallSize, 0, 0, cv::INTER_AREA);
+            cv::cvtColor(reduced, gray, cv::COLOR_BGR2GRAY);
+            cv::remap(gray, grays[i], *maps[i][0], *maps[i][1], cv::INTER_LINEAR);
+        }
+
+        cv::Mat disparity;
+        matcher->compute(grays[0], grays[1], disparity);
+
+        // Глубина из Q: Z = f / (d / B + (cx - cx') / B), в единицах T (мм)
+        const cv::Matx44d Q = rectification.Q;
+        const double focal = Q(2, 3);
+        const double inverseBaseline = Q(3, 2);
+        const double offset = Q(3, 3);
+
+        map.columns = settings.columns;
+        map.rows = settings.rows;
+        map.warnM = settings.warnM;
+        map.cautionM = settings.cautionM;
+        map.distanceM.fill(-1.0f, settings.columns * settings.rows);
+        std::vector<float> depths;
+        for (int row = 0; row < settings.rows; ++row) {
+            for (int column = 0; column < settings.columns; ++column) {
+                const cv::Rect sector(column * disparity.cols / settings.columns, row * disparity.rows / settings.rows,
+                                      disparity.cols / settings.columns, disparity.rows / settings.rows);
+                depths.clear();
+                for (int y = sector.y; y < sector.y + sector.height; ++y) {
+                    const short* line = disparity.ptr<short>(y);
+                    for (int x = sector.x; x < sector.x + sector.width; ++x) {
+                        if (line[x] <= 0) continue;   // Нет совпадения
+                        const double w = inverseBaseline * (line[x] / 16.0) + offset;
+                        if (w <= 0) continue;
+                        depths.push_back(float(focal / w / 1000.0));
+                    }
+                }
+                // Одиночные ложные совпадения дают ложную близость, поэтому берётся 5-й перцентиль,
+                // и только если совпадений в секторе достаточно
+                if (depths.size() < size_t(sector.area() / 50 + 1)) continue;
+                auto percentile = depths.begin() + depths.size() / 20;
+                std::nth_element(depths.begin(), percentile, depths.end());
+                map.distanceM[row * settings.columns + column] = *percentile;
+            }
+        }
+    } catch (const cv::Exception& e) {
+        error = QString("ошибка OpenCV: %1").arg(e.what());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#ifndef STEREO_PROXIMITY_H
+#define STEREO_PROXIMITY_H
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <QVector>
+#include "latest_frame_stage.h"
+#include "stereo_calibration.h"
+
+// Параметры оценки близости препятствий (ключи Stereo_proximity_* в настройках)
+struct ProximitySettings {
+    bool enabled = true;
+    double rateHz = 5;          // Частота расчёта карты глубины
+    int width = 320;            // Ширина грубой карты, высота - по пропорциям кадра
+    int numDisparities = 64;    // В пикселях грубой карты
+    int blockSize = 5;
+    int columns = 3;            // Сетка секторов на HUD
+    int rows = 3;
+    double warnM = 1.0;         // Ближе - красный сектор
+    double cautionM = 2.0;      // Ближе - жёлтый сектор
+    int maxSkewMs = 30;         // Допустимая разница времени кадров пары
+
+    static ProximitySettings load();
+};
+
+// Ближайшая дистанция по секторам кадра
+struct ProximityMap {
+    int columns = 0;
+    int rows = 0;
+    QVector<float> distanceM;   // По строкам секторов; < 0 - мало данных в секторе
+    double warnM = 0;
+    double cautionM = 0;
+    double latencyMs = 0;       // От захвата пары до результата
+    double computeMs = 0;       // Время самого расчёта
+    quint64 processed = 0;
+    quint64 skipped = 0;        // Пар пропущено, пока шёл предыдущий расчёт
+};
+Q_DECLARE_METATYPE(ProximityMap)
+
+// Грубая карта глубины для предупреждения о близости конструкций.
+// По таймеру последняя пара LCamera/RCamera уменьшается, выпрямляется картами для малого
+// кадра и считается SGBM в LatestFrameStage с пониженным приоритетом.
+class ProximityMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProximityMonitor(QObject* parent = nullptr);
+    ~ProximityMonitor() override;
+
+    // Вызывается из потока интерфейса на каждый кадр камеры
+    void submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs);
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void proximityUpdated(const ProximityMap& map);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    struct Input {
+        QImage left;
+        QImage right;
+        qint64 frameNs = 0;
+    };
+    struct Output {
+        bool ok = false;
+        ProximityMap map;
+        QString error;
+    };
+
+    void tick();
+    static bool compute(const Input& input, const StereoRectification& rectification,
+                        const cv::Ptr<cv::StereoSGBM>& matcher, const ProximitySettings& settings,
+                        ProximityMap& map, QString& error);
+
+    ProximitySettings m_settings;
+    StereoRectification m_rectification;  // Карты для уменьшенного кадра
+    cv::Size m_fullSize;
+    cv::Ptr<cv::StereoSGBM> m_matcher;    // Используется только одним расчётом за раз
+    LatestFrameStage* m_stage;
+
+    QImage m_left;
+    QImage m_right;
+    qint64 m_leftNs = 0;
+    qint64 m_rightNs = 0;
+    quint64 m_processed = 0;
+};
+
+#endif // STEREO_PROXIMITY_H
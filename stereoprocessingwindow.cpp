@@ -0,0 +1,153 @@
+#include "stereoprocessingwindow.h"
+#include <QCoreApplication>
+#include <QFileDialog>
+#include <QPointer>
+#include <QThreadPool>
+#include "SettingsManager.h"
+#include "stereo_calibrator.h"
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+StereoProcessingWindow::StereoProcessingWindow(QWidget *parent)
+    : QWidget(parent)
+{
+    setWindowTitle("Обработка стереокадров");
+    resize(640, 420);
+
+    processor = new StereoProcessor(this);
+
+    directoryEdit = new QLineEdit("stereo", this);
+    QPushButton *browseButton = new QPushButton("Обзор...", this);
+    pairsLabel = new QLabel(this);
+    progressBar = new QProgressBar(this);
+    progressBar->setRange(0, 1);
+    progressBar->setValue(0);
+    log = new QPlainTextEdit(this);
+    log->setReadOnly(true);
+    startButton = new QPushButton("Обработать", this);
+    cancelButton = new QPushButton("Отмена", this);
+    cancelButton->setEnabled(false);
+    calibrateButton = new QPushButton("Калибровка", this);
+    calibrateButton->setToolTip("Откалибровать стереопару по снимкам шахматной доски в выбранной папке");
+
+    connect(browseButton, &QPushButton::clicked, this, [this]() {
+        const QString directory = QFileDialog::getExistingDirectory(this, "Папка стереокадров", directoryEdit->text());
+        if (!directory.isEmpty())
+            directoryEdit->setText(directory);
+    });
+    connect(directoryEdit, &QLineEdit::textChanged, this, &StereoProcessingWindow::updatePairCount);
+    connect(startButton, &QPushButton::clicked, this, &StereoProcessingWindow::startProcessing);
+    connect(cancelButton, &QPushButton::clicked, processor, &StereoProcessor::cancel);
+    connect(calibrateButton, &QPushButton::clicked, this, &StereoProcessingWindow::startCalibration);
+    connect(processor, &StereoProcessor::progress, this, [this](int done, int total) {
+        progressBar->setRange(0, qMax(1, total));
+        progressBar->setValue(done);
+    });
+    connect(processor, &StereoProcessor::pairProcessed, this, &StereoProcessingWindow::onPairProcessed);
+    connect(processor, &StereoProcessor::finished, this, &StereoProcessingWindow::onFinished);
+    connect(processor, &StereoProcessor::errorOccurred, this, [this](const QString &, const QString &message) {
+        log->appendPlainText(message);
+    });
+
+    QHBoxLayout *directoryLayout = new QHBoxLayout;
+    directoryLayout->addWidget(directoryEdit);
+    directoryLayout->addWidget(browseButton);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(calibrateButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(startButton);
+    buttonLayout->addWidget(cancelButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(directoryLayout);
+    layout->addWidget(pairsLabel);
+    layout->addWidget(progressBar);
+    layout->addWidget(log);
+    layout->addLayout(buttonLayout);
+
+    updatePairCount();
+}
+
+void StereoProcessingWindow::updatePairCount()
+{
+    const int count = StereoProcessor::findPairs(directoryEdit->text()).size();
+    pairsLabel->setText(QString("Найдено стереопар: %1. Результаты сохраняются в %2/processed")
+                            .arg(count).arg(directoryEdit->text()));
+}
+
+void StereoProcessingWindow::startProcessing()
+{
+    log->clear();
+    startButton->setEnabled(false);
+    calibrateButton->setEnabled(false);
+    cancelButton->setEnabled(true);
+    processor->start(directoryEdit->text());
+}
+
+void StereoProcessingWindow::onPairProcessed(const QString &name, bool ok, const QString &message)
+{
+    log->appendPlainText(QString("%1: %2%3").arg(name, ok ? QString() : QString("ошибка - "), message));
+}
+
+void StereoProcessingWindow::onFinished(int succeeded, int failed, bool cancelled)
+{
+    startButton->setEnabled(true);
+    calibrateButton->setEnabled(true);
+    cancelButton->setEnabled(false);
+    log->appendPlainText(QString("Обработано успешно: %1, с ошибками: %2%3")
+                             .arg(succeeded).arg(failed).arg(cancelled ? " (отменено)" : ""));
+    updatePairCount();
+}
+
+void StereoProcessingWindow::startCalibration()
+{
+    log->clear();
+    log->appendPlainText("Калибровка: поиск доски на стереопарах...");
+    startButton->setEnabled(false);
+    calibrateButton->setEnabled(false);
+
+    // Поиск углов и расчёт карт выпрямления для 5 Мп занимают секунды - не в потоке интерфейса
+    const QString directory = directoryEdit->text();
+    const QString calibrationPath = SettingsManager::instance().getString("Stereo_calibration_file", "stereo/calibration.yml");
+    const CalibrationBoard board = CalibrationBoard::load();
+    QPointer<StereoProcessingWindow> self(this);
+    QThreadPool::globalInstance()->start([self, directory, calibrationPath, board]() {
+        StereoCalibration calibration;
+        QStringList rejected;
+        QString error;
+        bool ok = StereoCalibrator::calibrateDirectory(directory, board, calibration, rejected, error);
+        QStringList report = rejected;
+        if (ok) {
+            ok = calibration.save(calibrationPath, error);
+        }
+        if (ok) {
+            StereoRectification rectification;
+            rectification.loadOrCompute(calibrationPath, calibration);
+            const StereoCalibrationQuality &quality = calibration.quality;
+            report << QString("Пар в калибровке: %1, отклонено: %2").arg(quality.pairs).arg(rejected.size())
+                   << QString("Ошибка репроекции L/R/стерео: %1 / %2 / %3 пикс.")
+                          .arg(quality.leftRms, 0, 'f', 3).arg(quality.rightRms, 0, 'f', 3).arg(quality.stereoRms, 0, 'f', 3)
+                   << QString("Эпиполярная ошибка: %1 пикс., база: %2 мм")
+                          .arg(quality.epipolarError, 0, 'f', 3).arg(quality.baselineMm, 0, 'f', 1)
+                   << QString("Калибровка сохранена в %1").arg(calibrationPath);
+        } else {
+            report << error;
+        }
+        // Окно могло быть закрыто и удалено, пока шла калибровка
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, ok, text = report.join('\n')]() {
+            if (self)
+                self->onCalibrationFinished(ok, text);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void StereoProcessingWindow::onCalibrationFinished(bool ok, const QString &report)
+{
+    startButton->setEnabled(true);
+    calibrateButton->setEnabled(true);
+    log->appendPlainText(report);
+    if (!ok)
+        log->appendPlainText("Калибровка не выполнена");
+    else
+        emit calibrationSaved();
+}
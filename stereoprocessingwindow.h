@@ -0,0 +1,43 @@
+#ifndef STEREOPROCESSINGWINDOW_H
+#define STEREOPROCESSINGWINDOW_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+#include "stereo_processor.h"
+
+// Окно пакетной обработки стереокадров (кнопка "Обработка стереокадров")
+class StereoProcessingWindow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit StereoProcessingWindow(QWidget *parent = nullptr);
+
+signals:
+    // Новая калибровка записана: живые стереостадии перечитывают её
+    void calibrationSaved();
+
+private slots:
+    void startProcessing();
+    void onPairProcessed(const QString &name, bool ok, const QString &message);
+    void onFinished(int succeeded, int failed, bool cancelled);
+    void startCalibration();
+    void onCalibrationFinished(bool ok, const QString &report);
+
+private:
+    void updatePairCount();
+
+    StereoProcessor *processor;
+    QLineEdit *directoryEdit;
+    QLabel *pairsLabel;
+    QProgressBar *progressBar;
+    QPlainTextEdit *log;
+    QPushButton *startButton;
+    QPushButton *cancelButton;
+    QPushButton *calibrateButton;
+};
+
+#endif // STEREOPROCESSINGWINDOW_H
@@ -0,0 +1,207 @@
+#include "synthetic_camera_backend.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+namespace {
+QMutex outageMutex;
+QHash<QString, qint64> outageUntilNs; // Имя камеры -> монотонное время конца пропадания
+std::atomic<unsigned int> dropEvery{0};
+std::atomic<double> sceneBrightness{1.0};
+}
+
+SyntheticCameraBackend::SyntheticCameraBackend(const QString& cameraName, unsigned int width, unsigned int height, double fps)
+    : m_cameraName(cameraName),
+    m_sensorWidth(std::max(2u, width & ~1u)),
+    m_sensorHeight(std::max(2u, height & ~1u)),
+    m_width(m_sensorWidth),
+    m_height(m_sensorHeight),
+    m_periodNs(static_cast<qint64>(1e9 / std::max(0.1, fps))),
+    m_requestedPeriodNs(m_periodNs)
+{
+    if (isInOutage(m_cameraName)) {
+        qDebug() << "Синтетическая камера" << m_cameraName << "недоступна (имитация пропадания)";
+        m_open = false;
+        return;
+    }
+    buildPattern();
+    m_buffer.resize(static_cast<size_t>(m_width) * m_height);
+    qDebug() << "Синтетический источник для камеры" << m_cameraName << ":" << m_width << "x" << m_height << "," << fps << "к/с";
+}
+
+void SyntheticCameraBackend::simulateOutage(const QString& cameraName, int durationMs) {
+    QMutexLocker locker(&outageMutex);
+    outageUntilNs[cameraName] = monotonicNs() + static_cast<qint64>(durationMs) * 1000000;
+    qDebug() << "Имитация пропадания камеры" << cameraName << "на" << durationMs << "мс";
+}
+
+void SyntheticCameraBackend::setDropInjection(unsigned int everyN) {
+    dropEvery = everyN < 2 ? 0 : everyN;
+    qDebug() << "Имитация потерь: пропускается каждый" << dropEvery.load() << "-й кадр";
+}
+
+void SyntheticCameraBackend::setSceneBrightness(double factor) {
+    sceneBrightness = std::max(0.0, factor);
+    qDebug() << "Имитация смены освещения: яркость сцены x" << sceneBrightness.load();
+}
+
+int SyntheticCameraBackend::applyParameters(const CameraParameters& parameters, bool geometry) {
+    if (parameters.frameRate > 0) {
+        m_requestedPeriodNs = static_cast<qint64>(1e9 / parameters.frameRate);
+    }
+    if (!geometry) return MV_OK;
+    if (m_grabbing) return MV_E_CALLORDER;
+
+    // Как у камеры: ROI на сенсоре, затем уменьшение биннингом и прореживанием; размеры чётные
+    const unsigned int scale = static_cast<unsigned int>(parameters.binning * parameters.decimation);
+    const unsigned int x = std::min<unsigned int>(parameters.roiX, m_sensorWidth - 2);
+    const unsigned int y = std::min<unsigned int>(parameters.roiY, m_sensorHeight - 2);
+    const unsigned int w = parameters.roiWidth > 0 ? std::min<unsigned int>(parameters.roiWidth, m_sensorWidth - x) : m_sensorWidth - x;
+    const unsigned int h = parameters.roiHeight > 0 ? std::min<unsigned int>(parameters.roiHeight, m_sensorHeight - y) : m_sensorHeight - y;
+    m_width = std::max(2u, (w / scale) & ~1u);
+    m_height = std::max(2u, (h / scale) & ~1u);
+
+    buildPattern();
+    m_buffer.resize(static_cast<size_t>(m_width) * m_height);
+    qDebug() << "Синтетический источник для камеры" << m_cameraName << ": кадр" << m_width << "x" << m_height;
+    return MV_OK;
+}
+
+int SyntheticCameraBackend::setExposure(double exposureUs, double gainDb) {
+    m_exposureUs = exposureUs;
+    m_gainDb = gainDb;
+    return MV_OK;
+}
+
+int SyntheticCameraBackend::getExposure(double& exposureUs, double& gainDb) const {
+    exposureUs = m_exposureUs;
+    gainDb = m_gainDb;
+    return MV_OK;
+}
+
+bool SyntheticCameraBackend::transportStats(TransportStats& stats) const {
+    stats.lostFrames = m_droppedFrames;
+    stats.receivedFrames = m_deliveredFrames;
+    return true;
+}
+
+bool SyntheticCameraBackend::isInOutage(const QString& cameraName) {
+    QMutexLocker locker(&outageMutex);
+    auto it = outageUntilNs.constFind(cameraName);
+    return it != outageUntilNs.constEnd() && monotonicNs() < it.value();
+}
+
+void SyntheticCameraBackend::buildPattern() {
+    // Цветной узор, периодичный по горизонтали с периодом SCROLL_PERIOD: сдвиг окна по нему даёт движение без швов
+    const int patternWidth = static_cast<int>(m_width + SCROLL_PERIOD);
+    cv::Mat bgr(static_cast<int>(m_height), patternWidth, CV_8UC3);
+    for (int y = 0; y < bgr.rows; ++y) {
+        cv::Vec3b* row = bgr.ptr<cv::Vec3b>(y);
+        const int brightness = 40 + 180 * y / bgr.rows;
+        for (int x = 0; x < bgr.cols; ++x) {
+            const int phase = x % SCROLL_PERIOD;
+            const bool checker = ((phase / 32) + (y / 32)) & 1;
+            const int base = checker ? brightness : brightness / 2;
+            row[x] = cv::Vec3b(static_cast<uchar>(std::min(255, base + phase / 4)),
+                               static_cast<uchar>(std::min(255, base)),
+                               static_cast<uchar>(std::min(255, base + (SCROLL_PERIOD - phase) / 4)));
+        }
+    }
+    m_pattern.resize(static_cast<size_t>(patternWidth) * m_height);
+    mosaicBayerRG(bgr, m_pattern.data());
+}
+
+int SyntheticCameraBackend::startGrabbing() {
+    if (!m_open) return MV_E_HANDLE;
+    m_grabbing = true;
+    m_startNs = monotonicNs();
+    m_frameNum = 0;
+    return MV_OK;
+}
+
+int SyntheticCameraBackend::grabFrame(RawFrame& frame, unsigned int timeoutMs) {
+    if (!m_open || !m_grabbing) return MV_E_CALLORDER;
+    if (isInOutage(m_cameraName)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return MV_E_NODATA;
+    }
+
+    // Смена частоты: расписание продолжается от текущего кадра с новым периодом
+    const qint64 periodNs = m_requestedPeriodNs.load(std::memory_order_relaxed);
+    if (periodNs != m_periodNs) {
+        m_startNs = monotonicNs() - static_cast<qint64>(m_frameNum) * periodNs;
+        m_periodNs = periodNs;
+    }
+
+    // Потерянный кадр занимает свой интервал расписания, следующий приходит с номером через один
+    const unsigned int every = dropEvery.load(std::memory_order_relaxed);
+    if (every && m_frameNum % every == every - 1) {
+        ++m_frameNum;
+        ++m_droppedFrames;
+    }
+
+    // Кадры выдаются строго по расписанию start + n * period, без накопления дрейфа
+    const qint64 dueNs = m_startNs + static_cast<qint64>(m_frameNum) * m_periodNs;
+    const qint64 nowNs = monotonicNs();
+    const qint64 timeoutNs = static_cast<qint64>(timeoutMs) * 1000000;
+    if (dueNs - nowNs > timeoutNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(timeoutNs));
+        return MV_E_NODATA;
+    }
+    if (dueNs > nowNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - nowNs));
+    }
+
+    const size_t patternWidth = m_width + SCROLL_PERIOD;
+    const size_t offset = (m_frameNum * 4) % SCROLL_PERIOD;
+    // Освещённость сцены, выдержка и усиление меняют яркость узора линейно, с насыщением на 255
+    const double scale = sceneBrightness.load(std::memory_order_relaxed) * m_exposureUs.load(std::memory_order_relaxed) / REFERENCE_EXPOSURE_US
+                         * std::pow(10.0, m_gainDb.load(std::memory_order_relaxed) / 20);
+    if (std::abs(scale - 1) < 1e-3) {
+        for (unsigned int y = 0; y < m_height; ++y) {
+            memcpy(m_buffer.data() + static_cast<size_t>(y) * m_width,
+                   m_pattern.data() + y * patternWidth + offset, m_width);
+        }
+    } else {
+        if (scale != m_lutScale) {
+            for (int level = 0; level < 256; ++level) {
+                m_lut[level] = static_cast<unsigned char>(std::min(255.0, level * scale + 0.5));
+            }
+            m_lutScale = scale;
+        }
+        for (unsigned int y = 0; y < m_height; ++y) {
+            const unsigned char* src = m_pattern.data() + y * patternWidth + offset;
+            unsigned char* dst = m_buffer.data() + static_cast<size_t>(y) * m_width;
+            for (unsigned int x = 0; x < m_width; ++x) {
+                dst[x] = m_lut[src[x]];
+            }
+        }
+    }
+
+    frame.data = m_buffer.data();
+    frame.width = m_width;
+    frame.height = m_height;
+    frame.frameNum = m_frameNum++;
+    ++m_deliveredFrames;
+    frame.pixelType = PixelType_Gvsp_BayerRG8;
+    frame.timestampNs = monotonicNs();
+    return MV_OK;
+}
+
+void SyntheticCameraBackend::releaseFrame(RawFrame& frame) {
+    frame.data = nullptr;
+}
+
+int SyntheticCameraBackend::stopGrabbing() {
+    m_grabbing = false;
+    return MV_OK;
+}
+
+int SyntheticCameraBackend::close() {
+    m_grabbing = false;
+    m_open = false;
+    return MV_OK;
+}
@@ -0,0 +1,64 @@
+#ifndef SYNTHETIC_CAMERA_BACKEND_H
+#define SYNTHETIC_CAMERA_BACKEND_H
+
+#include "camera_backend.h"
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+#include <vector>
+
+// Генератор кадров BayerRG8 заданного разрешения и частоты.
+// Нужен для проверки и замеров конвейера захват -> запись/трансляция без камер.
+class SyntheticCameraBackend : public CameraBackend {
+public:
+    SyntheticCameraBackend(const QString& cameraName, unsigned int width, unsigned int height, double fps);
+
+    QString typeName() const override { return "synthetic"; }
+    int startGrabbing() override;
+    int grabFrame(RawFrame& frame, unsigned int timeoutMs) override;
+    void releaseFrame(RawFrame& frame) override;
+    int stopGrabbing() override;
+    int close() override;
+    bool isOpen() const override { return m_open; }
+    int applyParameters(const CameraParameters& parameters, bool geometry) override;
+    int setExposure(double exposureUs, double gainDb) override;
+    int getExposure(double& exposureUs, double& gainDb) const override;
+    bool transportStats(TransportStats& stats) const override;
+
+    // Имитация пропадания камеры: durationMs миллисекунд кадры не выдаются и камера не открывается
+    static void simulateOutage(const QString& cameraName, int durationMs);
+    // Имитация потерь в транспорте: каждый everyN-й кадр не выдаётся, его номер пропускается (0 - выкл.)
+    static void setDropInjection(unsigned int everyN);
+    // Имитация смены освещения (фары, глубина): яркость сцены всех источников умножается на factor
+    static void setSceneBrightness(double factor);
+
+private:
+    static bool isInOutage(const QString& cameraName);
+
+    static const unsigned int SCROLL_PERIOD = 256; // Период сдвига узора, пикселей (чётный - сохраняет фазу Байера)
+    static constexpr double REFERENCE_EXPOSURE_US = 10000; // Выдержка, при которой узор выдаётся без изменений
+
+    void buildPattern();
+
+    QString m_cameraName;
+    unsigned int m_sensorWidth;
+    unsigned int m_sensorHeight;
+    unsigned int m_width;
+    unsigned int m_height;
+    qint64 m_periodNs;
+    std::atomic<qint64> m_requestedPeriodNs;  // Частота меняется на ходу из потока Camera
+    std::atomic<double> m_exposureUs{REFERENCE_EXPOSURE_US};
+    std::atomic<double> m_gainDb{0};
+    double m_lutScale = 1;                    // Яркость, для которой построена m_lut
+    unsigned char m_lut[256];
+    bool m_open = true;
+    bool m_grabbing = false;
+    qint64 m_startNs = 0;
+    unsigned int m_frameNum = 0;
+    quint64 m_deliveredFrames = 0;
+    quint64 m_droppedFrames = 0;
+    std::vector<unsigned char> m_pattern;  // m_height x (m_width + SCROLL_PERIOD)
+    std::vector<unsigned char> m_buffer;   // m_height x m_width
+};
+
+#endif // SYNTHETIC_CAMERA_BACKEND_H
@@ -0,0 +1,126 @@
+#include "typedsettings.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace Settings {
+IntSetting CamAngleMinus("Cam_angle_minus", -90, -360, 360);
+IntSetting CamAnglePlus("Cam_angle_plus", 90, -360, 360);
+
+DoubleSetting RollKP("RollkP", 5, 0, 10000);
+DoubleSetting RollKI("RollkI", 0, 0, 10000);
+DoubleSetting RollKD("RollkD", 0, 0, 10000);
+DoubleSetting PitchKP("PitchkP", 5, 0, 10000);
+DoubleSetting PitchKI("PitchkI", 0, 0, 10000);
+DoubleSetting PitchKD("PitchkD", 0, 0, 10000);
+DoubleSetting YawKP("YawkP", 5, 0, 10000);
+DoubleSetting YawKI("YawkI", 0, 0, 10000);
+DoubleSetting YawKD("YawkD", 0, 0, 10000);
+DoubleSetting DepthKP("DepthkP", 200, 0, 10000);
+DoubleSetting DepthKI("DepthkI", 0, 0, 10000);
+DoubleSetting DepthKD("DepthkD", 0, 0, 10000);
+}
+
+// Реестр в функции, а не глобальной переменной: порядок инициализации глобальных объектов
+// в разных единицах трансляции не определён
+static QVector<TypedSetting*>& registry() {
+    static QVector<TypedSetting*> settings;
+    return settings;
+}
+
+TypedSetting::TypedSetting(const char* key)
+    : m_key(QString::fromLatin1(key))
+{
+    registry().append(this);
+}
+
+const QVector<TypedSetting*>& TypedSetting::all() {
+    return registry();
+}
+
+TypedSetting* TypedSetting::find(const QString& key) {
+    for (TypedSetting* setting : registry()) {
+        if (setting->key() == key)
+            return setting;
+    }
+    return nullptr;
+}
+
+// Число из JSON; старые файлы хранят часть чисел строками (коэффициенты PID)
+static bool parseNumber(const QJsonValue& raw, double& result) {
+    if (raw.isDouble()) {
+        result = raw.toDouble();
+        return true;
+    }
+    if (raw.isString()) {
+        bool ok = false;
+        result = raw.toString().trimmed().replace(',', '.').toDouble(&ok);
+        return ok;
+    }
+    return false;
+}
+
+IntSetting::IntSetting(const char* key, int defaultValue, int minValue, int maxValue)
+    : TypedSetting(key), m_value(defaultValue), m_default(defaultValue), m_min(minValue), m_max(maxValue)
+{
+}
+
+bool IntSetting::load(const QJsonValue& raw, QJsonValue& normalized) {
+    int value = m_default;
+    double number = 0;
+    if (raw.isUndefined() || raw.isNull()) {
+        // Нет в файле - значение по умолчанию
+    } else if (parseNumber(raw, number)) {
+        value = int(std::clamp(std::round(number), double(m_min), double(m_max)));
+        if (value != number)
+            qWarning() << "[Settings]" << m_key << ": значение" << raw << "вне диапазона" << m_min << ".." << m_max << ", используется" << value;
+    } else {
+        qWarning() << "[Settings]" << m_key << ": некорректное значение" << raw << ", используется" << m_default;
+    }
+    normalized = value;
+    return m_value.exchange(value, std::memory_order_relaxed) != value;
+}
+
+DoubleSetting::DoubleSetting(const char* key, double defaultValue, double minValue, double maxValue)
+    : TypedSetting(key), m_value(defaultValue), m_default(defaultValue), m_min(minValue), m_max(maxValue)
+{
+}
+
+bool DoubleSetting::load(const QJsonValue& raw, QJsonValue& normalized) {
+    double value = m_default;
+    double number = 0;
+    if (raw.isUndefined() || raw.isNull()) {
+        // Нет в файле - значение по умолчанию
+    } else if (parseNumber(raw, number) && std::isfinite(number)) {
+        value = std::clamp(number, m_min, m_max);
+        if (value != number)
+            qWarning() << "[Settings]" << m_key << ": значение" << number << "вне диапазона" << m_min << ".." << m_max << ", используется" << value;
+    } else {
+        qWarning() << "[Settings]" << m_key << ": некорректное значение" << raw << ", используется" << m_default;
+    }
+    normalized = value;
+    return m_value.exchange(value, std::memory_order_relaxed) != value;
+}
+
+BoolSetting::BoolSetting(const char* key, bool defaultValue)
+    : TypedSetting(key), m_value(defaultValue), m_default(defaultValue)
+{
+}
+
+bool BoolSetting::load(const QJsonValue& raw, QJsonValue& normalized) {
+    bool value = m_default;
+    if (raw.isUndefined() || raw.isNull()) {
+        // Нет в файле - значение по умолчанию
+    } else if (raw.isBool()) {
+        value = raw.toBool();
+    } else if (raw.isDouble()) {
+        value = raw.toDouble() != 0;
+    } else if (raw.isString()) {
+        QString text = raw.toString().trimmed().toLower();
+        value = text == "true" || text == "1";
+    } else {
+        qWarning() << "[Settings]" << m_key << ": некорректное значение" << raw << ", используется" << m_default;
+    }
+    normalized = value;
+    return m_value.exchange(value, std::memory_order_relaxed) != value;
+}
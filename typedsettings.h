@@ -0,0 +1,87 @@
+#ifndef TYPEDSETTINGS_H
+#define TYPEDSETTINGS_H
+
+#include <QJsonValue>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// Типизированная настройка. Значение разбирается и проверяется SettingsManager'ом
+// при загрузке файла и при setValue(), а в горячих местах читается одной атомарной загрузкой
+// вместо поиска по QJsonObject. Все экземпляры регистрируются при создании.
+class TypedSetting {
+public:
+    explicit TypedSetting(const char* key);
+    virtual ~TypedSetting() = default;
+
+    const QString& key() const { return m_key; }
+
+    // Разбирает значение из JSON (отсутствующее - значение по умолчанию), проверяет диапазон
+    // и обновляет кэш. В normalized - значение в том виде, в котором его нужно хранить в файле.
+    // Возвращает true, если кэшированное значение изменилось.
+    virtual bool load(const QJsonValue& raw, QJsonValue& normalized) = 0;
+
+    static const QVector<TypedSetting*>& all();
+    static TypedSetting* find(const QString& key);
+
+protected:
+    QString m_key;
+};
+
+class IntSetting : public TypedSetting {
+public:
+    IntSetting(const char* key, int defaultValue, int minValue, int maxValue);
+    int value() const { return m_value.load(std::memory_order_relaxed); }
+    bool load(const QJsonValue& raw, QJsonValue& normalized) override;
+
+private:
+    std::atomic<int> m_value;
+    const int m_default;
+    const int m_min;
+    const int m_max;
+};
+
+class DoubleSetting : public TypedSetting {
+public:
+    DoubleSetting(const char* key, double defaultValue, double minValue, double maxValue);
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+    bool load(const QJsonValue& raw, QJsonValue& normalized) override;
+
+private:
+    std::atomic<double> m_value;
+    const double m_default;
+    const double m_min;
+    const double m_max;
+};
+
+class BoolSetting : public TypedSetting {
+public:
+    BoolSetting(const char* key, bool defaultValue);
+    bool value() const { return m_value.load(std::memory_order_relaxed); }
+    bool load(const QJsonValue& raw, QJsonValue& normalized) override;
+
+private:
+    std::atomic<bool> m_value;
+    const bool m_default;
+};
+
+// Настройки, которые читаются на каждом пакете телеметрии или управления
+namespace Settings {
+extern IntSetting CamAngleMinus;
+extern IntSetting CamAnglePlus;
+
+extern DoubleSetting RollKP;
+extern DoubleSetting RollKI;
+extern DoubleSetting RollKD;
+extern DoubleSetting PitchKP;
+extern DoubleSetting PitchKI;
+extern DoubleSetting PitchKD;
+extern DoubleSetting YawKP;
+extern DoubleSetting YawKI;
+extern DoubleSetting YawKD;
+extern DoubleSetting DepthKP;
+extern DoubleSetting DepthKI;
+extern DoubleSetting DepthKD;
+}
+
+#endif // TYPEDSETTINGS_H
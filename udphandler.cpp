@@ -1,10 +1,15 @@
 #include "udphandler.h"
+#include "eventlog.h"
+#include "typedsettings.h"
 #include <QCoreApplication>
 #include <QDir>
 #include <QVariant>
 #include <cstdlib>
 #include <QDebug>
 #include <QNetworkInterface>
+#include <QPointer>
+#include <QThreadPool>
+#include "persistenceservice.h"
 #include <cmath>
 
 /*TODO
@@ -69,20 +74,51 @@ UdpHandler::UdpHandler(ProfileManager *profileManager, UdpTelemetryParser *telem
     prevRecordingButtonState = false;
 
     QString baseDir = QCoreApplication::applicationDirPath();
-    loadMappingsFromJson(baseDir + QDir::separator() +
-                         "Configs" + QDir::separator() + "Control mapping.cfg");
-
-    //Таймер для проверки подключения к аппарату
+    mappingFilePath = baseDir + QDir::separator() + "Configs" + QDir::separator() + "Control mapping.cfg";
+    bindings = ControlBindings::compile(QJsonObject(), QJsonObject());
+
+    //Раскладка и профиль перечитываются при изменении файлов, без перезапуска программы
+    configWatcher = new QFileSystemWatcher(this);
+    connect(configWatcher, &QFileSystemWatcher::fileChanged, this, &UdpHandler::onConfigFileChanged);
+    configReloadTimer = new QTimer(this);
+    configReloadTimer->setSingleShot(true);
+    connect(configReloadTimer, &QTimer::timeout, this, &UdpHandler::reloadChangedFiles);
+    watchFile(mappingFilePath);
+    connect(profileManager, &ProfileManager::profileChanged, this, &UdpHandler::onProfileChanged);
+    connect(profileManager, &ProfileManager::profileNameChange, this, &UdpHandler::onProfileSwitched);
+    //Конструктор выполняется в потоке интерфейса, до переноса в udpThread
+    onProfileSwitched(profileManager->getProfile());
+
+    qRegisterMetaType<ControlLatencyStats>("ControlLatencyStats");
+
+    //Таймер для проверки подключения к аппарату: heartbeat + оценка качества связи
     onlineFlag = false;
-    lastOnlineTime = 0;
+    linkFailsafe = false;
+    failsafeZeroThrust = true;
+    linkMonitor = new LinkMonitor(this);
+    connect(linkMonitor, &LinkMonitor::statsUpdated, this, &UdpHandler::linkStatsUpdated);
+    connect(linkMonitor, &LinkMonitor::failsafeChanged, this, &UdpHandler::onLinkFailsafeChanged);
     onlineTimer = new QTimer(this);
+    onlineTimer->setTimerType(Qt::PreciseTimer);
     connect(onlineTimer, &QTimer::timeout, this, &UdpHandler::onlineTimerTick);
-    onlineTimer->start(1000);
+    onlineTimer->start(50);
 
     incremental = new QTimer(this);
     connect(incremental, &QTimer::timeout, this, &UdpHandler::incrementValues);
     incremental->start(50);
 
+    //Джойстик публикует состояние только при изменении, поэтому управление повторяется по таймеру
+    controlResendTimer = new QTimer(this);
+    controlResendTimer->setTimerType(Qt::PreciseTimer);
+    connect(controlResendTimer, &QTimer::timeout, this, &UdpHandler::resendControlData);
+    controlResendTimer->start(20);
+
+    latencyReportTimer = new QTimer(this);
+    connect(latencyReportTimer, &QTimer::timeout, this, [this]() {
+        emit controlLatencyUpdated(latencyStats());
+    });
+    latencyReportTimer->start(1000);
+
     qDebug() << "Local IPs:";
     for (const QHostAddress &addr : QNetworkInterface::allAddresses()) {
         if (addr.protocol() == QAbstractSocket::IPv4Protocol && addr != QHostAddress::LocalHost)
@@ -103,6 +139,7 @@ void UdpHandler::sendDatagram(const QByteArray &data) {
     }
 
     qint64 sent = socket->writeDatagram(data, remoteAddress, remotePort);
+    lastDatagramSentNs = SDL_GetTicksNS();
     if (sent == -1) {
         qWarning() << "[UdpHandler] Failed to send datagram:" << socket->errorString();
     } else {
@@ -135,59 +172,150 @@ void UdpHandler::onReadyRead() {
         }*/
         // qDebug() << "Data size:" << buffer.size();
         // qDebug() << "Data hex:" << buffer.toHex();
-        if(buffer.size() == 44){
+        if(LinkMonitor::isHeartbeat(buffer)){
+            linkMonitor->heartbeatEchoReceived(buffer);
+        } else if(buffer.size() == 44){
             telemetryParser->parse(buffer, telemetryData);
-            lastOnlineTime = QDateTime::currentSecsSinceEpoch();
+            linkMonitor->packetReceived();
         }
     }
 }
 
 void UdpHandler::onlineTimerTick(){
-    qint64 currentSecs = QDateTime::currentSecsSinceEpoch();
-    if((currentSecs - lastOnlineTime) > 2){
-        if(onlineFlag){
-            onlineFlag = false;
-            emit onlineStateChanged(onlineFlag);
-            return;
-        } else {
-            if(connectToROV(remoteAddress, remotePort)){
+    sendDatagram(linkMonitor->makeHeartbeat());
+    linkMonitor->evaluate();
 
-            }
-        }
-    } else if(!onlineFlag){
-        onlineFlag = true;
+    bool online = linkMonitor->isOnline();
+    if(online != onlineFlag){
+        onlineFlag = online;
+        EventLog::record(EventId::LinkOnlineChanged, {online, linkMonitor->stats().sinceLastRxMs});
         emit onlineStateChanged(onlineFlag);
     }
-    // qDebug() << "Online: " << onlineFlag;
-    // qDebug() << currentSecs - lastOnlineTime;
+    //Пакет подключения без связи отправляем не чаще раза в секунду
+    if(!onlineFlag && (!reconnectProbeTimer.isValid() || reconnectProbeTimer.elapsed() >= 1000)){
+        connectToROV(remoteAddress, remotePort);
+        reconnectProbeTimer.restart();
+    }
+}
+
+void UdpHandler::onLinkFailsafeChanged(const bool &failsafe){
+    linkFailsafe = failsafe;
+    LinkStats stats = linkMonitor->stats();
+    EventLog::record(EventId::LinkFailsafeChanged, {failsafe, stats.lossPercent, stats.rttP95Ms});
+    emit linkFailsafeChanged(failsafe);
 }
 
-void UdpHandler::loadMappingsFromJson(const QString& filePath) {
+bool UdpHandler::loadMappingsFromJson(const QString& filePath, QJsonObject &mapping) {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qWarning() << "Cannot open file:" << filePath;
-        return;
+        return false;
     }
 
     QByteArray data = file.readAll();
     file.close();
 
-    QJsonDocument doc = QJsonDocument::fromJson(data);
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
     if (!doc.isObject()) {
-        qWarning() << "Invalid JSON format";
-        return;
+        qWarning() << "Invalid JSON format" << filePath << error.errorString();
+        return false;
+    }
+
+    mapping = doc.object();
+    return true;
+}
+
+void UdpHandler::rebuildBindings(){
+    quint64 generation = ++bindingsGeneration;
+    QJsonObject profile = currentProfile;
+    QJsonObject fallbackMapping = lastGoodMapping;
+    QString path = mappingFilePath;
+    QPointer<UdpHandler> self(this);
+
+    //Чтение раскладки и сборка таблицы - вне потока управления
+    QThreadPool::globalInstance()->start([self, generation, profile, fallbackMapping, path]() {
+        QJsonObject mapping;
+        bool mappingOk = loadMappingsFromJson(path, mapping);
+        //Файл в процессе редактирования может быть битым - остаёмся на последней исправной раскладке
+        if (!mappingOk)
+            mapping = fallbackMapping;
+        std::shared_ptr<const ControlBindings> compiled = ControlBindings::compile(mapping, profile);
+        if (!self)
+            return;
+        QMetaObject::invokeMethod(self.data(), [self, generation, compiled, mapping, mappingOk]() {
+            //Уже запущена более поздняя пересборка - этот результат устарел
+            if (generation != self->bindingsGeneration)
+                return;
+            if (mappingOk)
+                self->lastGoodMapping = mapping;
+            std::atomic_store(&self->bindings, compiled);
+            qDebug() << "[UdpHandler] Привязки управления обновлены, профиль" << compiled->profileName();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void UdpHandler::onProfileChanged(const QJsonObject &profile){
+    currentProfile = profile;
+    rebuildBindings();
+}
+
+void UdpHandler::onProfileSwitched(const QJsonObject &profile){
+    currentProfile = profile;
+    QString profileName = profile["profileName"].toString();
+    QString path = profileName.isEmpty() ? QString() : ProfileManager::profileFilePath(profileName);
+    if (path != watchedProfilePath) {
+        if (!watchedProfilePath.isEmpty())
+            configWatcher->removePath(watchedProfilePath);
+        watchedProfilePath = path;
+        if (!path.isEmpty())
+            watchFile(path);
     }
+    rebuildBindings();
+}
 
-    QJsonObject root = doc.object();
+void UdpHandler::watchFile(const QString &path){
+    if (QFile::exists(path) && !configWatcher->files().contains(path))
+        configWatcher->addPath(path);
+}
 
-    for (auto it = root.begin(); it != root.end(); ++it) {
-        QString machineAction = it.key();
-        QJsonArray inputs = it.value().toArray();
+void UdpHandler::onConfigFileChanged(const QString &path){
+    //Редактор может сохранять файл в несколько приёмов - ждём, пока изменения закончатся
+    changedConfigPaths.insert(path);
+    configReloadTimer->start(200);
+}
 
-        for (const QJsonValue& inputVal : inputs) {
-            QString input = inputVal.toString();
-            inputToMachine.insert(input, machineAction);
-            machineToInput.insert(machineAction, input);
+void UdpHandler::reloadChangedFiles(){
+    QSet<QString> paths;
+    paths.swap(changedConfigPaths);
+
+    for (const QString &path : std::as_const(paths)) {
+        //При атомарной замене файла наблюдение за ним снимается, возвращаем его
+        if (!QFile::exists(path)) {
+            if (path == mappingFilePath || path == watchedProfilePath) {
+                changedConfigPaths.insert(path);
+                configReloadTimer->start(500);
+            }
+            continue;
+        }
+        watchFile(path);
+
+        if (path == mappingFilePath) {
+            qDebug() << "[UdpHandler] Раскладка управления изменена на диске, пересборка привязок";
+            rebuildBindings();
+        } else if (path == watchedProfilePath) {
+            //Профиль живёт в потоке интерфейса - замена выполняется там же,
+            //новый снимок вернётся сюда через profileChanged
+            QPointer<ProfileManager> manager(profileManager);
+            QThreadPool::globalInstance()->start([manager, path]() {
+                QJsonObject profile;
+                if (!PersistenceService::readJsonWithBackup(path, profile) || !manager)
+                    return;
+                QMetaObject::invokeMethod(manager.data(), [manager, path, profile]() {
+                    if (manager)
+                        manager->reloadFromFile(path, profile);
+                }, Qt::QueuedConnection);
+            });
         }
     }
 }
@@ -207,14 +335,25 @@ QByteArray UdpHandler::packControlData()
     controlFlags |= quint64(cUpdatePID)     << 8;
     if(cUpdatePID) cUpdatePID = false;
 
+    //При деградации связи не передаем аппарату устаревшие команды движения
+    bool zeroThrust = linkFailsafe && failsafeZeroThrust;
+
+    //Коррекция удержания позиции добавляется к маршу и лагу пилота
+    float forwardThrust = cForwardThrust;
+    float sideThrust = cSideThrust;
+    if(holdCorrectionNs != 0 && SDL_GetTicksNS() - holdCorrectionNs < HOLD_CORRECTION_TIMEOUT_NS){
+        forwardThrust = constrainf(forwardThrust + holdForward, -1.0f, 1.0f);
+        sideThrust = constrainf(sideThrust + holdSide, -1.0f, 1.0f);
+    }
+
     //Data
     QList<float> floats = {
-        cForwardThrust,
-        cSideThrust,
-        cVerticalThrust,
-        cYawThrust,
-        cRollThrust,
-        cPitchThrust,
+        zeroThrust ? 0.0f : forwardThrust,
+        zeroThrust ? 0.0f : sideThrust,
+        zeroThrust ? 0.0f : cVerticalThrust,
+        zeroThrust ? 0.0f : cYawThrust,
+        zeroThrust ? 0.0f : cRollThrust,
+        zeroThrust ? 0.0f : cPitchThrust,
         cPowerLimit,
         cCameraRotate,
         cManipulatorGrip,
@@ -242,27 +381,32 @@ QByteArray UdpHandler::packControlData()
 
 void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     if(!onlineFlag) return;
-    QJsonObject controlProfile = profileManager->getProfile();
+    Uint64 handlerNs = SDL_GetTicksNS();
+    //Таблица привязок собрана заранее, здесь только чтение состояния джойстиков
+    std::shared_ptr<const ControlBindings> table = std::atomic_load(&bindings);
+    ControlValues values;
+    table->evaluate(joysticsState, values);
+    auto controlValue = [&values](ControlAction action) { return values[size_t(action)]; };
 
     //Manipulator rotate
 
-    cManipulatorRotate = getControlValue("manipulator_rotate", machineToInput, joysticsState, controlProfile, "Right", "Left");
+    cManipulatorRotate = controlValue(ControlAction::ManipulatorRotate);
 
     //Manipulator grip
-    cManipulatorGrip = getControlValue("manipulator_grip", machineToInput, joysticsState, controlProfile, "Open", "Close");
+    cManipulatorGrip = controlValue(ControlAction::ManipulatorGrip);
 
     //Power limit incremental
-    iPowerLimit = getControlValue("power_limit", machineToInput, joysticsState, controlProfile);
+    iPowerLimit = controlValue(ControlAction::PowerLimit);
 
     //Camera rotate
-    cCameraRotate = getControlValue("camera_rotate", machineToInput, joysticsState, controlProfile, "Up", "Down");
+    cCameraRotate = controlValue(ControlAction::CameraRotate);
 
     //Reset stabilization setpoints
-    float positionResetButtonState = getControlValue("position_reset", machineToInput, joysticsState, controlProfile, "PosReset");
+    float positionResetButtonState = controlValue(ControlAction::PositionReset);
     cPosReset = positionResetButtonState? true : false;
 
     //Lights on off
-    float lightsButtonState = getControlValue("lights", machineToInput, joysticsState, controlProfile, "On");
+    float lightsButtonState = controlValue(ControlAction::Lights);
     if(lightsButtonState){
         if (!lightsValueChangeFlag){
             cLights = !cLights;
@@ -274,7 +418,7 @@ void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     }
 
     //Record video start stop
-    float recordingButtonState = getControlValue("recording", machineToInput, joysticsState, controlProfile, "Start");
+    float recordingButtonState = controlValue(ControlAction::Recording);
     if(recordingButtonState){
         if (!recordingValueChangeFlag){
 
@@ -287,7 +431,7 @@ void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     }
 
     //Take frame
-    float takeFrameButtonState = getControlValue("take_frame", machineToInput, joysticsState, controlProfile, "Stereoframe");
+    float takeFrameButtonState = controlValue(ControlAction::TakeFrame);
     if(takeFrameButtonState){
         if (!takeFrameValueChangeFlag){
             emit takeFrame();
@@ -299,7 +443,7 @@ void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     }
 
     //MASTER on off
-    float masterButtonState = getControlValue("master_switch", machineToInput, joysticsState, controlProfile, "Master");
+    float masterButtonState = controlValue(ControlAction::MasterSwitch);
     if(masterButtonState){
         if (!masterValueChangeFlag){
             cMASTER = !cMASTER;
@@ -311,25 +455,47 @@ void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     }
 
     //Forward
-    cForwardThrust = getControlValue("forward_thrust", machineToInput, joysticsState, controlProfile, "Forward", "Backward");
+    cForwardThrust = controlValue(ControlAction::ForwardThrust);
 
     //Strafe
-    cSideThrust = getControlValue("side_thrust", machineToInput, joysticsState, controlProfile, "Right", "Left");
+    cSideThrust = controlValue(ControlAction::SideThrust);
+
+    //Пока пилот сам ведёт аппарат по маршу или лагу, точка удержания позиции следует за ним
+    bool manual = std::fabs(cForwardThrust) > 0.05f || std::fabs(cSideThrust) > 0.05f;
+    if(manual != manualTranslation){
+        manualTranslation = manual;
+        emit manualTranslationChanged(manual);
+    }
 
     //Vertical
-    cVerticalThrust = getControlValue("vertical_thrust", machineToInput, joysticsState, controlProfile, "Up", "Down");
+    cVerticalThrust = controlValue(ControlAction::VerticalThrust);
 
     //Yaw
-    cYawThrust = getControlValue("rotate_yaw", machineToInput, joysticsState, controlProfile, "Right", "Left");
+    cYawThrust = controlValue(ControlAction::RotateYaw);
 
     //Roll
-    cRollThrust = getControlValue("rotate_roll", machineToInput, joysticsState, controlProfile, "dec", "inc");
+    cRollThrust = controlValue(ControlAction::RotateRoll);
 
     //Pitch
-    cPitchThrust = getControlValue("rotate_pitch", machineToInput, joysticsState, controlProfile);
-
-    if(onlineFlag)
-        sendDatagram(packControlData());
+    cPitchThrust = controlValue(ControlAction::RotatePitch);
+
+    if(onlineFlag){
+        QByteArray packet = packControlData();
+        Uint64 packedNs = SDL_GetTicksNS();
+        sendDatagram(packet);
+        controlResendTimer->start();
+
+        // Учитываем только новые события ввода, а не повторную публикацию того же состояния
+        Uint64 inputNs = joysticsState.timestampNs;
+        if(inputNs > lastRecordedInputNs && joysticsState.publishedNs >= inputNs){
+            lastRecordedInputNs = inputNs;
+            latInputToPublish.record(qint64(joysticsState.publishedNs - inputNs));
+            latPublishToHandler.record(qint64(handlerNs - joysticsState.publishedNs));
+            latHandlerToPacked.record(qint64(packedNs - handlerNs));
+            latPackedToSent.record(qint64(lastDatagramSentNs - packedNs));
+            latInputToSent.record(qint64(lastDatagramSentNs - inputNs));
+        }
+    }
 
     // qDebug() << "Forward thrust: " << cForwardThrust;
     // qDebug() << "Side thrust: " << cSideThrust;
@@ -347,199 +513,6 @@ void UdpHandler::onJoystickDataChange(const DualJoystickState joysticsState){
     // qDebug() << "Video recording: " << cRecording;
 }
 
-std::pair<QString, bool> findInputByInputName(const QJsonObject& rootObj, const QString& targetInputName) {
-    QJsonArray mappings = rootObj["inputs"].toArray();
-
-    for (const QJsonValue& val : mappings) {
-        QJsonObject obj = val.toObject();
-        if (obj["inputName"].toString() == targetInputName) {
-            QString input = obj["input"].toString();
-            bool inversion = obj["inversion"].toBool(false); // если поля нет — false
-            // qDebug() << input << " is inverted: " << inversion;
-            return std::make_pair(input, inversion);
-        }
-    }
-
-    // если не найдено — вернуть пустую строку и false
-    return std::make_pair("", false);
-}
-
-QVariant getInputValue(const QString &joyInput,
-                       const JoystickState &joyState){
-    QStringList parts = joyInput.split(' ', Qt::SkipEmptyParts);
-    QString inputType = parts[0];
-    int inputId = parts[1].toInt();
-    if(inputType.contains(("hat"), Qt::CaseInsensitive)){
-        QString hatAction = parts[0].split('_', Qt::SkipEmptyParts)[1];
-        // qDebug() << "Raw joy value:" << parts[0] <<" : "<< inputId << " : " << hatAction << " value: " << joyState.hats[inputId].contains(hatAction, Qt::CaseInsensitive);
-        return joyState.hats[inputId].contains(hatAction, Qt::CaseInsensitive);
-    }else if(inputType.contains(("button"), Qt::CaseInsensitive)){
-        // qDebug() << "Raw joy value:" << parts[0] <<" : "<< inputId << " value: " << joyState.buttons[inputId];
-        return joyState.buttons[inputId];
-    }else if(inputType.contains(("axis"), Qt::CaseInsensitive)){
-        // qDebug() << "Raw joy value:" << parts[0] <<" : "<< inputId << " value: " << joyState.axes[inputId];
-        return joyState.axes[inputId];
-    }
-    return 0;
-}
-
-float mapSInt16ToFloat(Sint16 x, Sint16 in_min, Sint16 in_max, float out_min, float out_max)
-{
-    if (in_max == in_min)
-        return out_min; // защита от деления на 0
-
-    return float(x - in_min) * (out_max - out_min) / float(in_max - in_min) + out_min;
-}
-
-float UdpHandler::getControlValue(QString action,
-                      const QMultiMap<QString, QString>& controlMap,
-                      const DualJoystickState& joysticsState,
-                      const QJsonObject& controlProfile,
-                      const QString inc,
-                      const QString dec) {
-    JoystickState primaryJoyState = joysticsState.primary;
-    JoystickState secondaryJoyState = joysticsState.secondary;
-
-    QList<QString> controls = controlMap.values(action);
-    QString primaryJoystick = controlProfile["devices"]["primary"].toString();
-    QString secondaryJoystick = controlProfile["devices"]["secondary"].toString();
-    bool isPrimaryOnline = !((primaryJoystick.contains("[offline]", Qt::CaseInsensitive)) || (primaryJoystick == "No Device"));
-    bool isSecondaryOnline = !((secondaryJoystick.contains("[offline]", Qt::CaseInsensitive)) || (secondaryJoystick == "No Device"));
-    if(primaryJoyState.deviceName != primaryJoystick) isPrimaryOnline = false;
-    if(secondaryJoyState.deviceName != secondaryJoystick) isSecondaryOnline = false;
-    if(! (isPrimaryOnline || isSecondaryOnline)){
-        return 0;
-    }
-    bool primaryIncBut = false;
-    bool primaryDecBut = false;
-    bool secondaryIncBut = false;
-    bool secondaryDecBut = false;
-    Sint16 primaryAxis = 0;
-    Sint16 secondaryAxis = 0;
-    //axis > buttons, primary > secondary
-
-    for(const QString& str : controls) {
-        if(str.contains("secondary", Qt::CaseInsensitive) &&
-           str.contains("but", Qt::CaseInsensitive) &&
-           str.contains(inc, Qt::CaseInsensitive) &&
-           isSecondaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    secondaryIncBut = inputValue.toBool();
-                }else{
-                    secondaryIncBut = false;
-                }
-            }
-        }
-
-        if(str.contains("secondary", Qt::CaseInsensitive) &&
-            str.contains("but", Qt::CaseInsensitive) &&
-            str.contains(dec, Qt::CaseInsensitive) &&
-            isSecondaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    secondaryDecBut = inputValue.toBool();
-                }else{
-                    secondaryDecBut = false;
-                }
-            }
-        }
-
-        if(str.contains("primary", Qt::CaseInsensitive) &&
-            str.contains("but", Qt::CaseInsensitive) &&
-            str.contains(inc, Qt::CaseInsensitive) &&
-            isPrimaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    primaryIncBut = inputValue.toBool();
-                }else{
-                    primaryIncBut = false;
-                }
-            }
-        }
-
-        if(str.contains("primary", Qt::CaseInsensitive) &&
-            str.contains("but", Qt::CaseInsensitive) &&
-            str.contains(dec, Qt::CaseInsensitive) &&
-            isPrimaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    primaryDecBut = inputValue.toBool();
-                }else{
-                    primaryDecBut = false;
-                }
-            }
-        }
-
-        if(str.contains("primary", Qt::CaseInsensitive) &&
-            !str.contains("but", Qt::CaseInsensitive) &&
-            isPrimaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            bool inversion = input.second;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    primaryAxis = 0;
-                }else{
-                    if(!inversion){
-                        primaryAxis = mapSInt16ToFloat(inputValue.value<Sint16>(), -32768, 32767, -100.0f, 100.0f);
-                    }else{
-                        primaryAxis = -mapSInt16ToFloat(inputValue.value<Sint16>(), -32768, 32767, -100.0f, 100.0f);
-                    }
-                }
-            }
-        }
-
-        if(str.contains("secondary", Qt::CaseInsensitive) &&
-            !str.contains("but", Qt::CaseInsensitive) &&
-            isSecondaryOnline) {
-            auto input = findInputByInputName(controlProfile, str);
-            QString joyInput = input.first;
-            bool inversion = input.second;
-            if (!joyInput.isEmpty()){
-                QVariant inputValue = getInputValue(joyInput, secondaryJoyState);
-                if (inputValue.typeId() == QMetaType::Bool) {
-                    secondaryAxis = 0;
-                }else{
-                    if(!inversion){
-                        secondaryAxis = mapSInt16ToFloat(inputValue.value<Sint16>(), -32768, 32767, -100.0f, 100.0f);
-                    }else{
-                        secondaryAxis = -mapSInt16ToFloat(inputValue.value<Sint16>(), -32768, 32767, -100.0f, 100.0f);
-                    }
-                }
-            }
-        }
-    }
-
-    float value = 0;
-    if (std::abs(primaryAxis) < DEADZONE){
-        primaryAxis = 0;
-    }
-    if (std::abs(secondaryAxis) < DEADZONE){
-        secondaryAxis = 0;
-    }
-
-    value = (secondaryIncBut - secondaryDecBut) * 100;
-    value = value == 0 ? ((primaryIncBut - primaryDecBut) * 100) : value;
-    value = secondaryAxis == 0 ? value : secondaryAxis;
-    value = primaryAxis == 0 ? value : primaryAxis;
-    value = value/100.0f;
-    return value;
-}
-
 bool UdpHandler::connectToROV(const QHostAddress &address, quint16 port){
     // setRemoteEndpoint(address, port);
     QByteArray packet;
@@ -552,10 +525,30 @@ bool UdpHandler::connectToROV(const QHostAddress &address, quint16 port){
 
 void UdpHandler::settingsChanged(){
     SettingsManager &settingsManager = SettingsManager::instance();
-    QString ip = settingsManager.getString("ip");
-    quint16 port = settingsManager.getInt("portEdit");
-    remoteAddress.setAddress(ip);
-    setRemoteEndpoint(remoteAddress, port);
+    if(hasEndpointOverride){
+        setRemoteEndpoint(overrideAddress, overridePort);
+    } else {
+        QString ip = settingsManager.getString("ip");
+        quint16 port = settingsManager.getInt("portEdit");
+        remoteAddress.setAddress(ip);
+        setRemoteEndpoint(remoteAddress, port);
+    }
+
+    linkMonitor->setThresholds(settingsManager.getInt("Link_timeout_ms", 1000),
+                               settingsManager.getDouble("Link_max_loss_percent", 20.0),
+                               settingsManager.getDouble("Link_max_rtt_ms", 250.0));
+    failsafeZeroThrust = settingsManager.getBool("Link_failsafe_zero_thrust", true);
+    int heartbeatMs = settingsManager.getInt("Link_heartbeat_ms", 50);
+    onlineTimer->setInterval(heartbeatMs > 0 ? heartbeatMs : 50);
+    int resendMs = settingsManager.getInt("Control_resend_ms", 20);
+    controlResendTimer->setInterval(resendMs > 0 ? resendMs : 20);
+}
+
+void UdpHandler::setEndpointOverride(const QHostAddress &address, quint16 port){
+    hasEndpointOverride = true;
+    overrideAddress = address;
+    overridePort = port;
+    setRemoteEndpoint(address, port);
 }
 
 void UdpHandler::masterChangedGui(const bool &masterState)
@@ -569,6 +562,30 @@ float UdpHandler::constrainf(const float value, const float lower_limit, const f
     return value;
 }
 
+ControlLatencyStats UdpHandler::latencyStats() const{
+    ControlLatencyStats stats;
+    stats.stages << latInputToPublish.stats("Ввод -> публикация")
+                 << latPublishToHandler.stats("Публикация -> обработчик")
+                 << latHandlerToPacked.stats("Обработчик -> пакет")
+                 << latPackedToSent.stats("Пакет -> отправка")
+                 << latInputToSent.stats("Ввод -> отправка (итого)");
+    return stats;
+}
+
+void UdpHandler::resetLatencyStats(){
+    latInputToPublish.reset();
+    latPublishToHandler.reset();
+    latHandlerToPacked.reset();
+    latPackedToSent.reset();
+    latInputToSent.reset();
+    qDebug() << "[UdpHandler] Статистика задержек управления сброшена";
+}
+
+void UdpHandler::resendControlData(){
+    if(onlineFlag)
+        sendDatagram(packControlData());
+}
+
 void UdpHandler::incrementValues(){
     float powLim = cPowerLimit + float(iPowerLimit/50.0f);
     cPowerLimit = constrainf(powLim, 0.0f, 1.0f);
@@ -580,19 +597,18 @@ void UdpHandler::updatePowerLimitFromGui(const int &powerLimit){
 }
 
 void UdpHandler::updatePID(){
-    SettingsManager &settingsManager = SettingsManager::instance();
-    RollKP = settingsManager.getDouble("RollkP");
-    RollKI = settingsManager.getDouble("RollkI");
-    RollKD = settingsManager.getDouble("RollkD");
-    PitchKP = settingsManager.getDouble("PitchkP");
-    PitchKI = settingsManager.getDouble("PitchkI");
-    PitchKD = settingsManager.getDouble("PitchkD");
-    YawKP = settingsManager.getDouble("YawkP");
-    YawKI = settingsManager.getDouble("YawkI");
-    YawKD = settingsManager.getDouble("YawkD");
-    DepthKP = settingsManager.getDouble("DepthkP");
-    DepthKI = settingsManager.getDouble("DepthkI");
-    DepthKD = settingsManager.getDouble("DepthkD");
+    RollKP = Settings::RollKP.value();
+    RollKI = Settings::RollKI.value();
+    RollKD = Settings::RollKD.value();
+    PitchKP = Settings::PitchKP.value();
+    PitchKI = Settings::PitchKI.value();
+    PitchKD = Settings::PitchKD.value();
+    YawKP = Settings::YawKP.value();
+    YawKI = Settings::YawKI.value();
+    YawKD = Settings::YawKD.value();
+    DepthKP = Settings::DepthKP.value();
+    DepthKI = Settings::DepthKI.value();
+    DepthKD = Settings::DepthKD.value();
     cUpdatePID = true;
 }
 
@@ -614,3 +630,9 @@ void UdpHandler::stabStateChanged(const bool& stabAllState,
     }
 }
 
+void UdpHandler::setHoldCorrection(float forward, float side){
+    holdForward = forward;
+    holdSide = side;
+    holdCorrectionNs = (forward != 0.0f || side != 0.0f) ? SDL_GetTicksNS() : 0;
+}
+
@@ -13,10 +13,17 @@
 #include <QFile>
 #include <QMultiMap>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <memory>
 #include "gamepadworker.h"
 #include "profilemanager.h"
 #include "udptelemetryparser.h"
 #include "SettingsManager.h"
+#include "linkmonitor.h"
+#include "latencyhistogram.h"
+#include "controlbindings.h"
 
 class UdpHandler : public QObject {
     Q_OBJECT
@@ -27,6 +34,7 @@ public:
                         GamepadWorker *gamepadWorker,
                         QObject *parent = nullptr);
     void sendDatagram(const QByteArray &data);
+    ControlLatencyStats latencyStats() const;
     float getPowerLimit();
     void getThrust(const float forward,
                    const float strafe,
@@ -48,22 +56,36 @@ signals:
     void onlineStateChanged(const bool &onlineState);
     void updatePowerLimit(const int &powerLimit);
     void lightStateChanged(const bool &lightState);
+    void linkStatsUpdated(const LinkStats &stats);
+    void linkFailsafeChanged(const bool &failsafe);
+    void controlLatencyUpdated(const ControlLatencyStats &stats);
+    void manualTranslationChanged(bool active);
 
 public slots:
     void settingsChanged();
     void masterChangedGui(const bool &masterState);
     void updatePowerLimitFromGui(const int &powerLimit);
     void updatePID();
+    void setEndpointOverride(const QHostAddress &address, quint16 port);
+    void resetLatencyStats();
     void stabStateChanged(const bool& stabAllState,
                           const bool& stabRollState,
                           const bool& stabPitchState,
                           const bool& stabYawState,
                           const bool& stabDepthState);
+    void setHoldCorrection(float forward, float side);
 
 private slots:
     void onReadyRead();
     void onJoystickDataChange(const DualJoystickState joysticsState);
     void incrementValues();
+    void resendControlData();
+    void onLinkFailsafeChanged(const bool &failsafe);
+    void rebuildBindings();
+    void onProfileChanged(const QJsonObject &profile);
+    void onProfileSwitched(const QJsonObject &profile);
+    void onConfigFileChanged(const QString &path);
+    void reloadChangedFiles();
 
 private:
 
@@ -76,28 +98,48 @@ private:
     GamepadWorker *gamepadWorker;
 
     TelemetryPacket telemetryData;
-    QMultiMap<QString, QString> inputToMachine;
-    QMultiMap<QString, QString> machineToInput;
 
-    float getControlValue(QString action,
-                          const QMultiMap<QString, QString>& controlMap,
-                          const DualJoystickState& joysticsState,
-                          const QJsonObject& controlProfile,
-                          const QString inc = "inc",
-                          const QString dec = "dec");
+    // Собранная таблица привязок; подменяется целиком после пересборки в фоне
+    std::shared_ptr<const ControlBindings> bindings;
+    quint64 bindingsGeneration = 0;
+    QJsonObject lastGoodMapping;
+    // Снимок профиля из сигналов ProfileManager: сам профиль правится в потоке интерфейса
+    QJsonObject currentProfile;
+    QString mappingFilePath;
+    QString watchedProfilePath;
+    QFileSystemWatcher *configWatcher;
+    QTimer *configReloadTimer;
+    QSet<QString> changedConfigPaths;
 
     void setRemoteEndpoint(const QHostAddress &address, quint16 port);
 
-    void loadMappingsFromJson(const QString& filePath);
+    static bool loadMappingsFromJson(const QString& filePath, QJsonObject &mapping);
+    void watchFile(const QString &path);
     void onlineTimerTick();
 
-    const float DEADZONE = 5;
-
     QByteArray packControlData();
     QTimer *onlineTimer;
-    qint64 lastOnlineTime;
+    QElapsedTimer reconnectProbeTimer;
+    LinkMonitor *linkMonitor;
+    bool linkFailsafe;
+    bool failsafeZeroThrust;
+
+    bool hasEndpointOverride = false;
+    QHostAddress overrideAddress;
+    quint16 overridePort = 0;
 
     QTimer *incremental;
+    QTimer *controlResendTimer;
+
+    // Задержка тракта управления: событие джойстика -> публикация -> обработчик -> пакет -> отправка
+    LatencyHistogram latInputToPublish;
+    LatencyHistogram latPublishToHandler;
+    LatencyHistogram latHandlerToPacked;
+    LatencyHistogram latPackedToSent;
+    LatencyHistogram latInputToSent;
+    Uint64 lastRecordedInputNs = 0;
+    Uint64 lastDatagramSentNs = 0;
+    QTimer *latencyReportTimer;
 
     SettingsManager *settingsManager = nullptr;
 
@@ -141,4 +183,11 @@ private:
     bool recordingValueChangeFlag;
     bool takeFrameValueChangeFlag;
     bool prevRecordingButtonState;
+
+    // Коррекция удержания позиции по визуальной одометрии; без обновления дольше тайм-аута не применяется
+    static const Uint64 HOLD_CORRECTION_TIMEOUT_NS = 300000000;
+    float holdForward = 0;
+    float holdSide = 0;
+    Uint64 holdCorrectionNs = 0;
+    bool manualTranslation = false;
 };
@@ -29,3 +29,23 @@ bool UdpTelemetryParser::parse(const QByteArray &data, TelemetryPacket &packet)
     emit telemetryReceived(packet);
     return true;
 }
+
+QByteArray UdpTelemetryParser::pack(const TelemetryPacket &packet)
+{
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << packet.flags;
+    stream << packet.roll;
+    stream << packet.pitch;
+    stream << packet.yaw;
+    stream << packet.depth;
+    stream << packet.batVoltage;
+    stream << packet.batCharge;
+    stream << packet.cameraAngle;
+    stream << packet.rollSP;
+    stream << packet.pitchSP;
+    return buffer;
+}
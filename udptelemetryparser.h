@@ -25,6 +25,7 @@ public:
     explicit UdpTelemetryParser(QObject *parent = nullptr);
 
     bool parse(const QByteArray &data, TelemetryPacket &packet);
+    static QByteArray pack(const TelemetryPacket &packet);
 
 signals:
     void telemetryReceived(const TelemetryPacket &packet);
@@ -1,4 +1,5 @@
 #include "video_recorder.h"
+#include "eventlog.h"
 
 VideoRecorder::VideoRecorder(RecordFrameInfo* recordInfo, QObject* parent)
     : QObject(parent), m_recordInfo(recordInfo), m_isRecording(false), m_recordInterval(30), m_storedVideoFilesLimit(10) {}
@@ -184,6 +185,7 @@ void VideoRecorder::stopRecording() {
     if (videoWriter.isOpened()) {
         videoWriter.release();
         qDebug() << "Запись видео остановлена для камеры" << m_recordInfo->name;
+        EventLog::record(EventId::RecordingStopped, {m_recordInfo->name, quint64(m_recordInfo->writtenFrames)});
     }
 }
 
@@ -214,10 +216,21 @@ void VideoRecorder::recordFrame() {
         }
     }
 
+    // Кадр другого размера (сменились ROI или биннинг) - новый сегмент с новым разрешением
+    if (!frame.empty() && videoWriter.isOpened() && frame.size() != m_segmentResolution) {
+        qDebug() << "Размер кадра камеры" << m_recordInfo->name << "изменился на" << frame.cols << "x" << frame.rows
+                 << ", начинается новый сегмент";
+        videoWriter.release();
+        emit recordingFinished();
+        startNewSegment();
+        m_timer.restart();
+    }
+
     if (!frame.empty() && videoWriter.isOpened()) {
         cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
         try {
             videoWriter.write(frame);
+            m_recordInfo->writtenFrames++;
         } catch (const cv::Exception& e) {
             QString errorMsg = QString("Ошибка записи кадра для камеры %1: %2")
                                    .arg(m_recordInfo->name).arg(e.what());
@@ -249,6 +262,7 @@ void VideoRecorder::startNewSegment() {
         }
         videoResolution = m_recordInfo->img.size();
     }
+    m_segmentResolution = videoResolution;
 
     videoWriter.open(filePath, fourccCode, realFPS, videoResolution);
     if (!videoWriter.isOpened()) {
@@ -263,6 +277,8 @@ void VideoRecorder::startNewSegment() {
 
     qDebug() << "Запись видео начата для файла:" << QString::fromStdString(fileName)
              << ", FPS:" << realFPS << ", Разрешение:" << videoResolution.width << "x" << videoResolution.height;
+    EventLog::record(EventId::RecordingSegmentStarted, {m_recordInfo->name, QString::fromStdString(fileName),
+                                                        videoResolution.width, videoResolution.height});
     emit recordingStarted();
 }
 
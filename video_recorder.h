@@ -42,6 +42,7 @@ private:
     std::string generateTimeDirectoryName();
     RecordFrameInfo* m_recordInfo;
     cv::VideoWriter videoWriter;
+    cv::Size m_segmentResolution;     // Разрешение текущего сегмента
     QElapsedTimer m_timer;
     std::string fileName;
     bool m_isRecording;
@@ -0,0 +1,232 @@
+#include "video_stabilizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+std::atomic<float> VideoStabilizer::s_rollDeg{0};
+std::atomic<float> VideoStabilizer::s_pitchDeg{0};
+std::atomic<int64_t> VideoStabilizer::s_attitudeNs{0};
+
+VideoStabilizer::VideoStabilizer(const StabilizationSettings& settings)
+    : m_settings(settings) {
+    m_settings.lookahead = std::clamp(settings.lookahead, 0, 30);
+    m_settings.smoothingFrames = std::max(1.0, settings.smoothingFrames);
+    m_settings.crop = std::clamp(settings.crop, 0.0, 0.25);
+    m_history = std::min(90, int(std::ceil(3 * m_settings.smoothingFrames)));
+}
+
+void VideoStabilizer::setAttitude(float rollDeg, float pitchDeg) {
+    s_rollDeg = rollDeg;
+    s_pitchDeg = pitchDeg;
+    s_attitudeNs = steadyNs();
+}
+
+void VideoStabilizer::reset() {
+    m_previousGray.release();
+    m_previousPoints.clear();
+    m_hasPreviousAttitude = false;
+    m_position = cv::Vec3d(0, 0, 0);
+    m_trajectory.clear();
+    for (Pending& pending : m_pending) {
+        m_spare.push_back(pending.stream);
+        if (!pending.shared) m_spare.push_back(pending.record);
+    }
+    m_pending.clear();
+}
+
+bool VideoStabilizer::process(const cv::Mat& bgr, const cv::Mat& streamFrame, const cv::Mat& recordFrame) {
+    CV_Assert(bgr.type() == CV_8UC3);
+
+    const cv::Size workSize(m_settings.workWidth, std::max(1, int(std::lround(double(m_settings.workWidth) * bgr.rows / bgr.cols))));
+    cv::Mat reduced;
+    cv::resize(bgr, reduced, workSize, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(reduced, m_gray, cv::COLOR_BGR2GRAY);
+
+    // Смена размера кадра (ROI, биннинг) начинает траекторию заново
+    if (bgr.size() != m_frameSize) {
+        reset();
+        m_frameSize = bgr.size();
+    }
+
+    const Motion prior = attitudePrior(workSize);
+    Motion motion;
+    if (!m_previousGray.empty())
+        motion = estimateMotion(m_gray, prior);
+    cv::swap(m_previousGray, m_gray);
+    m_position += cv::Vec3d(motion.dx, motion.dy, motion.da);
+
+    Pending pending;
+    pending.position = m_position;
+    pending.shared = streamFrame.data == recordFrame.data;
+    if (m_settings.stream || pending.shared) {
+        pending.stream = takeBuffer();
+        streamFrame.copyTo(pending.stream);
+    }
+    if (m_settings.record && !pending.shared) {
+        pending.record = takeBuffer();
+        recordFrame.copyTo(pending.record);
+    }
+    m_pending.push_back(pending);
+    m_trajectory.push_back(m_position);
+    while (int(m_trajectory.size()) > m_history + 1 + m_settings.lookahead)
+        m_trajectory.pop_front();
+
+    if (int(m_pending.size()) <= m_settings.lookahead)
+        return false;
+    Pending output = m_pending.front();
+    m_pending.pop_front();
+
+    // Поправка переводит кадр с фактической траектории на сглаженную
+    const int index = int(m_trajectory.size()) - 1 - m_settings.lookahead;
+    const cv::Vec3d correction = smoothedPosition(index) - output.position;
+    const double scale = double(bgr.cols) / workSize.width;
+    const double maxShiftX = m_settings.crop * bgr.cols;
+    const double maxShiftY = m_settings.crop * bgr.rows;
+    const double maxAngle = m_settings.maxAngleDeg * CV_PI / 180.0;
+    const double dx = std::clamp(correction[0] * scale, -maxShiftX, maxShiftX);
+    const double dy = std::clamp(correction[1] * scale, -maxShiftY, maxShiftY);
+    const double da = std::clamp(correction[2], -maxAngle, maxAngle);
+
+    // Поворот вокруг центра, сдвиг, затем увеличение на поле crop: p' = zR(p - c) + c + z*t
+    const double zoom = 1.0 / (1.0 - 2 * m_settings.crop);
+    const double cx = bgr.cols / 2.0;
+    const double cy = bgr.rows / 2.0;
+    const double a = zoom * std::cos(da);
+    const double b = zoom * std::sin(da);
+    const cv::Matx23d transform(a, -b, cx + zoom * dx - (a * cx - b * cy),
+                                b, a, cy + zoom * dy - (b * cx + a * cy));
+    if (m_settings.stream)
+        warp(output.stream, m_streamOut, transform);
+    if (m_settings.record) {
+        if (output.shared && m_settings.stream)
+            m_recordOut = m_streamOut;
+        else
+            warp(output.shared ? output.stream : output.record, m_recordOut, transform);
+    }
+
+    if (!output.stream.empty()) m_spare.push_back(output.stream);
+    if (!output.record.empty()) m_spare.push_back(output.record);
+    return true;
+}
+
+VideoStabilizer::Motion VideoStabilizer::attitudePrior(const cv::Size& workSize) {
+    Motion prior;
+    const int64_t attitudeNs = s_attitudeNs;
+    const bool fresh = attitudeNs != 0 && steadyNs() - attitudeNs < int64_t(STALE_ATTITUDE_MS) * 1000000;
+    if (!fresh) {
+        m_hasPreviousAttitude = false;
+        return prior;
+    }
+    const float roll = s_rollDeg;
+    const float pitch = s_pitchDeg;
+    if (m_hasPreviousAttitude) {
+        // Крен поворачивает кадр вокруг оси камеры, дифферент сдвигает его по вертикали на f*tg(угла)
+        const double focal = workSize.width / 2.0 / std::tan(m_settings.hfovDeg * CV_PI / 360.0);
+        prior.da = -m_settings.rollSign * (roll - m_previousRoll) * CV_PI / 180.0;
+        prior.dy = m_settings.pitchSign * focal * std::tan((pitch - m_previousPitch) * CV_PI / 180.0);
+    }
+    m_previousRoll = roll;
+    m_previousPitch = pitch;
+    m_hasPreviousAttitude = true;
+    return prior;
+}
+
+VideoStabilizer::Motion VideoStabilizer::estimateMotion(const cv::Mat& gray, const Motion& prior) {
+    cv::goodFeaturesToTrack(m_previousGray, m_previousPoints, m_settings.features, 0.01, gray.cols / 30.0, cv::noArray(), 7);
+    if (int(m_previousPoints.size()) < MIN_INLIERS)
+        return prior;
+
+    // Приближение по телеметрии - начальная точка поиска: при быстром крене смещение больше окна поиска
+    const cv::Point2d center(gray.cols / 2.0, gray.rows / 2.0);
+    const double c = std::cos(prior.da);
+    const double s = std::sin(prior.da);
+    std::vector<cv::Point2f> points;
+    points.reserve(m_previousPoints.size());
+    for (const cv::Point2f& point : m_previousPoints) {
+        const double x = point.x - center.x;
+        const double y = point.y - center.y;
+        points.emplace_back(float(c * x - s * y + center.x + prior.dx), float(s * x + c * y + center.y + prior.dy));
+    }
+    std::vector<uchar> status;
+    std::vector<float> errors;
+    cv::calcOpticalFlowPyrLK(m_previousGray, gray, m_previousPoints, points, status, errors, cv::Size(21, 21), 3,
+                             cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03),
+                             cv::OPTFLOW_USE_INITIAL_FLOW);
+
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (!status[i]) continue;
+        from.push_back(m_previousPoints[i]);
+        to.push_back(points[i]);
+    }
+    if (int(from.size()) < MIN_INLIERS)
+        return prior;
+    cv::Mat inliers;
+    const cv::Mat affine = cv::estimateAffinePartial2D(from, to, inliers, cv::RANSAC, 2.0);
+    if (affine.empty() || cv::countNonZero(inliers) < MIN_INLIERS)
+        return prior;
+
+    // Сдвиг центра кадра и поворот; изменение масштаба (ход вперёд) не стабилизируется
+    const cv::Matx23d M = affine;
+    Motion motion;
+    motion.dx = M(0, 0) * center.x + M(0, 1) * center.y + M(0, 2) - center.x;
+    motion.dy = M(1, 0) * center.x + M(1, 1) * center.y + M(1, 2) - center.y;
+    motion.da = std::atan2(M(1, 0), M(0, 0));
+    return motion;
+}
+
+cv::Vec3d VideoStabilizer::smoothedPosition(int index) const {
+    // Взвешенная прямая по окну: при равномерном развороте камеры сглаженная траектория
+    // идёт вместе с фактической, а не отстаёт от неё
+    const double sigma = m_settings.smoothingFrames;
+    double sumW = 0;
+    double sumT = 0;
+    double sumTT = 0;
+    cv::Vec3d sumP(0, 0, 0);
+    cv::Vec3d sumTP(0, 0, 0);
+    for (int i = 0; i < int(m_trajectory.size()); ++i) {
+        const double t = i - index;
+        const double w = std::exp(-t * t / (2 * sigma * sigma));
+        sumW += w;
+        sumT += w * t;
+        sumTT += w * t * t;
+        sumP += w * m_trajectory[i];
+        sumTP += w * t * m_trajectory[i];
+    }
+    const cv::Vec3d meanP = sumP / sumW;
+    const double meanT = sumT / sumW;
+    const double variance = sumTT / sumW - meanT * meanT;
+    if (variance < 1e-6)
+        return meanP;
+    const cv::Vec3d slope = (sumTP / sumW - meanT * meanP) / variance;
+    return meanP - meanT * slope;
+}
+
+void VideoStabilizer::warp(const cv::Mat& source, cv::Mat& destination, const cv::Matx23d& transform) const {
+    destination.create(source.size(), source.type());
+    // Каждая полоса строк - отдельный warpAffine в свою часть кадра: сдвиг преобразования на начало полосы
+    cv::parallel_for_(cv::Range(0, source.rows), [&](const cv::Range& range) {
+        cv::Mat stripe = destination.rowRange(range.start, range.end);
+        cv::Matx23d stripeTransform = transform;
+        stripeTransform(1, 2) -= range.start;
+        cv::warpAffine(source, stripe, stripeTransform, stripe.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    }, std::max(1, source.rows / 64));
+}
+
+cv::Mat VideoStabilizer::takeBuffer() {
+    if (m_spare.empty())
+        return cv::Mat();
+    cv::Mat buffer = m_spare.back();
+    m_spare.pop_back();
+    return buffer;
+}
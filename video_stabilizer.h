@@ -0,0 +1,95 @@
+#ifndef VIDEO_STABILIZER_H
+#define VIDEO_STABILIZER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Настройки стабилизации изображения. Окно пилота не стабилизируется: задержка
+// упреждения допустима для трансляции и записи, но не для управления.
+struct StabilizationSettings {
+    bool stream = false;
+    bool record = false;
+
+    int lookahead = 3;              // Кадров упреждения: на столько отстаёт выровненный кадр
+    double smoothingFrames = 10;    // Сигма сглаживания траектории, кадров
+    double crop = 0.06;             // Доля кадра с каждой стороны, которая уходит под сдвиг
+    double maxAngleDeg = 5;         // Наибольший доворот кадра
+    int workWidth = 320;            // Ширина кадра для оценки движения
+    int features = 200;
+    double hfovDeg = 80;            // Горизонтальный угол обзора камеры, для пересчёта дифферента в пиксели
+    int rollSign = 1;               // Направление поворота кадра при крене; 0 - крен не используется
+    int pitchSign = 1;              // Направление сдвига кадра при дифференте; 0 - дифферент не используется
+
+    bool enabled() const { return stream || record; }
+};
+
+// Стабилизация кадров трансляции и записи.
+// Движение между соседними кадрами - подобие (сдвиг и поворот) по точкам на уменьшенном кадре.
+// Крен и дифферент из телеметрии дают начальное приближение для отслеживания точек и
+// замещают оценку, когда точек мало (толща воды без деталей). Накопленная траектория
+// сглаживается локальной линейной регрессией с гауссовыми весами по прошлым кадрам и
+// lookahead будущим: выровненный кадр выдаётся с постоянной задержкой в lookahead кадров,
+// а плавный разворот камеры не копит отставания. Доворот ограничен полем crop, кадр
+// немного увеличен, чтобы края не попадали в кадр. Поворот полного кадра разбит на полосы
+// строк для cv::parallel_for_. Состояние своё у каждой камеры.
+class VideoStabilizer {
+public:
+    explicit VideoStabilizer(const StabilizationSettings& settings);
+
+    // bgr - кадр для оценки движения, streamFrame и recordFrame - кадры потребителей (могут совпадать).
+    // true, когда готовы выровненные кадры, отстающие на lookahead кадров.
+    bool process(const cv::Mat& bgr, const cv::Mat& streamFrame, const cv::Mat& recordFrame);
+    const cv::Mat& stream() const { return m_streamOut; }
+    const cv::Mat& record() const { return m_recordOut; }
+
+    // Ориентация аппарата из телеметрии, общая для всех камер. Вызывается из потока интерфейса.
+    static void setAttitude(float rollDeg, float pitchDeg);
+
+private:
+    static const int STALE_ATTITUDE_MS = 500;  // Более старая телеметрия не используется
+    static const int MIN_INLIERS = 12;
+
+    struct Motion {
+        double dx = 0;  // Пиксели рабочего кадра
+        double dy = 0;
+        double da = 0;  // Радианы
+    };
+    struct Pending {
+        cv::Mat stream;
+        cv::Mat record;
+        bool shared = false;    // Трансляция и запись получают один и тот же кадр
+        cv::Vec3d position;     // Накопленная траектория на этом кадре
+    };
+
+    void reset();
+    Motion attitudePrior(const cv::Size& workSize);
+    Motion estimateMotion(const cv::Mat& gray, const Motion& prior);
+    cv::Vec3d smoothedPosition(int index) const;
+    void warp(const cv::Mat& source, cv::Mat& destination, const cv::Matx23d& transform) const;
+    cv::Mat takeBuffer();
+
+    StabilizationSettings m_settings;
+    int m_history;                      // Прошлых кадров в окне сглаживания
+    cv::Size m_frameSize;
+    cv::Mat m_gray;
+    cv::Mat m_previousGray;
+    std::vector<cv::Point2f> m_previousPoints;
+    float m_previousRoll = 0;
+    float m_previousPitch = 0;
+    bool m_hasPreviousAttitude = false;
+    cv::Vec3d m_position{0, 0, 0};
+    std::deque<cv::Vec3d> m_trajectory; // Прошлые кадры окна и кадры в ожидании
+    std::deque<Pending> m_pending;      // Кадры, ждущие упреждения
+    std::vector<cv::Mat> m_spare;       // Освободившиеся буферы кадров
+    cv::Mat m_streamOut;
+    cv::Mat m_recordOut;
+
+    static std::atomic<float> s_rollDeg;
+    static std::atomic<float> s_pitchDeg;
+    static std::atomic<int64_t> s_attitudeNs;  // 0 - телеметрии не было
+};
+
+#endif // VIDEO_STABILIZER_H
@@ -1,4 +1,5 @@
 #include "video_streamer.h"
+#include "eventlog.h"
 
 VideoStreamer::VideoStreamer(StreamFrameInfo* streamInfo, int port, QObject* parent)
     : QObject(parent), m_streamInfo(streamInfo), m_port(port), m_server(new QTcpServer(this)), m_isStreaming(false) {
@@ -69,6 +70,7 @@ void VideoStreamer::handleNewConnection() {
         m_clients.remove(client);
         client->deleteLater();
         qDebug() << "Клиент отключился от стриминга камеры" << m_streamInfo->name;
+        EventLog::record(EventId::StreamClientDisconnected, {m_streamInfo->name, qint64(m_clients.size())});
     });
 
     connect(client, &QTcpSocket::readyRead, this, [=]() {
@@ -78,6 +80,7 @@ void VideoStreamer::handleNewConnection() {
             m_clients.insert(client);
             sendMJPEGHeader(client);
             qDebug() << "Клиент подключился к стримингу камеры" << m_streamInfo->name;
+            EventLog::record(EventId::StreamClientConnected, {m_streamInfo->name, qint64(m_clients.size())});
             streamFrames(client);
         } else {
             QString errorMsg = QString("Неверный запрос для камеры %1: %2").arg(m_streamInfo->name).arg(requestStr);
@@ -137,6 +140,8 @@ void VideoStreamer::streamFrames(QTcpSocket* client) {
 
                 client->write(frameData);
                 client->flush();
+                m_streamInfo->sentFrames++;
+                m_streamInfo->sentBytes += frameData.size();
             } catch (const cv::Exception& e) {
                 QString errorMsg = QString("Ошибка кодирования кадра для стриминга камеры %1: %2")
                                        .arg(m_streamInfo->name).arg(e.what());
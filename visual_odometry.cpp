@@ -0,0 +1,488 @@
+#include "visual_odometry.h"
+#include "camera_backend.h"
+#include "SettingsManager.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double wrapDegrees(double angle) {
+    angle = std::fmod(angle + 180.0, 360.0);
+    if (angle < 0) angle += 360.0;
+    return angle - 180.0;
+}
+
+// Кадр камеры (BGR) -> уменьшенный кадр в оттенках серого для отслеживания
+cv::Mat workFrame(const cv::Mat& bgr, int width) {
+    const cv::Size workSize(width, qRound(double(width) * bgr.rows / bgr.cols));
+    cv::Mat reduced, gray;
+    cv::resize(bgr, reduced, workSize, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(reduced, gray, cv::COLOR_BGR2GRAY);
+    return gray;
+}
+
+} // namespace
+
+OdometrySettings OdometrySettings::load() {
+    SettingsManager& settings = SettingsManager::instance();
+    OdometrySettings s;
+    s.cameraName = settings.getString("Odometry_camera", s.cameraName);
+    s.rateHz = qBound(1.0, settings.getDouble("Odometry_rate_hz", s.rateHz), 60.0);
+    s.workWidth = qBound(160, settings.getInt("Odometry_work_width", s.workWidth), 1280);
+    s.features = qBound(30, settings.getInt("Odometry_features", s.features), 2000);
+    s.minFeatures = qBound(10, settings.getInt("Odometry_min_features", s.minFeatures), s.features);
+    s.minInliers = qBound(6, settings.getInt("Odometry_min_inliers", s.minInliers), s.minFeatures);
+    s.hfovDeg = qBound(10.0, settings.getDouble("Odometry_hfov_deg", s.hfovDeg), 170.0);
+    s.altitudeM = qMax(0.1, settings.getDouble("Odometry_altitude_m", s.altitudeM));
+    s.yawSign = qBound(-1, settings.getInt("Odometry_yaw_sign", s.yawSign), 1);
+    s.tiltSign = qBound(-1, settings.getInt("Odometry_tilt_sign", s.tiltSign), 1);
+    s.budgetMs = qMax(1.0, settings.getDouble("Odometry_budget_ms", s.budgetMs));
+    s.holdKp = qMax(0.0, settings.getDouble("Odometry_hold_kp", s.holdKp));
+    s.holdKi = qMax(0.0, settings.getDouble("Odometry_hold_ki", s.holdKi));
+    s.holdMaxThrust = qBound(0.0, settings.getDouble("Odometry_hold_max_thrust", s.holdMaxThrust), 1.0);
+    s.holdDeadbandM = qMax(0.0, settings.getDouble("Odometry_hold_deadband_m", s.holdDeadbandM));
+    return s;
+}
+
+OdometryEstimator::OdometryEstimator(const OdometrySettings& settings)
+    : m_settings(settings), m_features(settings.features) {
+}
+
+void OdometryEstimator::reset() {
+    m_previous.release();
+    m_keyPoints.clear();
+    m_points.clear();
+    m_northM = 0;
+    m_eastM = 0;
+    m_headingDeg = 0;
+}
+
+void OdometryEstimator::startKeyframe(const cv::Mat& gray, const OdometryAttitude& attitude) {
+    m_previous = gray;
+    cv::goodFeaturesToTrack(gray, m_keyPoints, m_features, 0.01, gray.cols / 40.0, cv::noArray(), 7);
+    m_points = m_keyPoints;
+    m_keyAttitude = attitude;
+    m_keyNorthM = m_northM;
+    m_keyEastM = m_eastM;
+    m_keyHeadingDeg = m_headingDeg;
+}
+
+bool OdometryEstimator::update(const cv::Mat& gray, const OdometryAttitude& attitude, OdometryEstimate& estimate) {
+    auto fill = [&](bool tracking, int inliers) {
+        estimate.tracking = tracking;
+        estimate.northM = m_northM;
+        estimate.eastM = m_eastM;
+        estimate.headingDeg = m_headingDeg;
+        estimate.inliers = inliers;
+        return tracking;
+    };
+    estimate.keyframe = false;
+
+    if (m_previous.empty() || m_previous.size() != gray.size()) {
+        m_focal = gray.cols / 2.0 / std::tan(m_settings.hfovDeg * CV_PI / 360.0);
+        if (attitude.valid) m_headingDeg = attitude.yawDeg;
+        startKeyframe(gray, attitude);
+        estimate.keyframe = true;
+        return fill(int(m_keyPoints.size()) >= m_settings.minInliers, int(m_keyPoints.size()));
+    }
+
+    // Потеря привязки: положение остаётся прежним, отсчёт продолжается от нового опорного кадра
+    auto lose = [&](int inliers) {
+        startKeyframe(gray, attitude);
+        estimate.keyframe = true;
+        return fill(false, inliers);
+    };
+    if (int(m_points.size()) < m_settings.minInliers)
+        return lose(0);
+
+    std::vector<cv::Point2f> next;
+    std::vector<uchar> status;
+    std::vector<float> errors;
+    cv::calcOpticalFlowPyrLK(m_previous, gray, m_points, next, status, errors, cv::Size(21, 21), 3);
+    m_previous = gray;
+
+    std::vector<cv::Point2f> keyPoints;
+    std::vector<cv::Point2f> points;
+    keyPoints.reserve(next.size());
+    points.reserve(next.size());
+    for (size_t i = 0; i < next.size(); ++i) {
+        if (!status[i] || next[i].x < 0 || next[i].y < 0 || next[i].x >= gray.cols || next[i].y >= gray.rows)
+            continue;
+        keyPoints.push_back(m_keyPoints[i]);
+        points.push_back(next[i]);
+    }
+    if (int(points.size()) < m_settings.minInliers)
+        return lose(int(points.size()));
+
+    // Ожидаемое положение точек опорного кадра при одном только повороте аппарата:
+    // курс поворачивает кадр вокруг центра, крен и дифферент сдвигают его на f*tg(угла)
+    const cv::Point2d center(gray.cols / 2.0, gray.rows / 2.0);
+    double rotation = 0;
+    cv::Point2d shift(0, 0);
+    if (attitude.valid && m_keyAttitude.valid) {
+        rotation = -m_settings.yawSign * wrapDegrees(attitude.yawDeg - m_keyAttitude.yawDeg) * CV_PI / 180.0;
+        shift.x = m_settings.tiltSign * m_focal * std::tan((attitude.rollDeg - m_keyAttitude.rollDeg) * CV_PI / 180.0);
+        shift.y = m_settings.tiltSign * m_focal * std::tan((attitude.pitchDeg - m_keyAttitude.pitchDeg) * CV_PI / 180.0);
+    }
+    const double c = std::cos(rotation);
+    const double s = std::sin(rotation);
+    std::vector<cv::Point2f> predicted;
+    predicted.reserve(keyPoints.size());
+    for (const cv::Point2f& point : keyPoints) {
+        const double x = point.x - center.x;
+        const double y = point.y - center.y;
+        predicted.emplace_back(float(c * x - s * y + center.x + shift.x), float(s * x + c * y + center.y + shift.y));
+    }
+
+    cv::Mat inlierMask;
+    const cv::Mat affine = cv::estimateAffinePartial2D(predicted, points, inlierMask, cv::RANSAC, 1.5);
+    if (affine.empty())
+        return lose(0);
+    const int inliers = cv::countNonZero(inlierMask);
+    if (inliers < m_settings.minInliers)
+        return lose(inliers);
+
+    // Сдвиг центра кадра, не объяснённый поворотом, - перемещение камеры в осях текущего кадра
+    const cv::Matx23d M = affine;
+    const cv::Point2d t(M(0, 0) * center.x + M(0, 1) * center.y + M(0, 2) - center.x,
+                        M(1, 0) * center.x + M(1, 1) * center.y + M(1, 2) - center.y);
+    if (attitude.valid)
+        m_headingDeg = attitude.yawDeg;
+    else if (m_settings.yawSign != 0)
+        m_headingDeg = wrapDegrees(m_keyHeadingDeg - m_settings.yawSign * std::atan2(M(1, 0), M(0, 0)) * 180.0 / CV_PI);
+
+    // Дно уходит назад по кадру (вниз), когда аппарат идёт вперёд, и влево, когда вправо
+    const double metresPerPixel = m_settings.altitudeM / m_focal;
+    const double forward = t.y * metresPerPixel;
+    const double right = -t.x * metresPerPixel;
+    const double heading = m_headingDeg * CV_PI / 180.0;
+    m_northM = m_keyNorthM + forward * std::cos(heading) - right * std::sin(heading);
+    m_eastM = m_keyEastM + forward * std::sin(heading) + right * std::cos(heading);
+
+    m_keyPoints.swap(keyPoints);
+    m_points.swap(points);
+    // Опорный кадр меняется, только когда точки уходят из кадра
+    if (int(m_points.size()) < m_settings.minFeatures || std::hypot(t.x, t.y) > 0.25 * gray.cols) {
+        startKeyframe(gray, attitude);
+        estimate.keyframe = true;
+    }
+    return fill(true, inliers);
+}
+
+VisualOdometry::VisualOdometry(QObject* parent)
+    : QObject(parent), m_stage(new LatestFrameStage(QThread::NormalPriority, this)) {
+    qRegisterMetaType<OdometryState>("OdometryState");
+    // Обычный приоритет: коррекция идёт в управление, а нагрузку ограничивает бюджет времени
+    connect(m_stage, &LatestFrameStage::tick, this, &VisualOdometry::tick);
+    m_settings = OdometrySettings::load();
+}
+
+VisualOdometry::~VisualOdometry() {
+    m_stage->stop();
+    m_stage->waitForDone();
+}
+
+void VisualOdometry::setHoldEnabled(bool enabled) {
+    if (enabled == m_hold) return;
+    m_hold = enabled;
+
+    if (!enabled) {
+        m_stage->stop();
+        m_frame = QImage();
+        m_estimator.reset();
+        m_state.running = false;
+        m_state.hold = false;
+        m_state.tracking = false;
+        m_state.forward = 0;
+        m_state.side = 0;
+        emit holdCorrection(0, 0);
+        emit stateUpdated(m_state);
+        qDebug() << "Удержание позиции выключено";
+        return;
+    }
+
+    m_settings = OdometrySettings::load();
+    m_estimator = std::make_shared<OdometryEstimator>(m_settings);
+    m_frame = QImage();
+    m_state = OdometryState();
+    m_state.running = true;
+    m_state.hold = true;
+    m_state.features = m_settings.features;
+    m_rateStartNs = CameraBackend::monotonicNs();
+    m_rateStartProcessed = 0;
+    m_previousEstimateNs = 0;
+    resetHold();
+    // Нижняя камера не входит в стандартный набор и подключается по требованию
+    emit cameraRequired(m_settings.cameraName);
+    m_stage->start(m_settings.rateHz);
+    emit stateUpdated(m_state);
+    qDebug() << "Удержание позиции включено: камера" << m_settings.cameraName << "," << m_settings.rateHz << "Гц";
+}
+
+void VisualOdometry::setPilotOverride(bool active) {
+    m_pilotOverride = active;
+}
+
+void VisualOdometry::resetHold() {
+    m_originValid = false;
+    m_integralForward = 0;
+    m_integralSide = 0;
+}
+
+void VisualOdometry::submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs) {
+    if (!m_stage->isActive() || cameraName != m_settings.cameraName) return;
+    m_frame = image;
+    m_frameNs = timestampNs;
+}
+
+void VisualOdometry::setTelemetry(float rollDeg, float pitchDeg, float yawDeg) {
+    m_rollDeg = rollDeg;
+    m_pitchDeg = pitchDeg;
+    m_yawDeg = yawDeg;
+    m_hasTelemetry = true;
+}
+
+void VisualOdometry::tick() {
+    if (m_frame.isNull()) return;
+
+    Input input;
+    input.image = m_frame;
+    input.frameNs = m_frameNs;
+    input.attitude.rollDeg = m_rollDeg;
+    input.attitude.pitchDeg = m_pitchDeg;
+    input.attitude.yawDeg = m_yawDeg;
+    input.attitude.valid = m_hasTelemetry;
+    const std::shared_ptr<OdometryEstimator> estimator = m_estimator;
+    const int workWidth = m_settings.workWidth;
+    m_stage->process(m_frameNs, [estimator, input, workWidth]() {
+        const qint64 startNs = CameraBackend::monotonicNs();
+        Output output;
+        output.frameNs = input.frameNs;
+        const QImage& image = input.image;
+        if (image.format() != QImage::Format_RGB888) {
+            output.error = "неподдерживаемый формат кадра";
+        } else {
+            try {
+                const cv::Mat source(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), image.bytesPerLine());
+                output.ok = estimator->update(workFrame(source, workWidth), input.attitude, output.estimate);
+            } catch (const cv::Exception& e) {
+                output.error = QString("ошибка OpenCV: %1").arg(e.what());
+            }
+        }
+        output.computeMs = (CameraBackend::monotonicNs() - startNs) / 1e6;
+        return output;
+    }, [this](const Output& output) {
+        if (!output.error.isEmpty()) {
+            QString errorMsg = QString("Удержание позиции выключено: %1").arg(output.error);
+            qDebug() << errorMsg;
+            setHoldEnabled(false);
+            emit errorOccurred("VisualOdometry", errorMsg);
+            return;
+        }
+        applyEstimate(output.ok, output.estimate, output.frameNs, output.computeMs);
+    });
+}
+
+void VisualOdometry::applyEstimate(bool ok, const OdometryEstimate& estimate, qint64 frameNs, double computeMs) {
+    m_state.processed++;
+    m_state.skipped = m_stage->skipped();
+    m_state.computeMs = computeMs;
+    m_state.latencyMs = (CameraBackend::monotonicNs() - frameNs) / 1e6;
+
+    // Бюджет времени держится числом точек; обработка сейчас не идёт, оценщик свободен
+    const int features = m_estimator->features();
+    if (computeMs > m_settings.budgetMs && features > m_settings.minFeatures * 2)
+        m_estimator->setFeatures(qMax(m_settings.minFeatures * 2, features * 4 / 5));
+    else if (computeMs < m_settings.budgetMs / 2 && features < m_settings.features)
+        m_estimator->setFeatures(qMin(m_settings.features, features + 10));
+    m_state.features = m_estimator->features();
+
+    const double dt = m_previousEstimateNs > 0 ? (frameNs - m_previousEstimateNs) / 1e9 : 0;
+    m_previousEstimateNs = frameNs;
+    double forward = 0;
+    double side = 0;
+    if (!ok) {
+        // Без привязки коррекция не выдаётся: по устаревшему смещению аппарат уведёт в сторону
+        if (m_state.tracking) qDebug() << "Удержание позиции: привязка к дну потеряна";
+        m_state.lost++;
+        m_integralForward = 0;
+        m_integralSide = 0;
+    } else {
+        // Точка удержания - первое положение после включения; пока пилот двигает аппарат, она следует за ним
+        if (!m_originValid || m_pilotOverride) {
+            m_originNorthM = estimate.northM;
+            m_originEastM = estimate.eastM;
+            m_originValid = true;
+            m_integralForward = 0;
+            m_integralSide = 0;
+        }
+        const double errorNorth = m_originNorthM - estimate.northM;
+        const double errorEast = m_originEastM - estimate.eastM;
+        m_state.driftNorthM = -errorNorth;
+        m_state.driftEastM = -errorEast;
+
+        // Ошибка в осях аппарата: марш вперёд, лаг вправо
+        const double heading = estimate.headingDeg * CV_PI / 180.0;
+        double errorForward = errorNorth * std::cos(heading) + errorEast * std::sin(heading);
+        double errorSide = -errorNorth * std::sin(heading) + errorEast * std::cos(heading);
+        if (std::hypot(errorForward, errorSide) < m_settings.holdDeadbandM) {
+            errorForward = 0;
+            errorSide = 0;
+        } else if (dt > 0 && dt < 0.5) {
+            m_integralForward += errorForward * dt;
+            m_integralSide += errorSide * dt;
+            if (m_settings.holdKi > 0) {
+                const double limit = m_settings.holdMaxThrust / m_settings.holdKi;
+                m_integralForward = qBound(-limit, m_integralForward, limit);
+                m_integralSide = qBound(-limit, m_integralSide, limit);
+            }
+        }
+        if (!m_pilotOverride) {
+            const double maxThrust = m_settings.holdMaxThrust;
+            forward = qBound(-maxThrust, m_settings.holdKp * errorForward + m_settings.holdKi * m_integralForward, maxThrust);
+            side = qBound(-maxThrust, m_settings.holdKp * errorSide + m_settings.holdKi * m_integralSide, maxThrust);
+        }
+    }
+    m_state.tracking = ok;
+    m_state.forward = forward;
+    m_state.side = side;
+    emit holdCorrection(float(forward), float(side));
+
+    const qint64 nowNs = CameraBackend::monotonicNs();
+    if (nowNs - m_rateStartNs >= 1000000000) {
+        m_state.rateHz = (m_state.processed - m_rateStartProcessed) * 1e9 / (nowNs - m_rateStartNs);
+        m_rateStartNs = nowNs;
+        m_rateStartProcessed = m_state.processed;
+    }
+    emit stateUpdated(m_state);
+}
+
+int VisualOdometry::replayCheck(QTextStream& out, const QString& sourcePath) {
+    const OdometrySettings settings;
+    const int TEXTURE_SIZE = 4000;
+    const double TEXTURE_PX_PER_M = 500;
+    const double FRAME_RATE = 25;
+    const int FRAMES = 500;
+
+    // Текстура дна: 8x8 м, 500 пикселей на метр
+    cv::Mat texture;
+    if (sourcePath.isEmpty()) {
+        texture.create(TEXTURE_SIZE, TEXTURE_SIZE, CV_8UC1);
+        cv::RNG rng(1);
+        rng.fill(texture, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(texture, texture, cv::Size(0, 0), 3);
+        cv::equalizeHist(texture, texture);
+    } else {
+        cv::Mat frame = cv::imread(sourcePath.toStdString(), cv::IMREAD_GRAYSCALE);
+        if (frame.empty()) {
+            cv::VideoCapture video(sourcePath.toStdString());
+            cv::Mat bgr;
+            if (video.isOpened() && video.read(bgr))
+                cv::cvtColor(bgr, frame, cv::COLOR_BGR2GRAY);
+        }
+        if (frame.empty()) {
+            out << "Не удалось прочитать кадр из " << sourcePath << "\n";
+            return 1;
+        }
+        // Один кадр покрывает мало дна: он увеличивается и отражается до размера текстуры
+        cv::resize(frame, frame, cv::Size(TEXTURE_SIZE / 2, qRound(TEXTURE_SIZE / 2.0 * frame.rows / frame.cols)), 0, 0, cv::INTER_CUBIC);
+        cv::copyMakeBorder(frame, texture, 0, qMax(0, TEXTURE_SIZE - frame.rows), 0, TEXTURE_SIZE - frame.cols, cv::BORDER_REFLECT);
+        texture = texture(cv::Rect(0, 0, TEXTURE_SIZE, TEXTURE_SIZE)).clone();
+    }
+
+    // Кадр камеры вдвое больше рабочего, чтобы в замер времени вошло и уменьшение
+    const cv::Size frameSize(settings.workWidth * 2, settings.workWidth * 3 / 2);
+    const double focal = frameSize.width / 2.0 / std::tan(settings.hfovDeg * CV_PI / 360.0);
+    const cv::Point2d frameCenter(frameSize.width / 2.0, frameSize.height / 2.0);
+    auto render = [&](double north, double east, double yawDeg, double pitchDeg, double rollDeg) {
+        // Луч каждого угла кадра в осях аппарата (вперёд, вправо, вниз), поворот в осях дна,
+        // пересечение с дном на высоте altitudeM
+        const double yaw = yawDeg * CV_PI / 180.0;
+        const double pitch = pitchDeg * CV_PI / 180.0;
+        const double roll = rollDeg * CV_PI / 180.0;
+        const cv::Matx33d Rz(std::cos(yaw), -std::sin(yaw), 0, std::sin(yaw), std::cos(yaw), 0, 0, 0, 1);
+        const cv::Matx33d Ry(std::cos(pitch), 0, std::sin(pitch), 0, 1, 0, -std::sin(pitch), 0, std::cos(pitch));
+        const cv::Matx33d Rx(1, 0, 0, 0, std::cos(roll), -std::sin(roll), 0, std::sin(roll), std::cos(roll));
+        const cv::Matx33d R = Rz * Ry * Rx;
+        std::vector<cv::Point2f> imageCorners = {cv::Point2f(0, 0), cv::Point2f(frameSize.width, 0),
+                                                 cv::Point2f(frameSize.width, frameSize.height), cv::Point2f(0, frameSize.height)};
+        std::vector<cv::Point2f> textureCorners;
+        for (const cv::Point2f& corner : imageCorners) {
+            const cv::Vec3d ray = R * cv::Vec3d(-(corner.y - frameCenter.y) / focal, (corner.x - frameCenter.x) / focal, 1.0);
+            const double scale = settings.altitudeM / ray[2];
+            const double groundNorth = north + scale * ray[0];
+            const double groundEast = east + scale * ray[1];
+            textureCorners.emplace_back(float(TEXTURE_SIZE / 2.0 + groundEast * TEXTURE_PX_PER_M),
+                                        float(TEXTURE_SIZE / 2.0 - groundNorth * TEXTURE_PX_PER_M));
+        }
+        cv::Mat gray, bgr;
+        cv::warpPerspective(texture, gray, cv::getPerspectiveTransform(textureCorners, imageCorners), frameSize, cv::INTER_LINEAR);
+        cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+        return bgr;
+    };
+
+    // Маршрут: медленный снос с колебаниями по курсу, крену и дифференту, как при зависании на течении.
+    // Телеметрия приходит с шумом 0.1 градуса.
+    OdometryEstimator estimator(settings);
+    cv::RNG noise(2);
+    double maxError = 0;
+    double squaredError = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    double pathM = 0;
+    double previousNorth = 0;
+    double previousEast = 0;
+    int lost = 0;
+    int keyframes = 0;
+    double finalError = 0;
+    for (int i = 0; i < FRAMES; ++i) {
+        const double time = i / FRAME_RATE;
+        const double north = 0.3 * std::sin(0.4 * time) + 0.03 * time;
+        const double east = 0.3 * (1 - std::cos(0.4 * time));
+        const double yaw = 20 * std::sin(0.3 * time);
+        const double pitch = 4 * std::sin(1.1 * time);
+        const double roll = 3 * std::sin(0.9 * time + 1);
+        const cv::Mat frame = render(north, east, yaw, pitch, roll);
+
+        OdometryAttitude attitude;
+        attitude.rollDeg = float(roll + noise.gaussian(0.1));
+        attitude.pitchDeg = float(pitch + noise.gaussian(0.1));
+        attitude.yawDeg = float(yaw + noise.gaussian(0.1));
+        attitude.valid = true;
+
+        OdometryEstimate estimate;
+        const qint64 startNs = CameraBackend::monotonicNs();
+        const bool ok = estimator.update(workFrame(frame, settings.workWidth), attitude, estimate);
+        const double ms = (CameraBackend::monotonicNs() - startNs) / 1e6;
+        totalMs += ms;
+        maxMs = qMax(maxMs, ms);
+        if (!ok) lost++;
+        if (estimate.keyframe) keyframes++;
+
+        finalError = std::hypot(estimate.northM - north, estimate.eastM - east);
+        maxError = qMax(maxError, finalError);
+        squaredError += finalError * finalError;
+        if (i > 0) pathM += std::hypot(north - previousNorth, east - previousEast);
+        previousNorth = north;
+        previousEast = east;
+    }
+
+    int exitCode = 0;
+    auto check = [&](const QString& name, double value, double limit) {
+        const bool ok = value <= limit;
+        out << QString("%1: %2 (допустимо %3) %4\n").arg(name, -36).arg(value, 0, 'g', 4).arg(limit).arg(ok ? "OK" : "ОШИБКА");
+        if (!ok) exitCode = 1;
+    };
+    out << QString("Кадров: %1 (%2 Гц), путь %3 м, опорных кадров %4, текстура: %5\n")
+               .arg(FRAMES).arg(FRAME_RATE).arg(pathM, 0, 'f', 2).arg(keyframes)
+               .arg(sourcePath.isEmpty() ? QString("шум") : sourcePath);
+    out << QString("Средняя ошибка положения: %1 м\n").arg(std::sqrt(squaredError / FRAMES), 0, 'f', 3);
+    check("Кадров без привязки", lost, 0);
+    check("Ошибка положения в конце, м", finalError, 0.05);
+    check("Наибольшая ошибка положения, м", maxError, 0.08);
+    check("Среднее время обработки кадра, мс", totalMs / FRAMES, settings.budgetMs);
+    check("Наибольшее время обработки кадра, мс", maxMs, 1000.0 / 20);
+    out << (exitCode == 0 ? "Проверка одометрии пройдена\n" : "Проверка одометрии не пройдена\n");
+    return exitCode;
+}
@@ -0,0 +1,184 @@
+#ifndef VISUAL_ODOMETRY_H
+#define VISUAL_ODOMETRY_H
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <QTextStream>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "latest_frame_stage.h"
+
+// Параметры визуальной одометрии и удержания позиции (ключи Odometry_* в настройках)
+struct OdometrySettings {
+    QString cameraName = "DCamera"; // Камера, смотрящая вниз
+    double rateHz = 25;             // Частота оценки смещения
+    int workWidth = 320;            // Ширина кадра для отслеживания точек
+    int features = 150;             // Точек на опорном кадре
+    int minFeatures = 40;           // Меньше отслеживается - берётся новый опорный кадр
+    int minInliers = 15;            // Меньше совпадений после RANSAC - привязка потеряна
+    double hfovDeg = 90;            // Горизонтальный угол обзора камеры
+    double altitudeM = 1.5;         // Расстояние до дна: переводит пиксели в метры
+    int yawSign = 1;                // Направление поворота кадра при росте курса; 0 - поворот не предсказывается
+    int tiltSign = 1;               // Направление сдвига кадра при крене и дифференте; 0 - не используются
+    double budgetMs = 15;           // Допустимое время обработки кадра, дольше - точек становится меньше
+    double holdKp = 0.5;            // Тяга на метр смещения
+    double holdKi = 0.05;           // Тяга на метр*секунду накопленного смещения
+    double holdMaxThrust = 0.3;     // Предел коррекции по каждой оси
+    double holdDeadbandM = 0.03;    // Меньшее смещение не исправляется
+
+    static OdometrySettings load();
+};
+
+// Ориентация аппарата из телеметрии, градусы
+struct OdometryAttitude {
+    float rollDeg = 0;
+    float pitchDeg = 0;
+    float yawDeg = 0;
+    bool valid = false;
+};
+
+// Положение камеры над дном относительно первого кадра: север - курс 0, восток - курс 90
+struct OdometryEstimate {
+    bool tracking = false;
+    double northM = 0;
+    double eastM = 0;
+    double headingDeg = 0;
+    int inliers = 0;
+    bool keyframe = false;          // На этом кадре взят новый опорный кадр
+};
+
+// Оценка смещения по последовательности кадров нижней камеры.
+// Точки опорного кадра отслеживаются пирамидальным Лукасом-Канаде от кадра к кадру, но смещение
+// считается между опорным и текущим кадром: пока аппарат висит на месте, ошибка не накапливается.
+// Поворот кадра от изменения курса и сдвиг от крена и дифферента с момента опорного кадра
+// вычитаются по телеметрии, остаток - подобие по RANSAC, его сдвиг в центре кадра и есть
+// перемещение камеры. Без телеметрии курс берётся из поворота кадра.
+class OdometryEstimator {
+public:
+    explicit OdometryEstimator(const OdometrySettings& settings);
+
+    void reset();
+    // Кадр в оттенках серого; false - привязка потеряна, положение не изменилось
+    bool update(const cv::Mat& gray, const OdometryAttitude& attitude, OdometryEstimate& estimate);
+    // Применяется со следующего опорного кадра
+    void setFeatures(int features) { m_features = features; }
+    int features() const { return m_features; }
+
+private:
+    void startKeyframe(const cv::Mat& gray, const OdometryAttitude& attitude);
+
+    OdometrySettings m_settings;
+    int m_features;
+    double m_focal = 0;
+    cv::Mat m_previous;
+    std::vector<cv::Point2f> m_keyPoints;   // Положение точек на опорном кадре
+    std::vector<cv::Point2f> m_points;      // Те же точки на предыдущем кадре
+    OdometryAttitude m_keyAttitude;
+    double m_keyNorthM = 0;
+    double m_keyEastM = 0;
+    double m_keyHeadingDeg = 0;
+    double m_northM = 0;
+    double m_eastM = 0;
+    double m_headingDeg = 0;
+};
+
+// Состояние одометрии и удержания позиции для HUD
+struct OdometryState {
+    bool running = false;
+    bool hold = false;
+    bool tracking = false;
+    double driftNorthM = 0;     // Смещение от точки удержания
+    double driftEastM = 0;
+    double forward = 0;         // Выданная коррекция
+    double side = 0;
+    double rateHz = 0;          // Частота обработанных кадров
+    double computeMs = 0;
+    double latencyMs = 0;       // От захвата кадра до коррекции
+    int features = 0;
+    quint64 processed = 0;
+    quint64 lost = 0;           // Кадров без привязки
+    quint64 skipped = 0;        // Кадров пропущено, пока шла обработка предыдущего
+};
+Q_DECLARE_METATYPE(OdometryState)
+
+// Визуальная одометрия по нижней камере и удержание позиции.
+// Включается вместе с режимом удержания: камера подключается по требованию, по таймеру
+// последний кадр уменьшается до workWidth и обрабатывается OdometryEstimator в
+// LatestFrameStage. При превышении бюджета времени уменьшается число отслеживаемых точек.
+// Смещение от точки удержания переводится в оси аппарата, ПИ-регулятор выдаёт добавку
+// к маршу и лагу. Пока пилот сам двигает аппарат, точка удержания следует за ним.
+class VisualOdometry : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VisualOdometry(QObject* parent = nullptr);
+    ~VisualOdometry() override;
+
+    bool isHoldEnabled() const { return m_hold; }
+    // Вызываются из потока интерфейса
+    void submitFrame(const QString& cameraName, const QImage& image, qint64 timestampNs);
+    void setTelemetry(float rollDeg, float pitchDeg, float yawDeg);
+
+    // Воспроизведение синтетического маршрута над дном с известной траекторией и телеметрией;
+    // текстура дна - первый кадр записи или снимок sourcePath, без него - шум.
+    // Сверяет оценку с траекторией и время обработки с бюджетом. Возвращает код выхода.
+    static int replayCheck(QTextStream& out, const QString& sourcePath);
+
+public slots:
+    void setHoldEnabled(bool enabled);
+    void setPilotOverride(bool active);
+
+signals:
+    void cameraRequired(const QString& cameraName);
+    void holdCorrection(float forward, float side);
+    void stateUpdated(const OdometryState& state);
+    void errorOccurred(const QString& component, const QString& message);
+
+private:
+    struct Input {
+        QImage image;
+        qint64 frameNs = 0;
+        OdometryAttitude attitude;
+    };
+    struct Output {
+        bool ok = false;
+        OdometryEstimate estimate;
+        QString error;
+        qint64 frameNs = 0;
+        double computeMs = 0;
+    };
+
+    void tick();
+    void applyEstimate(bool ok, const OdometryEstimate& estimate, qint64 frameNs, double computeMs);
+    void resetHold();
+
+    OdometrySettings m_settings;
+    std::shared_ptr<OdometryEstimator> m_estimator;  // Используется только одной обработкой за раз
+    LatestFrameStage* m_stage;
+    bool m_hold = false;
+    bool m_pilotOverride = false;
+
+    QImage m_frame;
+    qint64 m_frameNs = 0;
+    std::atomic<float> m_rollDeg{0};
+    std::atomic<float> m_pitchDeg{0};
+    std::atomic<float> m_yawDeg{0};
+    std::atomic<bool> m_hasTelemetry{false};
+
+    // Регулятор удержания
+    bool m_originValid = false;
+    double m_originNorthM = 0;
+    double m_originEastM = 0;
+    double m_integralForward = 0;
+    double m_integralSide = 0;
+    qint64 m_previousEstimateNs = 0;
+
+    OdometryState m_state;
+    qint64 m_rateStartNs = 0;
+    quint64 m_rateStartProcessed = 0;
+};
+
+#endif // VISUAL_ODOMETRY_H